@@ -0,0 +1,839 @@
+/*
+ *      audiofile.c -- built-in readers for common audio file formats
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * WAV (PCM 8/16/24/32 bit, IEEE float, A-law, u-law, including
+ * WAVE_FORMAT_EXTENSIBLE), Sun/NeXT AU and FLAC are decoded here instead
+ * of forking sox. The output mimics what the sox pipeline in unixinput.c
+ * delivers: the first channel as signed 16 bit samples. Rate conversion
+ * is left to the multirate stage in unixinput.c.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "audiofile.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ---------------------------------------------------------------------- */
+
+enum { AF_WAV, AF_AU, AF_FLAC };
+
+enum { ENC_PCM_U8, ENC_PCM, ENC_FLOAT, ENC_ULAW, ENC_ALAW };
+
+#define RAW_BUF_SIZE  65536
+#define FLAC_MAX_BLOCK 65535
+#define FLAC_MAX_CHANNELS 8
+
+struct flac_state {
+    uint64_t cache;             /* bit reader */
+    unsigned int bits;
+    unsigned char crc8;
+    unsigned short crc16;
+    int eof;
+    unsigned int max_block;
+    int32_t *chan[2];           /* decoded subframes of the first two channels */
+    int32_t *scratch;           /* subframes that are decoded but not used */
+};
+
+struct audio_file {
+    FILE *fp;
+    int format;
+    int encoding;
+    int big_endian;
+    unsigned int rate;
+    unsigned int channels;
+    unsigned int bits;          /* bits per sample as stored */
+    unsigned int frame_size;    /* bytes per sample frame for WAV/AU */
+    uint64_t remaining;         /* bytes left in the data chunk */
+    uint64_t frames;            /* length in sample frames, 0 if unknown */
+    char bext_date[20];         /* origination date and time of a BWF file, "" if none */
+    uint64_t bext_ref;          /* its time reference, in samples since midnight */
+    unsigned char raw[RAW_BUF_SIZE];
+    float *block;               /* decoded first channel samples */
+    unsigned int block_len;
+    unsigned int block_pos;
+    struct flac_state flac;
+};
+
+/* ---------------------------------------------------------------------- */
+
+int audio_native_type(const char *type)
+{
+    return type && (!strcmp(type, "wav") || !strcmp(type, "au") ||
+                    !strcmp(type, "flac"));
+}
+
+static uint32_t le16(const unsigned char *p) { return p[0] | p[1] << 8; }
+static uint32_t le32(const unsigned char *p) { return le16(p) | (uint32_t)le16(p + 2) << 16; }
+static uint32_t be32(const unsigned char *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static int skip_bytes(FILE *fp, uint32_t n)
+{
+    unsigned char tmp[256];
+
+    if (!fseek(fp, n, SEEK_CUR))
+        return 0;
+    while (n) {
+        uint32_t k = n < sizeof(tmp) ? n : sizeof(tmp);
+        if (fread(tmp, 1, k, fp) != k)
+            return -1;
+        n -= k;
+    }
+    return 0;
+}
+
+/* G.711 expansion, same 16 bit scaling as sox */
+static int ulaw_to_linear(unsigned char u)
+{
+    int t;
+
+    u = ~u;
+    t = ((u & 0x0f) << 3) + 0x84;
+    t <<= (u & 0x70) >> 4;
+    return (u & 0x80) ? (0x84 - t) : (t - 0x84);
+}
+
+static int alaw_to_linear(unsigned char a)
+{
+    int t, seg;
+
+    a ^= 0x55;
+    t = (a & 0x0f) << 4;
+    seg = (a & 0x70) >> 4;
+    if (seg == 0)
+        t += 8;
+    else if (seg == 1)
+        t += 0x108;
+    else {
+        t += 0x108;
+        t <<= seg - 1;
+    }
+    return (a & 0x80) ? t : -t;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static int wav_open(struct audio_file *af)
+{
+    unsigned char hdr[40];
+    unsigned int tag = 0;
+    int have_fmt = 0;
+
+    if (fread(hdr, 1, 12, af->fp) != 12 || memcmp(hdr, "RIFF", 4) ||
+        memcmp(hdr + 8, "WAVE", 4))
+        return 0;
+
+    for (;;) {
+        uint32_t size;
+
+        if (fread(hdr, 1, 8, af->fp) != 8)
+            return 0;
+        size = le32(hdr + 4);
+
+        if (!memcmp(hdr, "fmt ", 4)) {
+            uint32_t n = size < sizeof(hdr) ? size : sizeof(hdr);
+            if (n < 16 || fread(hdr, 1, n, af->fp) != n)
+                return 0;
+            tag = le16(hdr);
+            af->channels = le16(hdr + 2);
+            af->rate = le32(hdr + 4);
+            af->frame_size = le16(hdr + 12);
+            af->bits = le16(hdr + 14);
+            /* WAVE_FORMAT_EXTENSIBLE: the real format leads the sub-format GUID */
+            if (tag == 0xfffe && n >= 26)
+                tag = le16(hdr + 24);
+            if (skip_bytes(af->fp, size - n + (size & 1)))
+                return 0;
+            have_fmt = 1;
+        } else if (!memcmp(hdr, "bext", 4) && size >= 346) {
+            /* Broadcast Wave: OriginationDate and Time follow 320 bytes of text */
+            unsigned char bext[346];
+            if (fread(bext, 1, sizeof(bext), af->fp) != sizeof(bext) ||
+                skip_bytes(af->fp, size - sizeof(bext) + (size & 1)))
+                return 0;
+            memcpy(af->bext_date, bext + 320, 10);
+            af->bext_date[10] = ' ';
+            memcpy(af->bext_date + 11, bext + 330, 8);
+            af->bext_ref = le32(bext + 338) | (uint64_t)le32(bext + 342) << 32;
+        } else if (!memcmp(hdr, "data", 4)) {
+            /* streamed files may not know their length, read to EOF then */
+            af->remaining = (size == 0 || size == 0xffffffff) ? UINT64_MAX : size;
+            break;
+        } else if (skip_bytes(af->fp, size + (size & 1))) {
+            return 0;
+        }
+    }
+    if (!have_fmt || !af->channels || !af->rate)
+        return 0;
+
+    switch (tag) {
+    case 1:
+        if (af->bits != 8 && af->bits != 16 && af->bits != 24 && af->bits != 32)
+            return 0;
+        af->encoding = af->bits == 8 ? ENC_PCM_U8 : ENC_PCM;
+        break;
+    case 3:
+        if (af->bits != 32 && af->bits != 64)
+            return 0;
+        af->encoding = ENC_FLOAT;
+        break;
+    case 6:
+        af->encoding = ENC_ALAW;
+        break;
+    case 7:
+        af->encoding = ENC_ULAW;
+        break;
+    default:
+        return 0;
+    }
+    if (af->encoding == ENC_ALAW || af->encoding == ENC_ULAW)
+        af->bits = 8;
+    if (af->frame_size != af->channels * (af->bits / 8))
+        return 0;
+    if (af->remaining != UINT64_MAX)
+        af->frames = af->remaining / af->frame_size;
+    return 1;
+}
+
+static int au_open(struct audio_file *af)
+{
+    unsigned char hdr[24];
+    uint32_t offset, size;
+
+    if (fread(hdr, 1, 24, af->fp) != 24 || memcmp(hdr, ".snd", 4))
+        return 0;
+    offset = be32(hdr + 4);
+    size = be32(hdr + 8);
+    af->rate = be32(hdr + 16);
+    af->channels = be32(hdr + 20);
+    af->big_endian = 1;
+    af->remaining = size == 0xffffffff ? UINT64_MAX : size;
+
+    switch (be32(hdr + 12)) {
+    case 1:  af->encoding = ENC_ULAW;  af->bits = 8;  break;
+    case 2:  af->encoding = ENC_PCM;   af->bits = 8;  break;
+    case 3:  af->encoding = ENC_PCM;   af->bits = 16; break;
+    case 4:  af->encoding = ENC_PCM;   af->bits = 24; break;
+    case 5:  af->encoding = ENC_PCM;   af->bits = 32; break;
+    case 6:  af->encoding = ENC_FLOAT; af->bits = 32; break;
+    case 7:  af->encoding = ENC_FLOAT; af->bits = 64; break;
+    case 27: af->encoding = ENC_ALAW;  af->bits = 8;  break;
+    default:
+        return 0;
+    }
+    if (!af->channels || !af->rate || offset < 24 || skip_bytes(af->fp, offset - 24))
+        return 0;
+    af->frame_size = af->channels * (af->bits / 8);
+    if (af->remaining != UINT64_MAX)
+        af->frames = af->remaining / af->frame_size;
+    return 1;
+}
+
+/* Decode the first channel of n frames stored in af->raw */
+static void pcm_convert(struct audio_file *af, float *out, unsigned int n)
+{
+    const unsigned char *p = af->raw;
+    unsigned int step = af->frame_size;
+    int be = af->big_endian;
+
+    for (unsigned int i = 0; i < n; i++, p += step) {
+        uint32_t u;
+        switch (af->encoding) {
+        case ENC_PCM_U8:
+            out[i] = ((int)p[0] - 128) * (1.0f/128.0f);
+            break;
+        case ENC_ULAW:
+            out[i] = ulaw_to_linear(p[0]) * (1.0f/32768.0f);
+            break;
+        case ENC_ALAW:
+            out[i] = alaw_to_linear(p[0]) * (1.0f/32768.0f);
+            break;
+        case ENC_PCM:
+            switch (af->bits) {
+            case 8:
+                out[i] = (signed char)p[0] * (1.0f/128.0f);
+                break;
+            case 16:
+                u = be ? (uint32_t)p[0] << 8 | p[1] : (uint32_t)p[1] << 8 | p[0];
+                out[i] = (int16_t)u * (1.0f/32768.0f);
+                break;
+            case 24:
+                u = be ? (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8
+                       : (uint32_t)p[2] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[0] << 8;
+                out[i] = (int32_t)u * (1.0f/2147483648.0f);
+                break;
+            default:
+                u = be ? be32(p) : le32(p);
+                out[i] = (int32_t)u * (1.0f/2147483648.0f);
+                break;
+            }
+            break;
+        case ENC_FLOAT:
+            if (af->bits == 32) {
+                float f;
+                u = be ? be32(p) : le32(p);
+                memcpy(&f, &u, sizeof(f));
+                out[i] = f;
+            } else {
+                uint64_t v = be ? (uint64_t)be32(p) << 32 | be32(p + 4)
+                                : (uint64_t)le32(p + 4) << 32 | le32(p);
+                double d;
+                memcpy(&d, &v, sizeof(d));
+                out[i] = d;
+            }
+            break;
+        }
+    }
+}
+
+static unsigned int pcm_decode(struct audio_file *af, float *out, unsigned int n)
+{
+    size_t bytes;
+
+    if (n > RAW_BUF_SIZE / af->frame_size)
+        n = RAW_BUF_SIZE / af->frame_size;
+    bytes = (size_t)n * af->frame_size;
+    if (bytes > af->remaining)
+        bytes = af->remaining - af->remaining % af->frame_size;
+    bytes = fread(af->raw, 1, bytes, af->fp);
+    if (af->remaining != UINT64_MAX)
+        af->remaining -= bytes;
+    n = bytes / af->frame_size;
+    pcm_convert(af, out, n);
+    return n;
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * FLAC: fixed and LPC subframes with partitioned Rice residuals, all
+ * stereo decorrelation modes, up to 24 bits per sample. Frame CRCs are
+ * verified; a frame that fails to parse makes the decoder resync on the
+ * next frame header.
+ */
+
+static const unsigned char crc8_poly = 0x07;
+static const unsigned short crc16_poly = 0x8005;
+
+static int flac_getbyte(struct audio_file *af)
+{
+    struct flac_state *fs = &af->flac;
+    int c = getc(af->fp);
+
+    if (c == EOF) {
+        fs->eof = 1;
+        return 0;
+    }
+    fs->crc8 ^= c;
+    for (int i = 0; i < 8; i++)
+        fs->crc8 = (fs->crc8 & 0x80) ? (fs->crc8 << 1) ^ crc8_poly : fs->crc8 << 1;
+    fs->crc16 ^= c << 8;
+    for (int i = 0; i < 8; i++)
+        fs->crc16 = (fs->crc16 & 0x8000) ? (fs->crc16 << 1) ^ crc16_poly : fs->crc16 << 1;
+    return c;
+}
+
+static uint32_t flac_bits(struct audio_file *af, unsigned int n)
+{
+    struct flac_state *fs = &af->flac;
+
+    if (!n)
+        return 0;
+    while (fs->bits < n) {
+        fs->cache = fs->cache << 8 | flac_getbyte(af);
+        fs->bits += 8;
+    }
+    fs->bits -= n;
+    return (fs->cache >> fs->bits) & (0xffffffffu >> (32 - n));
+}
+
+static int32_t flac_sbits(struct audio_file *af, unsigned int n)
+{
+    uint32_t u = flac_bits(af, n);
+
+    if (!n)
+        return 0;
+    return (int32_t)(u << (32 - n)) >> (32 - n);
+}
+
+static uint32_t flac_unary(struct audio_file *af)
+{
+    struct flac_state *fs = &af->flac;
+    uint32_t cnt = 0;
+
+    for (;;) {
+        if (!fs->bits) {
+            fs->cache = flac_getbyte(af);
+            fs->bits = 8;
+            if (fs->eof)
+                return cnt;
+        }
+        fs->bits--;
+        if ((fs->cache >> fs->bits) & 1)
+            return cnt;
+        cnt++;
+    }
+}
+
+static int flac_residual(struct audio_file *af, int32_t *res, unsigned int blocksize,
+                         unsigned int order)
+{
+    unsigned int method = flac_bits(af, 2);
+    unsigned int porder, parts, parambits, escape;
+
+    if (method > 1)
+        return -1;
+    parambits = method ? 5 : 4;
+    escape = method ? 31 : 15;
+    porder = flac_bits(af, 4);
+    parts = 1u << porder;
+    if ((blocksize >> porder) < order || (blocksize & (parts - 1)))
+        return -1;
+
+    for (unsigned int p = 0; p < parts; p++) {
+        unsigned int n = (blocksize >> porder) - (p ? 0 : order);
+        unsigned int param = flac_bits(af, parambits);
+
+        if (param == escape) {
+            unsigned int raw = flac_bits(af, 5);
+            for (unsigned int i = 0; i < n; i++)
+                *res++ = flac_sbits(af, raw);
+        } else {
+            for (unsigned int i = 0; i < n; i++) {
+                uint32_t u = flac_unary(af) << param | flac_bits(af, param);
+                *res++ = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+            }
+        }
+        if (af->flac.eof)
+            return -1;
+    }
+    return 0;
+}
+
+static int flac_subframe(struct audio_file *af, int32_t *s, unsigned int blocksize,
+                         unsigned int bps)
+{
+    unsigned int type, wasted = 0, order;
+
+    if (flac_bits(af, 1))
+        return -1;
+    type = flac_bits(af, 6);
+    if (flac_bits(af, 1))
+        wasted = flac_unary(af) + 1;
+    if (wasted >= bps)
+        return -1;
+    bps -= wasted;
+
+    if (type == 0) {
+        int32_t v = flac_sbits(af, bps);
+        for (unsigned int i = 0; i < blocksize; i++)
+            s[i] = v;
+    } else if (type == 1) {
+        for (unsigned int i = 0; i < blocksize; i++)
+            s[i] = flac_sbits(af, bps);
+    } else if (type >= 8 && type <= 12) {
+        order = type - 8;
+        if (order > blocksize)
+            return -1;
+        for (unsigned int i = 0; i < order; i++)
+            s[i] = flac_sbits(af, bps);
+        if (flac_residual(af, s + order, blocksize, order))
+            return -1;
+        for (unsigned int i = order; i < blocksize; i++) {
+            int64_t r = s[i];
+            switch (order) {
+            case 1: r += s[i-1]; break;
+            case 2: r += 2*(int64_t)s[i-1] - s[i-2]; break;
+            case 3: r += 3*((int64_t)s[i-1] - s[i-2]) + s[i-3]; break;
+            case 4: r += 4*((int64_t)s[i-1] + s[i-3]) - 6*(int64_t)s[i-2] - s[i-4]; break;
+            }
+            s[i] = (int32_t)r;
+        }
+    } else if (type >= 32) {
+        int32_t coef[32];
+        unsigned int precision;
+        int shift;
+
+        order = type - 31;
+        if (order > blocksize)
+            return -1;
+        for (unsigned int i = 0; i < order; i++)
+            s[i] = flac_sbits(af, bps);
+        precision = flac_bits(af, 4) + 1;
+        if (precision == 16)
+            return -1;
+        shift = flac_sbits(af, 5);
+        if (shift < 0)
+            return -1;
+        for (unsigned int i = 0; i < order; i++)
+            coef[i] = flac_sbits(af, precision);
+        if (flac_residual(af, s + order, blocksize, order))
+            return -1;
+        for (unsigned int i = order; i < blocksize; i++) {
+            int64_t sum = 0;
+            for (unsigned int j = 0; j < order; j++)
+                sum += (int64_t)coef[j] * s[i-1-j];
+            s[i] += (int32_t)(sum >> shift);
+        }
+    } else {
+        return -1;
+    }
+
+    if (wasted)
+        for (unsigned int i = 0; i < blocksize; i++)
+            s[i] = (int32_t)((uint32_t)s[i] << wasted);
+    return 0;
+}
+
+static void flac_crc_seed(struct audio_file *af, const unsigned char *b, int n)
+{
+    struct flac_state *fs = &af->flac;
+
+    fs->crc8 = 0;
+    fs->crc16 = 0;
+    for (int k = 0; k < n; k++) {
+        fs->crc8 ^= b[k];
+        for (int i = 0; i < 8; i++)
+            fs->crc8 = (fs->crc8 & 0x80) ? (fs->crc8 << 1) ^ crc8_poly : fs->crc8 << 1;
+        fs->crc16 ^= b[k] << 8;
+        for (int i = 0; i < 8; i++)
+            fs->crc16 = (fs->crc16 & 0x8000) ? (fs->crc16 << 1) ^ crc16_poly : fs->crc16 << 1;
+    }
+}
+
+/*
+ * Search the next frame sync code. The bit reader never holds more than
+ * a partial byte, so dropping that leaves it byte aligned and empty.
+ */
+static int flac_sync(struct audio_file *af)
+{
+    struct flac_state *fs = &af->flac;
+    int prev = 0;
+
+    fs->bits = 0;
+    for (;;) {
+        int c = flac_getbyte(af);
+        if (fs->eof)
+            return -1;
+        if (prev == 0xff && (c & 0xfe) == 0xf8) {
+            unsigned char sync[2] = { 0xff, (unsigned char)c };
+            flac_crc_seed(af, sync, 2);
+            return 0;
+        }
+        prev = c;
+    }
+}
+
+static unsigned int flac_frame(struct audio_file *af)
+{
+    static const unsigned int sample_sizes[8] = { 0, 8, 12, 0, 16, 20, 24, 0 };
+    struct flac_state *fs = &af->flac;
+
+    for (;;) {
+        unsigned int bscode, srcode, assign, sscode, blocksize, bps, nch;
+        uint32_t c;
+        int ok = 1;
+
+        if (flac_sync(af))
+            return 0;
+
+        bscode = flac_bits(af, 4);
+        srcode = flac_bits(af, 4);
+        assign = flac_bits(af, 4);
+        sscode = flac_bits(af, 3);
+        if (flac_bits(af, 1) || bscode == 0 || srcode == 15 || assign > 10 ||
+            (sample_sizes[sscode] == 0 && sscode != 0))
+            continue;
+
+        /* coded frame or sample number, UTF-8 style */
+        c = flac_bits(af, 8);
+        if (c >= 0x80) {
+            int extra = 0;
+            while (c & (0x40 >> extra))
+                extra++;
+            if (!(c & 0x40) || extra > 5)
+                continue;
+            for (int k = 0; k <= extra; k++)
+                flac_bits(af, 8);
+        }
+
+        if (bscode == 1)
+            blocksize = 192;
+        else if (bscode <= 5)
+            blocksize = 576u << (bscode - 2);
+        else if (bscode == 6)
+            blocksize = flac_bits(af, 8) + 1;
+        else if (bscode == 7)
+            blocksize = flac_bits(af, 16) + 1;
+        else
+            blocksize = 256u << (bscode - 8);
+
+        if (srcode == 12)
+            flac_bits(af, 8);
+        else if (srcode == 13 || srcode == 14)
+            flac_bits(af, 16);
+
+        {
+            unsigned char crc = fs->crc8;
+            if (flac_bits(af, 8) != crc || fs->eof)
+                continue;
+        }
+
+        bps = sscode ? sample_sizes[sscode] : af->bits;
+        nch = assign < 8 ? assign + 1 : 2;
+        if (bps > 24 || blocksize > fs->max_block || nch != af->channels)
+            continue;
+
+        for (unsigned int ch = 0; ch < nch && ok; ch++) {
+            unsigned int sbps = bps;
+            if ((assign == 8 && ch == 1) || (assign == 9 && ch == 0) ||
+                (assign == 10 && ch == 1))
+                sbps++;
+            int32_t *dst = ch < 2 ? fs->chan[ch] : fs->scratch;
+            if (flac_subframe(af, dst, blocksize, sbps) || fs->eof)
+                ok = 0;
+        }
+        if (!ok)
+            continue;
+
+        /* footer, byte aligned */
+        fs->bits = 0;
+        {
+            unsigned short crc = fs->crc16;
+            if (flac_bits(af, 16) != crc)
+                fprintf(stderr, "flac: frame CRC mismatch\n");
+        }
+
+        {
+            int32_t *l = fs->chan[0], *r = fs->chan[1];
+            float scale = 1.0f / (float)(1u << (bps - 1));
+            for (unsigned int i = 0; i < blocksize; i++) {
+                int32_t v;
+                switch (assign) {
+                case 9:                 /* side/right */
+                    v = l[i] + r[i];
+                    break;
+                case 10:                /* mid/side */
+                    v = (int32_t)((((int64_t)l[i] << 1) | (r[i] & 1)) + r[i]) >> 1;
+                    break;
+                default:                /* independent, left/side */
+                    v = l[i];
+                    break;
+                }
+                af->block[i] = v * scale;
+            }
+        }
+        return blocksize;
+    }
+}
+
+static int flac_open(struct audio_file *af)
+{
+    unsigned char hdr[34];
+    struct flac_state *fs = &af->flac;
+    int last = 0, have_info = 0;
+
+    if (fread(hdr, 1, 4, af->fp) != 4)
+        return 0;
+    /* tolerate an ID3v2 tag in front of the stream */
+    if (!memcmp(hdr, "ID3", 3)) {
+        unsigned char id3[6];
+        if (fread(id3, 1, 6, af->fp) != 6)
+            return 0;
+        uint32_t size = (id3[2] & 0x7f) << 21 | (id3[3] & 0x7f) << 14 |
+                        (id3[4] & 0x7f) << 7 | (id3[5] & 0x7f);
+        if (skip_bytes(af->fp, size) || fread(hdr, 1, 4, af->fp) != 4)
+            return 0;
+    }
+    if (memcmp(hdr, "fLaC", 4))
+        return 0;
+
+    while (!last) {
+        uint32_t len;
+        if (fread(hdr, 1, 4, af->fp) != 4)
+            return 0;
+        last = hdr[0] & 0x80;
+        len = (uint32_t)hdr[1] << 16 | hdr[2] << 8 | hdr[3];
+        if ((hdr[0] & 0x7f) == 0 && len >= 34) {
+            if (fread(hdr, 1, 34, af->fp) != 34 || skip_bytes(af->fp, len - 34))
+                return 0;
+            fs->max_block = (uint32_t)hdr[2] << 8 | hdr[3];
+            af->rate = (uint32_t)hdr[10] << 12 | hdr[11] << 4 | hdr[12] >> 4;
+            af->channels = ((hdr[12] >> 1) & 7) + 1;
+            af->bits = (((hdr[12] & 1) << 4) | hdr[13] >> 4) + 1;
+            af->frames = (uint64_t)(hdr[13] & 15) << 32 | be32(hdr + 14);
+            have_info = 1;
+        } else if (skip_bytes(af->fp, len)) {
+            return 0;
+        }
+    }
+    if (!have_info || !af->rate || af->bits > 24 || af->channels > FLAC_MAX_CHANNELS)
+        return 0;
+    if (fs->max_block < 16 || fs->max_block > FLAC_MAX_BLOCK)
+        fs->max_block = FLAC_MAX_BLOCK;
+
+    fs->chan[0] = malloc(fs->max_block * sizeof(int32_t));
+    fs->chan[1] = malloc(fs->max_block * sizeof(int32_t));
+    fs->scratch = malloc(fs->max_block * sizeof(int32_t));
+    af->block = malloc(fs->max_block * sizeof(float));
+    return fs->chan[0] && fs->chan[1] && fs->scratch && af->block;
+}
+
+static unsigned int flac_decode(struct audio_file *af, float *out, unsigned int n)
+{
+    if (af->block_pos >= af->block_len) {
+        af->block_len = flac_frame(af);
+        af->block_pos = 0;
+        if (!af->block_len)
+            return 0;
+    }
+    if (n > af->block_len - af->block_pos)
+        n = af->block_len - af->block_pos;
+    memcpy(out, af->block + af->block_pos, n * sizeof(out[0]));
+    af->block_pos += n;
+    return n;
+}
+
+/* ---------------------------------------------------------------------- */
+
+struct audio_file *audio_open(const char *fname, const char *type)
+{
+    struct audio_file *af;
+    int ok;
+
+    if (!audio_native_type(type))
+        return NULL;
+    if (!(af = calloc(1, sizeof(*af)))) {
+        perror("calloc");
+        exit(10);
+    }
+    if (!(af->fp = fopen(fname, "rb"))) {
+        perror("open");
+        exit(10);
+    }
+
+    if (!strcmp(type, "wav")) {
+        af->format = AF_WAV;
+        ok = wav_open(af);
+    } else if (!strcmp(type, "au")) {
+        af->format = AF_AU;
+        ok = au_open(af);
+    } else {
+        af->format = AF_FLAC;
+        ok = flac_open(af);
+    }
+
+    if (!ok) {
+        audio_close(af);
+        return NULL;
+    }
+    return af;
+}
+
+static unsigned int audio_decode(struct audio_file *af, float *out, unsigned int n)
+{
+    if (af->format == AF_FLAC)
+        return flac_decode(af, out, n);
+    return pcm_decode(af, out, n);
+}
+
+unsigned int audio_read(struct audio_file *af, short *buf, unsigned int n)
+{
+    float tmp[4096];
+    unsigned int cnt = 0;
+
+    while (cnt < n) {
+        unsigned int want = n - cnt < 4096 ? n - cnt : 4096;
+        unsigned int k = audio_decode(af, tmp, want);
+
+        if (!k)
+            break;
+        for (unsigned int i = 0; i < k; i++) {
+            float f = tmp[i] * 32768.0f;
+            buf[cnt++] = f >= 32767.0f ? 32767 : f <= -32768.0f ? -32768 :
+                         (short)(f < 0 ? f - 0.5f : f + 0.5f);
+        }
+    }
+    return cnt;
+}
+
+unsigned int audio_samplerate(const struct audio_file *af)
+{
+    return af->rate;
+}
+
+uint64_t audio_frames(const struct audio_file *af)
+{
+    return af->frames;
+}
+
+/*
+ * BWF dates are local time. The time reference counts samples since
+ * midnight and is more precise than the time of day, which is only used
+ * when the reference is not set.
+ */
+int audio_start_time(const struct audio_file *af, struct timespec *ts)
+{
+    struct tm tm;
+    time_t midnight;
+
+    memset(&tm, 0, sizeof(tm));
+    if (!af->bext_date[0] ||
+        sscanf(af->bext_date, "%4d%*c%2d%*c%2d %2d%*c%2d%*c%2d", &tm.tm_year, &tm.tm_mon,
+               &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6)
+        return 0;
+    tm.tm_year -= 1900;
+    tm.tm_mon--;
+    tm.tm_isdst = -1;
+    if (!af->bext_ref) {
+        ts->tv_sec = mktime(&tm);
+        ts->tv_nsec = 0;
+        return ts->tv_sec != (time_t)-1;
+    }
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    if ((midnight = mktime(&tm)) == (time_t)-1)
+        return 0;
+    ts->tv_sec = midnight + af->bext_ref / af->rate;
+    ts->tv_nsec = (long)(af->bext_ref % af->rate * 1000000000ull / af->rate);
+    return 1;
+}
+
+void audio_close(struct audio_file *af)
+{
+    if (!af)
+        return;
+    if (af->fp)
+        fclose(af->fp);
+    free(af->flac.chan[0]);
+    free(af->flac.chan[1]);
+    free(af->flac.scratch);
+    free(af->block);
+    free(af);
+}
+
+/* ---------------------------------------------------------------------- */
@@ -0,0 +1,62 @@
+/*
+ *      audiofile.h -- built-in readers for common audio file formats
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _AUDIOFILE_H
+#define _AUDIOFILE_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* ---------------------------------------------------------------------- */
+
+struct audio_file;
+
+/* Returns 1 if files of this sox type name can be read without sox */
+int audio_native_type(const char *type);
+
+/*
+ * Open a file of a native type for reading. Returns NULL if the file uses
+ * an encoding the built-in reader does not handle, so the caller can fall
+ * back to sox. Exits if the file cannot be opened.
+ */
+struct audio_file *audio_open(const char *fname, const char *type);
+
+/* Sampling rate of the file, samples are delivered at this rate */
+unsigned int audio_samplerate(const struct audio_file *af);
+
+/* Length of the file in samples, 0 if the header does not say */
+uint64_t audio_frames(const struct audio_file *af);
+
+/* Time of the first sample if the file records it (Broadcast Wave), else 0 */
+int audio_start_time(const struct audio_file *af, struct timespec *ts);
+
+/*
+ * Read up to n mono 16 bit samples. Like the sox pipeline ("remix 1")
+ * only the first channel is used. Returns 0 at EOF.
+ */
+unsigned int audio_read(struct audio_file *af, short *buf, unsigned int n);
+
+void audio_close(struct audio_file *af);
+
+/* ---------------------------------------------------------------------- */
+#endif /* _AUDIOFILE_H */
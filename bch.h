@@ -47,6 +47,9 @@ extern "C" {
 /* Initialize lookup tables (called automatically on first use) */
 void bch_init(void);
 
+/* Most bit errors bch_flex_correct() and bch_pocsag_correct() repair */
+#define BCH_MAX_ERRORS 2
+
 /* ========== FLEX Functions ========== */
 
 /*
@@ -0,0 +1,1249 @@
+/*
+ *      bench.c -- micro-benchmarks for the signal processing kernels
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Every kernel variant is timed on the sizes the demodulators actually
+ * use and compared against the scalar reference, both for speed and for
+ * the result it computes. A mismatch makes the benchmark fail. The
+ * decoders themselves are timed on what the gen-ng generators send, and
+ * must decode it. With -j the results are written as JSON.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "bch.h"
+#include "gen.h"
+#undef COS                      /* gen.h's reads the integer table */
+#include "multimon.h"
+#include "libmultimon.h"
+#include "channelizer.h"
+#include "deinterleave.h"
+#include "filter.h"
+#include "fmdemod.h"
+#include "fskcorr.h"
+#include "goertzel.h"
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define SIGNAL_LEN 4096
+
+static double min_time = 0.2;   /* seconds per measurement */
+static int failed = 0;
+static int json_output = 0;
+static unsigned int reports = 0;
+static volatile float sink;
+
+static float signal_buf[SIGNAL_LEN + 256];
+static float coef_buf[256];
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill_random(float *buf, unsigned int n)
+{
+    for (unsigned int i = 0; i < n; i++)
+        buf[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+static void print_json_string(const char *str)
+{
+    putchar('"');
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            putchar('\\');
+        putchar(*str);
+    }
+    putchar('"');
+}
+
+/*
+ * ns is the time per unit ("call", "sample"), speedups are relative to
+ * base_ns. A base_ns of 0 leaves the speedup out, for rows that time a
+ * different workload rather than a different implementation.
+ */
+static void report(const char *group, const char *label, const char *variant,
+                   const char *unit, double ns, double base_ns)
+{
+    if (json_output) {
+        printf("%s\n    {\"group\": ", reports++ ? "," : "");
+        print_json_string(group);
+        printf(", \"label\": ");
+        print_json_string(label);
+        printf(", \"variant\": ");
+        print_json_string(variant);
+        printf(", \"unit\": ");
+        print_json_string(unit);
+        printf(", \"ns\": %.3f, \"mops\": %.3f", ns, 1e3 / ns);
+        if (base_ns > 0)
+            printf(", \"speedup\": %.3f", base_ns / ns);
+        putchar('}');
+        return;
+    }
+    printf("%-12s %-44s %-8s %10.2f ns/%-6s %9.2f M%s/s",
+           group, label, variant, ns, unit, 1e3 / ns, unit);
+    if (base_ns > 0)
+        printf("  %6.2fx", base_ns / ns);
+    putchar('\n');
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Correlator lengths as used by the demodulators: one bit period at
+ * 22050 Hz for the 1200 baud modems (and two for the 2400 baud ones),
+ * the FSK9600 matched filter and one EAS bit.
+ */
+static const struct {
+    unsigned int len;
+    const char *users;
+} mac_sizes[] = {
+    { 18, "AFSK1200 AFSK2400* CLIPFSK FMSFSK UFSK" },
+    { 24, "FSK9600" },
+    { 42, "EAS" },
+};
+
+static double time_mac(float (*fn)(const float *, const float *, unsigned int),
+                       unsigned int len)
+{
+    unsigned long iters = 1024;
+
+    for (;;) {
+        double start = now_seconds(), secs;
+        float acc = 0;
+        unsigned int pos = 0;
+
+        for (unsigned long it = 0; it < iters; it++) {
+            /* slide along the input like the demodulators do */
+            acc += fn(signal_buf + pos, coef_buf, len);
+            if (++pos >= SIGNAL_LEN)
+                pos = 0;
+        }
+        sink = acc;
+        secs = now_seconds() - start;
+        if (secs >= min_time)
+            return secs / iters * 1e9;
+        iters = secs > min_time / 16 ? (unsigned long)(iters * min_time / secs * 1.1) : iters * 16;
+    }
+}
+
+/* the scalar reference is always last in the table */
+static const struct mac_impl *mac_reference(void)
+{
+    const struct mac_impl *impl = mac_impls;
+
+    while (impl[1].name)
+        impl++;
+    return impl;
+}
+
+static int check_mac(const struct mac_impl *impl, unsigned int len)
+{
+    const struct mac_impl *ref = mac_reference();
+
+    for (unsigned int pos = 0; pos < SIGNAL_LEN; pos += 97) {
+        float want = ref->fn(signal_buf + pos, coef_buf, len);
+        float got = impl->fn(signal_buf + pos, coef_buf, len);
+
+        if (fabsf(got - want) > 1e-5f * len * (1.0f + fabsf(want))) {
+            fprintf(stderr, "mac %s n=%u: got %g, expected %g at offset %u\n",
+                    impl->name, len, got, want, pos);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void bench_mac(void)
+{
+    const struct mac_impl *ref = mac_reference();
+
+    for (unsigned int s = 0; s < sizeof(mac_sizes) / sizeof(mac_sizes[0]); s++) {
+        unsigned int len = mac_sizes[s].len;
+        double base = time_mac(ref->fn, len);
+        char label[64];
+
+        snprintf(label, sizeof(label), "n=%-3u %s", len, mac_sizes[s].users);
+        for (const struct mac_impl *impl = mac_impls; impl->name; impl++) {
+            if (!mac_supported(impl))
+                continue;
+            if (!check_mac(impl, len))
+                failed = 1;
+            report("mac", label, impl->name, "call",
+                   impl == ref ? base : time_mac(impl->fn, len), base);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * FSK front ends: the four direct mac() correlations the demodulators
+ * used to run per step against the sliding DFT in fskcorr.c, on the same
+ * samples. Throughput is per input sample; every decision (sign of mark
+ * minus space power) is compared as well.
+ */
+static const struct {
+    const char *name;
+    struct fskcorr_front front;
+} fsk_fronts[] = {
+    { "AFSK1200 (CLIPFSK, UFSK1200)", { 22050, 18, 2, FSKCORR_RECT, 2, { 1200, 2200 } } },
+    { "FMSFSK", { 22050, 18, 2, FSKCORR_RECT, 2, { 1200, 1800 } } },
+    { "AFSK2400 (Hamming)", { 22050, 18, 1, FSKCORR_HAMMING, 2, { 3970, 2165 } } },
+    { "EAS", { 22050, 42, 2, FSKCORR_RECT, 2, { 2083.3, 1562.5 } } },
+};
+
+#define FSK_SIGNAL_LEN 65536
+
+static float fsk_signal[FSK_SIGNAL_LEN + FSKCORR_MAXLEN];
+
+/* direct correlators, built the way the demodulators used to build them */
+static void fsk_direct_tables(unsigned int f, float tab[4][FSKCORR_MAXLEN])
+{
+    const struct fskcorr_front *fr = &fsk_fronts[f].front;
+
+    for (unsigned int t = 0; t < 2; t++) {
+        float ph = 0;
+        for (unsigned int k = 0; k < fr->len; k++) {
+            float w = fr->window == FSKCORR_HAMMING ?
+                0.54 - 0.46*cos(2*M_PI*k/(float)(fr->len-1)) : 1.0f;
+            tab[2*t][k] = cos(ph);
+            tab[2*t+1][k] = sin(ph);
+            tab[2*t][k] *= w;
+            tab[2*t+1][k] *= w;
+            ph += 2.0*M_PI*fr->freqs[t]/fr->fsamp;
+        }
+    }
+}
+
+static float fsk_direct(const float *win, float tab[4][FSKCORR_MAXLEN], unsigned int len)
+{
+    return fsqr(mac(win, tab[0], len)) + fsqr(mac(win, tab[1], len)) -
+           fsqr(mac(win, tab[2], len)) - fsqr(mac(win, tab[3], len));
+}
+
+/* best pass over the signal, which is less sensitive to other load than the mean */
+static double time_fsk(unsigned int f, int sliding)
+{
+    unsigned int len = fsk_fronts[f].front.len, step = fsk_fronts[f].front.step;
+    float tab[4][FSKCORR_MAXLEN];
+    struct fskcorr_bank bank;
+    double start = now_seconds(), best = 0;
+    unsigned int bits = 0;
+
+    fsk_direct_tables(f, tab);
+    fskcorr_bank_init(&bank, &fsk_fronts[f].front);
+    bank.direct = 0;
+    do {
+        struct fskcorr corr;
+        double t = now_seconds();
+
+        fskcorr_init(&corr, &bank);
+        for (unsigned int p = 0; p < FSK_SIGNAL_LEN; p += step) {
+            float v;
+            if (sliding) {
+                fskcorr_slide(&corr, fsk_signal + p, step);
+                v = fskcorr_mark_space(&corr);
+            } else {
+                v = fsk_direct(fsk_signal + p, tab, len);
+            }
+            bits = bits << 1 | (v > 0);
+        }
+        t = now_seconds() - t;
+        if (best == 0 || t < best)
+            best = t;
+    } while (now_seconds() - start < min_time);
+    sink = bits;
+    return best / FSK_SIGNAL_LEN * 1e9;
+}
+
+/*
+ * Decisions of the sliding DFT may only differ where mark and space power
+ * are equal to float precision; where the bank correlates directly, its
+ * values must be those of the old correlators.
+ */
+static int check_fsk(unsigned int f)
+{
+    unsigned int len = fsk_fronts[f].front.len, step = fsk_fronts[f].front.step;
+    float tab[4][FSKCORR_MAXLEN];
+    struct fskcorr_bank bank, sliding;
+    struct fskcorr auto_corr, corr;
+    unsigned int differ = 0;
+
+    fsk_direct_tables(f, tab);
+    fskcorr_bank_init(&bank, &fsk_fronts[f].front);
+    sliding = bank;
+    sliding.direct = 0;
+    fskcorr_init(&auto_corr, &bank);
+    fskcorr_init(&corr, &sliding);
+    for (unsigned int p = 0; p < FSK_SIGNAL_LEN; p += step) {
+        float want = fsk_direct(fsk_signal + p, tab, len);
+        float got, scale;
+
+        fskcorr_slide(&auto_corr, fsk_signal + p, step);
+        if (bank.direct && fskcorr_mark_space(&auto_corr) != want) {
+            fprintf(stderr, "fskcorr %s: direct %g, expected %g at %u\n",
+                    fsk_fronts[f].name, fskcorr_mark_space(&auto_corr), want, p);
+            return 0;
+        }
+        fskcorr_slide(&corr, fsk_signal + p, step);
+        got = fskcorr_mark_space(&corr);
+        scale = fskcorr_power(&corr, 0) + fskcorr_power(&corr, 1);
+        if (fabsf(got - want) > 1e-4f * scale + 1e-9f) {
+            fprintf(stderr, "fskcorr %s: got %g, expected %g at %u\n",
+                    fsk_fronts[f].name, got, want, p);
+            return 0;
+        }
+        differ += (got > 0) != (want > 0);
+    }
+    if (differ)
+        fprintf(json_output ? stderr : stdout, "%-12s %-44s %u of %u decisions differ (ties)\n",
+                "fskcorr", fsk_fronts[f].name, differ, FSK_SIGNAL_LEN / step);
+    return 1;
+}
+
+/* FSK-ish test signal: random mark/space symbols plus noise */
+static void fsk_fill(void)
+{
+    double ph = 0;
+    unsigned int sym = 0;
+
+    for (unsigned int i = 0; i < sizeof(fsk_signal) / sizeof(fsk_signal[0]); i++) {
+        if (i % 18 == 0)
+            sym = rand() & 1;
+        ph += 2.0 * M_PI * (sym ? 1200 : 2200) / 22050;
+        fsk_signal[i] = 0.5f * sin(ph) + 0.1f * ((float)rand() / RAND_MAX - 0.5f);
+    }
+}
+
+static void bench_fskcorr(void)
+{
+    fsk_fill();
+    for (unsigned int f = 0; f < sizeof(fsk_fronts) / sizeof(fsk_fronts[0]); f++) {
+        const char *kernel = mac_selected();
+        double base = time_fsk(f, 0), scalar;
+
+        if (!check_fsk(f))
+            failed = 1;
+        /* the direct correlation on CPUs without a vector mac() kernel */
+        mac_select("scalar");
+        scalar = time_fsk(f, 0);
+        mac_select(kernel);
+
+        report("fskcorr", fsk_fronts[f].name, kernel, "sample", base, base);
+        report("fskcorr", fsk_fronts[f].name, "scalar", "sample", scalar, base);
+        report("fskcorr", fsk_fronts[f].name, "sliding", "sample", time_fsk(f, 1), base);
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * DTMF tone detection: the quadrature oscillators the decoder used to
+ * run against the Goertzel bank, for one channel and for DTMF_CHANNELS
+ * channels filtered together. Throughput is per sample and channel; the
+ * 10ms block records are compared, the oscillators being accurate to
+ * their cosine table.
+ */
+#define DTMF_RATE     22050
+#define DTMF_BLOCKLEN (DTMF_RATE/100)
+#define DTMF_LEN      32768
+#define DTMF_CHANNELS 8
+#define DTMF_RECLEN   17
+#define DTMF_MAXREC   (DTMF_LEN / (DTMF_BLOCKLEN + 1) + 1)
+
+extern const float costabf[0x400];
+#define COS(x) costabf[(((x)>>6)&0x3ffu)]
+#define SIN(x) COS((x)+0xc000)
+#define PHINC(x) ((x)*0x10000/DTMF_RATE)
+
+static const unsigned int dtmf_phinc[8] = {
+    PHINC(1209), PHINC(1336), PHINC(1477), PHINC(1633),
+    PHINC(697), PHINC(770), PHINC(852), PHINC(941)
+};
+
+static float dtmf_signal[DTMF_CHANNELS][DTMF_LEN];
+static float dtmf_rec[DTMF_CHANNELS][DTMF_MAXREC * DTMF_RECLEN];
+
+/* the per sample loop of the old decoder, returns the number of records */
+static unsigned int dtmf_oscillators(const float *x, float *out)
+{
+    unsigned int ph[8] = { 0 }, n = 0;
+    float rec[DTMF_RECLEN] = { 0 };
+    int blkcount = 0;
+
+    for (unsigned int p = 0; p < DTMF_LEN; p++) {
+        rec[0] += x[p] * x[p];
+        for (unsigned int i = 0; i < 8; i++) {
+            rec[1 + i] += COS(ph[i]) * x[p];
+            rec[9 + i] += SIN(ph[i]) * x[p];
+            ph[i] += dtmf_phinc[i];
+        }
+        if ((blkcount--) <= 0) {
+            blkcount = DTMF_BLOCKLEN;
+            memcpy(out + n++ * DTMF_RECLEN, rec, sizeof(rec));
+            memset(rec, 0, sizeof(rec));
+        }
+    }
+    return n;
+}
+
+static unsigned int dtmf_goertzel(unsigned int nch)
+{
+    struct goertzel_bank bank[DTMF_CHANNELS], *b[DTMF_CHANNELS];
+    const float *in[DTMF_CHANNELS];
+    unsigned int c, n = 0;
+
+    for (c = 0; c < nch; c++) {
+        goertzel_init(&bank[c], DTMF_BLOCKLEN);
+        for (unsigned int i = 0; i < 8; i++)
+            goertzel_add(&bank[c], dtmf_phinc[i]);
+        b[c] = &bank[c];
+        in[c] = dtmf_signal[c];
+    }
+    /* all channels start together, so their blocks end together */
+    for (int left = DTMF_LEN; left > 0; ) {
+        left -= goertzel_feed(b, in, nch, left);
+        for (c = 0; c < nch; c++)
+            if (goertzel_finish(b[c], dtmf_rec[c] + n * DTMF_RECLEN) && c == nch - 1)
+                n++;
+    }
+    return n;
+}
+
+/* best pass, per sample and channel; nch 0 runs the oscillators */
+static double time_dtmf(unsigned int nch)
+{
+    double start = now_seconds(), best = 0;
+
+    do {
+        double t = now_seconds();
+
+        if (nch)
+            dtmf_goertzel(nch);
+        else
+            dtmf_oscillators(dtmf_signal[0], dtmf_rec[0]);
+        t = now_seconds() - t;
+        if (best == 0 || t < best)
+            best = t;
+    } while (now_seconds() - start < min_time);
+    sink = dtmf_rec[0][0];
+    return best / DTMF_LEN / (nch ? nch : 1) * 1e9;
+}
+
+static int check_dtmf(void)
+{
+    static float want[DTMF_MAXREC * DTMF_RECLEN];
+    unsigned int n = dtmf_oscillators(dtmf_signal[DTMF_CHANNELS - 1], want);
+
+    if (dtmf_goertzel(DTMF_CHANNELS) != n) {
+        fprintf(stderr, "goertzel: block count differs\n");
+        return 0;
+    }
+    for (unsigned int r = 0; r < n * DTMF_RECLEN; r += DTMF_RECLEN) {
+        for (unsigned int i = 1; i < DTMF_RECLEN; i++) {
+            float got = dtmf_rec[DTMF_CHANNELS - 1][r + i];
+            /* the cosine table is good to about 2^-8 of the block energy's root */
+            if (fabsf(got - want[r + i]) > 4e-3f * sqrtf(want[r] * (DTMF_BLOCKLEN + 1)) + 1e-6f) {
+                fprintf(stderr, "goertzel: got %g, expected %g in block %u\n",
+                        got, want[r + i], r / DTMF_RECLEN);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void bench_goertzel(void)
+{
+    double base;
+    char label[64];
+
+    /* a tone pair per channel plus noise */
+    for (unsigned int c = 0; c < DTMF_CHANNELS; c++) {
+        double f1 = 697 + 80 * (c & 3), f2 = 1209 + 130 * (c >> 1 & 3);
+        for (unsigned int p = 0; p < DTMF_LEN; p++)
+            dtmf_signal[c][p] = 0.3f * sin(2 * M_PI * f1 * p / DTMF_RATE) +
+                                0.3f * sin(2 * M_PI * f2 * p / DTMF_RATE) +
+                                0.1f * ((float)rand() / RAND_MAX - 0.5f);
+    }
+    if (!check_dtmf())
+        failed = 1;
+    base = time_dtmf(0);
+    report("goertzel", "DTMF 8 tones", "osc", "sample", base, base);
+    report("goertzel", "DTMF 8 tones", "block", "sample", time_dtmf(1), base);
+    snprintf(label, sizeof(label), "DTMF 8 tones, %u channels", DTMF_CHANNELS);
+    report("goertzel", label, "block", "sample", time_dtmf(DTMF_CHANNELS), base);
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * POCSAG sync search: without sync, every received bit completes a new
+ * 32 bit word that is checked for a sync word in either polarity. The
+ * decoder used to run the BCH repair on both; now a Hamming distance
+ * test with one popcount comes first. The bit stream is noise with sync
+ * words carrying up to three bit errors, and both searches must find
+ * sync at the same bits.
+ */
+#define POCSAG_SYNC 0x7cd215d8
+#define SYNC_BITS   (1 << 20)
+
+static unsigned char sync_stream[SYNC_BITS];
+
+static int sync_bch(uint32_t word)
+{
+    uint32_t w = word;
+
+    bch_pocsag_correct(&w);
+    if (w == POCSAG_SYNC)
+        return 1;
+    w = ~word;
+    bch_pocsag_correct(&w);
+    return w == POCSAG_SYNC;
+}
+
+static int sync_popcount(uint32_t word)
+{
+    int distance = __builtin_popcount(word ^ POCSAG_SYNC);
+
+    if (distance <= BCH_MAX_ERRORS) {
+        uint32_t w = word;
+        bch_pocsag_correct(&w);
+        if (w == POCSAG_SYNC)
+            return 1;
+    }
+    if (32 - distance <= BCH_MAX_ERRORS) {
+        uint32_t w = ~word;
+        bch_pocsag_correct(&w);
+        return w == POCSAG_SYNC;
+    }
+    return 0;
+}
+
+/* best pass, per bit; returns the syncs found through *found */
+static double time_sync(int (*search)(uint32_t), unsigned int *found)
+{
+    double start = now_seconds(), best = 0;
+
+    do {
+        double t = now_seconds();
+        uint32_t word = 0;
+        unsigned int n = 0;
+
+        for (unsigned int i = 0; i < SYNC_BITS; i++) {
+            word = word << 1 | sync_stream[i];
+            n += search(word);
+        }
+        t = now_seconds() - t;
+        if (best == 0 || t < best)
+            best = t;
+        *found = n;
+    } while (now_seconds() - start < min_time);
+    return best / SYNC_BITS * 1e9;
+}
+
+static int check_sync(void)
+{
+    uint32_t word = 0;
+
+    for (unsigned int i = 0; i < SYNC_BITS; i++) {
+        word = word << 1 | sync_stream[i];
+        if (sync_bch(word) != sync_popcount(word)) {
+            fprintf(stderr, "pocsag: sync searches disagree on %08x at bit %u\n", word, i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void bench_pocsag(void)
+{
+    unsigned int found_bch, found_pop;
+    double base;
+
+    bch_init();
+    for (unsigned int i = 0; i < SYNC_BITS; i++)
+        sync_stream[i] = rand() & 1;
+    /* a sync word every 544 bits, like one per batch */
+    for (unsigned int p = 0; p + 32 <= SYNC_BITS; p += 544) {
+        uint32_t sync = POCSAG_SYNC;
+        for (unsigned int e = 0; e < p / 544 % 4; e++)
+            sync ^= 1u << (rand() & 31);
+        if (p / 544 % 8 >= 4)
+            sync = ~sync;
+        for (unsigned int b = 0; b < 32; b++)
+            sync_stream[p + b] = sync >> (31 - b) & 1;
+    }
+    if (!check_sync())
+        failed = 1;
+    base = time_sync(sync_bch, &found_bch);
+    report("pocsag", "sync search", "bch", "bit", base, base);
+    report("pocsag", "sync search", "popcount", "bit", time_sync(sync_popcount, &found_pop), base);
+    if (found_bch != found_pop)
+        failed = 1;
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Multichannel raw input: a block of interleaved frames, as the library
+ * takes them apart before feeding each channel's demodulators. The
+ * dispatching version must give the same samples as the strided copy.
+ */
+#define DEINT_FRAMES   8192
+#define DEINT_CHANNELS 32
+
+static short deint_in[DEINT_FRAMES * DEINT_CHANNELS];
+static short deint_out[2][DEINT_CHANNELS][DEINT_FRAMES + 32];  /* rows padded as in the library */
+
+static double time_deinterleave(void (*fn)(short *const *, const short *, unsigned int, size_t),
+                                unsigned int nch)
+{
+    short *out[DEINT_CHANNELS];
+    unsigned long iters = 16;
+
+    for (unsigned int c = 0; c < nch; c++)
+        out[c] = deint_out[0][c];
+    for (;;) {
+        double start = now_seconds(), secs;
+
+        for (unsigned long it = 0; it < iters; it++)
+            fn(out, deint_in, nch, DEINT_FRAMES);
+        sink = out[nch - 1][DEINT_FRAMES - 1];
+        secs = now_seconds() - start;
+        if (secs >= min_time)
+            return secs / ((double)iters * DEINT_FRAMES * nch) * 1e9;
+        iters = secs > min_time / 16 ? (unsigned long)(iters * min_time / secs * 1.1) : iters * 16;
+    }
+}
+
+static int check_deinterleave(unsigned int nch)
+{
+    short *ref[DEINT_CHANNELS], *out[DEINT_CHANNELS];
+
+    for (unsigned int c = 0; c < nch; c++) {
+        ref[c] = deint_out[0][c];
+        out[c] = deint_out[1][c];
+    }
+    /* an odd length leaves frames outside the transposed tiles */
+    deinterleave_s16_scalar(ref, deint_in, nch, DEINT_FRAMES - 3);
+    deinterleave_s16(out, deint_in, nch, DEINT_FRAMES - 3);
+    for (unsigned int c = 0; c < nch; c++)
+        if (memcmp(ref[c], out[c], (DEINT_FRAMES - 3) * sizeof(out[c][0]))) {
+            fprintf(stderr, "deinterleave: channel %u of %u differs\n", c, nch);
+            return 0;
+        }
+    return 1;
+}
+
+static void bench_deinterleave(void)
+{
+    static const unsigned int nchs[] = { 2, 4, 6, 8, 16, 32 };
+    char label[64];
+
+    for (unsigned int i = 0; i < DEINT_FRAMES * DEINT_CHANNELS; i++)
+        deint_in[i] = rand();
+    for (unsigned int k = 0; k < sizeof(nchs) / sizeof(nchs[0]); k++) {
+        double base;
+
+        if (!check_deinterleave(nchs[k]))
+            failed = 1;
+        snprintf(label, sizeof(label), "16 bit, %u channels", nchs[k]);
+        base = time_deinterleave(deinterleave_s16_scalar, nchs[k]);
+        report("deinterleave", label, "strided", "sample", base, base);
+        report("deinterleave", label, "dispatch", "sample", time_deinterleave(deinterleave_s16, nchs[k]), base);
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * IQ input: the discriminator on its own, against atan2f() from libm,
+ * and the whole chain of decimating resamplers and discriminator from
+ * typical receiver rates down to the demodulators' rate. The polynomial
+ * atan2 has to stay within 1e-4 rad of libm.
+ */
+#define FM_LEN 4096
+
+static float fm_i[FM_LEN], fm_q[FM_LEN], fm_out[FM_LEN];
+
+static double time_discriminator(void (*fn)(float *, const float *, const float *, size_t,
+                                            float *, float))
+{
+    unsigned long iters = 64;
+    float last[2] = { 1, 0 };
+
+    for (;;) {
+        double start = now_seconds(), secs;
+
+        for (unsigned long it = 0; it < iters; it++)
+            fn(fm_out, fm_i, fm_q, FM_LEN, last, 1.0f);
+        sink = fm_out[FM_LEN - 1];
+        secs = now_seconds() - start;
+        if (secs >= min_time)
+            return secs / ((double)iters * FM_LEN) * 1e9;
+        iters = secs > min_time / 16 ? (unsigned long)(iters * min_time / secs * 1.1) : iters * 16;
+    }
+}
+
+static int check_discriminator(void)
+{
+    static float ref[FM_LEN];
+    float last[2] = { 1, 0 }, last_ref[2] = { 1, 0 };
+    double worst = 0;
+
+    /* an odd length leaves samples for the scalar tail */
+    fm_discriminate_libm(ref, fm_i, fm_q, FM_LEN - 3, last_ref, 1.0f);
+    fm_discriminate(fm_out, fm_i, fm_q, FM_LEN - 3, last, 1.0f);
+    for (unsigned int k = 0; k < FM_LEN - 3; k++) {
+        double d = fabs(fm_out[k] - ref[k]);
+        if (d > M_PI)
+            d = 2 * M_PI - d;
+        if (d > worst)
+            worst = d;
+    }
+    if (worst > 1e-4) {
+        fprintf(stderr, "fm_discriminate: %g rad off libm\n", worst);
+        return 0;
+    }
+    return 1;
+}
+
+static double time_fm_demod(unsigned int rate)
+{
+    struct fm_demod *fm = fm_demod_new(rate, 22050, 5000);
+    unsigned long iters = 16;
+
+    if (!fm) {
+        perror("fm_demod_new");
+        exit(1);
+    }
+    for (;;) {
+        double start = now_seconds(), secs;
+
+        for (unsigned long it = 0; it < iters; it++) {
+            fm_demod_write(fm, fm_i, fm_q, FM_LEN);
+            while (fm_demod_read(fm, fm_out, FM_LEN))
+                ;
+        }
+        sink = fm_out[0];
+        secs = now_seconds() - start;
+        if (secs >= min_time) {
+            fm_demod_free(fm);
+            return secs / ((double)iters * FM_LEN) * 1e9;
+        }
+        iters = secs > min_time / 16 ? (unsigned long)(iters * min_time / secs * 1.1) : iters * 16;
+    }
+}
+
+static void bench_fmdemod(void)
+{
+    static const unsigned int rates[] = { 240000, 1024000, 2400000 };
+    char label[64];
+    double base;
+
+    fill_random(fm_i, FM_LEN);
+    fill_random(fm_q, FM_LEN);
+    if (!check_discriminator())
+        failed = 1;
+    base = time_discriminator(fm_discriminate_libm);
+    report("fmdemod", "discriminator", "libm", "sample", base, base);
+    report("fmdemod", "discriminator", "poly", "sample", time_discriminator(fm_discriminate), base);
+    for (unsigned int k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        double ns = time_fm_demod(rates[k]);
+        snprintf(label, sizeof(label), "IQ %u Hz to 22050 Hz", rates[k]);
+        report("fmdemod", label, "chain", "sample", ns, ns);
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Cutting channels out of a wideband IQ stream: the filter bank and the
+ * per-channel demodulators against a full rate FM chain per channel.
+ */
+static double time_channelizer(unsigned int rate, unsigned int nch)
+{
+    double freqs[64];
+    struct channelizer *cz;
+    unsigned long iters = 4;
+
+    for (unsigned int c = 0; c < nch; c++)
+        freqs[c] = (c + 0.5) * rate / nch - rate / 2.0;
+    if (!(cz = channelizer_new(rate, 22050, freqs, nch, 5000))) {
+        perror("channelizer_new");
+        exit(1);
+    }
+    for (;;) {
+        double start = now_seconds(), secs;
+
+        for (unsigned long it = 0; it < iters; it++) {
+            channelizer_write(cz, fm_i, fm_q, FM_LEN);
+            for (unsigned int c = 0; c < nch; c++)
+                while (channelizer_read(cz, c, fm_out, FM_LEN))
+                    ;
+        }
+        sink = fm_out[0];
+        secs = now_seconds() - start;
+        if (secs >= min_time) {
+            channelizer_free(cz);
+            return secs / ((double)iters * FM_LEN) * 1e9;
+        }
+        iters = secs > min_time / 16 ? (unsigned long)(iters * min_time / secs * 1.1) : iters * 16;
+    }
+}
+
+static void bench_channelizer(void)
+{
+    static const unsigned int nchs[] = { 1, 8, 64 };
+    double chain;
+    char label[64];
+
+    fill_random(fm_i, FM_LEN);
+    fill_random(fm_q, FM_LEN);
+    chain = time_fm_demod(2400000);
+    for (unsigned int k = 0; k < sizeof(nchs) / sizeof(nchs[0]); k++) {
+        snprintf(label, sizeof(label), "IQ 2400000 Hz, %u channel%s", nchs[k], nchs[k] == 1 ? "" : "s");
+        report("channelizer", label, "chain", "sample", nchs[k] * chain, nchs[k] * chain);
+        report("channelizer", label, "pfb", "sample", time_channelizer(2400000, nchs[k]), nchs[k] * chain);
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * BCH(31,21) correction of POCSAG and FLEX codewords with no, one and
+ * two bit errors, which is what the decoders run on every codeword. The
+ * data must come back unchanged.
+ */
+#define BCH_WORDS 4096
+
+static unsigned int bch_data[BCH_WORDS];
+static unsigned int bch_words[BCH_MAX_ERRORS + 1][BCH_WORDS];
+
+static void bch_fill(unsigned int (*encode)(unsigned int), unsigned int first, unsigned int bits)
+{
+    for (unsigned int w = 0; w < BCH_WORDS; w++) {
+        unsigned int word;
+
+        bch_data[w] = rand() & 0x1fffff;
+        word = encode(bch_data[w]);
+        for (unsigned int e = 0; e <= BCH_MAX_ERRORS; e++) {
+            bch_words[e][w] = word;
+            /* e different bits */
+            for (unsigned int k = 0; k < e; ) {
+                unsigned int bit = 1u << (first + rand() % bits);
+                if ((bch_words[e][w] ^ word) & bit)
+                    continue;
+                bch_words[e][w] ^= bit;
+                k++;
+            }
+        }
+    }
+}
+
+static double time_bch(int (*correct)(unsigned int *), const unsigned int *words)
+{
+    double start = now_seconds(), best = 0;
+
+    do {
+        double t = now_seconds();
+        int acc = 0;
+
+        for (unsigned int w = 0; w < BCH_WORDS; w++) {
+            unsigned int word = words[w];
+            acc += correct(&word);
+        }
+        sink = acc;
+        t = now_seconds() - t;
+        if (best == 0 || t < best)
+            best = t;
+    } while (now_seconds() - start < min_time);
+    return best / BCH_WORDS * 1e9;
+}
+
+/* data_shift locates the 21 data bits in the codeword */
+static int check_bch(const char *name, int (*correct)(unsigned int *), unsigned int data_shift)
+{
+    for (unsigned int e = 0; e <= BCH_MAX_ERRORS; e++)
+        for (unsigned int w = 0; w < BCH_WORDS; w++) {
+            unsigned int word = bch_words[e][w];
+            int got = correct(&word);
+
+            if (got != (int)e || (word >> data_shift & 0x1fffff) != bch_data[w]) {
+                fprintf(stderr, "%s: word %u with %u errors: returned %d, data %06x, expected %06x\n",
+                        name, w, e, got, word >> data_shift & 0x1fffff, bch_data[w]);
+                return 0;
+            }
+        }
+    return 1;
+}
+
+static void bench_bch(void)
+{
+    static const char *const label[] = { "0 errors", "1 error", "2 errors" };
+
+    bch_init();
+    /* the POCSAG parity bit is not covered by the code */
+    bch_fill(bch_pocsag_encode, 1, 31);
+    if (!check_bch("bch_pocsag_correct", bch_pocsag_correct, 11))
+        failed = 1;
+    for (unsigned int e = 0; e <= BCH_MAX_ERRORS; e++)
+        report("bch", "bch_pocsag_correct POCSAG", label[e], "call",
+               time_bch(bch_pocsag_correct, bch_words[e]), 0);
+
+    bch_fill(bch_flex_encode, 0, 31);
+    if (!check_bch("bch_flex_correct", bch_flex_correct, 0))
+        failed = 1;
+    for (unsigned int e = 0; e <= BCH_MAX_ERRORS; e++)
+        report("bch", "bch_flex_correct FLEX", label[e], "call",
+               time_bch(bch_flex_correct, bch_words[e]), 0);
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * The decoders on what gen-ng sends: the bit level of the AX.25 and
+ * POCSAG decoders fed the generators' bit streams, and the DTMF, selcall
+ * and FLEX demodulators fed their audio, with a second of silence after
+ * it. Each runs in a context of its own, as multimon-ng would run it,
+ * and every pass over the signal has to decode what was sent.
+ */
+#define DECODE_LEN (6 * SAMPLE_RATE)
+#define DECODE_BITS 16384
+
+static const char *decode_want;     /* text every decoded message contains */
+static unsigned int decode_count;   /* messages seen containing it */
+
+static void decode_output(void *arg, const struct multimon_message *msg)
+{
+    char line[512];
+
+    (void)arg;
+    snprintf(line, sizeof(line), "%.*s", (int)msg->len, msg->text);
+    if (strstr(line, decode_want))
+        decode_count++;
+}
+
+static struct multimon *decode_context(const char *demod, const char *want)
+{
+    const char *demods[] = { demod, NULL };
+    struct multimon_config cfg;
+    struct multimon *m;
+
+    multimon_config_init(&cfg);
+    cfg.demods = demods;
+    cfg.output = decode_output;
+    if (!(m = multimon_create(&cfg)))
+        exit(10);
+    decode_want = want;
+    decode_count = 0;
+    return m;
+}
+
+/* what one generator sends, then silence */
+static unsigned int gen_audio(void (*init)(struct gen_params *, struct gen_state *),
+                              int (*gen)(signed short *, int, struct gen_params *, struct gen_state *),
+                              struct gen_params *p, short *out, unsigned int max)
+{
+    struct gen_state st;
+    unsigned int n = 0;
+    int got;
+
+    memset(out, 0, max * sizeof(out[0]));
+    init(p, &st);
+    while (n < max && (got = gen(out + n, max - n, p, &st)) > 0)
+        n += got;
+    return n + SAMPLE_RATE < max ? n + SAMPLE_RATE : max;
+}
+
+struct decode_job {
+    const unsigned char *bits;
+    const float *f;
+    const short *s;
+    unsigned int len;
+    void (*rxbit)(struct demod_state *s, int bit);
+};
+
+static void decode_bits(struct demod_state *s, void *arg)
+{
+    const struct decode_job *job = arg;
+
+    for (unsigned int i = 0; i < job->len; i++)
+        job->rxbit(s, job->bits[i]);
+}
+
+static void decode_samples(struct demod_state *s, void *arg)
+{
+    const struct decode_job *job = arg;
+    buffer_t buffer = { job->s, job->f, NULL, NULL, 0 };
+
+    s->dem_par->demod(s, buffer, job->len);
+}
+
+static void hdlc_bit(struct demod_state *s, int bit)
+{
+    hdlc_rxbit(s, bit);
+}
+
+/* the slicer hands over sample > 0, a 1 bit being sent as a negative level */
+static void pocsag_bit(struct demod_state *s, int bit)
+{
+    pocsag_rxbit(s, !bit);
+}
+
+/*
+ * DTMF on DECODE_CHANNELS interleaved channels pushed into one context,
+ * which decodes them in one call per block: best pass per sample and
+ * channel, every pass must decode want digits on every channel.
+ */
+#define DECODE_CHANNELS 8
+
+static double time_dtmf_channels(const short *sbuf, unsigned int len, unsigned int want)
+{
+    static short frames[DECODE_LEN * DECODE_CHANNELS];
+    const char *demods[] = { "DTMF", NULL };
+    struct multimon_config cfg;
+    struct multimon *m;
+    double start, best = 0;
+    unsigned int passes = 0;
+
+    for (unsigned int i = 0; i < len; i++)
+        for (unsigned int c = 0; c < DECODE_CHANNELS; c++)
+            frames[i * DECODE_CHANNELS + c] = sbuf[i];
+    multimon_config_init(&cfg);
+    cfg.demods = demods;
+    cfg.channels = DECODE_CHANNELS;
+    cfg.output = decode_output;
+    if (!(m = multimon_create(&cfg)))
+        exit(10);
+    decode_want = "DTMF: ";
+    decode_count = 0;
+    start = now_seconds();
+    do {
+        double t = now_seconds();
+
+        multimon_push_samples(m, frames, len);
+        t = now_seconds() - t;
+        if (best == 0 || t < best)
+            best = t;
+        passes++;
+    } while (now_seconds() - start < min_time);
+    multimon_destroy(m);
+    if (decode_count != passes * want * DECODE_CHANNELS) {
+        fprintf(stderr, "DTMF: decoded %u digits on %u channels in %u passes, expected %u\n",
+                decode_count, DECODE_CHANNELS, passes, passes * want * DECODE_CHANNELS);
+        failed = 1;
+    }
+    return best / ((double)len * DECODE_CHANNELS) * 1e9;
+}
+
+/* best pass per bit or sample, every pass must decode want messages */
+static double time_decode(const char *demod, const char *text, unsigned int want,
+                          void (*fn)(struct demod_state *, void *), struct decode_job *job)
+{
+    struct multimon *m = decode_context(demod, text);
+    double start = now_seconds(), best = 0;
+    unsigned int passes = 0;
+
+    do {
+        double t = now_seconds();
+
+        multimon_call(m, 0, fn, job);
+        t = now_seconds() - t;
+        if (best == 0 || t < best)
+            best = t;
+        passes++;
+    } while (now_seconds() - start < min_time);
+    multimon_destroy(m);
+    if (decode_count != passes * want) {
+        fprintf(stderr, "%s: decoded \"%s\" %u times in %u passes, expected %u\n",
+                demod, text, decode_count, passes, passes * want);
+        failed = 1;
+    }
+    return best / job->len * 1e9;
+}
+
+static void bench_decoders(void)
+{
+    static short sbuf[DECODE_LEN];
+    static float fbuf[DECODE_LEN];
+    static unsigned char bits[DECODE_BITS];
+    struct decode_job job = { bits, fbuf, sbuf, 0, NULL };
+    struct gen_params p;
+    struct gen_state st;
+    double ns;
+
+    /* AX.25 frames back to back, their bits stuffed as sent (NRZI undone) */
+    memset(&p, 0, sizeof(p));
+    p.p.hdlc.txdelay = 10;
+    memcpy(p.p.hdlc.pkt, "\x90\x84\x72\x94\x9c\xb0\x00\x82\x8a\x68\xae\x82\x40\x01\x03\xf0", 16);
+    strcpy((char *)p.p.hdlc.pkt + 16, "Bench frame");
+    p.p.hdlc.pktlen = 16 + strlen("Bench frame");
+    gen_init_hdlc(&p, &st);
+    job.len = 0;
+    while (job.len + st.s.hdlc.datalen * 8 <= DECODE_BITS)
+        for (unsigned int i = 0; i < st.s.hdlc.datalen * 8; i++)
+            bits[job.len++] = st.s.hdlc.data[i / 8] >> (i % 8) & 1;
+    job.rxbit = hdlc_bit;
+    ns = time_decode("AFSK1200", "Bench frame", DECODE_BITS / (st.s.hdlc.datalen * 8),
+                     decode_bits, &job);
+    report("decoders", "hdlc_rxbit AX.25 UI frames", "AFSK1200", "bit", ns, ns);
+
+    /* one alphanumeric page: preamble, sync and codewords */
+    memset(&p, 0, sizeof(p));
+    p.p.pocsag.address = 1234567;
+    p.p.pocsag.function = 3;
+    p.p.pocsag.baud = 1200;
+    strcpy(p.p.pocsag.message, "Bench page for the POCSAG bit level decoder");
+    gen_init_pocsag(&p, &st);
+    job.len = st.s.pocsag.datalen * 8;
+    for (unsigned int i = 0; i < job.len; i++)
+        bits[i] = st.s.pocsag.data[i / 8] >> (7 - i % 8) & 1;
+    job.rxbit = pocsag_bit;
+    ns = time_decode("POCSAG1200", "Bench page", 1, decode_bits, &job);
+    report("decoders", "pocsag_rxbit alphanumeric page", "POCSAG", "bit", ns, ns);
+
+    /* the demodulators on audio */
+    memset(&p, 0, sizeof(p));
+    p.ampl = 16384;
+    p.p.dtmf.duration = MS(100);
+    p.p.dtmf.pause = MS(100);
+    strcpy(p.p.dtmf.str, "0123456789ABCD*#");
+    job.len = gen_audio(gen_init_dtmf, gen_dtmf, &p, sbuf, DECODE_LEN);
+    for (unsigned int i = 0; i < job.len; i++)
+        fbuf[i] = sbuf[i] * (1.0f/32768.0f);
+    ns = time_decode("DTMF", "DTMF: ", 16, decode_samples, &job);
+    report("decoders", "dtmf_demod 16 digits", "DTMF", "sample", ns, ns);
+    report("decoders", "dtmf_demod_channels 16 digits, 8 channels", "DTMF", "sample",
+           time_dtmf_channels(sbuf, job.len, 16), ns);
+
+    memset(&p, 0, sizeof(p));
+    p.ampl = 16384;
+    p.p.zvei.duration = MS(70);
+    p.p.zvei.pause = MS(0);
+    strcpy(p.p.zvei.str, "12345");
+    job.len = gen_audio(gen_init_zvei, gen_zvei, &p, sbuf, DECODE_LEN);
+    for (unsigned int i = 0; i < job.len; i++)
+        fbuf[i] = sbuf[i] * (1.0f/32768.0f);
+    ns = time_decode("ZVEI1", "ZVEI1: 12345", 1, decode_samples, &job);
+    report("decoders", "selcall_demod 5 tone sequence", "ZVEI1", "sample", ns, ns);
+
+    memset(&p, 0, sizeof(p));
+    p.ampl = 16384;
+    p.p.flex.capcode = 1234567;
+    strcpy(p.p.flex.message, "Bench message for Flex_Demodulate");
+    job.len = gen_audio(gen_init_flex, gen_flex, &p, sbuf, DECODE_LEN);
+    for (unsigned int i = 0; i < job.len; i++)
+        fbuf[i] = sbuf[i] * (1.0f/32768.0f);
+    ns = time_decode("FLEX", "Bench message", 1, decode_samples, &job);
+    report("decoders", "Flex_Demodulate one frame", "FLEX", "sample", ns, ns);
+}
+
+/* ---------------------------------------------------------------------- */
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} benches[] = {
+    { "mac", bench_mac },
+    { "fskcorr", bench_fskcorr },
+    { "goertzel", bench_goertzel },
+    { "pocsag", bench_pocsag },
+    { "deinterleave", bench_deinterleave },
+    { "fmdemod", bench_fmdemod },
+    { "channelizer", bench_channelizer },
+    { "bch", bench_bch },
+    { "decoders", bench_decoders },
+};
+
+static const char usage_str[] =
+    "multimon-bench\n"
+    "Micro-benchmarks for the multimon-ng signal processing kernels\n"
+    "usage: %s [-t <seconds>] [-j] [benchmark ...]\n"
+    "  -t <seconds> : Minimum run time per measurement (default: 0.2)\n"
+    "  -j           : Write the results as JSON\n"
+    "  -h           : This help\n"
+    "Benchmarks:";
+
+int main(int argc, char *argv[])
+{
+    int c, errflg = 0;
+
+    while ((c = getopt(argc, argv, "t:jh")) != EOF) {
+        switch (c) {
+        case 'j':
+            json_output = 1;
+            break;
+        case 't':
+            min_time = atof(optarg);
+            if (min_time <= 0)
+                errflg++;
+            break;
+        default:
+            errflg++;
+            break;
+        }
+    }
+    if (errflg) {
+        fprintf(stderr, usage_str, argv[0]);
+        for (unsigned int b = 0; b < sizeof(benches) / sizeof(benches[0]); b++)
+            fprintf(stderr, " %s", benches[b].name);
+        fprintf(stderr, "\n");
+        exit(2);
+    }
+
+    srand(1);
+    fill_random(signal_buf, sizeof(signal_buf) / sizeof(signal_buf[0]));
+    fill_random(coef_buf, sizeof(coef_buf) / sizeof(coef_buf[0]));
+    if (json_output) {
+        printf("{\n  \"selected\": ");
+        print_json_string(mac_selected());
+        printf(",\n  \"min_time\": %g,\n  \"results\": [", min_time);
+    }
+    else
+        printf("Correlator kernel selected at runtime: %s\n", mac_selected());
+
+    for (unsigned int b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        int run = optind >= argc;
+        for (int i = optind; i < argc; i++)
+            if (!strcmp(argv[i], benches[b].name))
+                run = 1;
+        if (run)
+            benches[b].run();
+    }
+    if (json_output)
+        printf("\n  ],\n  \"failed\": %s\n}\n", failed ? "true" : "false");
+    return failed;
+}
+
+/* ---------------------------------------------------------------------- */
@@ -0,0 +1,469 @@
+/*
+ *      channelizer.c -- polyphase filter bank splitting wideband IQ into FM channels
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * The band is cut into M bins, M a power of two, by a twice oversampled
+ * polyphase filter bank: every M/2 input samples the last M*K of them
+ * are weighted with the prototype lowpass, folded into M sums and an
+ * inverse FFT turns those into one output sample of every bin, each
+ * mixed down to 0 Hz and running at 2 * in_rate / M. Mixing is done
+ * by the FFT, so one pass serves all channels no matter how many.
+ *
+ * Bins are spaced at least three times the audio bandwidth the FM
+ * demodulator keeps (the passband of its resampler), and the prototype
+ * cuts off at one bin spacing. A channel lying halfway between two bins
+ * then still fits its bin without aliasing, because the oversampled
+ * output only folds back from one and a half spacings on. Fewer, wider
+ * bins would leave the per-channel resamplers more to do, which is
+ * where most of the time goes. Each channel
+ * takes the nearest bin, a mixer removes what is left of its offset and
+ * a fm_demod decimates it to the audio rate and discriminates.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "channelizer.h"
+#include "fmdemod.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define AUDIO_PASSBAND 0.46     /* of the audio rate, as the resampler keeps it */
+#define MIN_SPACING    3.0      /* bin spacing in audio passbands */
+#define TRANSITION     5.5      /* Blackman transition width times the filter length */
+
+struct channel {
+    unsigned int bin;
+    double rot_re, rot_im;      /* mixer phase */
+    double step_re, step_im;    /* mixer turn per bin sample */
+    float *i, *q;               /* bin samples written since the last read */
+    unsigned int n;
+    struct fm_demod *fm;
+};
+
+struct channelizer {
+    unsigned int nbins;         /* M */
+    unsigned int decim;         /* M / 2 */
+    unsigned int taps;          /* M * K */
+    float *coef;                /* prototype, time reversed */
+    float *xi, *xq;             /* the last taps - 1 input samples and the new ones */
+    unsigned int xlen, xcap;
+    unsigned int next;          /* newest sample of the next frame, index into xi/xq */
+    unsigned long frame;
+    float *acc_i, *acc_q;       /* the folded sums */
+    float *re, *im;             /* FFT work area */
+    float *tw_re, *tw_im;       /* exp(2 pi i k / len), k < len / 2, at len / 2 - 1 for each stage */
+    unsigned int *bitrev;
+    unsigned int nch;
+    struct channel *ch;
+    unsigned int stage_cap;     /* of ch[].i and ch[].q */
+};
+
+/* ---------------------------------------------------------------------- */
+
+static double sinc(double x)
+{
+    if (fabs(x) < 1e-9)
+        return 1.0;
+    return sin(M_PI * x) / (M_PI * x);
+}
+
+static double blackman(double x, double half)
+{
+    if (fabs(x) >= half)
+        return 0.0;
+    return 0.42 + 0.5 * cos(M_PI * x / half) + 0.08 * cos(2.0 * M_PI * x / half);
+}
+
+struct channelizer *channelizer_new(unsigned int in_rate, unsigned int out_rate,
+                                    const double *freqs, unsigned int nch, float deviation)
+{
+    struct channelizer *cz;
+    double audio = AUDIO_PASSBAND * out_rate, spacing, transition, sum = 0;
+    unsigned int m, k, bits = 0;
+
+    if (!in_rate || !out_rate || !nch)
+        return NULL;
+    for (unsigned int c = 0; c < nch; c++)
+        if (fabs(freqs[c]) > in_rate / 2.0)
+            return NULL;
+    if (!(cz = calloc(1, sizeof(*cz))))
+        return NULL;
+
+    /* the most bins that are still MIN_SPACING audio passbands apart */
+    for (m = 2; in_rate / (2.0 * m) >= MIN_SPACING * audio; m *= 2)
+        bits++;
+    bits++;
+    spacing = (double)in_rate / m;
+    transition = spacing - 2 * audio;
+    if (transition < spacing / 4)
+        transition = spacing / 4;
+    k = (unsigned int)ceil(TRANSITION * spacing / transition);
+    cz->nbins = m;
+    cz->decim = m / 2;
+    cz->taps = m * k;
+    cz->nch = nch;
+
+    cz->coef = malloc(cz->taps * sizeof(cz->coef[0]));
+    cz->acc_i = malloc(m * sizeof(cz->acc_i[0]));
+    cz->acc_q = malloc(m * sizeof(cz->acc_q[0]));
+    cz->re = malloc(m * sizeof(cz->re[0]));
+    cz->im = malloc(m * sizeof(cz->im[0]));
+    cz->tw_re = malloc(m * sizeof(cz->tw_re[0]));
+    cz->tw_im = malloc(m * sizeof(cz->tw_im[0]));
+    cz->bitrev = malloc(m * sizeof(cz->bitrev[0]));
+    cz->xcap = 2 * cz->taps + 65536;
+    cz->xi = calloc(cz->xcap, sizeof(cz->xi[0]));
+    cz->xq = calloc(cz->xcap, sizeof(cz->xq[0]));
+    cz->ch = calloc(nch, sizeof(cz->ch[0]));
+    if (!cz->coef || !cz->acc_i || !cz->acc_q || !cz->re || !cz->im || !cz->tw_re ||
+        !cz->tw_im || !cz->bitrev || !cz->xi || !cz->xq || !cz->ch) {
+        channelizer_free(cz);
+        return NULL;
+    }
+
+    /* lowpass cutting off at one bin spacing, 1 / M cycles per sample */
+    for (unsigned int j = 0; j < cz->taps; j++) {
+        double d = j - (cz->taps - 1) / 2.0;
+        cz->coef[cz->taps - 1 - j] = 2.0 / m * sinc(2.0 / m * d) * blackman(d, cz->taps / 2.0);
+        sum += cz->coef[cz->taps - 1 - j];
+    }
+    for (unsigned int j = 0; j < cz->taps; j++)
+        cz->coef[j] /= sum;
+    for (unsigned int half = 1; half < m; half *= 2) {
+        for (unsigned int j = 0; j < half; j++) {
+            cz->tw_re[half - 1 + j] = cos(M_PI * j / half);
+            cz->tw_im[half - 1 + j] = sin(M_PI * j / half);
+        }
+    }
+    for (unsigned int j = 0; j < m; j++) {
+        unsigned int r = 0;
+        for (unsigned int b = 0; b < bits; b++)
+            r |= ((j >> b) & 1) << (bits - 1 - b);
+        cz->bitrev[j] = r;
+    }
+
+    for (unsigned int c = 0; c < nch; c++) {
+        struct channel *ch = cz->ch + c;
+        long b = lround(freqs[c] / spacing);
+        double rest = freqs[c] - b * spacing;
+
+        ch->bin = (unsigned int)((b % (long)m + m) % m);
+        ch->rot_re = 1;
+        ch->step_re = cos(-2.0 * M_PI * rest / (2.0 * spacing));
+        ch->step_im = sin(-2.0 * M_PI * rest / (2.0 * spacing));
+        if (!(ch->fm = fm_demod_new(2 * in_rate / m, out_rate, deviation))) {
+            channelizer_free(cz);
+            return NULL;
+        }
+    }
+
+    /* the first frame ends on the first input sample */
+    cz->xlen = cz->next = cz->taps - 1;
+    return cz;
+}
+
+void channelizer_free(struct channelizer *cz)
+{
+    if (!cz)
+        return;
+    for (unsigned int c = 0; cz->ch && c < cz->nch; c++) {
+        fm_demod_free(cz->ch[c].fm);
+        free(cz->ch[c].i);
+        free(cz->ch[c].q);
+    }
+    free(cz->ch);
+    free(cz->coef);
+    free(cz->acc_i);
+    free(cz->acc_q);
+    free(cz->re);
+    free(cz->im);
+    free(cz->tw_re);
+    free(cz->tw_im);
+    free(cz->bitrev);
+    free(cz->xi);
+    free(cz->xq);
+    free(cz);
+}
+
+unsigned int channelizer_bins(const struct channelizer *cz)
+{
+    return cz->nbins;
+}
+
+unsigned int channelizer_taps(const struct channelizer *cz)
+{
+    return cz->taps;
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * ai[j] = sum over s of h[s + j] * xi[s + j], s stepping by m up to taps,
+ * and the same for q. The sums stay in registers and I and Q share the
+ * coefficient loads.
+ */
+static inline void fold_scalar(float *ai, float *aq, const float *h, const float *xi,
+                               const float *xq, unsigned int j, unsigned int m, unsigned int taps)
+{
+    for (; j < m; j++) {
+        float si = 0, sq = 0;
+
+        for (unsigned int s = j; s < taps; s += m) {
+            si += h[s] * xi[s];
+            sq += h[s] * xq[s];
+        }
+        ai[j] = si;
+        aq[j] = sq;
+    }
+}
+
+/* the butterflies from k on of the stage of size 2 * half, starting at a */
+static inline void butterflies_scalar(float *re, float *im, const float *twr, const float *twi,
+                                      unsigned int a, unsigned int k, unsigned int half)
+{
+    for (; k < half; k++) {
+        unsigned int b = a + k + half;
+        float tr = re[b] * twr[k] - im[b] * twi[k];
+        float ti = re[b] * twi[k] + im[b] * twr[k];
+
+        re[b] = re[a + k] - tr;
+        im[b] = im[a + k] - ti;
+        re[a + k] += tr;
+        im[a + k] += ti;
+    }
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+/*
+ * Spelled out in generic vectors, as in resample.c: the trip counts are
+ * only known at run time, which keeps the compiler from vectorising at
+ * -O2. M is a power of two, so four at a time fits from M = 4 on.
+ */
+typedef float v4sf __attribute__((vector_size(16)));
+
+static inline v4sf load4(const float *p)
+{
+    v4sf v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store4(float *p, v4sf v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline void fold(float *ai, float *aq, const float *h, const float *xi, const float *xq,
+                        unsigned int m, unsigned int taps)
+{
+    unsigned int j = 0;
+
+    for (; j + 4 <= m; j += 4) {
+        v4sf si = {0, 0, 0, 0}, sq = {0, 0, 0, 0};
+
+        for (unsigned int s = j; s < taps; s += m) {
+            v4sf c = load4(h + s);
+            si += c * load4(xi + s);
+            sq += c * load4(xq + s);
+        }
+        store4(ai + j, si);
+        store4(aq + j, sq);
+    }
+    fold_scalar(ai, aq, h, xi, xq, j, m, taps);
+}
+
+static inline void butterflies(float *re, float *im, const float *twr, const float *twi,
+                               unsigned int a, unsigned int half)
+{
+    unsigned int k = 0;
+
+    for (; k + 4 <= half; k += 4) {
+        v4sf wr = load4(twr + k), wi = load4(twi + k);
+        v4sf br = load4(re + a + half + k), bi = load4(im + a + half + k);
+        v4sf ar = load4(re + a + k), ai = load4(im + a + k);
+        v4sf tr = br * wr - bi * wi, ti = br * wi + bi * wr;
+
+        store4(re + a + half + k, ar - tr);
+        store4(im + a + half + k, ai - ti);
+        store4(re + a + k, ar + tr);
+        store4(im + a + k, ai + ti);
+    }
+    butterflies_scalar(re, im, twr, twi, a, k, half);
+}
+#else
+static inline void fold(float *ai, float *aq, const float *h, const float *xi, const float *xq,
+                        unsigned int m, unsigned int taps)
+{
+    fold_scalar(ai, aq, h, xi, xq, 0, m, taps);
+}
+
+static inline void butterflies(float *re, float *im, const float *twr, const float *twi,
+                               unsigned int a, unsigned int half)
+{
+    butterflies_scalar(re, im, twr, twi, a, 0, half);
+}
+#endif
+
+/* in place, the input in bit reversed order, with exp(+2 pi i k n / M) */
+static void inverse_fft(struct channelizer *cz)
+{
+    float *restrict re = cz->re, *restrict im = cz->im;
+    unsigned int m = cz->nbins, half = 1;
+
+    /* the first two stages in one go, their twiddles are 1 and i */
+    if (m >= 4) {
+        for (unsigned int a = 0; a < m; a += 4) {
+            float s0r = re[a] + re[a+1], s0i = im[a] + im[a+1];
+            float d0r = re[a] - re[a+1], d0i = im[a] - im[a+1];
+            float s1r = re[a+2] + re[a+3], s1i = im[a+2] + im[a+3];
+            float d1r = re[a+2] - re[a+3], d1i = im[a+2] - im[a+3];
+
+            re[a] = s0r + s1r;
+            im[a] = s0i + s1i;
+            re[a+2] = s0r - s1r;
+            im[a+2] = s0i - s1i;
+            /* i * d1 */
+            re[a+1] = d0r - d1i;
+            im[a+1] = d0i + d1r;
+            re[a+3] = d0r + d1i;
+            im[a+3] = d0i - d1r;
+        }
+        half = 4;
+    }
+    for (; half < m; half *= 2)
+        for (unsigned int a = 0; a < m; a += 2 * half)
+            butterflies(re, im, cz->tw_re + half - 1, cz->tw_im + half - 1, a, half);
+}
+
+/* one output sample of every bin, from the window ending at cz->next */
+static void pfb_frame(struct channelizer *cz, unsigned int out)
+{
+    unsigned int m = cz->nbins;
+    const float *wi = cz->xi + cz->next - (cz->taps - 1);
+    const float *wq = cz->xq + cz->next - (cz->taps - 1);
+    float *restrict ai = cz->acc_i, *restrict aq = cz->acc_q;
+
+    fold(ai, aq, cz->coef, wi, wq, m, cz->taps);
+    /* sum j of the reversed window belongs to polyphase branch M - 1 - j */
+    for (unsigned int j = 0; j < m; j++) {
+        cz->re[cz->bitrev[m - 1 - j]] = ai[j];
+        cz->im[cz->bitrev[m - 1 - j]] = aq[j];
+    }
+    inverse_fft(cz);
+
+    /* decimating by M / 2 leaves the odd bins turned by pi every other frame */
+    for (unsigned int c = 0; c < cz->nch; c++) {
+        struct channel *ch = cz->ch + c;
+        float sign = (ch->bin & cz->frame & 1) ? -1.0f : 1.0f;
+
+        ch->i[out] = sign * cz->re[ch->bin];
+        ch->q[out] = sign * cz->im[ch->bin];
+    }
+    cz->frame++;
+}
+
+void channelizer_write(struct channelizer *cz, const float *i, const float *q, unsigned int n)
+{
+    unsigned int frames, drop;
+
+    if (cz->xlen + n > cz->xcap) {
+        unsigned int cap = 2 * (cz->xlen + n);
+        float *xi = realloc(cz->xi, cap * sizeof(xi[0]));
+        float *xq = xi ? realloc(cz->xq, cap * sizeof(xq[0])) : NULL;
+        if (!xi || !xq) {
+            perror("realloc");
+            exit(10);
+        }
+        cz->xi = xi;
+        cz->xq = xq;
+        cz->xcap = cap;
+    }
+    memcpy(cz->xi + cz->xlen, i, n * sizeof(i[0]));
+    memcpy(cz->xq + cz->xlen, q, n * sizeof(q[0]));
+    cz->xlen += n;
+
+    frames = cz->next < cz->xlen ? (cz->xlen - 1 - cz->next) / cz->decim + 1 : 0;
+    /* every channel holds as many bin samples as the first */
+    if (cz->ch[0].n + frames > cz->stage_cap) {
+        unsigned int cap = 2 * (cz->ch[0].n + frames);
+        for (unsigned int c = 0; c < cz->nch; c++) {
+            struct channel *ch = cz->ch + c;
+            float *ci = realloc(ch->i, cap * sizeof(ci[0]));
+            float *cq = ci ? realloc(ch->q, cap * sizeof(cq[0])) : NULL;
+            if (ci)
+                ch->i = ci;
+            if (!ci || !cq) {
+                perror("realloc");
+                exit(10);
+            }
+            ch->q = cq;
+        }
+        cz->stage_cap = cap;
+    }
+    for (unsigned int f = 0; f < frames; f++) {
+        pfb_frame(cz, cz->ch[0].n + f);
+        cz->next += cz->decim;
+    }
+    for (unsigned int c = 0; c < cz->nch; c++)
+        cz->ch[c].n += frames;
+
+    /* keep the window of the next frame */
+    drop = cz->next - (cz->taps - 1);
+    memmove(cz->xi, cz->xi + drop, (cz->xlen - drop) * sizeof(cz->xi[0]));
+    memmove(cz->xq, cz->xq + drop, (cz->xlen - drop) * sizeof(cz->xq[0]));
+    cz->xlen -= drop;
+    cz->next -= drop;
+}
+
+/* ---------------------------------------------------------------------- */
+
+unsigned int channelizer_read(struct channelizer *cz, unsigned int c, float *out, unsigned int n)
+{
+    struct channel *ch = cz->ch + c;
+
+    if (ch->n) {
+        double rr = ch->rot_re, ri = ch->rot_im, mag;
+
+        /* take the rest of the offset out, on the samples the bin gave */
+        for (unsigned int k = 0; k < ch->n; k++) {
+            float vi = ch->i[k], vq = ch->q[k];
+            double t;
+
+            ch->i[k] = vi * rr - vq * ri;
+            ch->q[k] = vi * ri + vq * rr;
+            t = rr * ch->step_re - ri * ch->step_im;
+            ri = rr * ch->step_im + ri * ch->step_re;
+            rr = t;
+        }
+        mag = sqrt(rr * rr + ri * ri);
+        ch->rot_re = rr / mag;
+        ch->rot_im = ri / mag;
+        fm_demod_write(ch->fm, ch->i, ch->q, ch->n);
+        ch->n = 0;
+    }
+    return fm_demod_read(ch->fm, out, n);
+}
+
+/* ---------------------------------------------------------------------- */
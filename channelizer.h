@@ -0,0 +1,56 @@
+/*
+ *      channelizer.h -- polyphase filter bank splitting wideband IQ into FM channels
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _CHANNELIZER_H
+#define _CHANNELIZER_H
+
+/* ---------------------------------------------------------------------- */
+
+struct channelizer;
+
+/*
+ * Split complex samples at in_rate into nch channels centred freqs[0..nch-1]
+ * Hz off the centre of the band, each FM demodulated to audio at out_rate
+ * with 'deviation' Hz giving full scale. Returns NULL if a frequency lies
+ * outside the band or memory runs out.
+ */
+struct channelizer *channelizer_new(unsigned int in_rate, unsigned int out_rate,
+                                    const double *freqs, unsigned int nch, float deviation);
+void channelizer_free(struct channelizer *cz);
+
+/* Filter bank bins, the bin spacing is in_rate / bins */
+unsigned int channelizer_bins(const struct channelizer *cz);
+unsigned int channelizer_taps(const struct channelizer *cz);
+
+/* Run n complex samples, given as separate I and Q runs, through the filter bank */
+void channelizer_write(struct channelizer *cz, const float *i, const float *q, unsigned int n);
+
+/*
+ * Fetch up to n audio samples of channel c, returns the number produced.
+ * Between two writes, different channels may be read from different
+ * threads at the same time.
+ */
+unsigned int channelizer_read(struct channelizer *cz, unsigned int c, float *out, unsigned int n);
+
+/* ---------------------------------------------------------------------- */
+#endif /* _CHANNELIZER_H */
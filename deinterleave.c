@@ -0,0 +1,148 @@
+/*
+ *      deinterleave.c -- splitting multichannel frames into channels
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * A strided copy with the stride only known at run time defeats the
+ * vectoriser, so the common layouts get loops of their own: with two or
+ * four channels the stride is a constant and the compiler turns the
+ * loads into shuffles. Eight, sixteen or more channels in multiples of
+ * eight are transposed eight frames by eight channels at a time in SSE2
+ * registers, which reads every frame once and writes whole vectors to
+ * each channel. Everything else takes the plain loop.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "deinterleave.h"
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+#define DEINTERLEAVE_FIXED(name, type, nch)                             \
+static void name(type *const *out, const type *restrict in, size_t n)   \
+{                                                                       \
+    for (unsigned int c = 0; c < nch; c++) {                            \
+        type *restrict o = out[c];                                      \
+        for (size_t i = 0; i < n; i++)                                  \
+            o[i] = in[i * nch + c];                                     \
+    }                                                                   \
+}
+
+DEINTERLEAVE_FIXED(deinterleave2_s16, short, 2)
+DEINTERLEAVE_FIXED(deinterleave4_s16, short, 4)
+DEINTERLEAVE_FIXED(deinterleave2_f32, float, 2)
+DEINTERLEAVE_FIXED(deinterleave4_f32, float, 4)
+
+void deinterleave_s16_scalar(short *const *out, const short *in, unsigned int nch, size_t n)
+{
+    for (unsigned int c = 0; c < nch; c++) {
+        short *restrict o = out[c];
+        for (size_t i = 0; i < n; i++)
+            o[i] = in[i * nch + c];
+    }
+}
+
+static void deinterleave_f32_scalar(float *const *out, const float *in, unsigned int nch, size_t n)
+{
+    for (unsigned int c = 0; c < nch; c++) {
+        float *restrict o = out[c];
+        for (size_t i = 0; i < n; i++)
+            o[i] = in[i * nch + c];
+    }
+}
+
+#ifdef __SSE2__
+/* nch a multiple of 8: rows are frames, columns channels */
+static void deinterleave8_s16(short *const *out, const short *in, unsigned int nch, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        for (unsigned int g = 0; g < nch; g += 8) {
+            const short *p = in + i * nch + g;
+            __m128i r0 = _mm_loadu_si128((const __m128i *)(p + 0 * nch));
+            __m128i r1 = _mm_loadu_si128((const __m128i *)(p + 1 * nch));
+            __m128i r2 = _mm_loadu_si128((const __m128i *)(p + 2 * nch));
+            __m128i r3 = _mm_loadu_si128((const __m128i *)(p + 3 * nch));
+            __m128i r4 = _mm_loadu_si128((const __m128i *)(p + 4 * nch));
+            __m128i r5 = _mm_loadu_si128((const __m128i *)(p + 5 * nch));
+            __m128i r6 = _mm_loadu_si128((const __m128i *)(p + 6 * nch));
+            __m128i r7 = _mm_loadu_si128((const __m128i *)(p + 7 * nch));
+            __m128i a0 = _mm_unpacklo_epi16(r0, r1), a1 = _mm_unpackhi_epi16(r0, r1);
+            __m128i a2 = _mm_unpacklo_epi16(r2, r3), a3 = _mm_unpackhi_epi16(r2, r3);
+            __m128i a4 = _mm_unpacklo_epi16(r4, r5), a5 = _mm_unpackhi_epi16(r4, r5);
+            __m128i a6 = _mm_unpacklo_epi16(r6, r7), a7 = _mm_unpackhi_epi16(r6, r7);
+            __m128i b0 = _mm_unpacklo_epi32(a0, a2), b1 = _mm_unpackhi_epi32(a0, a2);
+            __m128i b2 = _mm_unpacklo_epi32(a1, a3), b3 = _mm_unpackhi_epi32(a1, a3);
+            __m128i b4 = _mm_unpacklo_epi32(a4, a6), b5 = _mm_unpackhi_epi32(a4, a6);
+            __m128i b6 = _mm_unpacklo_epi32(a5, a7), b7 = _mm_unpackhi_epi32(a5, a7);
+            _mm_storeu_si128((__m128i *)(out[g + 0] + i), _mm_unpacklo_epi64(b0, b4));
+            _mm_storeu_si128((__m128i *)(out[g + 1] + i), _mm_unpackhi_epi64(b0, b4));
+            _mm_storeu_si128((__m128i *)(out[g + 2] + i), _mm_unpacklo_epi64(b1, b5));
+            _mm_storeu_si128((__m128i *)(out[g + 3] + i), _mm_unpackhi_epi64(b1, b5));
+            _mm_storeu_si128((__m128i *)(out[g + 4] + i), _mm_unpacklo_epi64(b2, b6));
+            _mm_storeu_si128((__m128i *)(out[g + 5] + i), _mm_unpackhi_epi64(b2, b6));
+            _mm_storeu_si128((__m128i *)(out[g + 6] + i), _mm_unpacklo_epi64(b3, b7));
+            _mm_storeu_si128((__m128i *)(out[g + 7] + i), _mm_unpackhi_epi64(b3, b7));
+        }
+    }
+    /* the last frames that do not make up a tile */
+    for (; i < n; i++)
+        for (unsigned int c = 0; c < nch; c++)
+            out[c][i] = in[i * nch + c];
+}
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+void deinterleave_s16(short *const *out, const short *in, unsigned int nch, size_t n)
+{
+    if (nch == 1)
+        memcpy(out[0], in, n * sizeof(in[0]));
+    else if (nch == 2)
+        deinterleave2_s16(out, in, n);
+    else if (nch == 4)
+        deinterleave4_s16(out, in, n);
+#ifdef __SSE2__
+    else if (nch % 8 == 0)
+        deinterleave8_s16(out, in, nch, n);
+#endif
+    else
+        deinterleave_s16_scalar(out, in, nch, n);
+}
+
+void deinterleave_f32(float *const *out, const float *in, unsigned int nch, size_t n)
+{
+    if (nch == 1)
+        memcpy(out[0], in, n * sizeof(in[0]));
+    else if (nch == 2)
+        deinterleave2_f32(out, in, n);
+    else if (nch == 4)
+        deinterleave4_f32(out, in, n);
+    else
+        deinterleave_f32_scalar(out, in, nch, n);
+}
+
+/* ---------------------------------------------------------------------- */
@@ -0,0 +1,42 @@
+/*
+ *      deinterleave.h -- splitting multichannel frames into channels
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _DEINTERLEAVE_H
+#define _DEINTERLEAVE_H
+
+#include <stddef.h>
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Copy n frames of nch interleaved samples to out[0] .. out[nch-1], one
+ * contiguous run of n samples per channel.
+ */
+void deinterleave_s16(short *const *out, const short *in, unsigned int nch, size_t n);
+void deinterleave_f32(float *const *out, const float *in, unsigned int nch, size_t n);
+
+/* The plain strided copy, for checking and timing the above */
+void deinterleave_s16_scalar(short *const *out, const short *in, unsigned int nch, size_t n);
+
+/* ---------------------------------------------------------------------- */
+#endif /* _DEINTERLEAVE_H */
@@ -47,30 +47,20 @@
 #define CORRLEN ((int)(FREQ_SAMP/BAUD))
 #define SPHASEINC (0x10000u*BAUD*SUBSAMP/FREQ_SAMP)
 
-static float corr_mark_i[CORRLEN];
-static float corr_mark_q[CORRLEN];
-static float corr_space_i[CORRLEN];
-static float corr_space_q[CORRLEN];
+static const struct fskcorr_front afsk12_front = {
+	FREQ_SAMP, CORRLEN, SUBSAMP, FSKCORR_RECT, 2, { FREQ_MARK, FREQ_SPACE }
+};
+static struct fskcorr_bank corr_bank;
 
 /* ---------------------------------------------------------------------- */
 	
 static void afsk12_init(struct demod_state *s)
 {
-	float f;
-	int i;
-
 	hdlc_init(s);
 	memset(&s->l1.afsk12, 0, sizeof(s->l1.afsk12));
-	for (f = 0, i = 0; i < CORRLEN; i++) {
-		corr_mark_i[i] = cos(f);
-		corr_mark_q[i] = sin(f);
-		f += 2.0*M_PI*FREQ_MARK/FREQ_SAMP;
-	}
-	for (f = 0, i = 0; i < CORRLEN; i++) {
-		corr_space_i[i] = cos(f);
-		corr_space_q[i] = sin(f);
-		f += 2.0*M_PI*FREQ_SPACE/FREQ_SAMP;
-	}
+	if (!corr_bank.len)
+		fskcorr_bank_init(&corr_bank, &afsk12_front);
+	fskcorr_init(&s->l1.afsk12.corr, &corr_bank);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -79,6 +69,8 @@ static void afsk12_demod(struct demod_state *s, buffer_t buffer, int length)
 {
 	float f;
 	unsigned char curbit;
+	const float *start = buffer.fbuffer;
+	const float *shared = fsk_shared(s, buffer, length);
 
 	if (s->l1.afsk12.subsamp) {
 		if (length <= (int)s->l1.afsk12.subsamp) {
@@ -90,10 +82,12 @@ static void afsk12_demod(struct demod_state *s, buffer_t buffer, int length)
 		s->l1.afsk12.subsamp = 0;
 	}
 	for (; length > 0; length -= SUBSAMP, buffer.fbuffer += SUBSAMP) {
-		f = fsqr(mac(buffer.fbuffer, corr_mark_i, CORRLEN)) +
-			fsqr(mac(buffer.fbuffer, corr_mark_q, CORRLEN)) -
-			fsqr(mac(buffer.fbuffer, corr_space_i, CORRLEN)) -
-			fsqr(mac(buffer.fbuffer, corr_space_q, CORRLEN));
+		if (shared) {
+			f = *shared++;
+		} else {
+			fskcorr_slide(&s->l1.afsk12.corr, buffer.fbuffer, SUBSAMP);
+			f = fskcorr_mark_space(&s->l1.afsk12.corr);
+		}
 		s->l1.afsk12.dcd_shreg <<= 1;
 		s->l1.afsk12.dcd_shreg |= (f > 0);
 		verbprintf(10, "%c", '0'+(s->l1.afsk12.dcd_shreg & 1));
@@ -114,6 +108,7 @@ static void afsk12_demod(struct demod_state *s, buffer_t buffer, int length)
 			curbit = (s->l1.afsk12.lasts ^ 
 				  (s->l1.afsk12.lasts >> 1) ^ 1) & 1;
 			verbprintf(9, " %c ", '0'+curbit);
+			s->rx_offset = buffer.fbuffer - start;
 			hdlc_rxbit(s, curbit);
 		}
 	}
@@ -123,7 +118,7 @@ static void afsk12_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_afsk1200 = {
-    "AFSK1200", true, FREQ_SAMP, CORRLEN, afsk12_init, afsk12_demod, NULL
+    "AFSK1200", true, FREQ_SAMP, CORRLEN, afsk12_init, afsk12_demod, NULL, &afsk12_front, NULL
 };
 
 /* ---------------------------------------------------------------------- */
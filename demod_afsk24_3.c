@@ -46,37 +46,20 @@
 #define CORRLEN ((int)(2*FREQ_SAMP/BAUD))
 #define SPHASEINC (0x10000u*BAUD/FREQ_SAMP)
 
-static float corr_mark_i[CORRLEN];
-static float corr_mark_q[CORRLEN];
-static float corr_space_i[CORRLEN];
-static float corr_space_q[CORRLEN];
+static const struct fskcorr_front afsk24_3_front = {
+	FREQ_SAMP, CORRLEN, 1, FSKCORR_HAMMING, 2, { FREQ_MARK, FREQ_SPACE }
+};
+static struct fskcorr_bank corr_bank;
 
 /* ---------------------------------------------------------------------- */
 	
 static void afsk24_3_init(struct demod_state *s)
 {
-	float f;
-	int i;
-
 	hdlc_init(s);
 	memset(&s->l1.afsk24, 0, sizeof(s->l1.afsk24));
-	for (f = 0, i = 0; i < CORRLEN; i++) {
-		corr_mark_i[i] = cos(f);
-		corr_mark_q[i] = sin(f);
-		f += 2.0*M_PI*FREQ_MARK/FREQ_SAMP;
-	}
-	for (f = 0, i = 0; i < CORRLEN; i++) {
-		corr_space_i[i] = cos(f);
-		corr_space_q[i] = sin(f);
-		f += 2.0*M_PI*FREQ_SPACE/FREQ_SAMP;
-	}
-	for (i = 0; i < CORRLEN; i++) {
-		f = 0.54 - 0.46*cos(2*M_PI*i/(float)(CORRLEN-1));
-		corr_mark_i[i] *= f;
-		corr_mark_q[i] *= f;
-		corr_space_i[i] *= f;
-		corr_space_q[i] *= f;
-	}
+	if (!corr_bank.len)
+		fskcorr_bank_init(&corr_bank, &afsk24_3_front);
+	fskcorr_init(&s->l1.afsk24.corr, &corr_bank);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -85,12 +68,16 @@ static void afsk24_3_demod(struct demod_state *s, buffer_t buffer, int length)
 {
 	float f;
 	unsigned char curbit;
+	const float *start = buffer.fbuffer;
+	const float *shared = fsk_shared(s, buffer, length);
 
 	for (; length > 0; length--, buffer.fbuffer++) {
-		f = fsqr(mac(buffer.fbuffer, corr_mark_i, CORRLEN)) +
-			fsqr(mac(buffer.fbuffer, corr_mark_q, CORRLEN)) -
-			fsqr(mac(buffer.fbuffer, corr_space_i, CORRLEN)) -
-			fsqr(mac(buffer.fbuffer, corr_space_q, CORRLEN));
+		if (shared) {
+			f = *shared++;
+		} else {
+			fskcorr_slide(&s->l1.afsk24.corr, buffer.fbuffer, 1);
+			f = fskcorr_mark_space(&s->l1.afsk24.corr);
+		}
 		s->l1.afsk24.dcd_shreg <<= 1;
 		s->l1.afsk24.dcd_shreg |= (f > 0);
 		verbprintf(10, "%c", '0'+(s->l1.afsk24.dcd_shreg & 1));
@@ -111,6 +98,7 @@ static void afsk24_3_demod(struct demod_state *s, buffer_t buffer, int length)
 			curbit = (s->l1.afsk24.lasts ^ 
 				  (s->l1.afsk24.lasts >> 1) ^ 1) & 1;
 			verbprintf(9, " %c ", '0'+curbit);
+			s->rx_offset = buffer.fbuffer - start;
 			hdlc_rxbit(s, curbit);
 		}
 	}
@@ -119,7 +107,7 @@ static void afsk24_3_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_afsk2400_3 = {
-    "AFSK2400_3", true, FREQ_SAMP, CORRLEN, afsk24_3_init, afsk24_3_demod, NULL
+    "AFSK2400_3", true, FREQ_SAMP, CORRLEN, afsk24_3_init, afsk24_3_demod, NULL, &afsk24_3_front, NULL
 };
 
 /* ---------------------------------------------------------------------- */
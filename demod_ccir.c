@@ -33,23 +33,8 @@ static const unsigned int ccir_freq[16] = {
 
 /* ---------------------------------------------------------------------- */
 
-static void ccir_init(struct demod_state *s)
-{
-    selcall_init(s);
-}
-
-static void ccir_deinit(struct demod_state *s)
-{
-    selcall_deinit(s);
-}
-
-static void ccir_demod(struct demod_state *s, buffer_t buffer, int length)
-{
-    selcall_demod(s, buffer.fbuffer, length, ccir_freq, demod_ccir.name);
-}
-
 const struct demod_param demod_ccir = {
-    "CCIR", true, SAMPLE_RATE, 0, ccir_init, ccir_demod, ccir_deinit
+    "CCIR", true, SAMPLE_RATE, 0, selcall_init, selcall_demod, selcall_deinit, NULL, ccir_freq
 };
 
 
@@ -44,30 +44,20 @@
 #define CORRLEN ((int)(FREQ_SAMP/BAUD))
 #define SPHASEINC (0x10000u*BAUD*SUBSAMP/FREQ_SAMP)
 
-static float corr_mark_i[CORRLEN];
-static float corr_mark_q[CORRLEN];
-static float corr_space_i[CORRLEN];
-static float corr_space_q[CORRLEN];
+static const struct fskcorr_front clipfsk_front = {
+	FREQ_SAMP, CORRLEN, SUBSAMP, FSKCORR_RECT, 2, { FREQ_MARK, FREQ_SPACE }
+};
+static struct fskcorr_bank corr_bank;
 
 /* ---------------------------------------------------------------------- */
 	
 static void clipfsk_init(struct demod_state *s)
 {
-	float f;
-	int i;
-
 	clip_init(s);
 	memset(&s->l1.clipfsk, 0, sizeof(s->l1.clipfsk));
-	for (f = 0, i = 0; i < CORRLEN; i++) {
-		corr_mark_i[i] = cos(f);
-		corr_mark_q[i] = sin(f);
-		f += 2.0*M_PI*FREQ_MARK/FREQ_SAMP;
-	}
-	for (f = 0, i = 0; i < CORRLEN; i++) {
-		corr_space_i[i] = cos(f);
-		corr_space_q[i] = sin(f);
-		f += 2.0*M_PI*FREQ_SPACE/FREQ_SAMP;
-	}
+	if (!corr_bank.len)
+		fskcorr_bank_init(&corr_bank, &clipfsk_front);
+	fskcorr_init(&s->l1.clipfsk.corr, &corr_bank);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -76,6 +66,8 @@ static void clipfsk_demod(struct demod_state *s, buffer_t buffer, int length)
 {
 	float f;
 	unsigned char curbit;
+	const float *start = buffer.fbuffer;
+	const float *shared = fsk_shared(s, buffer, length);
 
 	if (s->l1.clipfsk.subsamp) {
 		if (length <= (int)s->l1.clipfsk.subsamp) {
@@ -87,10 +79,12 @@ static void clipfsk_demod(struct demod_state *s, buffer_t buffer, int length)
 		s->l1.clipfsk.subsamp = 0;
 	}
 	for (; length > 0; length -= SUBSAMP, buffer.fbuffer += SUBSAMP) {
-		f = 	fsqr(mac(buffer.fbuffer, corr_mark_i, CORRLEN)) +
-			fsqr(mac(buffer.fbuffer, corr_mark_q, CORRLEN)) -
-			fsqr(mac(buffer.fbuffer, corr_space_i, CORRLEN)) -
-			fsqr(mac(buffer.fbuffer, corr_space_q, CORRLEN));
+		if (shared) {
+			f = *shared++;
+		} else {
+			fskcorr_slide(&s->l1.clipfsk.corr, buffer.fbuffer, SUBSAMP);
+			f = fskcorr_mark_space(&s->l1.clipfsk.corr);
+		}
 		s->l1.clipfsk.dcd_shreg <<= 1;
 		s->l1.clipfsk.dcd_shreg |= (f > 0);
 		verbprintf(10, "%c", '0'+(s->l1.clipfsk.dcd_shreg & 1));
@@ -108,6 +102,7 @@ static void clipfsk_demod(struct demod_state *s, buffer_t buffer, int length)
 			s->l1.clipfsk.sphase &= 0xffffu;
 			curbit = s->l1.clipfsk.dcd_shreg & 1;
 			verbprintf(9, " %c ", '0'+curbit);
+			s->rx_offset = buffer.fbuffer - start;
 			clip_rxbit(s, curbit);
 		}
 	}
@@ -117,7 +112,7 @@ static void clipfsk_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_clipfsk = {
-    "CLIPFSK", true, FREQ_SAMP, CORRLEN, clipfsk_init, clipfsk_demod, NULL
+    "CLIPFSK", true, FREQ_SAMP, CORRLEN, clipfsk_init, clipfsk_demod, NULL, &clipfsk_front, NULL
 };
 
 /* ---------------------------------------------------------------------- */
@@ -82,7 +82,7 @@ static void scope_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_scope = {
-    "SCOPE", true, SAMPLING_RATE, 0, scope_init, scope_demod, NULL
+    "SCOPE", true, SAMPLING_RATE, 0, scope_init, scope_demod, NULL, NULL, NULL
 };
 
 
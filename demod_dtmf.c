@@ -30,7 +30,6 @@
 #include <stdio.h>
 #include <string.h>
 
-#include "cJSON.h"
 
 /* ---------------------------------------------------------------------- */
 
@@ -49,6 +48,7 @@
 #define SAMPLE_RATE 22050
 #define BLOCKLEN (SAMPLE_RATE/100)  /* 10ms blocks */
 #define BLOCKNUM 4    /* must match numbers in multimon.h */
+#define DTMF_GROUP 8  /* channels filtered together, 16 vectors of 4 tones */
 
 #define PHINC(x) ((x)*0x10000/SAMPLE_RATE)
 
@@ -59,13 +59,16 @@ static const unsigned int dtmf_phinc[8] = {
 	PHINC(697), PHINC(770), PHINC(852), PHINC(941)
 };
 
-extern int json_mode;
-
 /* ---------------------------------------------------------------------- */
 	
 static void dtmf_init(struct demod_state *s)
 {
+	int i;
+
 	memset(&s->l1.dtmf, 0, sizeof(s->l1.dtmf));
+	goertzel_init(&s->l1.dtmf.bank, BLOCKLEN);
+	for (i = 0; i < 8; i++)
+		goertzel_add(&s->l1.dtmf.bank, dtmf_phinc[i]);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -131,45 +134,100 @@ static inline int process_block(struct demod_state *s)
 
 /* ---------------------------------------------------------------------- */
 
+/*
+ * The bank's record holds the block energy followed by the cosine and
+ * the sine correlation of the 8 tones, which is the layout of energy[0]
+ * and tenergy[0] that the oscillators used to accumulate.
+ */
+/* The block ended end samples into the current one */
+static void dtmf_block(struct demod_state *s, const float *rec, long end)
+{
+	int i;
+
+	s->l1.dtmf.energy[0] = rec[0];
+	memcpy(s->l1.dtmf.tenergy[0], rec + 1, sizeof(s->l1.dtmf.tenergy[0]));
+	i = process_block(s);
+	if (i != s->l1.dtmf.lastch && i >= 0) {
+		demod_mark(s, end - BLOCKLEN);
+		if (!s->cfg->json) {
+			verbprintf(0, "DTMF: %c\n", dtmf_transl[i]);
+		}
+		else {
+			json_begin();
+			json_add_string("demod_name", "DTMF");
+			char digit[2] = {dtmf_transl[i], '\0'};
+			json_add_string("digit", digit);
+			json_add_timestamp();
+			json_end();
+		}
+	}
+	s->l1.dtmf.lastch = i;
+}
+
+/* ---------------------------------------------------------------------- */
+
 static void dtmf_demod(struct demod_state *s, buffer_t buffer, int length)
 {
-	float s_in;
+	const float *start = buffer.fbuffer;
+	float rec[1 + 16];
 	int i;
 
-	for (; length > 0; length--, buffer.fbuffer++) {
-		s_in = *buffer.fbuffer;
-		s->l1.dtmf.energy[0] += fsqr(s_in);
-		for (i = 0; i < 8; i++) {
-			s->l1.dtmf.tenergy[0][i] += COS(s->l1.dtmf.ph[i]) * s_in;
-			s->l1.dtmf.tenergy[0][i+8] += SIN(s->l1.dtmf.ph[i]) * s_in;
-			s->l1.dtmf.ph[i] += dtmf_phinc[i];
+	if (s->l1.dtmf.filtered) {
+		/* dtmf_demod_channels() ran the filters over this block */
+		for (i = 0; i < s->l1.dtmf.nrec; i++)
+			dtmf_block(s, s->l1.dtmf.rec[i], s->l1.dtmf.rec_end[i]);
+		s->l1.dtmf.filtered = 0;
+		s->l1.dtmf.nrec = 0;
+		return;
+	}
+	while (length > 0)
+		if (goertzel_block(&s->l1.dtmf.bank, &buffer.fbuffer, &length, rec))
+			dtmf_block(s, rec, buffer.fbuffer - start);
+}
+
+/*
+ * Filter nch independent channels of length samples each, s[c] being the
+ * DTMF state of channel c (set up by demod_dtmf.init). The channels are
+ * filtered in groups, so that their Goertzel filters interleave. The
+ * records of the finished blocks wait in each state for dtmf_demod(), so
+ * that a channel's digits are printed in its turn among the demodulators.
+ */
+void dtmf_demod_channels(struct demod_state *const *s, const float *const *buf,
+			 unsigned int nch, int length)
+{
+	struct goertzel_bank *bank[DTMF_GROUP];
+	const float *in[DTMF_GROUP];
+	unsigned int first, c, m;
+	int left;
+
+	if (length > DTMF_BATCH_MAX)
+		return;
+	for (first = 0; first < nch; first += m) {
+		m = nch - first < DTMF_GROUP ? nch - first : DTMF_GROUP;
+		for (c = 0; c < m; c++) {
+			bank[c] = &s[first + c]->l1.dtmf.bank;
+			in[c] = buf[first + c];
 		}
-		if ((s->l1.dtmf.blkcount--) <= 0) {
-			s->l1.dtmf.blkcount = BLOCKLEN;
-			i = process_block(s);
-			if (i != s->l1.dtmf.lastch && i >= 0) {
-				if (!json_mode) {
-					verbprintf(0, "DTMF: %c\n", dtmf_transl[i]);
-				}
-				else {
-					cJSON *json_output = cJSON_CreateObject();
-					cJSON_AddStringToObject(json_output, "demod_name", "DTMF");
-					char digit[2] = {dtmf_transl[i], '\0'};
-					cJSON_AddStringToObject(json_output, "digit", digit);
-					addJsonTimestamp(json_output);
-					fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
-					cJSON_Delete(json_output);
-				}
+		for (c = 0; c < m; c++) {
+			s[first + c]->l1.dtmf.filtered = 1;
+			s[first + c]->l1.dtmf.nrec = 0;
+		}
+		for (left = length; left > 0; ) {
+			left -= goertzel_feed(bank, in, m, left);
+			for (c = 0; c < m; c++) {
+				struct l1_state_dtmf *d = &s[first + c]->l1.dtmf;
+
+				if (goertzel_finish(bank[c], d->rec[d->nrec]))
+					d->rec_end[d->nrec++] = length - left;
 			}
-			s->l1.dtmf.lastch = i;
 		}
 	}
 }
-				
+
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_dtmf = {
-    "DTMF", true, SAMPLE_RATE, 0, dtmf_init, dtmf_demod, NULL
+    "DTMF", true, SAMPLE_RATE, 0, dtmf_init, dtmf_demod, NULL, NULL, NULL
 };
 
 /* ---------------------------------------------------------------------- */
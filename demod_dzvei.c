@@ -33,23 +33,8 @@ static const unsigned int dzvei_freq[16] = {
 
 /* ---------------------------------------------------------------------- */
 
-static void dzvei_init(struct demod_state *s)
-{
-    selcall_init(s);
-}
-
-static void dzvei_deinit(struct demod_state *s)
-{
-    selcall_deinit(s);
-}
-
-static void dzvei_demod(struct demod_state *s, buffer_t buffer, int length)
-{
-    selcall_demod(s, buffer.fbuffer, length, dzvei_freq, demod_dzvei.name);
-}
-
 const struct demod_param demod_dzvei = {
-    "DZVEI", true, SAMPLE_RATE, 0, dzvei_init, dzvei_demod, dzvei_deinit
+    "DZVEI", true, SAMPLE_RATE, 0, selcall_init, selcall_demod, selcall_deinit, NULL, dzvei_freq
 };
 
 
@@ -40,7 +40,6 @@
 #include <stdio.h>
 #include <string.h>
 
-#include "cJSON.h"
 
 /* ---------------------------------------------------------------------- */
 
@@ -85,39 +84,26 @@
 #define MIN_IDENTICAL_MSGS 2              // # of msgs which must be identical
 
 /* ---------------------------------------------------------------------- */
-#define CORRLEN_SIZE 42                   // = (int)(FREQ_SAMP/BAUD) = (int)(22050/520.83)
 #define CORRLEN ((int)(FREQ_SAMP/BAUD))
 #define SPHASEINC (0x10000u*BAUD*SUBSAMP/FREQ_SAMP)
 
-static float eascorr_mark_i[CORRLEN_SIZE];
-static float eascorr_mark_q[CORRLEN_SIZE];
-static float eascorr_space_i[CORRLEN_SIZE];
-static float eascorr_space_q[CORRLEN_SIZE];
+static const struct fskcorr_front eas_front = {
+    FREQ_SAMP, CORRLEN, SUBSAMP, FSKCORR_RECT, 2, { FREQ_MARK, FREQ_SPACE }
+};
+static struct fskcorr_bank corr_bank;
 
 #define MAX(a,b) (((a)>(b))?(a):(b))
 #define MIN(a,b) (((a)<(b))?(a):(b))
 
-extern int json_mode;
-
 /* ---------------------------------------------------------------------- */
 
 static void eas_init(struct demod_state *s)
 {
-    float f;
-    int i;
-
     memset(&s->l1.eas, 0, sizeof(s->l1.eas));
     memset(&s->l2.eas, 0, sizeof(s->l2.eas));
-    for (f = 0, i = 0; i < CORRLEN; i++) {
-        eascorr_mark_i[i] = cos(f);
-        eascorr_mark_q[i] = sin(f);
-        f += 2.0*M_PI*FREQ_MARK/FREQ_SAMP;
-    }
-    for (f = 0, i = 0; i < CORRLEN; i++) {
-        eascorr_space_i[i] = cos(f);
-        eascorr_space_q[i] = sin(f);
-        f += 2.0*M_PI*FREQ_SPACE/FREQ_SAMP;
-    }
+    if (!corr_bank.len)
+        fskcorr_bank_init(&corr_bank, &eas_front);
+    fskcorr_init(&s->l1.eas.corr, &corr_bank);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -145,7 +131,6 @@ static void eas_frame(struct demod_state *s, char data)
 {
     int i,j = 0;
     char * ptr = 0;
-    cJSON *json_output = cJSON_CreateObject();
 
     if (data)
     {
@@ -157,7 +142,9 @@ static void eas_frame(struct demod_state *s, char data)
             s->l2.eas.headlen < MAX_HEADER_LEN)
        {
           // put it in the header buffer if we have room
-       
+          // the first character began eight bits before now
+          if (!s->l2.eas.headlen)
+             s->l2.eas.head_pos = demod_pos(s, s->rx_offset - (long)(8 * FREQ_SAMP / BAUD));
           s->l2.eas.head_buf[s->l2.eas.headlen] = data;
           s->l2.eas.headlen++;
        
@@ -168,8 +155,11 @@ static void eas_frame(struct demod_state *s, char data)
        {
           // test first 4 bytes to see if they are a header
           if (!strncmp(s->l2.eas.head_buf, HEADER_BEGIN, s->l2.eas.headlen))
+          {
              // have found header. keep reading
              s->l2.eas.state = EAS_L2_READING_MESSAGE;
+             s->l2.eas.msg_pos[s->l2.eas.msgno] = s->l2.eas.head_pos;
+          }
           else if (!strncmp(s->l2.eas.head_buf, EOM, s->l2.eas.headlen))
              // have found EOM
              s->l2.eas.state = EAS_L2_READING_EOM;
@@ -207,6 +197,7 @@ static void eas_frame(struct demod_state *s, char data)
          }
           
          // display message if verbosity permits
+         demod_mark_at(s, s->l2.eas.head_pos);
          verbprintf(7, "\n");
          verbprintf(1, "%s (part): %s%s\n", s->dem_par->name, HEADER_BEGIN,
                     s->l2.eas.msg_buf[s->l2.eas.msgno]);
@@ -237,18 +228,21 @@ static void eas_frame(struct demod_state *s, char data)
                   strncpy(s->l2.eas.last_message, s->l2.eas.msg_buf[j],
                         MAX_MSG_LEN);
                   
-                  // raise the alert and discontinue processing
+                  // raise the alert, timed by the earlier of the two,
+                  // and discontinue processing
+                  demod_mark_at(s, MIN(s->l2.eas.msg_pos[i], s->l2.eas.msg_pos[j]));
                   verbprintf(7, "\n");
-                  if (!json_mode) {
+                  if (!s->cfg->json) {
                       verbprintf(0, "%s: %s%s\n", s->dem_par->name, HEADER_BEGIN,
                                   s->l2.eas.last_message);
                   }
                   else {
-                      cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-                      cJSON_AddStringToObject(json_output, "header_begin", HEADER_BEGIN);
-                      cJSON_AddStringToObject(json_output, "last_message", s->l2.eas.last_message);
-                      addJsonTimestamp(json_output);
-                      fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
+                      json_begin();
+                      json_add_string("demod_name", s->dem_par->name);
+                      json_add_string("header_begin", HEADER_BEGIN);
+                      json_add_string("last_message", s->l2.eas.last_message);
+                      json_add_timestamp();
+                      json_end();
                   }
                   i = MAX_STORE_MSG;
                   break;
@@ -260,14 +254,16 @@ static void eas_frame(struct demod_state *s, char data)
        else if (s->l2.eas.state == EAS_L2_READING_EOM)
        {
          // raise the EOM
-         if (!json_mode) {
+         demod_mark_at(s, s->l2.eas.head_pos);
+         if (!s->cfg->json) {
              verbprintf(0, "%s: %s\n", s->dem_par->name, EOM);
          }
          else {
-             cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-             cJSON_AddStringToObject(json_output, "end_of_message", EOM);
-             addJsonTimestamp(json_output);
-             fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
+             json_begin();
+             json_add_string("demod_name", s->dem_par->name);
+             json_add_string("end_of_message", EOM);
+             json_add_timestamp();
+             json_end();
          }
        }
        // go back to idle
@@ -275,7 +271,6 @@ static void eas_frame(struct demod_state *s, char data)
        s->l2.eas.msglen = 0;
        s->l2.eas.headlen = 0;
     }
-    cJSON_Delete(json_output);
 }
 
 static void eas_demod(struct demod_state *s, buffer_t buffer, int length)
@@ -283,6 +278,8 @@ static void eas_demod(struct demod_state *s, buffer_t buffer, int length)
     float f;
     unsigned char curbit;
     float dll_gain;
+    const float *shared = fsk_shared(s, buffer, length);
+    const float *start = buffer.fbuffer;
 
     if (s->l1.eas.subsamp) {
         if (length <= (int)s->l1.eas.subsamp) {
@@ -296,10 +293,12 @@ static void eas_demod(struct demod_state *s, buffer_t buffer, int length)
     // We use a sliding window correlator which advances by SUBSAMP
     // each time. One correlator sample is output for each SUBSAMP symbols
     for (; length > 0; length -= SUBSAMP, buffer.fbuffer += SUBSAMP) {
-        f = fsqr(mac(buffer.fbuffer, eascorr_mark_i, CORRLEN)) +
-            fsqr(mac(buffer.fbuffer, eascorr_mark_q, CORRLEN)) -
-            fsqr(mac(buffer.fbuffer, eascorr_space_i, CORRLEN)) -
-            fsqr(mac(buffer.fbuffer, eascorr_space_q, CORRLEN));
+        if (shared) {
+            f = *shared++;
+        } else {
+            fskcorr_slide(&s->l1.eas.corr, buffer.fbuffer, SUBSAMP);
+            f = fskcorr_mark_space(&s->l1.eas.corr);
+        }
         // f > 0 if a mark (wireline 1) is detected
         // keep the last few correlator samples in s->l1.eas.dcd_shreg
         // when we've synchronized to the bit transitions, the dcd_shreg
@@ -363,6 +362,7 @@ static void eas_demod(struct demod_state *s, buffer_t buffer, int length)
             s->l1.afsk12.lasts |= ((s->l1.eas.dcd_integrator >= 0) << 7) & 0x80u;
 
             curbit = (s->l1.eas.lasts >> 7) & 0x1u;
+            s->rx_offset = buffer.fbuffer - start;
             verbprintf(9, "  ");
             verbprintf(7, "%c", '0'+curbit);
 
@@ -406,7 +406,7 @@ static void eas_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_eas = {
-    "EAS", true, FREQ_SAMP, CORRLEN, eas_init, eas_demod, NULL
+    "EAS", true, FREQ_SAMP, CORRLEN, eas_init, eas_demod, NULL, &eas_front, NULL
 };
 
 /* ---------------------------------------------------------------------- */
@@ -33,23 +33,8 @@ static const unsigned int eea_freq[16] = {
 
 /* ---------------------------------------------------------------------- */
 
-static void eea_init(struct demod_state *s)
-{
-    selcall_init(s);
-}
-
-static void eea_deinit(struct demod_state *s)
-{
-    selcall_deinit(s);
-}
-
-static void eea_demod(struct demod_state *s, buffer_t buffer, int length)
-{
-    selcall_demod(s, buffer.fbuffer, length, eea_freq, demod_eea.name);
-}
-
 const struct demod_param demod_eea = {
-    "EEA", true, SAMPLE_RATE, 0, eea_init, eea_demod, eea_deinit
+    "EEA", true, SAMPLE_RATE, 0, selcall_init, selcall_demod, selcall_deinit, NULL, eea_freq
 };
 
 
@@ -33,23 +33,8 @@ static const unsigned int eia_freq[16] = {
 
 /* ---------------------------------------------------------------------- */
 
-static void eia_init(struct demod_state *s)
-{
-    selcall_init(s);
-}
-
-static void eia_deinit(struct demod_state *s)
-{
-    selcall_deinit(s);
-}
-
-static void eia_demod(struct demod_state *s, buffer_t buffer, int length)
-{
-    selcall_demod(s, buffer.fbuffer, length, eia_freq, demod_eia.name);
-}
-
 const struct demod_param demod_eia = {
-    "EIA", true, SAMPLE_RATE, 0, eia_init, eia_demod, eia_deinit
+    "EIA", true, SAMPLE_RATE, 0, selcall_init, selcall_demod, selcall_deinit, NULL, eia_freq
 };
 
 
@@ -110,7 +110,6 @@
 #include <stdio.h>
 #include <inttypes.h>
 
-#include "cJSON.h"
 
 /* ---------------------------------------------------------------------- */
 
@@ -128,8 +127,6 @@
 #define CAPCODES_INDEX       0
 #define DEMOD_TIMEOUT        100           // Maximum number of periods with no zero crossings before we decide that the system is not longer within a Timing lock.
 
-int flex_disable_timestamp = 0;
-
 
 enum Flex_PageTypeEnum {
   FLEX_PAGETYPE_SECURE,
@@ -194,6 +191,7 @@ struct Flex_Sync {
   unsigned int                levels;        // FSK encoding of SYNC2 and DATA
   unsigned int                polarity;      // 0=Positive (Normal) 1=Negative (Inverted)
   uint64_t                    syncbuf;
+  uint64_t                    start;         // Stream index where the sync word was found
 };
 
 
@@ -203,6 +201,8 @@ struct Flex_FIW {
   unsigned int                cycleno;
   unsigned int                frameno;
   unsigned int                fix3;
+  int                         estimatedPassedHourlySeconds;
+  int                         lastTimeseconds;  // -1 until the first FIW
 };
 
 
@@ -238,10 +238,10 @@ struct Flex {
   struct Flex_Data            Data;
   struct Flex_Decode          Decode;
   struct Flex_GroupHandler    GroupHandler;
+  const struct multimon_config *cfg;
+  struct demod_state          *demod;        // Instance decoding it, for the time stamps
 };
 
-extern int json_mode;
-
 static int is_alphanumeric_page(struct Flex * flex) {
   if (flex==NULL) return 0;
   return (flex->Decode.type == FLEX_PAGETYPE_ALPHANUMERIC ||
@@ -394,9 +394,6 @@ static void read_2fsk(struct Flex * flex, unsigned int sym, unsigned int * dat)
   *dat = (*dat >> 1) | ((sym > 1)?0x80000000:0);
 }
 
-int estimatedPassedHourlySeconds = 0;
-int lastTimeseconds = -1;
-
 static int decode_fiw(struct Flex * flex) {
   if (flex==NULL) return -1;
   unsigned int fiw = flex->FIW.rawdata;
@@ -426,17 +423,17 @@ static int decode_fiw(struct Flex * flex) {
   if (checksum == 0xF) {
     int timeseconds = flex->FIW.cycleno*4*60 + flex->FIW.frameno*4*60/128;
 
-    if(lastTimeseconds == -1) // Initialize
+    if(flex->FIW.lastTimeseconds == -1) // Initialize
     {
       // Estimate the offset based on first detected frame, calculate hour offset of first frame
-      estimatedPassedHourlySeconds -= timeseconds;
+      flex->FIW.estimatedPassedHourlySeconds -= timeseconds;
     }
 
-    bool isHourlyRollover = lastTimeseconds > timeseconds;
-    lastTimeseconds = timeseconds;
-    if(isHourlyRollover) estimatedPassedHourlySeconds += 3600;
+    bool isHourlyRollover = flex->FIW.lastTimeseconds > timeseconds;
+    flex->FIW.lastTimeseconds = timeseconds;
+    if(isHourlyRollover) flex->FIW.estimatedPassedHourlySeconds += 3600;
 
-    int estimatedOffset = estimatedPassedHourlySeconds + timeseconds;
+    int estimatedOffset = flex->FIW.estimatedPassedHourlySeconds + timeseconds;
 
     int seconds = estimatedOffset;
     int days = seconds/86400; seconds -= 86400*days;
@@ -536,19 +533,35 @@ static int decode_fiw(struct Flex * flex) {
   }
 }
 
+/* Start a --json record with the fields every FLEX page carries */
+static void flex_json_begin(struct Flex * flex, char PhaseNo, const struct tm * gmt) {
+  char json_temp[100];
+  char buffer[2] = {PhaseNo, '\0'};
+
+  // Lets just always send timestamp, the user can discard
+  sprintf(json_temp,  "%04i-%02i-%02i %02i:%02i:%02i",
+          gmt->tm_year+1900, gmt->tm_mon+1, gmt->tm_mday, gmt->tm_hour, gmt->tm_min, gmt->tm_sec);
+  json_begin();
+  json_add_string("timestamp", json_temp);
+  json_add_int("sync_baud", flex->Sync.baud);
+  json_add_int("sync_level", flex->Sync.levels);
+  json_add_string("phase_number", buffer);
+  json_add_int("cycle_number", flex->FIW.cycleno);
+  json_add_int("frame_number", flex->FIW.frameno);
+  json_add_int("capcode", flex->Decode.capcode);
+}
+
 static void parse_alphanumeric(struct Flex * flex, unsigned int * phaseptr, char PhaseNo, int mw1, int mw2, int flex_groupmessage) {
         if (flex==NULL) return;
         verbprintf(3, "FLEX: Parse Alpha Numeric\n");
 
         int i;
-        time_t now=time(NULL);
+        time_t now=output_time();
         struct tm * gmt=gmtime(&now);
         // char buf[1024], *message;
         char message[1024];
         int  currentChar = 0; 
         char frag_flag = '?';
-        cJSON *json_output = cJSON_CreateObject();
-        static char json_temp[100];
 
         int frag = (phaseptr[mw1] >> 11) & 0x03;
         int cont = (phaseptr[mw1] >> 0x0A) & 0x01;
@@ -614,12 +627,12 @@ static void parse_alphanumeric(struct Flex * flex, unsigned int * phaseptr, char
         }
 */
 
-        static char pt_out[4096] = { 0 };
+        char pt_out[4096];
 
         int pt_offset;
 
-        if (!json_mode) {
-          if(flex_disable_timestamp)
+        if (!flex->cfg->json) {
+          if(flex->cfg->flex_disable_timestamp)
           {
             pt_offset = sprintf(pt_out, "FLEX|%i/%i/%c/%c|%02i.%03i|%09" PRId64,
                           flex->Sync.baud, flex->Sync.levels, frag_flag, PhaseNo, flex->FIW.cycleno, flex->FIW.frameno, flex->Decode.capcode);
@@ -632,18 +645,7 @@ static void parse_alphanumeric(struct Flex * flex, unsigned int * phaseptr, char
           }
         }
         else {
-            // Lets just always send timestamp, the user can discard
-            sprintf(json_temp,  "%04i-%02i-%02i %02i:%02i:%02i",
-                    gmt->tm_year+1900, gmt->tm_mon+1, gmt->tm_mday, gmt->tm_hour, gmt->tm_min, gmt->tm_sec);
-            cJSON_AddStringToObject(json_output, "timestamp", json_temp);
-            cJSON_AddNumberToObject(json_output, "sync_baud", flex->Sync.baud);
-            cJSON_AddNumberToObject(json_output, "sync_level", flex->Sync.levels);
-            char buffer[2] = "";  // Buffer to hold the string representation of PhaseNo.
-            snprintf(buffer, sizeof(buffer), "%c", PhaseNo);  // Convert PhaseNo into a C-string in buffer.
-            cJSON_AddStringToObject(json_output, "phase_number", buffer);
-            cJSON_AddNumberToObject(json_output, "cycle_number", flex->FIW.cycleno);
-            cJSON_AddNumberToObject(json_output, "frame_number", flex->FIW.frameno);
-            cJSON_AddNumberToObject(json_output, "capcode", flex->Decode.capcode);
+            flex_json_begin(flex, PhaseNo, gmt);
         }
 
         // Implemented bierviltje code from ticket: https://github.com/EliasOenal/multimon-ng/issues/123# 
@@ -663,18 +665,16 @@ static void parse_alphanumeric(struct Flex * flex, unsigned int * phaseptr, char
                 flex->GroupHandler.GroupFrame[groupbit] = -1;
                 flex->GroupHandler.GroupCycle[groupbit] = -1;
         } 
-        if (!json_mode) {
+        if (!flex->cfg->json) {
           pt_offset += sprintf(pt_out + pt_offset, "|ALN|%s", message);
           verbprintf(0, "%s\n", pt_out);
         }
         else {
-            cJSON_AddStringToObject(json_output, "demod_name", "flex_alphanumeric");
-            cJSON_AddStringToObject(json_output, "message", message);
-            addJsonTimestamp(json_output);
-            fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
+            json_add_string("demod_name", "flex_alphanumeric");
+            json_add_string("message", message);
+            json_add_timestamp();
+            json_end();
         }
-  verbprintf(1, "Delete json_output\n");
-  cJSON_Delete(json_output);
 }
 
 static void parse_numeric(struct Flex * flex, unsigned int * phaseptr, char PhaseNo, int j) {
@@ -686,13 +686,12 @@ static void parse_numeric(struct Flex * flex, unsigned int * phaseptr, char Phas
   w1 = w1 & 0x7f;
   w2 = (w2 & 0x07) + w1;  // numeric message is 7 words max
 
-  time_t now=time(NULL);
+  time_t now=output_time();
   struct tm * gmt=gmtime(&now);
-  cJSON *json_output = cJSON_CreateObject();
-  static char json_temp[100];
+  char json_temp[100];
 
-  if (!json_mode) {
-    if(flex_disable_timestamp)
+  if (!flex->cfg->json) {
+    if(flex->cfg->flex_disable_timestamp)
     {
       verbprintf(0,  "FLEX|%i/%i/%c|%02i.%03i|[%09lld]|NUM ",
                  flex->Sync.baud, flex->Sync.levels, PhaseNo, flex->FIW.cycleno, flex->FIW.frameno, flex->Decode.capcode);
@@ -704,18 +703,7 @@ static void parse_numeric(struct Flex * flex, unsigned int * phaseptr, char Phas
     }
   }
   else {
-      // Lets just always send timestamp, the user can discard
-      sprintf(json_temp,  "%04i-%02i-%02i %02i:%02i:%02i",
-              gmt->tm_year+1900, gmt->tm_mon+1, gmt->tm_mday, gmt->tm_hour, gmt->tm_min, gmt->tm_sec);
-      cJSON_AddStringToObject(json_output, "timestamp", json_temp);
-      cJSON_AddNumberToObject(json_output, "sync_baud", flex->Sync.baud);
-      cJSON_AddNumberToObject(json_output, "sync_level", flex->Sync.levels);
-      char buffer[2] = "";  // Buffer to hold the string representation of PhaseNo.
-      snprintf(buffer, sizeof(buffer), "%c", PhaseNo);  // Convert PhaseNo into a C-string in buffer.
-      cJSON_AddStringToObject(json_output, "phase_number", buffer);
-      cJSON_AddNumberToObject(json_output, "cycle_number", flex->FIW.cycleno);
-      cJSON_AddNumberToObject(json_output, "frame_number", flex->FIW.frameno);
-      cJSON_AddNumberToObject(json_output, "capcode", flex->Decode.capcode);
+      flex_json_begin(flex, PhaseNo, gmt);
   }
 
   // Get first dataword from message field or from second
@@ -750,7 +738,7 @@ static void parse_numeric(struct Flex * flex, unsigned int * phaseptr, char Phas
       if(--count == 0) {
         // The following if statement removes spaces between the numbers
         if(digit != 0x0C) {// Fill
-          if (!json_mode) {
+          if (!flex->cfg->json) {
             verbprintf(0, "%c", flex_bcd[digit]);
           }
           else {
@@ -762,15 +750,14 @@ static void parse_numeric(struct Flex * flex, unsigned int * phaseptr, char Phas
     }
     dw = phaseptr[i];
   }
-  if (!json_mode) {
+  if (!flex->cfg->json) {
     verbprintf(0, "\n");
   }
   else {
-    cJSON_AddStringToObject(json_output, "demod_name", "flex_numeric");
-    cJSON_AddStringToObject(json_output, "message", json_temp);
-    addJsonTimestamp(json_output);
-    fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
-    cJSON_Delete(json_output);
+    json_add_string("demod_name", "flex_numeric");
+    json_add_string("message", json_temp);
+    json_add_timestamp();
+    json_end();
   }
 }
 
@@ -787,13 +774,12 @@ static void parse_tone_only(struct Flex * flex, unsigned int * phaseptr, char Ph
   if (flex==NULL) return;
   unsigned const char flex_bcd[17] = "0123456789 U -][";
   
-  time_t now=time(NULL);
+  time_t now=output_time();
   struct tm * gmt=gmtime(&now);
-  cJSON *json_output = cJSON_CreateObject();
-  static char json_temp[100];
+  char json_temp[100];
 
-  if (!json_mode) {
-    if(flex_disable_timestamp)
+  if (!flex->cfg->json) {
+    if(flex->cfg->flex_disable_timestamp)
     {
       verbprintf(0,  "FLEX|%i/%i/%c|%02i.%03i|[%09lld]|TON ",
                  flex->Sync.baud, flex->Sync.levels, PhaseNo, flex->FIW.cycleno, flex->FIW.frameno, flex->Decode.capcode);
@@ -806,18 +792,7 @@ static void parse_tone_only(struct Flex * flex, unsigned int * phaseptr, char Ph
     }
   }
   else {
-      // Lets just always send timestamp, the user can discard
-      sprintf(json_temp,  "%04i-%02i-%02i %02i:%02i:%02i",
-              gmt->tm_year+1900, gmt->tm_mon+1, gmt->tm_mday, gmt->tm_hour, gmt->tm_min, gmt->tm_sec);
-      cJSON_AddStringToObject(json_output, "timestamp", json_temp);
-      cJSON_AddNumberToObject(json_output, "sync_baud", flex->Sync.baud);
-      cJSON_AddNumberToObject(json_output, "sync_level", flex->Sync.levels);
-      char buffer[2] = "";  // Buffer to hold the string representation of PhaseNo.
-      snprintf(buffer, sizeof(buffer), "%c", PhaseNo);  // Convert PhaseNo into a C-string in buffer.
-      cJSON_AddStringToObject(json_output, "phase_number", buffer);
-      cJSON_AddNumberToObject(json_output, "cycle_number", flex->FIW.cycleno);
-      cJSON_AddNumberToObject(json_output, "frame_number", flex->FIW.frameno);
-      cJSON_AddNumberToObject(json_output, "capcode", flex->Decode.capcode);
+      flex_json_begin(flex, PhaseNo, gmt);
   }
 
   // message type
@@ -831,15 +806,15 @@ static void parse_tone_only(struct Flex * flex, unsigned int * phaseptr, char Ph
     for (i=9; i<=17; i+=4)
     {
       digit = (phaseptr[j] >> i) & 0x0f;
-      if (!json_mode) {
+      if (!flex->cfg->json) {
         verbprintf(0, "%c", flex_bcd[digit]);
       }
       else {
         strncat(json_temp, (char*)&flex_bcd[digit], 1);
       }
     }
-    if(json_mode) {
-      cJSON_AddStringToObject(json_output, "tone", json_temp);
+    if(flex->cfg->json) {
+      json_add_string("tone", json_temp);
       json_temp[0] = '\0';
     }
 
@@ -848,38 +823,36 @@ static void parse_tone_only(struct Flex * flex, unsigned int * phaseptr, char Ph
       for (i=0; i<=16; i+=4)
       {
         digit = (phaseptr[j+1] >> i) & 0x0f;
-        if (!json_mode) {
+        if (!flex->cfg->json) {
           verbprintf(0, "%c", flex_bcd[digit]);
         }
         else {
           strncat(json_temp, (char*)&flex_bcd[digit], 1);
         }
       }
-      if(json_mode) {
-        cJSON_AddStringToObject(json_output, "tone_long", json_temp);
+      if(flex->cfg->json) {
+        json_add_string("tone_long", json_temp);
       }
     }
   }
-  if (!json_mode) {
+  if (!flex->cfg->json) {
     verbprintf(0, "\n");
   }
   else {
-    cJSON_AddStringToObject(json_output, "demod_name", "flex_tone_only");
-    addJsonTimestamp(json_output);
-    fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
-    cJSON_Delete(json_output);
+    json_add_string("demod_name", "flex_tone_only");
+    json_add_timestamp();
+    json_end();
   }
 }
 
 static void parse_unknown(struct Flex * flex, unsigned int * phaseptr, char PhaseNo, int mw1, int mw2) {
   if (flex==NULL) return;
-  time_t now=time(NULL);
+  time_t now=output_time();
   struct tm * gmt=gmtime(&now);
-  cJSON *json_output = cJSON_CreateObject();
-  static char json_temp[100];
+  char json_temp[100];
 
-  if (!json_mode) {
-    if(flex_disable_timestamp)
+  if (!flex->cfg->json) {
+    if(flex->cfg->flex_disable_timestamp)
     {
       verbprintf(0,  "FLEX|%i/%i/%c|%02i.%03i|[%09lld]|UNK",
           flex->Sync.baud, flex->Sync.levels, PhaseNo, flex->FIW.cycleno, flex->FIW.frameno, flex->Decode.capcode);
@@ -892,39 +865,27 @@ static void parse_unknown(struct Flex * flex, unsigned int * phaseptr, char Phas
     }
   }
   else {
-      // Lets just always send timestamp, the user can discard
-      sprintf(json_temp,  "%04i-%02i-%02i %02i:%02i:%02i",
-              gmt->tm_year+1900, gmt->tm_mon+1, gmt->tm_mday, gmt->tm_hour, gmt->tm_min, gmt->tm_sec);
-      cJSON_AddStringToObject(json_output, "timestamp", json_temp);
-      cJSON_AddNumberToObject(json_output, "sync_baud", flex->Sync.baud);
-      cJSON_AddNumberToObject(json_output, "sync_level", flex->Sync.levels);
-      char buffer[2] = "";  // Buffer to hold the string representation of PhaseNo.
-      snprintf(buffer, sizeof(buffer), "%c", PhaseNo);  // Convert PhaseNo into a C-string in buffer.
-      cJSON_AddStringToObject(json_output, "phase_number", buffer);
-      cJSON_AddNumberToObject(json_output, "cycle_number", flex->FIW.cycleno);
-      cJSON_AddNumberToObject(json_output, "frame_number", flex->FIW.frameno);
-      cJSON_AddNumberToObject(json_output, "capcode", flex->Decode.capcode);
+      flex_json_begin(flex, PhaseNo, gmt);
   }
 
   int i;
   json_temp[0] = '\0';
   for (i = mw1; i <= mw2; i++) {
-    if (!json_mode) {
+    if (!flex->cfg->json) {
       verbprintf(0, " %08x", phaseptr[i]);
     }
     else {
       strncat(json_temp, (char*)&phaseptr[i], 1);
     }
   }
-  if (!json_mode) {
+  if (!flex->cfg->json) {
     verbprintf(0, "\n");
   }
   else {
-    cJSON_AddStringToObject(json_output, "demod_name", "flex_unknown");
-    cJSON_AddStringToObject(json_output, "message", json_temp);
-    addJsonTimestamp(json_output);
-    fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
-    cJSON_Delete(json_output);
+    json_add_string("demod_name", "flex_unknown");
+    json_add_string("message", json_temp);
+    json_add_timestamp();
+    json_end();
   }
 }
 
@@ -1239,6 +1200,12 @@ static int read_data(struct Flex * flex, unsigned char sym) {
 }
 
 
+/* Time what is printed next by the sample being demodulated */
+static void mark_now(struct Flex * flex) {
+  demod_mark(flex->demod, flex->demod->rx_offset);
+}
+
+
 static void report_state(struct Flex * flex) {
   if (flex->State.Current != flex->State.Previous) {
     flex->State.Previous = flex->State.Current;
@@ -1261,6 +1228,7 @@ static void report_state(struct Flex * flex) {
         break;
 
     }
+    mark_now(flex);
     verbprintf(1, "FLEX: State: %s\n", state);
   }
 }
@@ -1284,6 +1252,9 @@ static void flex_sym(struct Flex * flex, unsigned char sym) {
         // against the known FLEX sync words.
         unsigned int sync_code=flex_sync(flex, sym); //Unrectified version of the symbol must be used here
         if (sync_code!=0) {
+          // Messages of the frame are timed by its sync word
+          flex->Sync.start = demod_rx_pos(flex->demod);
+          demod_mark_at(flex->demod, flex->Sync.start);
           decode_mode(flex,sync_code);
 
           if (flex->Sync.baud!=0 && flex->Sync.levels!=0) {
@@ -1314,6 +1285,7 @@ static void flex_sym(struct Flex * flex, unsigned char sym) {
         }
 
         if (flex->State.fiwcount==48) {
+          demod_mark_at(flex->demod, flex->Sync.start);
           if (decode_fiw(flex)==0) {
             flex->State.sync2_count=0;
             flex->Demodulator.baud = flex->Sync.baud;
@@ -1347,6 +1319,7 @@ static void flex_sym(struct Flex * flex, unsigned char sym) {
         // to each of the four transmitted phases of FLEX interleaved codes.
         int idle=read_data(flex, sym_rectified);
         if (++flex->State.data_count == flex->Sync.baud*1760/1000 || idle) {
+          demod_mark_at(flex->demod, flex->Sync.start);
           decode_data(flex);
           flex->Demodulator.baud = 1600;
           flex->State.Current=FLEX_STATE_SYNC1;
@@ -1432,6 +1405,7 @@ static int buildSymbol(struct Flex * flex, double sample) {
                 if (phasepercent > 10 && phasepercent < 90) {
                         flex->Demodulator.nonconsec++;
                         if (flex->Demodulator.nonconsec>20 && flex->Demodulator.locked) {
+                                mark_now(flex);
                                 verbprintf(1, "FLEX: Synchronisation Lost\n");
                                 flex->Demodulator.locked = 0;
                         }
@@ -1491,6 +1465,7 @@ static void Flex_Demodulate(struct Flex * flex, double sample) {
       uint64_t lock_pattern = flex->Demodulator.lock_buf ^ 0x6666666666666666ull;
       uint64_t lock_mask = (1ull << (2 * LOCK_LEN)) - 1;
       if ((lock_pattern&lock_mask) == 0 || ((~lock_pattern)&lock_mask) == 0) {
+        mark_now(flex);
         verbprintf(1, "FLEX: Locked\n");
         flex->Demodulator.locked = 1;
         /*Clear the syncronisation buffer*/
@@ -1503,6 +1478,7 @@ static void Flex_Demodulate(struct Flex * flex, double sample) {
     /*Time out after X periods with no zero crossing*/
     flex->Demodulator.timeout++;
     if (flex->Demodulator.timeout>DEMOD_TIMEOUT) {
+      mark_now(flex);
       verbprintf(1, "FLEX: Timeout\n");
       flex->Demodulator.locked = 0;
     }
@@ -1517,11 +1493,15 @@ static void Flex_Delete(struct Flex * flex) {
 }
 
 
-static struct Flex * Flex_New(unsigned int SampleFrequency) {
+static struct Flex * Flex_New(unsigned int SampleFrequency, struct demod_state *s) {
   struct Flex *flex=(struct Flex *)malloc(sizeof(struct Flex));
   if (flex!=NULL) {
     memset(flex, 0, sizeof(struct Flex));
 
+    flex->cfg = s->cfg;
+    flex->demod = s;
+    flex->FIW.lastTimeseconds = -1;
+
     flex->Demodulator.sample_freq=SampleFrequency;
     // The baud rate of first syncword and FIW is always 1600, so set that
     // rate to start.
@@ -1546,6 +1526,7 @@ static void flex_demod(struct demod_state *s, buffer_t buffer, int length) {
   if (s->l1.flex==NULL) return;
   int i;
   for (i=0; i<length; i++) {
+    s->rx_offset = i;
     Flex_Demodulate(s->l1.flex, buffer.fbuffer[i]);
   }
 }
@@ -1553,7 +1534,7 @@ static void flex_demod(struct demod_state *s, buffer_t buffer, int length) {
 
 static void flex_init(struct demod_state *s) {
   if (s==NULL) return;
-  s->l1.flex=Flex_New(FREQ_SAMP);
+  s->l1.flex=Flex_New(FREQ_SAMP, s);
 }
 
 
@@ -1567,5 +1548,5 @@ static void flex_deinit(struct demod_state *s) {
 
 
 const struct demod_param demod_flex = {
-  "FLEX", true, FREQ_SAMP, FILTLEN, flex_init, flex_demod, flex_deinit
+  "FLEX", true, FREQ_SAMP, FILTLEN, flex_init, flex_demod, flex_deinit, NULL, NULL
 };
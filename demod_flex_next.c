@@ -198,6 +198,7 @@ struct Flex_Sync {
   unsigned int                levels;        // FSK encoding of SYNC2 and DATA
   unsigned int                polarity;      // 0=Positive (Normal) 1=Negative (Inverted)
   uint64_t                    syncbuf;
+  uint64_t                    start;         // Stream index where the sync word was found
 };
 
 
@@ -242,6 +243,7 @@ struct Flex_Next {
   struct Flex_Data            Data;
   struct Flex_Decode          Decode;
         struct Flex_GroupHandler    GroupHandler;
+  struct demod_state          *demod;        // Instance decoding it, for the time stamps
 };
 
 
@@ -1065,6 +1067,12 @@ static int read_data(struct Flex_Next * flex, unsigned char sym) {
 }
 
 
+/* Time what is printed next by the sample being demodulated */
+static void mark_now(struct Flex_Next * flex) {
+  demod_mark(flex->demod, flex->demod->rx_offset);
+}
+
+
 static void report_state(struct Flex_Next * flex) {
   if (flex->State.Current != flex->State.Previous) {
     flex->State.Previous = flex->State.Current;
@@ -1087,6 +1095,7 @@ static void report_state(struct Flex_Next * flex) {
         break;
 
     }
+    mark_now(flex);
     verbprintf(1, "FLEX_NEXT: State: %s\n", state);
   }
 }
@@ -1110,6 +1119,9 @@ static void flex_sym(struct Flex_Next * flex, unsigned char sym) {
         // against the known FLEX sync words.
         unsigned int sync_code=flex_sync(flex, sym); //Unrectified version of the symbol must be used here
         if (sync_code!=0) {
+          // Messages of the frame are timed by its sync word
+          flex->Sync.start = demod_rx_pos(flex->demod);
+          demod_mark_at(flex->demod, flex->Sync.start);
           decode_mode(flex,sync_code);
 
           if (flex->Sync.baud!=0 && flex->Sync.levels!=0) {
@@ -1140,6 +1152,7 @@ static void flex_sym(struct Flex_Next * flex, unsigned char sym) {
         }
 
         if (flex->State.fiwcount==48) {
+          demod_mark_at(flex->demod, flex->Sync.start);
           if (decode_fiw(flex)==0) {
             flex->State.sync2_count=0;
             flex->Demodulator.baud = flex->Sync.baud;
@@ -1173,6 +1186,7 @@ static void flex_sym(struct Flex_Next * flex, unsigned char sym) {
         // to each of the four transmitted phases of FLEX interleaved codes.
         int idle=read_data(flex, sym_rectified);
         if (++flex->State.data_count == flex->Sync.baud*1760/1000 || idle) {
+          demod_mark_at(flex->demod, flex->Sync.start);
           decode_data(flex);
           flex->Demodulator.baud = 1600;
           flex->State.Current=FLEX_STATE_SYNC1;
@@ -1258,6 +1272,7 @@ static int buildSymbol(struct Flex_Next * flex, double sample) {
                 if (phasepercent > 10 && phasepercent < 90) {
                         flex->Demodulator.nonconsec++;
                         if (flex->Demodulator.nonconsec>20 && flex->Demodulator.locked) {
+                                mark_now(flex);
                                 verbprintf(1, "FLEX_NEXT: Synchronisation Lost\n");
                                 flex->Demodulator.locked = 0;
                         }
@@ -1317,6 +1332,7 @@ static void Flex_Demodulate(struct Flex_Next * flex, double sample) {
       uint64_t lock_pattern = flex->Demodulator.lock_buf ^ 0x6666666666666666ull;
       uint64_t lock_mask = (1ull << (2 * LOCK_LEN)) - 1;
       if ((lock_pattern&lock_mask) == 0 || ((~lock_pattern)&lock_mask) == 0) {
+        mark_now(flex);
         verbprintf(1, "FLEX_NEXT: Locked\n");
         flex->Demodulator.locked = 1;
         /*Clear the syncronisation buffer*/
@@ -1329,6 +1345,7 @@ static void Flex_Demodulate(struct Flex_Next * flex, double sample) {
     /*Time out after X periods with no zero crossing*/
     flex->Demodulator.timeout++;
     if (flex->Demodulator.timeout>DEMOD_TIMEOUT) {
+      mark_now(flex);
       verbprintf(1, "FLEX_NEXT: Timeout\n");
       flex->Demodulator.locked = 0;
     }
@@ -1343,11 +1360,13 @@ static void Flex_Delete(struct Flex_Next * flex) {
 }
 
 
-static struct Flex_Next * Flex_New(unsigned int SampleFrequency) {
+static struct Flex_Next * Flex_New(unsigned int SampleFrequency, struct demod_state *s) {
   struct Flex_Next *flex=(struct Flex_Next *)malloc(sizeof(struct Flex_Next));
   if (flex!=NULL) {
     memset(flex, 0, sizeof(struct Flex_Next));
 
+    flex->demod = s;
+
     flex->Demodulator.sample_freq=SampleFrequency;
     // The baud rate of first syncword and FIW is always 1600, so set that
     // rate to start.
@@ -1372,6 +1391,7 @@ static void flex_next_demod(struct demod_state *s, buffer_t buffer, int length)
   if (s->l1.flex_next==NULL) return;
   int i;
   for (i=0; i<length; i++) {
+    s->rx_offset = i;
     Flex_Demodulate(s->l1.flex_next, buffer.fbuffer[i]);
   }
 }
@@ -1379,7 +1399,7 @@ static void flex_next_demod(struct demod_state *s, buffer_t buffer, int length)
 
 static void flex_next_init(struct demod_state *s) {
   if (s==NULL) return;
-  s->l1.flex_next=Flex_New(FREQ_SAMP);
+  s->l1.flex_next=Flex_New(FREQ_SAMP, s);
 }
 
 
@@ -1393,5 +1413,5 @@ static void flex_next_deinit(struct demod_state *s) {
 
 
 const struct demod_param demod_flex_next = {
-  "FLEX_NEXT", true, FREQ_SAMP, FILTLEN, flex_next_init, flex_next_demod, flex_next_deinit
+  "FLEX_NEXT", true, FREQ_SAMP, FILTLEN, flex_next_init, flex_next_demod, flex_next_deinit, NULL, NULL
 };
@@ -44,30 +44,20 @@
 #define CORRLEN ((int)(FREQ_SAMP/BAUD))
 #define SPHASEINC (0x10000u*BAUD*SUBSAMP/FREQ_SAMP)
 
-static float corr_1_i[CORRLEN];
-static float corr_1_q[CORRLEN];
-static float corr_0_i[CORRLEN];
-static float corr_0_q[CORRLEN];
+static const struct fskcorr_front fmsfsk_front = {
+    FREQ_SAMP, CORRLEN, SUBSAMP, FSKCORR_RECT, 2, { FREQ_1, FREQ_0 }
+};
+static struct fskcorr_bank corr_bank;
 
 /* ---------------------------------------------------------------------- */
 
 static void fmsfsk_init(struct demod_state *s)
 {
-    float f;
-    int i;
-
     fms_init(s);
     memset(&s->l1.fmsfsk, 0, sizeof(s->l1.fmsfsk));
-    for (f = 0, i = 0; i < CORRLEN; i++) {
-        corr_1_i[i] = cos(f);
-        corr_1_q[i] = sin(f);
-        f += 2.0*M_PI*FREQ_1/FREQ_SAMP;
-    }
-    for (f = 0, i = 0; i < CORRLEN; i++) {
-        corr_0_i[i] = cos(f);
-        corr_0_q[i] = sin(f);
-        f += 2.0*M_PI*FREQ_0/FREQ_SAMP;
-    }
+    if (!corr_bank.len)
+        fskcorr_bank_init(&corr_bank, &fmsfsk_front);
+    fskcorr_init(&s->l1.fmsfsk.corr, &corr_bank);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -76,6 +66,8 @@ static void fmsfsk_demod(struct demod_state *s, buffer_t buffer, int length)
 {
     float f;
     unsigned char curbit;
+    const float *start = buffer.fbuffer;
+    const float *shared = fsk_shared(s, buffer, length);
 
     if (s->l1.fmsfsk.subsamp) {
         if (length <= (int)s->l1.fmsfsk.subsamp) {
@@ -87,10 +79,12 @@ static void fmsfsk_demod(struct demod_state *s, buffer_t buffer, int length)
         s->l1.fmsfsk.subsamp = 0;
     }
     for (; length > 0; length -= SUBSAMP, buffer.fbuffer += SUBSAMP) {
-        f = 	fsqr(mac(buffer.fbuffer, corr_1_i, CORRLEN)) +
-            fsqr(mac(buffer.fbuffer, corr_1_q, CORRLEN)) -
-            fsqr(mac(buffer.fbuffer, corr_0_i, CORRLEN)) -
-            fsqr(mac(buffer.fbuffer, corr_0_q, CORRLEN));
+        if (shared) {
+            f = *shared++;
+        } else {
+            fskcorr_slide(&s->l1.fmsfsk.corr, buffer.fbuffer, SUBSAMP);
+            f = fskcorr_mark_space(&s->l1.fmsfsk.corr);
+        }
         s->l1.fmsfsk.dcd_shreg <<= 1;
         s->l1.fmsfsk.dcd_shreg |= (f > 0);
         verbprintf(10, "%c", '0'+(s->l1.fmsfsk.dcd_shreg & 1));
@@ -108,6 +102,7 @@ static void fmsfsk_demod(struct demod_state *s, buffer_t buffer, int length)
             s->l1.fmsfsk.sphase &= 0xffffu;
             curbit = s->l1.fmsfsk.dcd_shreg & 1;
             verbprintf(9, "FMS %c ", '0'+curbit);
+            s->rx_offset = buffer.fbuffer - start;
             fms_rxbit(s, curbit);
         }
     }
@@ -117,7 +112,7 @@ static void fmsfsk_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_fmsfsk = {
-    "FMSFSK", true, FREQ_SAMP, CORRLEN, fmsfsk_init, fmsfsk_demod, NULL
+    "FMSFSK", true, FREQ_SAMP, CORRLEN, fmsfsk_init, fmsfsk_demod, NULL, &fmsfsk_front, NULL
 };
 
 /* ---------------------------------------------------------------------- */
@@ -86,6 +86,7 @@ static void fsk96_demod(struct demod_state *s, buffer_t buffer, int length)
 {
 	float f;
 	unsigned char curbit;
+	const float *start = buffer.fbuffer;
 	int i;
 	unsigned int descx;
 
@@ -113,6 +114,7 @@ static void fsk96_demod(struct demod_state *s, buffer_t buffer, int length)
 				curbit = ((descx >> DESCRAM_TAPSH1) ^ (descx >> DESCRAM_TAPSH2) ^
 					  (descx >> DESCRAM_TAPSH3) ^ 1) & 1;
 				verbprintf(9, " %c ", '0'+curbit);
+				s->rx_offset = buffer.fbuffer - start;
 				hdlc_rxbit(s, curbit);
 			}
 		}
@@ -122,7 +124,7 @@ static void fsk96_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_fsk9600 = {
-    "FSK9600", true, FREQ_SAMP, FILTLEN, fsk96_init, fsk96_demod, NULL
+    "FSK9600", true, FREQ_SAMP, FILTLEN, fsk96_init, fsk96_demod, NULL, NULL, NULL
 };
 
 /* ---------------------------------------------------------------------- */
@@ -48,6 +48,7 @@ static void hapn48_init(struct demod_state *s)
 static void hapn48_demod(struct demod_state *s, buffer_t buffer, int length)
 {
 	unsigned int curbit;
+	const float *start = buffer.fbuffer;
 
 	for (; length > 0; length--, buffer.fbuffer++) {
 		s->l1.hapn48.lvlhi *= 0.999;
@@ -89,6 +90,7 @@ static void hapn48_demod(struct demod_state *s, buffer_t buffer, int length)
 			s->l1.hapn48.sphase &= 0xffff;
 			curbit = ((s->l1.hapn48.shreg >> 4) ^ s->l1.hapn48.shreg ^ 1) & 1;
 			verbprintf(9, " %c ", '0'+curbit);
+			s->rx_offset = buffer.fbuffer - start;
 			hdlc_rxbit(s, curbit);
 		}
 	}
@@ -97,7 +99,7 @@ static void hapn48_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_hapn4800 = {
-    "HAPN4800", true, FREQ_SAMP, 3, hapn48_init, hapn48_demod, NULL
+    "HAPN4800", true, FREQ_SAMP, 3, hapn48_init, hapn48_demod, NULL, NULL, NULL
 };
 
 /* ---------------------------------------------------------------------- */
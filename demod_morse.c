@@ -35,11 +35,6 @@
 // Threshold between:   DITs and DAHs is 2*cw_dit_length
 //                      GAPS and EOC  is 2*cw_gap_length
 //                      EOC  and EOW  is 5*cw_gap_length
-int cw_dit_length = 50;
-int cw_gap_length = 50;
-int cw_threshold = 500;
-bool cw_disable_auto_threshold = false;
-bool cw_disable_auto_timing = false;
 
 static const struct morse_codes
 {
@@ -254,7 +249,7 @@ static void morse_demod(struct demod_state * restrict const s,
         if(s->l1.morse.samples_since_change < INT_FAST32_MAX/1000)
             s->l1.morse.samples_since_change++;
         
-        if(!cw_disable_auto_threshold) auto_threshold(s);
+        if(!s->cfg->cw_disable_auto_threshold) auto_threshold(s);
         
         int_fast8_t oldstate = s->l1.morse.current_state;
         
@@ -268,6 +263,9 @@ static void morse_demod(struct demod_state * restrict const s,
         int_fast8_t statechange = oldstate != s->l1.morse.current_state;
         int_fast8_t timeout = s->l1.morse.samples_since_change == 5*s->l1.morse.time_unit_gaps_samples;
         
+        if(statechange && oldstate == LOW && !s->l1.morse.current_sequence)
+            s->l1.morse.char_start = demod_pos(s, i);
+        
         // Enter on state transition or timeout
         if(statechange || timeout)
         {
@@ -288,6 +286,7 @@ static void morse_demod(struct demod_state * restrict const s,
                     if(s->l1.morse.current_sequence)
                     {
                         rtn = decode_character(s);
+                        demod_mark_at(s, s->l1.morse.char_start);
                         if(SHOW_FAILED_DECODES) verbprintf(0, "%s", rtn.string_ptr);
                         else if(rtn.status) verbprintf(0, "%s", rtn.string_ptr);
                         
@@ -324,7 +323,7 @@ static void morse_demod(struct demod_state * restrict const s,
                 }
             }
             
-            if(!cw_disable_auto_timing) auto_timing(oldstate, s);
+            if(!s->cfg->cw_disable_auto_timing) auto_timing(oldstate, s);
 reset_samples:
             s->l1.morse.samples_since_change = 0; // State has changed, restart counting
 end:;
@@ -335,9 +334,9 @@ end:;
 static void morse_init(struct demod_state * restrict s)
 {
     memset(&s->l1.morse, 0, sizeof(s->l1.morse));
-    s->l1.morse.time_unit_dit_dah_samples = FREQ_SAMP / (1000 / cw_dit_length);
-    s->l1.morse.time_unit_gaps_samples = FREQ_SAMP / (1000 / cw_gap_length);
-    s->l1.morse.detection_threshold = cw_threshold;
+    s->l1.morse.time_unit_dit_dah_samples = FREQ_SAMP / (1000 / s->cfg->cw_dit_length);
+    s->l1.morse.time_unit_gaps_samples = FREQ_SAMP / (1000 / s->cfg->cw_gap_length);
+    s->l1.morse.detection_threshold = s->cfg->cw_threshold;
     s->l1.morse.lowpass_strength = SMOOTHING_MAGNITUDE;
     if(HOLDOFF_MS) s->l1.morse.holdoff_samples = FREQ_SAMP / (1000 / HOLDOFF_MS);
     
@@ -359,5 +358,5 @@ static void morse_deinit(struct demod_state * const restrict s)
 }
 
 const struct demod_param demod_morse = {
-    "MORSE_CW", false, FREQ_SAMP, 0, morse_init, morse_demod, morse_deinit
+    "MORSE_CW", false, FREQ_SAMP, 0, morse_init, morse_demod, morse_deinit, NULL, NULL
 };
@@ -43,47 +43,21 @@
 
 #define SPHASEINC (0x10000u*BAUD*SUBSAMP/FREQ_SAMP)
 
+static const struct pocsag_clock poc12_clock = { SUBSAMP, SPHASEINC };
+
 /* ---------------------------------------------------------------------- */
 	
 static void poc12_init(struct demod_state *s)
 {
 	pocsag_init(s);
-	memset(&s->l1.poc12, 0, sizeof(s->l1.poc12));
+	memset(&s->l1.pocsag, 0, sizeof(s->l1.pocsag));
 }
 
 /* ---------------------------------------------------------------------- */
 
 static void poc12_demod(struct demod_state *s, buffer_t buffer, int length)
 {
-	if (s->l1.poc12.subsamp) {
-		if (length <= (int)s->l1.poc12.subsamp) {
-			s->l1.poc12.subsamp -= length;
-			return;
-		}
-		buffer.fbuffer += s->l1.poc12.subsamp;
-		length -= s->l1.poc12.subsamp;
-		s->l1.poc12.subsamp = 0;
-	}
-	for (; length > 0; length -= SUBSAMP, buffer.fbuffer += SUBSAMP) {
-		s->l1.poc12.dcd_shreg <<= 1;
-		s->l1.poc12.dcd_shreg |= ((*buffer.fbuffer) > 0);
-		verbprintf(10, "%c", '0'+(s->l1.poc12.dcd_shreg & 1));
-		/*
-		 * check if transition
-		 */
-		if ((s->l1.poc12.dcd_shreg ^ (s->l1.poc12.dcd_shreg >> 1)) & 1) {
-			if (s->l1.poc12.sphase < (0x8000u-(SPHASEINC/2)))
-				s->l1.poc12.sphase += SPHASEINC/8;
-			else
-				s->l1.poc12.sphase -= SPHASEINC/8;
-		}
-		s->l1.poc12.sphase += SPHASEINC;
-		if (s->l1.poc12.sphase >= 0x10000u) {
-			s->l1.poc12.sphase &= 0xffffu;
-			pocsag_rxbit(s, s->l1.poc12.dcd_shreg & 1);
-		}
-	}
-	s->l1.poc12.subsamp = -length;
+	pocsag_demod(s, &poc12_clock, buffer.fbuffer, length);
 }
 
 static void poc12_deinit(struct demod_state *s)
@@ -94,7 +68,7 @@ static void poc12_deinit(struct demod_state *s)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_poc12 = {
-    "POCSAG1200", true, FREQ_SAMP, FILTLEN, poc12_init, poc12_demod, poc12_deinit
+    "POCSAG1200", true, FREQ_SAMP, FILTLEN, poc12_init, poc12_demod, poc12_deinit, NULL, NULL
 };
 
 /* ---------------------------------------------------------------------- */
@@ -38,37 +38,21 @@
 
 #define SPHASEINC (0x10000u*BAUD/FREQ_SAMP)
 
+static const struct pocsag_clock poc24_clock = { 1, SPHASEINC };
+
 /* ---------------------------------------------------------------------- */
 	
 static void poc24_init(struct demod_state *s)
 {
 	pocsag_init(s);
-	memset(&s->l1.poc24, 0, sizeof(s->l1.poc24));
+	memset(&s->l1.pocsag, 0, sizeof(s->l1.pocsag));
 }
 
 /* ---------------------------------------------------------------------- */
 
 static void poc24_demod(struct demod_state *s, buffer_t buffer, int length)
 {
-	for (; length > 0; length--, buffer.fbuffer++) {
-		s->l1.poc24.dcd_shreg <<= 1;
-		s->l1.poc24.dcd_shreg |= ((*buffer.fbuffer) > 0);
-		verbprintf(10, "%c", '0'+(s->l1.poc24.dcd_shreg & 1));
-		/*
-		 * check if transition
-		 */
-		if ((s->l1.poc24.dcd_shreg ^ (s->l1.poc24.dcd_shreg >> 1)) & 1) {
-			if (s->l1.poc24.sphase < (0x8000u-(SPHASEINC/2)))
-				s->l1.poc24.sphase += SPHASEINC/8;
-			else
-				s->l1.poc24.sphase -= SPHASEINC/8;
-		}
-		s->l1.poc24.sphase += SPHASEINC;
-		if (s->l1.poc24.sphase >= 0x10000u) {
-			s->l1.poc24.sphase &= 0xffffu;
-			pocsag_rxbit(s, s->l1.poc24.dcd_shreg & 1);
-		}
-	}
+	pocsag_demod(s, &poc24_clock, buffer.fbuffer, length);
 }
 
 static void poc24_deinit(struct demod_state *s)
@@ -79,7 +63,7 @@ static void poc24_deinit(struct demod_state *s)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_poc24 = {
-    "POCSAG2400", true, FREQ_SAMP, FILTLEN, poc24_init, poc24_demod, poc24_deinit
+    "POCSAG2400", true, FREQ_SAMP, FILTLEN, poc24_init, poc24_demod, poc24_deinit, NULL, NULL
 };
 
 /* ---------------------------------------------------------------------- */
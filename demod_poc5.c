@@ -41,47 +41,21 @@
 
 #define SPHASEINC (0x10000u*BAUD*SUBSAMP/FREQ_SAMP)
 
+static const struct pocsag_clock poc5_clock = { SUBSAMP, SPHASEINC };
+
 /* ---------------------------------------------------------------------- */
 	
 static void poc5_init(struct demod_state *s)
 {
 	pocsag_init(s);
-	memset(&s->l1.poc5, 0, sizeof(s->l1.poc5));
+	memset(&s->l1.pocsag, 0, sizeof(s->l1.pocsag));
 }
 
 /* ---------------------------------------------------------------------- */
 
 static void poc5_demod(struct demod_state *s, buffer_t buffer, int length)
 {
-	if (s->l1.poc5.subsamp) {
-		if (length <= (int)s->l1.poc5.subsamp) {
-			s->l1.poc5.subsamp -= length;
-			return;
-		}
-		buffer.fbuffer += s->l1.poc5.subsamp;
-		length -= s->l1.poc5.subsamp;
-		s->l1.poc5.subsamp = 0;
-	}
-	for (; length > 0; length -= SUBSAMP, buffer.fbuffer += SUBSAMP) {
-		s->l1.poc5.dcd_shreg <<= 1;
-		s->l1.poc5.dcd_shreg |= ((*buffer.fbuffer) > 0);
-		verbprintf(10, "%c", '0'+(s->l1.poc5.dcd_shreg & 1));
-		/*
-		 * check if transition
-		 */
-		if ((s->l1.poc5.dcd_shreg ^ (s->l1.poc5.dcd_shreg >> 1)) & 1) {
-			if (s->l1.poc5.sphase < (0x8000u-(SPHASEINC/2)))
-				s->l1.poc5.sphase += SPHASEINC/8;
-			else
-				s->l1.poc5.sphase -= SPHASEINC/8;
-		}
-		s->l1.poc5.sphase += SPHASEINC;
-		if (s->l1.poc5.sphase >= 0x10000u) {
-			s->l1.poc5.sphase &= 0xffffu;
-			pocsag_rxbit(s, s->l1.poc5.dcd_shreg & 1);
-		}
-	}
-	s->l1.poc5.subsamp = -length;
+	pocsag_demod(s, &poc5_clock, buffer.fbuffer, length);
 }
 
 static void poc5_deinit(struct demod_state *s)
@@ -92,7 +66,7 @@ static void poc5_deinit(struct demod_state *s)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_poc5 = {
-    "POCSAG512", true, FREQ_SAMP, FILTLEN, poc5_init, poc5_demod, poc5_deinit
+    "POCSAG512", true, FREQ_SAMP, FILTLEN, poc5_init, poc5_demod, poc5_deinit, NULL, NULL
 };
 
 /* ---------------------------------------------------------------------- */
@@ -33,23 +33,8 @@ static const unsigned int pzvei_freq[16] = {
 
 /* ---------------------------------------------------------------------- */
 
-static void pzvei_init(struct demod_state *s)
-{
-    selcall_init(s);
-}
-
-static void pzvei_deinit(struct demod_state *s)
-{
-    selcall_deinit(s);
-}
-
-static void pzvei_demod(struct demod_state *s, buffer_t buffer, int length)
-{
-    selcall_demod(s, buffer.fbuffer, length, pzvei_freq, demod_pzvei.name);
-}
-
 const struct demod_param demod_pzvei = {
-    "PZVEI", true, SAMPLE_RATE, 0, pzvei_init, pzvei_demod, pzvei_deinit
+    "PZVEI", true, SAMPLE_RATE, 0, selcall_init, selcall_demod, selcall_deinit, NULL, pzvei_freq
 };
 
 
@@ -476,7 +476,7 @@ static void sdl_scope_deinit(struct demod_state *s)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_sdl_scope = {
-    "SDL_SCOPE", true, SAMPLING_RATE, 0, sdl_scope_init, sdl_scope_demod, sdl_scope_deinit
+    "SDL_SCOPE", true, SAMPLING_RATE, 0, sdl_scope_init, sdl_scope_demod, sdl_scope_deinit, NULL, NULL
 };
 
 #endif /* NO_SDL3 */
@@ -125,6 +125,7 @@ static void x10_demod(struct demod_state *s, buffer_t buffer, int length)
     int i;
     int bits = 0;
 
+    demod_mark(s, 0);
     verbprintf(2, "x10_demod length=%d, current_sequence=%d\n", length, s->l1.x10.current_sequence);
 
     src = buffer.sbuffer;
@@ -134,6 +135,7 @@ static void x10_demod(struct demod_state *s, buffer_t buffer, int length)
 	if ( s->l1.x10.current_stage == 0 ) {
 	    if ( *src >=  SAMPLING_THRESHOLD_HIGH ) {
 		s->l1.x10.last_rise = i + s->l1.x10.current_sequence;
+		s->l1.x10.start = demod_pos(s, i);
 		s->l1.x10.current_state = 1;
 		s->l1.x10.current_stage = 1;
 	    }
@@ -157,6 +159,7 @@ static void x10_demod(struct demod_state *s, buffer_t buffer, int length)
 		    s->l1.x10.current_stage = 2;
 		    s->l1.x10.last_rise = i + s->l1.x10.current_sequence;
 		} else {
+		    demod_mark_at(s, s->l1.x10.start);
             verbprintf(9, "stage 1 fail1\n");
 		    s->l1.x10.current_stage = 0;
 		}
@@ -186,6 +189,7 @@ static void x10_demod(struct demod_state *s, buffer_t buffer, int length)
 		    s->l1.x10.current_stage = 3;
 		    s->l1.x10.last_rise = i + s->l1.x10.current_sequence;
 		} else {
+		    demod_mark_at(s, s->l1.x10.start);
 		    verbprintf(2, "preamble 2nd stage fail\n");
 		    s->l1.x10.current_stage = 0;
 		}
@@ -205,6 +209,7 @@ static void x10_demod(struct demod_state *s, buffer_t buffer, int length)
 
 		    s->l1.x10.current_state = 1;
 		    bits++;
+		    demod_mark_at(s, s->l1.x10.start);
 		    verbprintf(3, "stage 3 rise (%d) %0.4f ms\n", j, (float) (j / SAMPLE_MS) );
 
 		    // fprintf(stderr, "stage 3 b %d %d %x\n", ( s->l1.x10.bi / 8 ), ( s->l1.x10.bi % 8 ), ( 1<< ( s->l1.x10.bi % 8 )  ) );
@@ -223,6 +228,7 @@ static void x10_demod(struct demod_state *s, buffer_t buffer, int length)
 
 		} else {
 		    if ( j > SAMPLING_TIMEOUT ) {  // if low for more then 10ms (appox)
+			demod_mark_at(s, s->l1.x10.start);
 			verbprintf(2, "Data stage end ( timeout )\n");
 			s->l1.x10.current_stage = 0;
 			// fprintf(stderr, "bits = %d\n", bits);
@@ -258,7 +264,7 @@ static void x10_demod(struct demod_state *s, buffer_t buffer, int length)
 /* ---------------------------------------------------------------------- */
 
 const struct demod_param demod_x10 = {
-    "X10", false, SAMPLING_RATE, 0, x10_init, x10_demod, NULL
+    "X10", false, SAMPLING_RATE, 0, x10_init, x10_demod, NULL, NULL, NULL
 };
 
 
@@ -33,23 +33,8 @@ static const unsigned int zvei1_freq[16] = {
 
 /* ---------------------------------------------------------------------- */
 
-static void zvei1_init(struct demod_state *s)
-{
-    selcall_init(s);
-}
-
-static void zvei1_deinit(struct demod_state *s)
-{
-    selcall_deinit(s);
-}
-
-static void zvei1_demod(struct demod_state *s, buffer_t buffer, int length)
-{
-    selcall_demod(s, buffer.fbuffer, length, zvei1_freq, demod_zvei1.name);
-}
-
 const struct demod_param demod_zvei1 = {
-    "ZVEI1", true, SAMPLE_RATE, 0, zvei1_init, zvei1_demod, zvei1_deinit
+    "ZVEI1", true, SAMPLE_RATE, 0, selcall_init, selcall_demod, selcall_deinit, NULL, zvei1_freq
 };
 
 
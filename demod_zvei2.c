@@ -33,23 +33,8 @@ static const unsigned int zvei2_freq[16] = {
 
 /* ---------------------------------------------------------------------- */
 
-static void zvei2_init(struct demod_state *s)
-{
-    selcall_init(s);
-}
-
-static void zvei2_deinit(struct demod_state *s)
-{
-    selcall_deinit(s);
-}
-
-static void zvei2_demod(struct demod_state *s, buffer_t buffer, int length)
-{
-    selcall_demod(s, buffer.fbuffer, length, zvei2_freq, demod_zvei2.name);
-}
-
 const struct demod_param demod_zvei2 = {
-    "ZVEI2", true, SAMPLE_RATE, 0, zvei2_init, zvei2_demod, zvei2_deinit
+    "ZVEI2", true, SAMPLE_RATE, 0, selcall_init, selcall_demod, selcall_deinit, NULL, zvei2_freq
 };
 
 
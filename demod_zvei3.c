@@ -33,23 +33,8 @@ static const unsigned int zvei3_freq[16] = {
 
 /* ---------------------------------------------------------------------- */
 
-static void zvei3_init(struct demod_state *s)
-{
-    selcall_init(s);
-}
-
-static void zvei3_deinit(struct demod_state *s)
-{
-    selcall_deinit(s);
-}
-
-static void zvei3_demod(struct demod_state *s, buffer_t buffer, int length)
-{
-    selcall_demod(s, buffer.fbuffer, length, zvei3_freq, demod_zvei3.name);
-}
-
 const struct demod_param demod_zvei3 = {
-    "ZVEI3", true, SAMPLE_RATE, 0, zvei3_init, zvei3_demod, zvei3_deinit
+    "ZVEI3", true, SAMPLE_RATE, 0, selcall_init, selcall_demod, selcall_deinit, NULL, zvei3_freq
 };
 
 
@@ -0,0 +1,218 @@
+/*
+ *      filter-simd.c -- vectorised filter kernels with runtime dispatch
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * mac() is the correlator inner loop of the AFSK, FSK and EAS
+ * demodulators. Every instruction set variant is compiled into the
+ * binary through target attributes, and the best one the CPU supports
+ * is picked once by mac_select(). The correlators are short (18 to 42
+ * taps), so the kernels keep two accumulators at most and finish the
+ * odd tail with a masked load where AVX2/AVX-512 offer one, in scalar
+ * code otherwise.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "filter.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MAC_X86
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#define MAC_NEON
+#include <arm_neon.h>
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+static float mac_scalar(const float *a, const float *b, unsigned int size)
+{
+	float sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < size; i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+#ifdef MAC_X86
+__attribute__((target("sse2")))
+static float mac_sse2(const float *a, const float *b, unsigned int size)
+{
+	__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+	unsigned int i = 0;
+	float sum;
+
+	for (; i + 8 <= size; i += 8) {
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	if (i + 4 <= size) {
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		i += 4;
+	}
+	acc0 = _mm_add_ps(acc0, acc1);
+	acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+	acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 0x55));
+	sum = _mm_cvtss_f32(acc0);
+	for (; i < size; i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static float mac_avx2(const float *a, const float *b, unsigned int size)
+{
+	__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+	unsigned int i = 0;
+	__m128 s;
+
+	for (; i + 16 <= size; i += 16) {
+		acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+		acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+	}
+	if (i + 8 <= size) {
+		acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+		i += 8;
+	}
+	if (i < size) {
+		__m256i m = _mm256_cmpgt_epi32(_mm256_set1_epi32(size - i),
+					       _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		acc1 = _mm256_fmadd_ps(_mm256_maskload_ps(a + i, m), _mm256_maskload_ps(b + i, m), acc1);
+	}
+	acc0 = _mm256_add_ps(acc0, acc1);
+	s = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+	return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx512f")))
+static float mac_avx512(const float *a, const float *b, unsigned int size)
+{
+	__m512 acc = _mm512_setzero_ps();
+	unsigned int i = 0;
+
+	for (; i + 16 <= size; i += 16)
+		acc = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc);
+	if (i < size) {
+		__mmask16 m = (__mmask16)((1u << (size - i)) - 1);
+		acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i),
+				      _mm512_maskz_loadu_ps(m, b + i), acc);
+	}
+	return _mm512_reduce_add_ps(acc);
+}
+
+static int have_sse2(void)
+{
+	return __builtin_cpu_supports("sse2");
+}
+
+static int have_avx2(void)
+{
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static int have_avx512(void)
+{
+	return __builtin_cpu_supports("avx512f");
+}
+#endif /* MAC_X86 */
+
+#ifdef MAC_NEON
+static float mac_neon(const float *a, const float *b, unsigned int size)
+{
+	float32x4_t acc = vdupq_n_f32(0);
+	float32x2_t s;
+	unsigned int i = 0;
+	float sum;
+
+	for (; i + 4 <= size; i += 4)
+		acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+	s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+	sum = vget_lane_f32(vpadd_f32(s, s), 0);
+	for (; i < size; i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+#endif /* MAC_NEON */
+
+/* ---------------------------------------------------------------------- */
+
+/* best first */
+const struct mac_impl mac_impls[] = {
+#ifdef MAC_X86
+	{ "avx512", mac_avx512, have_avx512 },
+	{ "avx2", mac_avx2, have_avx2 },
+	{ "sse2", mac_sse2, have_sse2 },
+#endif
+#ifdef MAC_NEON
+	{ "neon", mac_neon, NULL },
+#endif
+	{ "scalar", mac_scalar, NULL },
+	{ NULL, NULL, NULL }
+};
+
+static float mac_resolve(const float *a, const float *b, unsigned int size);
+
+float (*mac_kernel)(const float *a, const float *b, unsigned int size) = mac_resolve;
+static const char *mac_kernel_name;
+
+int mac_supported(const struct mac_impl *impl)
+{
+#ifdef MAC_X86
+	__builtin_cpu_init();
+#endif
+	return !impl->supported || impl->supported();
+}
+
+const char *mac_select(const char *name)
+{
+	const struct mac_impl *impl;
+
+	for (impl = mac_impls; impl->name; impl++) {
+		if (name && strcmp(name, impl->name))
+			continue;
+		if (!mac_supported(impl))
+			continue;
+		mac_kernel = impl->fn;
+		return mac_kernel_name = impl->name;
+	}
+	return NULL;
+}
+
+const char *mac_selected(void)
+{
+	if (!mac_kernel_name)
+		mac_select(NULL);
+	return mac_kernel_name;
+}
+
+/* Only reached if mac() runs before mac_select(), e.g. from a library user */
+static float mac_resolve(const float *a, const float *b, unsigned int size)
+{
+	mac_select(NULL);
+	return mac_kernel(a, b, size);
+}
+
+/* ---------------------------------------------------------------------- */
@@ -105,15 +105,28 @@ static inline unsigned int lcm(unsigned int x, unsigned int y)
 
 /* ---------------------------------------------------------------------- */
 
+/*
+ * Dot product kernels, see filter-simd.c. mac_impls lists every variant
+ * compiled in, best first; mac_select() installs the named one (or the
+ * best supported one for NULL) and returns its name, NULL if unavailable.
+ */
+struct mac_impl {
+	const char *name;
+	float (*fn)(const float *a, const float *b, unsigned int size);
+	int (*supported)(void);
+};
+
+extern const struct mac_impl mac_impls[];
+extern float (*mac_kernel)(const float *a, const float *b, unsigned int size);
+
+int mac_supported(const struct mac_impl *impl);
+const char *mac_select(const char *name);
+const char *mac_selected(void);
+
 #ifndef __HAVE_ARCH_MAC
 static inline float mac(const float *a, const float *b, unsigned int size)
 {
-	float sum = 0;
-	unsigned int i;
-
-	for (i = 0; i < size; i++)
-		sum += (*a++) * (*b++);
-	return sum;
+	return mac_kernel(a, b, size);
 }
 #endif /* __HAVE_ARCH_MAC */
 
@@ -0,0 +1,213 @@
+/*
+ *      fmdemod.c -- decimating FM discriminator for complex baseband input
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * I and Q each go through a polyphase resampler straight to the audio
+ * rate; decimating before the discriminator keeps it at the output rate
+ * and the channel filter is the resampler's lowpass, so only the
+ * deviation and the modulation have to fit below the output Nyquist
+ * frequency. The discriminator takes the angle of x[n] * conj(x[n-1]).
+ * Its atan2 is a polynomial on the octant with the quadrant fixed up by
+ * selects, no branches and no libm call, four samples to a vector; the
+ * error stays below 1e-5 rad, far beneath the noise of any real signal.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "fmdemod.h"
+#include "resample.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define FM_CHUNK 1024           /* complex samples taken from the resamplers at once */
+
+struct fm_demod {
+    struct resampler *rs_i, *rs_q;
+    float gain;                 /* rad per sample to full scale */
+    float last[2];
+    float i[FM_CHUNK], q[FM_CHUNK];
+};
+
+/* ---------------------------------------------------------------------- */
+
+struct fm_demod *fm_demod_new(unsigned int in_rate, unsigned int out_rate, float deviation)
+{
+    struct fm_demod *fm;
+
+    if (!in_rate || !out_rate || deviation <= 0)
+        return NULL;
+    if (!(fm = calloc(1, sizeof(*fm))))
+        return NULL;
+    fm->rs_i = resampler_new(in_rate, out_rate);
+    fm->rs_q = resampler_new(in_rate, out_rate);
+    if (!fm->rs_i || !fm->rs_q) {
+        fm_demod_free(fm);
+        return NULL;
+    }
+    /* a deviation of f Hz turns the phase by 2 pi f / out_rate per sample */
+    fm->gain = out_rate / (2.0 * M_PI * deviation);
+    fm->last[0] = 1;
+    return fm;
+}
+
+void fm_demod_free(struct fm_demod *fm)
+{
+    if (!fm)
+        return;
+    resampler_free(fm->rs_i);
+    resampler_free(fm->rs_q);
+    free(fm);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void fm_demod_write(struct fm_demod *fm, const float *i, const float *q, unsigned int n)
+{
+    resampler_write(fm->rs_i, i, n);
+    resampler_write(fm->rs_q, q, n);
+}
+
+unsigned int fm_demod_read(struct fm_demod *fm, float *out, unsigned int n)
+{
+    unsigned int cnt = 0;
+
+    while (cnt < n) {
+        unsigned int len = n - cnt < FM_CHUNK ? n - cnt : FM_CHUNK;
+
+        /* both resamplers hold the same number of samples */
+        len = resampler_read(fm->rs_i, fm->i, len);
+        if (!len)
+            break;
+        resampler_read(fm->rs_q, fm->q, len);
+        fm_discriminate(out + cnt, fm->i, fm->q, len, fm->last, fm->gain);
+        cnt += len;
+    }
+    return cnt;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static inline float fast_atan2f(float y, float x)
+{
+    float ax = fabsf(x), ay = fabsf(y);
+    float mn = ax < ay ? ax : ay;
+    float mx = ax < ay ? ay : ax;
+    float a = mn / (mx + 1e-30f);
+    float s = a * a;
+    float r = a * (0.99986600f + s * (-0.33029950f + s * (0.18014100f +
+                   s * (-0.08513300f + s * 0.02083510f))));
+
+    r = ay > ax ? (float)M_PI_2 - r : r;
+    r = x < 0 ? (float)M_PI - r : r;
+    return y < 0 ? -r : r;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+/*
+ * Spelled out in generic vectors: the compiler will not turn the selects
+ * into blends by itself unless it may ignore NaNs and signed zeros.
+ */
+typedef float v4sf __attribute__((vector_size(16)));
+typedef int v4si __attribute__((vector_size(16)));
+
+#define V4(x) { x, x, x, x }
+
+static inline v4sf vselect(v4si mask, v4sf a, v4sf b)
+{
+    return (v4sf)((mask & (v4si)a) | (~mask & (v4si)b));
+}
+
+static inline v4sf fast_atan2_v4(v4sf y, v4sf x)
+{
+    const v4si absmask = V4(0x7fffffff);
+    const v4sf zero = V4(0.0f), half_pi = V4((float)M_PI_2), pi = V4((float)M_PI);
+    const v4sf c0 = V4(0.99986600f), c1 = V4(-0.33029950f), c2 = V4(0.18014100f);
+    const v4sf c3 = V4(-0.08513300f), c4 = V4(0.02083510f), tiny = V4(1e-30f);
+    v4sf ax = (v4sf)((v4si)x & absmask), ay = (v4sf)((v4si)y & absmask);
+    v4si steep = ay > ax;
+    v4sf a = vselect(steep, ax, ay) / (vselect(steep, ay, ax) + tiny);
+    v4sf s = a * a;
+    v4sf r = a * (c0 + s * (c1 + s * (c2 + s * (c3 + s * c4))));
+
+    r = vselect(steep, half_pi - r, r);
+    r = vselect(x < zero, pi - r, r);
+    return (v4sf)((v4si)r ^ ((v4si)y & ~absmask));
+}
+
+void fm_discriminate(float *restrict out, const float *restrict i, const float *restrict q,
+                     size_t n, float last[2], float gain)
+{
+    const v4sf vgain = V4(gain);
+    size_t k = 1;
+
+    if (!n)
+        return;
+    out[0] = gain * fast_atan2f(q[0] * last[0] - i[0] * last[1],
+                                i[0] * last[0] + q[0] * last[1]);
+    for (; k + 4 <= n; k += 4) {
+        v4sf i0, q0, i1, q1, r;
+        memcpy(&i0, i + k, sizeof(i0));
+        memcpy(&q0, q + k, sizeof(q0));
+        memcpy(&i1, i + k - 1, sizeof(i1));
+        memcpy(&q1, q + k - 1, sizeof(q1));
+        r = vgain * fast_atan2_v4(q0 * i1 - i0 * q1, i0 * i1 + q0 * q1);
+        memcpy(out + k, &r, sizeof(r));
+    }
+    for (; k < n; k++)
+        out[k] = gain * fast_atan2f(q[k] * i[k-1] - i[k] * q[k-1],
+                                    i[k] * i[k-1] + q[k] * q[k-1]);
+    last[0] = i[n-1];
+    last[1] = q[n-1];
+}
+#else
+void fm_discriminate(float *out, const float *i, const float *q, size_t n,
+                     float last[2], float gain)
+{
+    float pi = last[0], pq = last[1];
+
+    for (size_t k = 0; k < n; k++) {
+        out[k] = gain * fast_atan2f(q[k] * pi - i[k] * pq, i[k] * pi + q[k] * pq);
+        pi = i[k];
+        pq = q[k];
+    }
+    last[0] = pi;
+    last[1] = pq;
+}
+#endif
+
+void fm_discriminate_libm(float *out, const float *i, const float *q, size_t n,
+                          float last[2], float gain)
+{
+    float pi = last[0], pq = last[1];
+
+    for (size_t k = 0; k < n; k++) {
+        out[k] = gain * atan2f(q[k] * pi - i[k] * pq, i[k] * pi + q[k] * pq);
+        pi = i[k];
+        pq = q[k];
+    }
+    last[0] = pi;
+    last[1] = pq;
+}
+
+/* ---------------------------------------------------------------------- */
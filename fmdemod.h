@@ -0,0 +1,59 @@
+/*
+ *      fmdemod.h -- decimating FM discriminator for complex baseband input
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _FMDEMOD_H
+#define _FMDEMOD_H
+
+#include <stddef.h>
+
+/* ---------------------------------------------------------------------- */
+
+struct fm_demod;
+
+/*
+ * Create a demodulator for complex samples at in_rate giving audio at
+ * out_rate. A frequency deviation of 'deviation' Hz comes out at full
+ * scale (+-1.0).
+ */
+struct fm_demod *fm_demod_new(unsigned int in_rate, unsigned int out_rate, float deviation);
+void fm_demod_free(struct fm_demod *fm);
+
+/* Queue n complex samples, given as separate I and Q runs */
+void fm_demod_write(struct fm_demod *fm, const float *i, const float *q, unsigned int n);
+
+/* Fetch up to n audio samples, returns the number produced */
+unsigned int fm_demod_read(struct fm_demod *fm, float *out, unsigned int n);
+
+/*
+ * The phase difference between successive samples times gain, for n
+ * samples; last holds the I/Q sample before i[0]/q[0] and is updated.
+ */
+void fm_discriminate(float *out, const float *i, const float *q, size_t n,
+                     float last[2], float gain);
+
+/* The same with atan2f() from libm, for checking and timing the above */
+void fm_discriminate_libm(float *out, const float *i, const float *q, size_t n,
+                          float last[2], float gain);
+
+/* ---------------------------------------------------------------------- */
+#endif /* _FMDEMOD_H */
@@ -25,10 +25,6 @@
 
 /* ---------------------------------------------------------------------- */
 
-bool fms_justhex = false;
-
-/* ---------------------------------------------------------------------- */
-
 static void fms_disp_service_id(uint8_t service_id)
 {
     verbprintf(0, "%1x=", service_id);
@@ -251,7 +247,7 @@ static char fms_is_crc_correct(uint64_t message)
 /*
  *  As specified in http://www.lfs-bw.de/Fachthemen/Digitalfunk-Funk/Documents/Pruefstelle/TRBOS-FMS.pdf
  */
-static void fms_disp_packet(uint64_t message)
+static void fms_disp_packet(struct demod_state *s, uint64_t message)
 {
     uint8_t service_id;  // BOS-Kennung
     uint8_t state_id;    // Landeskennung
@@ -267,7 +263,7 @@ static void fms_disp_packet(uint64_t message)
 
     verbprintf(0, "FMS: %08x%04x", message >> 32, ((uint32_t)message >> 16));
 
-    if(!fms_justhex)
+    if(!s->cfg->fms_justhex)
     {
         verbprintf(0, " (");
         service_id = (message >> 16) & 0xF;
@@ -339,6 +335,7 @@ void fms_rxbit(struct demod_state *s, int bit)
     // Check if the sync pattern is in the buffer
     if ((s->l2.fmsfsk.rxstate & 0x0007FFFF) == 0x7FF1A)
     {
+        demod_mark_at(s, demod_rx_pos(s)); // the telegram follows the sync word
         verbprintf(1, "FMS ->SYNC<-\n");
         s->l2.fmsfsk.rxbitstream = 0; // reset RX buffer
         s->l2.fmsfsk.rxbitcount = 1;  // > 1 means we have a valid SYNC
@@ -364,7 +361,7 @@ void fms_rxbit(struct demod_state *s, int bit)
                     if (fms_is_crc_correct(msg ^ (1 << (i+16))))
                     {
                         verbprintf(2, "FMS was able to correct a one bit error by swapping bit %d Original packet:\n", i);
-                        fms_disp_packet(s->l2.fmsfsk.rxbitstream);
+                        fms_disp_packet(s, s->l2.fmsfsk.rxbitstream);
                         s->l2.fmsfsk.rxbitstream = (msg ^ (1 << (i+16))) | 1; // lowest bit set means that the CRC has been corrected by us
                         break;
                     }
@@ -376,7 +373,7 @@ void fms_rxbit(struct demod_state *s, int bit)
                 }
             }
 
-            fms_disp_packet(s->l2.fmsfsk.rxbitstream);
+            fms_disp_packet(s, s->l2.fmsfsk.rxbitstream);
             s->l2.fmsfsk.rxbitcount = 0; // Reset counter, meaning "no valid SYNC yet"
             s->l2.fmsfsk.rxstate = 0;    // Reset message input buffer
         }
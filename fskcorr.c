@@ -0,0 +1,222 @@
+/*
+ *      fskcorr.c -- sliding DFT tone correlators for the FSK demodulators
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * The FSK demodulators correlate every window of len samples against
+ * cos/sin of the mark and space tones, i.e. they evaluate the DFT bin
+ *
+ *   C(n) = sum_{k=0}^{len-1} x[n+k] e^{jwk}
+ *
+ * for every window position n. Consecutive windows share all but one
+ * sample, so instead of len multiplications per bin the bin is updated
+ * recursively (sliding DFT):
+ *
+ *   C(n+1) = e^{-jw} (C(n) - x[n] + x[n+len] e^{jwlen})
+ *
+ * The recursion has its pole on the unit circle, so rounding errors would
+ * slowly accumulate. The state is kept in double precision and recomputed
+ * from the window every FSKCORR_RESEED samples.
+ *
+ * Where the direct correlation is as fast (see FSKCORR_DIRECT_MAXLEN), the
+ * bank keeps the demodulators' original tables and correlates each window
+ * with mac() instead.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "fskcorr.h"
+#include "filter.h"
+#include <math.h>
+#include <string.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define FSKCORR_RESEED 1024
+
+void fskcorr_bank_init(struct fskcorr_bank *b, const struct fskcorr_front *f)
+{
+    static const double offset[3] = { 0, 1, -1 };
+    unsigned int len = f->len;
+    unsigned int t, j, k;
+
+    memset(b, 0, sizeof(*b));
+    b->len = len;
+    b->ntones = f->ntones;
+    b->direct = len <= FSKCORR_DIRECT_MAXLEN && strcmp(mac_selected(), "scalar");
+    if (f->window == FSKCORR_HAMMING) {
+        b->bins_per_tone = 3;
+        b->weight[0] = 0.54f;
+        b->weight[1] = b->weight[2] = -0.23f;
+    } else {
+        b->bins_per_tone = 1;
+        b->weight[0] = 1.0f;
+    }
+
+    for (t = 0; t < f->ntones; t++) {
+        for (j = 0; j < b->bins_per_tone; j++) {
+            unsigned int bin = t * b->bins_per_tone + j;
+            double w = 2.0 * M_PI * f->freqs[t] / f->fsamp + offset[j] * 2.0 * M_PI / (len - 1);
+
+            b->rot_re[bin] = cos(w);
+            b->rot_im[bin] = -sin(w);
+            b->wrap_re[bin] = cos(w * len);
+            b->wrap_im[bin] = sin(w * len);
+            for (k = 0; k < len; k++) {
+                b->tab_re[bin][k] = cos(w * k);
+                b->tab_im[bin][k] = sin(w * k);
+            }
+        }
+    }
+
+    /* the correlators exactly as the demodulators built them */
+    for (t = 0; t < f->ntones; t++) {
+        float ph = 0;
+
+        for (k = 0; k < len; k++) {
+            b->corr[2*t][k] = cos(ph);
+            b->corr[2*t+1][k] = sin(ph);
+            ph += 2.0*M_PI*f->freqs[t]/f->fsamp;
+        }
+        if (f->window == FSKCORR_HAMMING) {
+            for (k = 0; k < len; k++) {
+                float w = 0.54 - 0.46*cos(2*M_PI*k/(float)(len-1));
+
+                b->corr[2*t][k] *= w;
+                b->corr[2*t+1][k] *= w;
+            }
+        }
+    }
+}
+
+void fskcorr_init(struct fskcorr *c, const struct fskcorr_bank *b)
+{
+    memset(c, 0, sizeof(*c));
+    c->bank = b;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void fskcorr_seed(struct fskcorr *c, const float *win)
+{
+    const struct fskcorr_bank *b = c->bank;
+    unsigned int nbins = b->ntones * b->bins_per_tone;
+
+    /* in double precision, so the seed cancels exactly as samples leave */
+    for (unsigned int bin = 0; bin < nbins; bin++) {
+        double re = 0, im = 0;
+        for (unsigned int k = 0; k < b->len; k++) {
+            re += win[k] * b->tab_re[bin][k];
+            im += win[k] * b->tab_im[bin][k];
+        }
+        c->re[bin] = re;
+        c->im[bin] = im;
+    }
+    c->since_seed = 0;
+}
+
+void fskcorr_slide(struct fskcorr *c, const float *win, unsigned int step)
+{
+    const struct fskcorr_bank *b = c->bank;
+    unsigned int len = b->len;
+    unsigned int nbins = b->ntones * b->bins_per_tone;
+
+    if (b->direct) {
+        /* every front end has a mark and a space tone */
+        float space_i = mac(win, b->corr[2], len), space_q = mac(win, b->corr[3], len);
+
+        c->power[0] = fsqr(mac(win, b->corr[0], len)) + fsqr(mac(win, b->corr[1], len));
+        c->power[1] = fsqr(space_i) + fsqr(space_q);
+        /* summed in the demodulators' order, for the same decisions */
+        c->mark_space = c->power[0] - fsqr(space_i) - fsqr(space_q);
+        return;
+    }
+
+    if (!c->primed || step >= len) {
+        memcpy(c->hist, win, len * sizeof(c->hist[0]));
+        c->pos = 0;
+        c->primed = 1;
+        fskcorr_seed(c, win);
+        return;
+    }
+
+    for (unsigned int i = len - step; i < len; i++) {
+        double x = win[i], old = c->hist[c->pos];
+
+        c->hist[c->pos] = win[i];
+        if (++c->pos == len)
+            c->pos = 0;
+        for (unsigned int bin = 0; bin < nbins; bin++) {
+            double re = c->re[bin] - old + x * b->wrap_re[bin];
+            double im = c->im[bin] + x * b->wrap_im[bin];
+            c->re[bin] = re * b->rot_re[bin] - im * b->rot_im[bin];
+            c->im[bin] = re * b->rot_im[bin] + im * b->rot_re[bin];
+        }
+    }
+
+    c->since_seed += step;
+    if (c->since_seed >= FSKCORR_RESEED)
+        fskcorr_seed(c, win);
+}
+
+/* ---------------------------------------------------------------------- */
+
+int fskcorr_front_equal(const struct fskcorr_front *a, const struct fskcorr_front *b)
+{
+    if (a->fsamp != b->fsamp || a->len != b->len || a->step != b->step ||
+        a->window != b->window || a->ntones != b->ntones)
+        return 0;
+    for (unsigned int t = 0; t < a->ntones; t++)
+        if (a->freqs[t] != b->freqs[t])
+            return 0;
+    return 1;
+}
+
+void fskcorr_stream_init(struct fskcorr_stream *st, const struct fskcorr_front *f)
+{
+    memset(st, 0, sizeof(*st));
+    fskcorr_bank_init(&st->bank, f);
+    fskcorr_init(&st->corr, &st->bank);
+    st->step = f->step;
+}
+
+/* mirrors the subsampling loop of the FSK demodulators */
+unsigned int fskcorr_stream_run(struct fskcorr_stream *st, const float *buf, int length, float *out)
+{
+    unsigned int n = 0;
+
+    if (st->subsamp) {
+        if (length <= (int)st->subsamp) {
+            st->subsamp -= length;
+            return 0;
+        }
+        buf += st->subsamp;
+        length -= st->subsamp;
+        st->subsamp = 0;
+    }
+    for (; length > 0; length -= st->step, buf += st->step) {
+        fskcorr_slide(&st->corr, buf, st->step);
+        out[n++] = fskcorr_mark_space(&st->corr);
+    }
+    st->subsamp = -length;
+    return n;
+}
+
+/* ---------------------------------------------------------------------- */
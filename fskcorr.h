@@ -0,0 +1,155 @@
+/*
+ *      fskcorr.h -- sliding DFT tone correlators for the FSK demodulators
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _FSKCORR_H
+#define _FSKCORR_H
+
+/* ---------------------------------------------------------------------- */
+
+#define FSKCORR_MAXLEN   48     /* longest correlator (EAS uses 42) */
+#define FSKCORR_MAXTONES 2
+#define FSKCORR_MAXBINS  (3*FSKCORR_MAXTONES)
+
+enum { FSKCORR_RECT, FSKCORR_HAMMING };
+
+/*
+ * A single 16 bit LSB in the window already gives a power around 1e-9.
+ * Anything far below that is what rounding leaves behind once a signal
+ * has slid out of the window; report it as the exact zero the direct
+ * correlation would give, so digital silence decodes as before.
+ */
+#define FSKCORR_FLOOR 1e-15
+
+/*
+ * Against a vector mac() kernel the sliding DFT gains nothing on windows
+ * this short (0.95-1.03x for AFSK1200, FMSFSK and the Hamming windowed
+ * AFSK2400), so those correlate every window directly, as the
+ * demodulators always did, and make the same decisions. It is used for
+ * longer windows (EAS, 42 taps, 1.15x) and with the scalar kernel.
+ */
+#define FSKCORR_DIRECT_MAXLEN 32
+
+/*
+ * What a demodulator's front end computes: the mark minus space power of
+ * a len sample window, advanced by step samples. Demodulators running
+ * at the same rate with equal front ends can share one correlator.
+ */
+struct fskcorr_front {
+    double fsamp;
+    unsigned int len;
+    unsigned int step;
+    int window;
+    unsigned int ntones;
+    double freqs[FSKCORR_MAXTONES];
+};
+
+/*
+ * Tone set and window, shared by all instances of a demodulator. A
+ * rectangular window needs one DFT bin per tone, a Hamming window is
+ * 0.54 - 0.46 cos(2 pi k/(len-1)) and thus the combination of the bin at
+ * the tone and the two bins 2 pi/(len-1) either side of it.
+ */
+struct fskcorr_bank {
+    unsigned int len;
+    unsigned int ntones;
+    unsigned int bins_per_tone;
+    int direct;                 /* correlate each window with mac() instead */
+    float corr[2*FSKCORR_MAXTONES][FSKCORR_MAXLEN];             /* windowed cos, sin */
+    float weight[3];
+    double rot_re[FSKCORR_MAXBINS], rot_im[FSKCORR_MAXBINS];    /* e^-jw */
+    double wrap_re[FSKCORR_MAXBINS], wrap_im[FSKCORR_MAXBINS];  /* e^jw*len */
+    double tab_re[FSKCORR_MAXBINS][FSKCORR_MAXLEN];             /* e^jwk, for reseeding */
+    double tab_im[FSKCORR_MAXBINS][FSKCORR_MAXLEN];
+};
+
+/* Per instance state: the current window and its DFT bins */
+struct fskcorr {
+    const struct fskcorr_bank *bank;
+    unsigned int pos;           /* oldest sample in hist */
+    unsigned int since_seed;
+    int primed;
+    float hist[FSKCORR_MAXLEN];
+    double re[FSKCORR_MAXBINS], im[FSKCORR_MAXBINS];
+    float power[FSKCORR_MAXTONES];  /* direct correlation */
+    float mark_space;
+};
+
+/* Shared front end: one correlator whose output several demodulators read */
+struct fskcorr_stream {
+    struct fskcorr_bank bank;
+    struct fskcorr corr;
+    unsigned int step;
+    unsigned int subsamp;       /* the same carry the demodulators keep */
+};
+
+/* Picks the direct correlation or the sliding DFT for the selected mac() kernel */
+void fskcorr_bank_init(struct fskcorr_bank *b, const struct fskcorr_front *f);
+void fskcorr_init(struct fskcorr *c, const struct fskcorr_bank *b);
+
+/*
+ * Move the correlation window to win[0..len-1], which must be 'step'
+ * samples after the previous window. The first call after fskcorr_init()
+ * takes the whole window, so the step does not matter there.
+ */
+void fskcorr_slide(struct fskcorr *c, const float *win, unsigned int step);
+
+/* Squared magnitude of the windowed correlation with a tone */
+static inline float fskcorr_power(const struct fskcorr *c, unsigned int tone)
+{
+    const struct fskcorr_bank *b = c->bank;
+    unsigned int bin = tone * b->bins_per_tone;
+    double re, im;
+
+    if (b->direct)
+        return c->power[tone];
+    re = c->re[bin] * b->weight[0];
+    im = c->im[bin] * b->weight[0];
+    for (unsigned int j = 1; j < b->bins_per_tone; j++) {
+        re += b->weight[j] * c->re[bin + j];
+        im += b->weight[j] * c->im[bin + j];
+    }
+    re = re * re + im * im;
+    return re < FSKCORR_FLOOR ? 0 : re;
+}
+
+/* Power of tone 0 minus power of tone 1, > 0 for mark */
+static inline float fskcorr_mark_space(const struct fskcorr *c)
+{
+    if (c->bank->direct)
+        return c->mark_space;
+    return fskcorr_power(c, 0) - fskcorr_power(c, 1);
+}
+
+int fskcorr_front_equal(const struct fskcorr_front *a, const struct fskcorr_front *b);
+void fskcorr_stream_init(struct fskcorr_stream *st, const struct fskcorr_front *f);
+
+/*
+ * Run the shared front end over length new samples (buf extends len-step
+ * samples into the overlap) and store one value per window in out, at
+ * exactly the positions a demodulator stepping through the same blocks
+ * evaluates. Returns the number of values, at most length.
+ */
+unsigned int fskcorr_stream_run(struct fskcorr_stream *st, const float *buf, int length, float *out);
+
+/* ---------------------------------------------------------------------- */
+#endif /* _FSKCORR_H */
@@ -12,7 +12,8 @@ target.path = $$PREFIX/bin
 INSTALLS += target
 
 HEADERS += \
-	gen.h
+	gen.h \
+	impair.h
 
 
 SOURCES += \
@@ -23,7 +24,8 @@ SOURCES += \
 	gen_hdlc.c \
 	gen_uart.c \
 	gen_clipfsk.c \
-	costabi.c
+	costabi.c \
+	impair.c
 
 macx{
 DEFINES += DUMMY_AUDIO
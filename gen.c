@@ -28,6 +28,8 @@
 #endif
 
 #include "gen.h"
+#include "bch.h"
+#include "impair.h"
 #include <sys/types.h>
 #include <sys/stat.h>
 #ifdef _MSC_VER
@@ -45,6 +47,9 @@
 #include <errno.h>
 #include <math.h>
 #include <stdlib.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #ifdef SUN_AUDIO
 #include <sys/audioio.h>
@@ -82,12 +87,23 @@ static const char *allowed_types[] = {
 	"smp", "wav", "maud", "vwe", "mp3", "mp4", "ogg", "flac", NULL
 };
 
+/* Complex baseband, the generated audio frequency modulates a carrier */
+static const char *iq_types[] = { "cu8", "cs16", "cf32", NULL };
+
 /* Extension to type mapping (extensions that differ from type name) */
 static const struct { const char *ext; const char *type; } ext_map[] = {
 	{ "aif", "aiff" },
 	{ NULL, NULL }
 };
 
+static int is_iq_type(const char *type)
+{
+	for (const char **t = iq_types; *t; t++)
+		if (!strcmp(type, *t))
+			return 1;
+	return 0;
+}
+
 /* Detect output type from filename extension, returns NULL if unknown */
 static const char *detect_type_from_extension(const char *fname)
 {
@@ -119,6 +135,10 @@ static const char *detect_type_from_extension(const char *fname)
 		if (!strcmp(ext_lower, *t))
 			return *t;
 	}
+	for (const char **t = iq_types; *t; t++) {
+		if (!strcmp(ext_lower, *t))
+			return *t;
+	}
 
 	return NULL;
 }
@@ -143,9 +163,15 @@ static struct gen_params params[MAX_GEN];
 static struct gen_state state[MAX_GEN];
 static int num_gen = 0;
 
+/* IQ output: generators on the same carrier offset (-O) share one carrier */
+static double carriers[MAX_GEN+1];
+static int num_carriers = 1;
+static int gen_carrier[MAX_GEN];
+
 /* ---------------------------------------------------------------------- */
 
-static int process_buffer(short *buf, int len)
+/* the generators on carrier k, or all of them for k < 0 */
+static int process_carrier(short *buf, int len, int k)
 {
 	int i;
 	int totnum = 0, num;
@@ -156,6 +182,8 @@ static int process_buffer(short *buf, int len)
 			break;
 		if (!gen_procs[params[i].type])
 			break;
+		if (k >= 0 && gen_carrier[i] != k)
+			continue;
 		num = gen_procs[params[i].type](buf, len, params+i, state+i);
 		if (num > totnum)
 			totnum = num;
@@ -163,6 +191,101 @@ static int process_buffer(short *buf, int len)
 	return totnum;
 }
 
+static int process_buffer(short *buf, int len)
+{
+	return process_carrier(buf, len, -1);
+}
+
+static void init_generators(void)
+{
+	int i;
+
+	memset(state, 0, sizeof(state));
+	for (i = 0; i < num_gen; i++) {
+		if (params[i].type >= sizeof(init_procs)/sizeof(init_procs[0]))
+			break;
+		if (!init_procs[params[i].type])
+			break;
+		init_procs[params[i].type](params+i, state+i);
+	}
+}
+
+/* an AX.25 UI frame from HB9JNX to AE4WA carrying text */
+static void set_hdlc_packet(struct gen_params *p, const char *text)
+{
+	p->type = gentype_hdlc;
+	p->ampl = 16384;
+	p->p.hdlc.modulation = 0;
+	p->p.hdlc.txdelay = 100;
+	p->p.hdlc.pkt[0] = ('H') << 1;
+	p->p.hdlc.pkt[1] = ('B') << 1;
+	p->p.hdlc.pkt[2] = ('9') << 1;
+	p->p.hdlc.pkt[3] = ('J') << 1;
+	p->p.hdlc.pkt[4] = ('N') << 1;
+	p->p.hdlc.pkt[5] = ('X') << 1;
+	p->p.hdlc.pkt[6] = (0x00) << 1;
+	p->p.hdlc.pkt[7] = ('A') << 1;
+	p->p.hdlc.pkt[8] = ('E') << 1;
+	p->p.hdlc.pkt[9] = ('4') << 1;
+	p->p.hdlc.pkt[10] = ('W') << 1;
+	p->p.hdlc.pkt[11] = ('A') << 1;
+	p->p.hdlc.pkt[12] = (' ') << 1;
+	p->p.hdlc.pkt[13] = ((0x00) << 1) | 1;
+	p->p.hdlc.pkt[14] = 0x03;
+	p->p.hdlc.pkt[15] = 0xf0;
+	strncpy((char *)p->p.hdlc.pkt+16, text, sizeof(p->p.hdlc.pkt)-16);
+	p->p.hdlc.pktlen = 16 + strlen((char *)p->p.hdlc.pkt+16);
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Channel impairments, applied to the mixed signal of all generators.
+ * The SNR refers to a sine at the loudest generator's amplitude, as in
+ * bulk mode, so the noise does not depend on what the generators send.
+ */
+static struct impair_params impair_par;
+static int impair_on = 0;
+static struct impair *impairer;
+
+static double reference_rms(void)
+{
+	int ampl = 0;
+	int i;
+
+	for (i = 0; i < num_gen; i++)
+		if (params[i].ampl > ampl)
+			ampl = params[i].ampl;
+	return ampl / 32768.0 / sqrt(2.0);
+}
+
+static int process_impaired(short *buf, int len)
+{
+	float in[8192], out[8192];
+	int i, num;
+
+	/* room for the samples a fast clock adds */
+	len -= len / 999 + 2;
+	if (len > 8192 - 8192 / 999 - 2)
+		len = 8192 - 8192 / 999 - 2;
+	if ((num = process_buffer(buf, len)) <= 0)
+		return num;
+	for (i = 0; i < num; i++)
+		in[i] = buf[i] * (1.0f/32768.0f);
+	num = impair_run(impairer, in, num, out);
+	for (i = 0; i < num; i++) {
+		float x = out[i] * 32768.0f;
+		buf[i] = x >= 32767.0f ? 32767 : x <= -32768.0f ? -32768 : (short)lrintf(x);
+	}
+	return num;
+}
+
+/* the next samples to write, impaired if asked to */
+static int process_output(short *buf, int len)
+{
+	return impair_on ? process_impaired(buf, len) : process_buffer(buf, len);
+}
+
 /* ---------------------------------------------------------------------- */
 #ifdef SUN_AUDIO
 
@@ -208,7 +331,7 @@ static void output_sound(unsigned int sample_rate, const char *ifname)
 		"sampling rate %d\n", audiodev.name, audiodev.version,
 		audiodev.config, audioinfo.record.sample_rate);
 	do {
-		num2 = num = process_buffer(sp = buffer, sizeof(buffer)/sizeof(buffer[0]));
+		num2 = num = process_output(sp = buffer, sizeof(buffer)/sizeof(buffer[0]));
 		while (num > 0) {
 			i = write(fd, sp, num*sizeof(sp[0]));
 			if (i < 0 && errno != EAGAIN) {
@@ -301,7 +424,7 @@ static void output_sound(unsigned int sample_rate, const char *ifname)
 	}
 #endif
 	do {
-		num2 = num = process_buffer(b.s, sizeof(b.s)/sizeof(b.s[0]));
+		num2 = num = process_output(b.s, sizeof(b.s)/sizeof(b.s[0]));
 		if (fmt) {
 			for (bp = b.b, sp = b.s, i = sizeof(b.s)/sizeof(b.s[0]); i > 0; i--, bp++, sp++)
 				*bp = 0x80 + (*sp >> 8);
@@ -526,7 +649,7 @@ static void output_file(unsigned int sample_rate, const char *fname, const char
 	 * modulate
 	 */
 	do {
-		num2 = num = process_buffer(sp = buffer, sizeof(buffer)/sizeof(buffer[0]));
+		num2 = num = process_output(sp = buffer, sizeof(buffer)/sizeof(buffer[0]));
 		while (num > 0) {
 			i = write(fd, sp, num*sizeof(sp[0]));
 			if (i < 0 && errno != EAGAIN) {
@@ -549,9 +672,551 @@ static void output_file(unsigned int sample_rate, const char *fname, const char
 
 /* ---------------------------------------------------------------------- */
 
+/*
+ * IQ output: the audio is interpolated linearly up to iq_rate and
+ * frequency modulates a carrier, a full scale sample deviates it by
+ * iq_deviation Hz. Generators given a -O offset modulate a carrier of
+ * their own that far off the centre, the carriers adding up to full
+ * scale. cu8 is offset binary like rtl_sdr writes it, cs16 and cf32 are
+ * in platform-native byte order.
+ */
+static unsigned int iq_rate = 240000;
+static double iq_deviation = 5000;
+
+struct iq_carrier {
+	short buffer[8192];
+	int num;		/* audio samples in buffer, 0 once its generators are done */
+	double pos;		/* counts audio samples, buffer[-1] is prev */
+	short prev;
+	double phase;
+	double phinc;		/* the carrier's offset, per IQ sample */
+};
+
+static void write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	int i;
+
+	while (len > 0) {
+		i = write(fd, p, len);
+		if (i < 0 && errno != EAGAIN) {
+			perror("write");
+			exit(4);
+		}
+		if (i > 0) {
+			p += i;
+			len -= (size_t)i;
+		}
+	}
+}
+
+static void output_iq(const char *fname, const char *type)
+{
+	static struct iq_carrier car[MAX_GEN+1];
+	static union { unsigned char u8[2*4096]; short s16[2*4096]; float f32[2*4096]; } out;
+	unsigned int size = !strcmp(type, "cu8") ? 2 : !strcmp(type, "cs16") ? 4 : 8;
+	double step = (double)SAMPLE_RATE / iq_rate;
+	double phinc = 2.0 * M_PI * iq_deviation / iq_rate / 32768.0;
+	double scale;
+	int fd, k, active, used = 0, n = 0;
+
+	if (!strcmp(fname, "-")) {
+		fd = 1;
+#ifdef WINDOWS
+		setmode(fd, O_BINARY);
+#endif
+	}
+#ifdef WINDOWS
+	else if ((fd = open(fname, O_WRONLY|O_CREAT|O_EXCL|O_BINARY, 0777)) < 0) {
+#else
+	else if ((fd = open(fname, O_WRONLY|O_CREAT|O_EXCL, 0777)) < 0) {
+#endif
+		perror("open");
+		exit(10);
+	}
+	for (k = 0; k < num_carriers; k++) {
+		car[k].num = process_carrier(car[k].buffer, sizeof(car[k].buffer)/sizeof(car[k].buffer[0]), k);
+		car[k].phinc = 2.0 * M_PI * carriers[k] / iq_rate;
+		used += car[k].num > 0;
+	}
+	scale = used ? 1.0 / used : 1.0;
+	for (;;) {
+		double c = 0, s = 0;
+
+		for (active = k = 0; k < num_carriers; k++) {
+			struct iq_carrier *ca = car + k;
+			int idx;
+			double x0, x;
+
+			if (ca->num > 0 && ca->pos >= ca->num) {
+				ca->pos -= ca->num;
+				ca->prev = ca->buffer[ca->num-1];
+				ca->num = process_carrier(ca->buffer, sizeof(ca->buffer)/sizeof(ca->buffer[0]), k);
+			}
+			if (ca->num <= 0)
+				continue;
+			active++;
+			idx = (int)ca->pos;
+			x0 = idx ? ca->buffer[idx-1] : ca->prev;
+			x = x0 + (ca->pos - idx) * (ca->buffer[idx] - x0);
+			ca->pos += step;
+
+			ca->phase += phinc * x + ca->phinc;
+			if (ca->phase > M_PI)
+				ca->phase -= 2.0 * M_PI;
+			else if (ca->phase < -M_PI)
+				ca->phase += 2.0 * M_PI;
+			c += scale * cos(ca->phase);
+			s += scale * sin(ca->phase);
+		}
+		if (!active)
+			break;
+		if (size == 2) {
+			out.u8[2*n] = (unsigned char)lrint(127.5 + 127.0 * c);
+			out.u8[2*n+1] = (unsigned char)lrint(127.5 + 127.0 * s);
+		} else if (size == 4) {
+			out.s16[2*n] = (short)lrint(32767.0 * c);
+			out.s16[2*n+1] = (short)lrint(32767.0 * s);
+		} else {
+			out.f32[2*n] = (float)c;
+			out.f32[2*n+1] = (float)s;
+		}
+		if (++n == 4096) {
+			write_all(fd, out.u8, (size_t)n * size);
+			n = 0;
+		}
+	}
+	write_all(fd, out.u8, (size_t)n * size);
+	close(fd);
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Bulk mode: a script of timed messages, one per line, is rendered into
+ * one raw stream. Each message is generated on its own, by a pool of
+ * threads running at most BULK_AHEAD ahead of the output; the writer
+ * mixes them into blocks, impairs and writes these in order. A manifest
+ * records where every message starts in the output.
+ */
+#define BULK_BLOCK (4 * SAMPLE_RATE)
+#define BULK_AHEAD (60 * SAMPLE_RATE)
+#define BULK_MAX_TEXT 239
+
+struct bulk_msg {
+	unsigned long long start;	/* sample of the script's time */
+	int line;
+	const char *proto;
+	unsigned long address;		/* POCSAG and FLEX only */
+	struct gen_params par;
+	short *buf;			/* what the generator sent */
+	int len;
+	int done;			/* buf and len are set */
+	int written;			/* mixed into the output, buf freed */
+};
+
+static const struct {
+	const char *name;
+	enum gen_type type;
+	int baud;
+} bulk_protos[] = {
+	{ "POCSAG512", gentype_pocsag, 512 },
+	{ "POCSAG1200", gentype_pocsag, 1200 },
+	{ "POCSAG2400", gentype_pocsag, 2400 },
+	{ "FLEX", gentype_flex, 0 },
+	{ "AFSK1200", gentype_hdlc, 0 },
+	{ "DTMF", gentype_dtmf, 0 },
+};
+
+static struct bulk_msg *bulk;
+static unsigned int bulk_num;
+static unsigned int bulk_threads;
+
+static unsigned int online_cpus(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n > 0)
+		return n;
+#endif
+	return 1;
+}
+
+static void bulk_error(const char *fname, int line, const char *msg)
+{
+	fprintf(stderr, "gen: %s:%d: %s\n", fname, line, msg);
+	exit(2);
+}
+
+static int bulk_cmp(const void *a, const void *b)
+{
+	const struct bulk_msg *x = a, *y = b;
+
+	if (x->start != y->start)
+		return x->start < y->start ? -1 : 1;
+	return x->line - y->line;
+}
+
+/* time,protocol,address,message per line; # starts a comment */
+static void read_bulk_script(const char *fname)
+{
+	FILE *f = strcmp(fname, "-") ? fopen(fname, "r") : stdin;
+	char line[1024];
+	unsigned int cap = 0;
+	int lineno = 0;
+
+	if (!f) {
+		perror("fopen");
+		exit(10);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		char *fld[4], *cp = line, *end;
+		struct bulk_msg *m;
+		double t;
+		unsigned int k;
+
+		lineno++;
+		line[strcspn(line, "\r\n")] = 0;
+		while (*cp == ' ' || *cp == '\t')
+			cp++;
+		if (!*cp || *cp == '#')
+			continue;
+		for (k = 0; k < 3; k++) {
+			fld[k] = cp;
+			if (!(cp = strchr(cp, ',')))
+				bulk_error(fname, lineno, "expected time,protocol,address,message");
+			*cp++ = '\0';
+		}
+		fld[3] = cp;
+
+		if (bulk_num == cap) {
+			cap = cap ? 2 * cap : 256;
+			if (!(bulk = realloc(bulk, cap * sizeof(bulk[0])))) {
+				perror("realloc");
+				exit(10);
+			}
+		}
+		m = bulk + bulk_num;
+		memset(m, 0, sizeof(*m));
+		m->line = lineno;
+
+		t = strtod(fld[0], &end);
+		while (*end == ' ')
+			end++;
+		if (end == fld[0] || *end || !(t >= 0))
+			bulk_error(fname, lineno, "invalid time");
+		m->start = (unsigned long long)llrint(t * SAMPLE_RATE);
+
+		for (cp = fld[1]; *cp == ' '; cp++)
+			;
+		for (end = cp; *end && *end != ' '; end++)
+			if (*end >= 'a' && *end <= 'z')
+				*end -= 'a' - 'A';
+		*end = '\0';
+		for (k = 0; k < sizeof(bulk_protos)/sizeof(bulk_protos[0]); k++)
+			if (!strcmp(cp, bulk_protos[k].name))
+				break;
+		if (k == sizeof(bulk_protos)/sizeof(bulk_protos[0]))
+			bulk_error(fname, lineno, "unknown protocol, expected POCSAG512, POCSAG1200, "
+				   "POCSAG2400, FLEX, AFSK1200 or DTMF");
+		m->proto = bulk_protos[k].name;
+
+		if (strlen(fld[3]) > BULK_MAX_TEXT)
+			bulk_error(fname, lineno, "message too long");
+		/* the manifest is what decodes are checked against, so no defaults */
+		for (cp = fld[2]; *cp == ' '; cp++)
+			;
+		switch (bulk_protos[k].type) {
+		case gentype_pocsag:
+		case gentype_flex:
+			if (!*cp)
+				bulk_error(fname, lineno, "missing address");
+			m->address = strtoul(cp, &end, 0);
+			while (*end == ' ')
+				end++;
+			if (end == cp || *end || m->address > 2097151)
+				bulk_error(fname, lineno, "invalid address");
+			break;
+		default:
+			if (*cp)
+				bulk_error(fname, lineno, "AFSK1200 and DTMF take no address");
+			break;
+		}
+
+		m->par.type = bulk_protos[k].type;
+		m->par.ampl = 16384;
+		switch (bulk_protos[k].type) {
+		case gentype_pocsag:
+			m->par.p.pocsag.address = m->address;
+			m->par.p.pocsag.function = 3;
+			m->par.p.pocsag.baud = bulk_protos[k].baud;
+			strcpy(m->par.p.pocsag.message, fld[3]);
+			break;
+		case gentype_flex:
+			m->par.p.flex.capcode = m->address;
+			strcpy(m->par.p.flex.message, fld[3]);
+			break;
+		case gentype_hdlc:
+			set_hdlc_packet(&m->par, fld[3]);
+			break;
+		default:
+			m->par.p.dtmf.duration = MS(100);
+			m->par.p.dtmf.pause = MS(100);
+			strcpy(m->par.p.dtmf.str, fld[3]);
+			break;
+		}
+		bulk_num++;
+	}
+	if (f != stdin)
+		fclose(f);
+	qsort(bulk, bulk_num, sizeof(bulk[0]), bulk_cmp);
+}
+
+static void bulk_render(struct bulk_msg *m)
+{
+	struct gen_state st;
+	short *buf = NULL;
+	int cap = 0, n = 0, num;
+
+	init_procs[m->par.type](&m->par, &st);
+	do {
+		if (cap - n < 8192) {
+			cap = cap ? 2 * cap : 65536;
+			if (!(buf = realloc(buf, cap * sizeof(buf[0])))) {
+				perror("realloc");
+				exit(10);
+			}
+			memset(buf + n, 0, (cap - n) * sizeof(buf[0]));
+		}
+		num = gen_procs[m->par.type](buf + n, cap - n, &m->par, &st);
+		if (num > 0)
+			n += num;
+	} while (num > 0);
+	m->buf = buf;
+	m->len = n;
+}
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t bulk_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bulk_moved = PTHREAD_COND_INITIALIZER;	/* the writer went on */
+static pthread_cond_t bulk_ready = PTHREAD_COND_INITIALIZER;	/* a message was rendered */
+static unsigned int bulk_next;
+static unsigned long long bulk_pos;
+
+static void *bulk_worker(void *arg)
+{
+	(void)arg;
+	pthread_mutex_lock(&bulk_lock);
+	while (bulk_next < bulk_num) {
+		struct bulk_msg *m = bulk + bulk_next;
+
+		if (m->start > bulk_pos + BULK_AHEAD) {
+			pthread_cond_wait(&bulk_moved, &bulk_lock);
+			continue;
+		}
+		bulk_next++;
+		pthread_mutex_unlock(&bulk_lock);
+		bulk_render(m);
+		pthread_mutex_lock(&bulk_lock);
+		m->done = 1;
+		pthread_cond_broadcast(&bulk_ready);
+	}
+	pthread_mutex_unlock(&bulk_lock);
+	return NULL;
+}
+#endif
+
+/* message m, rendered */
+static void bulk_wait(struct bulk_msg *m)
+{
+#ifdef HAVE_PTHREAD
+	if (bulk_threads > 1) {
+		pthread_mutex_lock(&bulk_lock);
+		while (!m->done)
+			pthread_cond_wait(&bulk_ready, &bulk_lock);
+		pthread_mutex_unlock(&bulk_lock);
+		return;
+	}
+#endif
+	if (!m->done) {
+		bulk_render(m);
+		m->done = 1;
+	}
+}
+
+/* the writer is at pos */
+static void bulk_advance(unsigned long long pos)
+{
+#ifdef HAVE_PTHREAD
+	if (bulk_threads > 1) {
+		pthread_mutex_lock(&bulk_lock);
+		bulk_pos = pos;
+		pthread_cond_broadcast(&bulk_moved);
+		pthread_mutex_unlock(&bulk_lock);
+	}
+#else
+	(void)pos;
+#endif
+}
+
+static unsigned long long bulk_out;	/* samples written */
+
+static void bulk_write(int fd, const float *x, int n)
+{
+	static float out[4096];
+	static short s[4096];
+	int i, len, num;
+
+	while (n > 0) {
+		len = n < 4000 ? n : 4000;
+		if (impairer)
+			num = impair_run(impairer, x, len, out);
+		else {
+			memcpy(out, x, len * sizeof(out[0]));
+			num = len;
+		}
+		for (i = 0; i < num; i++) {
+			float v = out[i] * 32768.0f;
+			s[i] = v >= 32767.0f ? 32767 : v <= -32768.0f ? -32768 : (short)lrintf(v);
+		}
+		write_all(fd, s, num * sizeof(s[0]));
+		bulk_out += num;
+		x += len;
+		n -= len;
+	}
+}
+
+static void bulk_manifest_line(FILE *mf, const struct bulk_msg *m)
+{
+	double start = impairer ? impair_position(impairer, (double)m->start) : (double)m->start;
+	double end = impairer ? impair_position(impairer, (double)(m->start + m->len)) : (double)(m->start + m->len);
+	const char *cp;
+
+	fprintf(mf, "%.0f,%.0f,%.6f,%s,", start, end - start, start / SAMPLE_RATE, m->proto);
+	if (m->par.type == gentype_pocsag || m->par.type == gentype_flex)
+		fprintf(mf, "%lu", m->address);
+	putc(',', mf);
+	putc('"', mf);
+	for (cp = m->par.type == gentype_hdlc ? (const char *)m->par.p.hdlc.pkt + 16 :
+	          m->par.type == gentype_pocsag ? m->par.p.pocsag.message :
+	          m->par.type == gentype_flex ? m->par.p.flex.message : m->par.p.dtmf.str; *cp; cp++) {
+		if (*cp == '"')
+			putc('"', mf);
+		putc(*cp, mf);
+	}
+	fputs("\"\n", mf);
+}
+
+static void output_bulk(const char *fname, const char *manifest)
+{
+	static float mix[BULK_BLOCK];
+	unsigned long long pos = 0, end = 0;
+	unsigned int first = 0, i;
+	FILE *mf = NULL;
+	int fd;
+#ifdef HAVE_PTHREAD
+	pthread_t *tids = NULL;
+#endif
+
+	if (!strcmp(fname, "-")) {
+		fd = 1;
+#ifdef WINDOWS
+		setmode(fd, O_BINARY);
+#endif
+	}
+#ifdef WINDOWS
+	else if ((fd = open(fname, O_WRONLY|O_CREAT|O_EXCL|O_BINARY, 0777)) < 0) {
+#else
+	else if ((fd = open(fname, O_WRONLY|O_CREAT|O_EXCL, 0777)) < 0) {
+#endif
+		perror("open");
+		exit(10);
+	}
+	if (manifest) {
+		if (!(mf = fopen(manifest, "w"))) {
+			perror("fopen");
+			exit(10);
+		}
+		fprintf(mf, "sample,length,time,protocol,address,message\n");
+	}
+#ifdef HAVE_PTHREAD
+	if (bulk_threads > 1) {
+		if (!(tids = malloc(bulk_threads * sizeof(tids[0])))) {
+			perror("malloc");
+			exit(10);
+		}
+		for (i = 0; i < bulk_threads; i++)
+			if (pthread_create(tids + i, NULL, bulk_worker, NULL)) {
+				perror("pthread_create");
+				exit(10);
+			}
+	}
+#endif
+
+	while (first < bulk_num) {
+		unsigned long long block_end = pos + BULK_BLOCK;
+		unsigned long long k, from, to;
+		int n = BULK_BLOCK;
+
+		memset(mix, 0, sizeof(mix));
+		for (i = first; i < bulk_num && bulk[i].start < block_end; i++) {
+			struct bulk_msg *m = bulk + i;
+
+			if (m->written)
+				continue;
+			bulk_wait(m);
+			from = m->start > pos ? m->start : pos;
+			to = m->start + m->len < block_end ? m->start + m->len : block_end;
+			for (k = from; k < to; k++)
+				mix[k - pos] += m->buf[k - m->start] * (1.0f/32768.0f);
+			if (m->start + m->len > end)
+				end = m->start + m->len;
+			if (m->start + m->len <= block_end) {
+				free(m->buf);
+				m->buf = NULL;
+				m->written = 1;
+			}
+		}
+		for (; first < bulk_num && bulk[first].written; first++)
+			if (mf)
+				bulk_manifest_line(mf, bulk + first);
+		if (first == bulk_num)
+			n = end > pos ? (int)(end - pos) : 0;
+		bulk_write(fd, mix, n);
+		pos = block_end;
+		bulk_advance(pos);
+	}
+	/* what the impairments still hold of the last message */
+	if (impairer) {
+		memset(mix, 0, 16 * sizeof(mix[0]));
+		while (bulk_out < impair_position(impairer, (double)end))
+			bulk_write(fd, mix, 16);
+	}
+
+#ifdef HAVE_PTHREAD
+	if (bulk_threads > 1) {
+		for (i = 0; i < bulk_threads; i++)
+			pthread_join(tids[i], NULL);
+		free(tids);
+	}
+#endif
+	if (mf && fclose(mf)) {
+		perror("fclose");
+		exit(10);
+	}
+	close(fd);
+	free(bulk);
+}
+
+/* ---------------------------------------------------------------------- */
+
 static const char usage_str[] = "Generates test signals\n"
 "  -t <type>  : output file type (auto-detected from extension if not specified)\n"
 "               Types other than raw require sox. Supported: raw, wav, flac, mp3, ogg, etc.\n"
+"               cu8, cs16 and cf32 write FM modulated complex baseband (IQ):\n"
+"     -R <rate>    : IQ sampling rate (default: 240000)\n"
+"     -D <hz>      : IQ deviation of a full scale sample (default: 5000)\n"
+"     -O <hz>      : IQ carrier of the last generator, off the centre (default: 0)\n"
 "  -a <ampl>  : amplitude\n"
 "  -d <str>   : encode DTMF string\n"
 "  -z <str>   : encode ZVEI string\n"
@@ -568,6 +1233,20 @@ static const char usage_str[] = "Generates test signals\n"
 "     -I           : POCSAG inverted output polarity\n"
 "  -S <text>  : encode text for SDL_SCOPE display\n"
 "  -e <0-3>   : inject 0-3 bit errors per codeword (FLEX/POCSAG BCH testing)\n"
+"  Channel impairments, applied to the mix of all generators:\n"
+"     -w <dB>      : white noise at this SNR\n"
+"     -o <hz>      : frequency offset\n"
+"     -C <ppm>     : sample clock error, up to 1000\n"
+"     -g <hz>      : Rayleigh fading of this Doppler spread, up to 100\n"
+"     -x <level>   : DC offset, full scale being 1\n"
+"     -l <level>   : clip at this level, full scale being 1\n"
+"     -r <seed>    : seed of the noise and the fading (default: 1)\n"
+"  -b <script>: bulk mode, render the timed messages of a script to raw output\n"
+"               lines of time,protocol,address,message; time in seconds, protocol\n"
+"               POCSAG512, POCSAG1200, POCSAG2400, FLEX, AFSK1200 or DTMF; the\n"
+"               address is required for POCSAG and FLEX and left empty otherwise\n"
+"     -M <file>    : write a manifest of where every message starts\n"
+"     -T <n>       : threads rendering the messages (default: one per CPU)\n"
 "  -h         : this help\n";
 
 int main(int argc, char *argv[])
@@ -579,10 +1258,13 @@ int main(int argc, char *argv[])
 	char *output_type = "hw";
 	char *cp;
 	char *scope_text = NULL;
+	char *bulk_script = NULL;
+	char *manifest = NULL;
 
+	impair_params_init(&impair_par);
 	fprintf(stdout, "gen-ng - (C) 1997 by Tom Sailer HB9JNX/AE4WA\n"
                     "         (C) 2012/2013 by Elias Oenal\n");	
-	while ((c = getopt(argc, argv, "t:a:d:s:z:p:u:c:f:F:e:P:A:B:S:NIh")) != EOF) {
+	while ((c = getopt(argc, argv, "t:a:d:s:z:p:u:c:f:F:e:P:A:B:S:R:D:O:w:o:C:g:x:l:r:b:M:T:NIh")) != EOF) {
 		switch (c) {
 		case 'h':
 		case '?':
@@ -596,10 +1278,17 @@ int main(int argc, char *argv[])
 					output_type = *otype;
 					goto outtypefound;
 				}
+			for (otype = (char **)iq_types; *otype; otype++)
+				if (!strcmp(*otype, optarg)) {
+					output_type = *otype;
+					goto outtypefound;
+				}
 			fprintf(stderr, "invalid output type \"%s\"\n"
 				"allowed types: ", optarg);
 			for (otype = (char **)allowed_types; *otype; otype++) 
 				fprintf(stderr, "%s ", *otype);
+			for (otype = (char **)iq_types; *otype; otype++)
+				fprintf(stderr, "%s ", *otype);
 			fprintf(stderr, "\n");
 			errflg++;
 		outtypefound:
@@ -696,30 +1385,7 @@ int main(int argc, char *argv[])
 				errflg++;
 				break;
 			}
-			params[num_gen-1].type = gentype_hdlc;
-			params[num_gen-1].ampl = 16384;
-			params[num_gen-1].p.hdlc.modulation = 0;
-			params[num_gen-1].p.hdlc.txdelay = 100;
-			params[num_gen-1].p.hdlc.pkt[0] = ('H') << 1;
-			params[num_gen-1].p.hdlc.pkt[1] = ('B') << 1;
-			params[num_gen-1].p.hdlc.pkt[2] = ('9') << 1;
-			params[num_gen-1].p.hdlc.pkt[3] = ('J') << 1;
-			params[num_gen-1].p.hdlc.pkt[4] = ('N') << 1;
-			params[num_gen-1].p.hdlc.pkt[5] = ('X') << 1;
-			params[num_gen-1].p.hdlc.pkt[6] = (0x00) << 1;
-			params[num_gen-1].p.hdlc.pkt[7] = ('A') << 1;
-			params[num_gen-1].p.hdlc.pkt[8] = ('E') << 1;
-			params[num_gen-1].p.hdlc.pkt[9] = ('4') << 1;
-			params[num_gen-1].p.hdlc.pkt[10] = ('W') << 1;
-			params[num_gen-1].p.hdlc.pkt[11] = ('A') << 1;
-			params[num_gen-1].p.hdlc.pkt[12] = (' ') << 1;
-			params[num_gen-1].p.hdlc.pkt[13] = ((0x00) << 1) | 1;
-			params[num_gen-1].p.hdlc.pkt[14] = 0x03;
-			params[num_gen-1].p.hdlc.pkt[15] = 0xf0;
-			strncpy((char *)params[num_gen-1].p.hdlc.pkt+16, optarg, 
-				sizeof(params[num_gen-1].p.hdlc.pkt)-16);
-			params[num_gen-1].p.hdlc.pktlen = 16 + 
-				strlen((char *)params[num_gen-1].p.hdlc.pkt+16);
+			set_hdlc_packet(params+num_gen-1, optarg);
 			break;
 
 		case 'f':
@@ -829,6 +1495,123 @@ int main(int argc, char *argv[])
 			scope_text = optarg;
 			break;
 
+		case 'R':
+			iq_rate = strtoul(optarg, &cp, 0);
+			if (*cp || iq_rate < SAMPLE_RATE) {
+				fprintf(stderr, "gen: -R must be at least %d\n", SAMPLE_RATE);
+				errflg++;
+			}
+			break;
+
+		case 'D':
+			iq_deviation = strtod(optarg, &cp);
+			if (*cp || !(iq_deviation > 0)) {
+				fprintf(stderr, "gen: invalid deviation \"%s\"\n", optarg);
+				errflg++;
+			}
+			break;
+
+		case 'O':
+		{
+			double offset = strtod(optarg, &cp);
+			int k;
+
+			if (num_gen <= 0) {
+				fprintf(stderr, "gen: -O requires a generator first\n");
+				errflg++;
+				break;
+			}
+			if (*cp) {
+				fprintf(stderr, "gen: invalid carrier offset \"%s\"\n", optarg);
+				errflg++;
+				break;
+			}
+			for (k = 0; k < num_carriers && carriers[k] != offset; k++)
+				;
+			if (k == num_carriers)
+				carriers[num_carriers++] = offset;
+			gen_carrier[num_gen-1] = k;
+			break;
+		}
+
+		case 'w':
+			impair_par.snr_db = strtod(optarg, &cp);
+			if (*cp) {
+				fprintf(stderr, "gen: invalid SNR \"%s\"\n", optarg);
+				errflg++;
+			}
+			impair_on = 1;
+			break;
+
+		case 'o':
+			impair_par.freq_shift = strtod(optarg, &cp);
+			if (*cp || fabs(impair_par.freq_shift) >= SAMPLE_RATE / 2) {
+				fprintf(stderr, "gen: invalid frequency offset \"%s\"\n", optarg);
+				errflg++;
+			}
+			impair_on = 1;
+			break;
+
+		case 'C':
+			impair_par.drift_ppm = strtod(optarg, &cp);
+			if (*cp || fabs(impair_par.drift_ppm) > 1000) {
+				fprintf(stderr, "gen: -C must be -1000 to 1000 ppm\n");
+				errflg++;
+			}
+			impair_on = 1;
+			break;
+
+		case 'g':
+			impair_par.fading_hz = strtod(optarg, &cp);
+			if (*cp || impair_par.fading_hz < 0 || impair_par.fading_hz > 100) {
+				fprintf(stderr, "gen: -g must be 0 to 100 Hz\n");
+				errflg++;
+			}
+			impair_on = 1;
+			break;
+
+		case 'x':
+			impair_par.dc_offset = strtod(optarg, &cp);
+			if (*cp) {
+				fprintf(stderr, "gen: invalid DC offset \"%s\"\n", optarg);
+				errflg++;
+			}
+			impair_on = 1;
+			break;
+
+		case 'l':
+			impair_par.clip = strtod(optarg, &cp);
+			if (*cp || !(impair_par.clip > 0)) {
+				fprintf(stderr, "gen: invalid clip level \"%s\"\n", optarg);
+				errflg++;
+			}
+			impair_on = 1;
+			break;
+
+		case 'r':
+			impair_par.seed = strtoull(optarg, &cp, 0);
+			if (*cp) {
+				fprintf(stderr, "gen: invalid seed \"%s\"\n", optarg);
+				errflg++;
+			}
+			break;
+
+		case 'b':
+			bulk_script = optarg;
+			break;
+
+		case 'M':
+			manifest = optarg;
+			break;
+
+		case 'T':
+			bulk_threads = strtoul(optarg, &cp, 0);
+			if (*cp || !bulk_threads) {
+				fprintf(stderr, "gen: invalid thread count \"%s\"\n", optarg);
+				errflg++;
+			}
+			break;
+
 		case 'I':
 			if (num_gen <= 0 || params[num_gen-1].type != gentype_pocsag) {
 				fprintf(stderr, "gen: -I requires -P first\n");
@@ -840,20 +1623,45 @@ int main(int argc, char *argv[])
 		}
 	}
 		
-	if (errflg || (num_gen <= 0 && !scope_text)) {
+	if (errflg || (num_gen <= 0 && !scope_text && !bulk_script)) {
 		(void)fprintf(stderr, usage_str);
 		exit(2);
 	}
-
-	memset(state, 0, sizeof(state));
-	for (c = 0; c < num_gen; c++) {
-		if (params[c].type >= sizeof(init_procs)/sizeof(init_procs[0]))
-			break;
-		if (!init_procs[params[c].type])
-			break;
-		init_procs[params[c].type](params+c, state+c);
+	if (bulk_script) {
+		if (num_gen > 0 || scope_text) {
+			fprintf(stderr, "gen: -b does not mix with other generators\n");
+			exit(2);
+		}
+		if ((argc - optind) < 1) {
+			(void)fprintf(stderr, "no destination file specified\n");
+			exit(4);
+		}
+		if (type_explicit && strcmp(output_type, "raw")) {
+			fprintf(stderr, "gen: -b writes raw output\n");
+			exit(2);
+		}
+		read_bulk_script(bulk_script);
+		if (impair_on) {
+			/* the SNR refers to a sine at the generators' amplitude */
+			impair_par.signal_rms = 0.5 / sqrt(2.0);
+			if (!(impairer = impair_new(&impair_par, SAMPLE_RATE))) {
+				fprintf(stderr, "gen: impairment out of range\n");
+				exit(2);
+			}
+		}
+		if (!bulk_threads)
+			bulk_threads = online_cpus();
+		bch_init();	/* build the tables now, not from the threads */
+		output_bulk(argv[optind], manifest);
+		exit(0);
+	}
+	if (manifest || bulk_threads) {
+		fprintf(stderr, "gen: -M and -T need -b\n");
+		exit(2);
 	}
 
+	init_generators();
+
 	/* If no explicit type and file specified, auto-detect from extension */
 	if (!type_explicit && !strcmp(output_type, "hw") && (argc - optind) >= 1) {
 		const char *detected = detect_type_from_extension(argv[optind]);
@@ -865,6 +1673,22 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (num_carriers > 1 && !is_iq_type(output_type)) {
+		fprintf(stderr, "gen: -O needs IQ output (cu8, cs16 or cf32)\n");
+		exit(2);
+	}
+	if (impair_on) {
+		if (scope_text || is_iq_type(output_type)) {
+			fprintf(stderr, "gen: impairments need audio output of the generators\n");
+			exit(2);
+		}
+		impair_par.signal_rms = reference_rms();
+		if (!(impairer = impair_new(&impair_par, SAMPLE_RATE))) {
+			fprintf(stderr, "gen: impairment out of range\n");
+			exit(2);
+		}
+	}
+
 	if (!strcmp(output_type, "hw")) {
 		if (scope_text) {
 			fprintf(stderr, "Scope text output to sound device not supported\n");
@@ -883,10 +1707,24 @@ int main(int argc, char *argv[])
 
 	/* Handle scope text separately (uses callback API) */
 	if (scope_text) {
+		if (is_iq_type(output_type)) {
+			fprintf(stderr, "Scope text output as IQ not supported\n");
+			exit(2);
+		}
 		output_scope_file(argv[optind], output_type, scope_text);
 		exit(0);
 	}
 
+	if (is_iq_type(output_type)) {
+		for (c = 1; c < num_carriers; c++)
+			if (fabs(carriers[c]) >= iq_rate / 2.0) {
+				fprintf(stderr, "gen: carrier offset %g Hz outside of +-%g Hz\n",
+					carriers[c], iq_rate / 2.0);
+				exit(2);
+			}
+		output_iq(argv[optind], output_type);
+		exit(0);
+	}
 	output_file(SAMPLE_RATE, argv[optind], output_type);
 	exit(0);
 }
@@ -0,0 +1,262 @@
+/*
+ *      goertzel.c -- block Goertzel tone detectors for DTMF and selcall
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * The tone decoders used to mix every sample with a quadrature oscillator
+ * per tone: two table lookups and two multiply-adds per tone and sample.
+ * A Goertzel filter needs one multiply per tone and sample,
+ *
+ *   s[n] = x[n] + 2 cos w s[n-1] - s[n-2]
+ *
+ * and gives the same correlation once per block. The filters of
+ * GOERTZEL_LANES tones run side by side in one vector, and the recursion
+ * of a vector is a chain of dependent operations, so several vectors
+ * (more tones, or more channels) are interleaved to keep the FPU busy.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "goertzel.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define GOERTZEL_GANG 4         /* vectors filtered together */
+
+/* GOERTZEL_LANES tones of one channel */
+struct chain {
+    const float *in;
+    float *s1;
+    float *s2;
+    const float *coeff;
+    float *energy;              /* the channel's first chain sums the energy, too */
+};
+
+#if defined(__GNUC__) || defined(__clang__)
+typedef float v4sf __attribute__((vector_size(16)));
+
+/* nc is a constant after inlining, so the state stays in registers */
+static inline __attribute__((always_inline))
+void run_chains(const struct chain *ch, unsigned int nc, int n)
+{
+    v4sf s1[GOERTZEL_GANG], s2[GOERTZEL_GANG], c[GOERTZEL_GANG];
+    float e[GOERTZEL_GANG];
+    unsigned int j;
+
+    for (j = 0; j < nc; j++) {
+        memcpy(&s1[j], ch[j].s1, sizeof(s1[j]));
+        memcpy(&s2[j], ch[j].s2, sizeof(s2[j]));
+        memcpy(&c[j], ch[j].coeff, sizeof(c[j]));
+        e[j] = ch[j].energy ? *ch[j].energy : 0;
+    }
+    for (int i = 0; i < n; i++) {
+        for (j = 0; j < nc; j++) {
+            float x = ch[j].in[i];
+            /* x - s2 is off the critical path, which is the multiply-add on s1 */
+            v4sf s0 = (x - s2[j]) + c[j] * s1[j];
+            s2[j] = s1[j];
+            s1[j] = s0;
+            e[j] += x * x;
+        }
+    }
+    for (j = 0; j < nc; j++) {
+        memcpy(ch[j].s1, &s1[j], sizeof(s1[j]));
+        memcpy(ch[j].s2, &s2[j], sizeof(s2[j]));
+        if (ch[j].energy)
+            *ch[j].energy = e[j];
+    }
+}
+
+static void run_gang(const struct chain *ch, unsigned int nc, int n)
+{
+    switch (nc) {
+    case 4:
+        run_chains(ch, 4, n);
+        break;
+    case 3:
+        run_chains(ch, 3, n);
+        break;
+    case 2:
+        run_chains(ch, 2, n);
+        break;
+    default:
+        run_chains(ch, 1, n);
+        break;
+    }
+}
+#else
+static void run_gang(const struct chain *ch, unsigned int nc, int n)
+{
+    for (unsigned int j = 0; j < nc; j++) {
+        for (unsigned int k = 0; k < GOERTZEL_LANES; k++) {
+            float s1 = ch[j].s1[k], s2 = ch[j].s2[k], c = ch[j].coeff[k];
+            for (int i = 0; i < n; i++) {
+                float s0 = (ch[j].in[i] - s2) + c * s1;
+                s2 = s1;
+                s1 = s0;
+            }
+            ch[j].s1[k] = s1;
+            ch[j].s2[k] = s2;
+        }
+        if (ch[j].energy)
+            for (int i = 0; i < n; i++)
+                *ch[j].energy += ch[j].in[i] * ch[j].in[i];
+    }
+}
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+void goertzel_init(struct goertzel_bank *b, unsigned int blocklen)
+{
+    memset(b, 0, sizeof(*b));
+    b->blocklen = blocklen;
+    b->left = 1;
+}
+
+unsigned int goertzel_tone(const struct goertzel_bank *b, unsigned int phinc)
+{
+    unsigned int k;
+
+    for (k = 0; k < b->ntones; k++)
+        if (b->phinc[k] == phinc)
+            break;
+    return k;
+}
+
+unsigned int goertzel_add(struct goertzel_bank *b, unsigned int phinc)
+{
+    unsigned int k = goertzel_tone(b, phinc);
+    double w = 2.0 * M_PI * phinc / 65536.0;
+
+    if (k < b->ntones || k >= GOERTZEL_MAXTONES)
+        return k;
+    b->phinc[k] = phinc;
+    b->cosw[k] = cos(w);
+    b->sinw[k] = sin(w);
+    b->coeff[k] = 2.0 * cos(w);
+    b->ntones++;
+    return k;
+}
+
+unsigned int goertzel_outlen(const struct goertzel_bank *b, int length)
+{
+    return (length / (b->blocklen + 1) + 1) * goertzel_reclen(b);
+}
+
+unsigned int goertzel_count(int *blkcount, unsigned int blocklen, int length)
+{
+    unsigned int n = 0;
+
+    while (length > *blkcount) {
+        length -= *blkcount + 1;
+        *blkcount = blocklen;
+        n++;
+    }
+    *blkcount -= length;
+    return n;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int goertzel_feed(struct goertzel_bank **b, const float **in, unsigned int nch, int length)
+{
+    struct chain ch[GOERTZEL_GANG];
+    unsigned int c, k, nc = 0;
+    int n = length;
+
+    for (c = 0; c < nch; c++)
+        if ((int)b[c]->left < n)
+            n = b[c]->left;
+    if (n <= 0)
+        return 0;
+
+    for (c = 0; c < nch; c++) {
+        for (k = 0; k < b[c]->ntones; k += GOERTZEL_LANES) {
+            ch[nc].in = in[c];
+            ch[nc].s1 = b[c]->s1 + k;
+            ch[nc].s2 = b[c]->s2 + k;
+            ch[nc].coeff = b[c]->coeff + k;
+            ch[nc].energy = k ? NULL : &b[c]->energy;
+            if (++nc == GOERTZEL_GANG) {
+                run_gang(ch, nc, n);
+                nc = 0;
+            }
+        }
+    }
+    if (nc)
+        run_gang(ch, nc, n);
+
+    for (c = 0; c < nch; c++) {
+        b[c]->blklen += n;
+        b[c]->left -= n;
+        in[c] += n;
+    }
+    return n;
+}
+
+int goertzel_finish(struct goertzel_bank *b, float *rec)
+{
+    if (b->left)
+        return 0;
+
+    /*
+     * s1 - e^-jw s2 is sum x[i] e^jw(n-1-i); conjugated and turned by the
+     * oscillator phase at the last sample it becomes sum x[i] e^j ph[i].
+     */
+    rec[0] = b->energy;
+    for (unsigned int k = 0; k < b->ntones; k++) {
+        double last = 2.0 * M_PI * ((b->ph[k] + (b->blklen - 1) * b->phinc[k]) & 0xffffu) / 65536.0;
+        double yr = b->s1[k] - b->cosw[k] * b->s2[k];
+        double yi = b->sinw[k] * b->s2[k];
+        double cl = cos(last), sl = sin(last);
+
+        rec[1 + k] = cl * yr + sl * yi;
+        rec[1 + b->ntones + k] = sl * yr - cl * yi;
+        b->ph[k] += b->blklen * b->phinc[k];
+    }
+    memset(b->s1, 0, sizeof(b->s1));
+    memset(b->s2, 0, sizeof(b->s2));
+    b->energy = 0;
+    b->blklen = 0;
+    b->left = b->blocklen + 1;
+    return 1;
+}
+
+int goertzel_block(struct goertzel_bank *b, const float **buf, int *length, float *rec)
+{
+    *length -= goertzel_feed(&b, buf, 1, *length);
+    return goertzel_finish(b, rec);
+}
+
+unsigned int goertzel_run(struct goertzel_bank *b, const float *buf, int length, float *out)
+{
+    unsigned int n = 0;
+
+    while (length > 0)
+        if (goertzel_block(b, &buf, &length, out + n * goertzel_reclen(b)))
+            n++;
+    return n;
+}
+
+/* ---------------------------------------------------------------------- */
@@ -0,0 +1,105 @@
+/*
+ *      goertzel.h -- block Goertzel tone detectors for DTMF and selcall
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _GOERTZEL_H
+#define _GOERTZEL_H
+
+/* ---------------------------------------------------------------------- */
+
+#define GOERTZEL_LANES    4     /* tones per vector */
+#define GOERTZEL_MAXTONES 64    /* the eight selcall standards use 48 distinct tones */
+
+/*
+ * Goertzel filters for a set of tones, given as phase increments in
+ * 1/65536 of a cycle per sample like the oscillators of the tone
+ * decoders. Samples are cut into blocks of blocklen + 1 samples (the
+ * first block is a single sample), the way the decoders count, and every
+ * block yields one record:
+ *
+ *   rec[0]              energy of the block
+ *   rec[1 + k]          sum x[i] cos ph_k[i]
+ *   rec[1 + ntones + k] sum x[i] sin ph_k[i]
+ *
+ * where ph_k is the phase of tone k's oscillator, running on across
+ * blocks so that consecutive records add up coherently.
+ */
+struct goertzel_bank {
+    unsigned int ntones;
+    unsigned int blocklen;
+    unsigned int phinc[GOERTZEL_MAXTONES];
+    unsigned int ph[GOERTZEL_MAXTONES];     /* oscillator phase at the block start */
+    double cosw[GOERTZEL_MAXTONES];
+    double sinw[GOERTZEL_MAXTONES];
+    float coeff[GOERTZEL_MAXTONES];         /* 2 cos w, zero in unused lanes */
+    float s1[GOERTZEL_MAXTONES];
+    float s2[GOERTZEL_MAXTONES];
+    float energy;
+    unsigned int blklen;                    /* samples in the current block so far */
+    unsigned int left;                      /* samples until the block is complete */
+};
+
+void goertzel_init(struct goertzel_bank *b, unsigned int blocklen);
+
+/* Index of a tone in the bank, ntones if it is not there */
+unsigned int goertzel_tone(const struct goertzel_bank *b, unsigned int phinc);
+
+/* Add a tone unless already present; returns its index, or ntones if the bank is full */
+unsigned int goertzel_add(struct goertzel_bank *b, unsigned int phinc);
+
+static inline unsigned int goertzel_reclen(const struct goertzel_bank *b)
+{
+    return 1 + 2 * b->ntones;
+}
+
+/* Upper bound for the floats goertzel_run() stores for length samples */
+unsigned int goertzel_outlen(const struct goertzel_bank *b, int length);
+
+/*
+ * Advance a decoder's own block counter (starting at 0, like a bank) over
+ * length samples, returns the number of blocks that ended. A decoder
+ * reading the records of a bank run elsewhere uses it to know how many
+ * records each input block brings.
+ */
+unsigned int goertzel_count(int *blkcount, unsigned int blocklen, int length);
+
+/*
+ * Feed nch independent channels, each with its own bank and input, at
+ * most length samples, but never past the end of any bank's block.
+ * Advances in[] and returns the number of samples taken from each.
+ * Channels are filtered together, so their filters share the vector
+ * registers and hide each other's latency. Call goertzel_finish() on every
+ * bank before feeding again.
+ */
+int goertzel_feed(struct goertzel_bank **b, const float **in, unsigned int nch, int length);
+
+/* If the bank's block is complete, store its record in rec, start the next block and return 1 */
+int goertzel_finish(struct goertzel_bank *b, float *rec);
+
+/* Feed samples up to the end of the current block, returns 1 once rec holds its record */
+int goertzel_block(struct goertzel_bank *b, const float **buf, int *length, float *rec);
+
+/* Run over length samples, store the records of all blocks that end; returns their number */
+unsigned int goertzel_run(struct goertzel_bank *b, const float *buf, int length, float *out);
+
+/* ---------------------------------------------------------------------- */
+#endif /* _GOERTZEL_H */
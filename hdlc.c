@@ -79,8 +79,6 @@ static inline int check_crc_ccitt(const unsigned char *buf, int cnt)
 
 /* ---------------------------------------------------------------------- */
 
-int aprs_mode = 0;
-
 static void aprs_print_ax25call(unsigned char *call, int is_repeater)
 {
 	int i;
@@ -183,7 +181,7 @@ static void ax25_disp_packet(struct demod_state *s, unsigned char *bp, unsigned
                  */
                 if (len < 15) 
 			return;
-		if (aprs_mode) {
+		if (s->cfg->aprs_mode) {
 			aprs_disp_packet(bp, len);
 			return;
 		}
@@ -312,8 +310,11 @@ void hdlc_rxbit(struct demod_state *s, int bit)
 	s->l2.hdlc.rxbitstream <<= 1;
 	s->l2.hdlc.rxbitstream |= !!bit;
 	if ((s->l2.hdlc.rxbitstream & 0xff) == 0x7e) {
-		if (s->l2.hdlc.rxstate && (s->l2.hdlc.rxptr - s->l2.hdlc.rxbuf) > 2)
+		if (s->l2.hdlc.rxstate && (s->l2.hdlc.rxptr - s->l2.hdlc.rxbuf) > 2) {
+			demod_mark_at(s, s->l2.hdlc.start);
 			ax25_disp_packet(s, s->l2.hdlc.rxbuf, s->l2.hdlc.rxptr - s->l2.hdlc.rxbuf);
+		}
+		s->l2.hdlc.start = demod_rx_pos(s);
 		s->l2.hdlc.rxstate = 1;
 		s->l2.hdlc.rxptr = s->l2.hdlc.rxbuf;
 		s->l2.hdlc.rxbitbuf = 0x80;
@@ -332,6 +333,7 @@ void hdlc_rxbit(struct demod_state *s, int bit)
 	if (s->l2.hdlc.rxbitbuf & 1) {
 		if (s->l2.hdlc.rxptr >= s->l2.hdlc.rxbuf+sizeof(s->l2.hdlc.rxbuf)) {
 			s->l2.hdlc.rxstate = 0;
+			demod_mark_at(s, s->l2.hdlc.start);
 			verbprintf(1, "Error: packet size too large\n");
 			return;
 		}
@@ -0,0 +1,329 @@
+/*
+ *      impair.c -- channel impairments for generated test signals
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * The stages run in the order a signal meets them: the sender's
+ * frequency error, its sample clock, the fading path, then the
+ * receiver's DC offset, noise and clipping. A frequency shift takes the
+ * analytic signal from a Hilbert filter and turns it by a complex
+ * oscillator; the clock error resamples with cubic interpolation. Fading
+ * is flat, its gain the magnitude of a sum of sinusoids spread by the
+ * Doppler frequency (the Zheng and Xiao model of Clarke's). The noise
+ * and the fading come from a seeded generator, so the same seed gives
+ * the same samples on every platform.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "impair.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+#define HILBERT_HALF 63
+#define HILBERT_LEN  (2 * HILBERT_HALF + 1)
+#define MAX_DRIFT_PPM 1000.0
+#define MAX_FADING_HZ 100.0
+#define FADE_PATHS 8
+#define FADE_STEP 32                /* samples the fading gain is interpolated over */
+
+struct impair {
+    struct impair_params p;
+
+    /* frequency shift */
+    float hilbert[HILBERT_LEN];
+    float hist[2 * HILBERT_LEN];    /* written twice, the window is contiguous */
+    unsigned int hpos;
+    double rot_c, rot_s;            /* oscillator phasor */
+    double step_c, step_s;
+    unsigned int renorm;
+
+    /* sample clock */
+    double clock_step;
+    double frac;                    /* next output between x[1] and x[2] of the history */
+    float x[4];
+
+    /* fading */
+    double fade_ph[2][FADE_PATHS], fade_inc[2][FADE_PATHS];
+    float gain, gain_step;
+    unsigned int fade_left;
+
+    /* noise */
+    float sigma;
+    uint64_t rng;
+    double spare;
+    int have_spare;
+
+    float *tmp;
+    unsigned int tmpcap;
+};
+
+/* ---------------------------------------------------------------------- */
+
+void impair_params_init(struct impair_params *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->snr_db = INFINITY;
+    p->signal_rms = 1;
+    p->seed = 1;
+}
+
+/* xorshift64*, seeded through splitmix64 so that small seeds spread */
+static uint64_t next_u64(struct impair *im)
+{
+    im->rng ^= im->rng >> 12;
+    im->rng ^= im->rng << 25;
+    im->rng ^= im->rng >> 27;
+    return im->rng * 0x2545f4914f6cdd1dull;
+}
+
+static uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/* standard normal, by the polar method */
+static double gauss(struct impair *im)
+{
+    double u, v, r;
+
+    if (im->have_spare) {
+        im->have_spare = 0;
+        return im->spare;
+    }
+    do {
+        u = (next_u64(im) >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+        v = (next_u64(im) >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+        r = u * u + v * v;
+    } while (r >= 1.0 || r == 0.0);
+    r = sqrt(-2.0 * log(r) / r);
+    im->spare = v * r;
+    im->have_spare = 1;
+    return u * r;
+}
+
+static double uniform_phase(struct impair *im)
+{
+    return (next_u64(im) >> 11) * (2 * M_PI / 9007199254740992.0) - M_PI;
+}
+
+/* the envelope now, then advances the paths by FADE_STEP samples; unit mean power */
+static float fade_gain(struct impair *im)
+{
+    double re = 0, im_ = 0;
+
+    for (int k = 0; k < FADE_PATHS; k++) {
+        re += cos(im->fade_ph[0][k]);
+        im_ += cos(im->fade_ph[1][k]);
+        im->fade_ph[0][k] = fmod(im->fade_ph[0][k] + FADE_STEP * im->fade_inc[0][k], 2 * M_PI);
+        im->fade_ph[1][k] = fmod(im->fade_ph[1][k] + FADE_STEP * im->fade_inc[1][k], 2 * M_PI);
+    }
+    return (float)sqrt((re * re + im_ * im_) / FADE_PATHS);
+}
+
+struct impair *impair_new(const struct impair_params *p, unsigned int rate)
+{
+    struct impair *im;
+
+    if (!rate || fabs(p->drift_ppm) > MAX_DRIFT_PPM || fabs(p->freq_shift) >= rate / 2.0 ||
+        isnan(p->snr_db) || !(p->signal_rms >= 0) || !(p->fading_hz >= 0) ||
+        p->fading_hz > MAX_FADING_HZ || !(p->clip >= 0))
+        return NULL;
+    if (!(im = calloc(1, sizeof(*im))))
+        return NULL;
+    im->p = *p;
+
+    /* Blackman windowed Hilbert transformer, 2/(pi k) at odd k */
+    for (int j = 0; j < HILBERT_LEN; j++) {
+        int k = HILBERT_HALF - j;
+        double w = 0.42 - 0.5 * cos(2 * M_PI * j / (HILBERT_LEN - 1))
+                   + 0.08 * cos(4 * M_PI * j / (HILBERT_LEN - 1));
+        im->hilbert[j] = k & 1 ? (float)(2.0 / (M_PI * k) * w) : 0.0f;
+    }
+    im->rot_c = 1;
+    im->step_c = cos(2 * M_PI * p->freq_shift / rate);
+    im->step_s = sin(2 * M_PI * p->freq_shift / rate);
+
+    im->clock_step = 1.0 + p->drift_ppm * 1e-6;
+
+    im->sigma = isinf(p->snr_db) ? 0.0f : (float)(p->signal_rms * pow(10.0, -p->snr_db / 20.0));
+    im->rng = splitmix64(p->seed);
+    if (!im->rng)
+        im->rng = 1;
+
+    if (p->fading_hz > 0) {
+        double theta = uniform_phase(im);
+
+        for (int k = 0; k < FADE_PATHS; k++) {
+            double alpha = (2 * M_PI * (k + 1) - M_PI + theta) / (4 * FADE_PATHS);
+            double w = 2 * M_PI * p->fading_hz / rate;
+
+            im->fade_inc[0][k] = w * cos(alpha);
+            im->fade_inc[1][k] = w * sin(alpha);
+            im->fade_ph[0][k] = uniform_phase(im);
+            im->fade_ph[1][k] = uniform_phase(im);
+        }
+        im->gain = fade_gain(im);
+    }
+    return im;
+}
+
+void impair_free(struct impair *im)
+{
+    if (!im)
+        return;
+    free(im->tmp);
+    free(im);
+}
+
+unsigned int impair_max_out(unsigned int n)
+{
+    return n + n / 999 + 2;
+}
+
+double impair_position(const struct impair *im, double pos)
+{
+    if (im->p.freq_shift != 0)
+        pos += HILBERT_HALF;
+    /* the interpolator runs two samples behind its input */
+    if (im->p.drift_ppm != 0)
+        pos = (pos + 2) / im->clock_step;
+    return pos;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void shift_frequency(struct impair *im, const float *in, unsigned int n, float *out)
+{
+    for (unsigned int i = 0; i < n; i++) {
+        const float *w;
+        float q = 0;
+
+        im->hist[im->hpos] = im->hist[im->hpos + HILBERT_LEN] = in[i];
+        if (++im->hpos == HILBERT_LEN)
+            im->hpos = 0;
+        w = im->hist + im->hpos;
+        for (int j = 0; j < HILBERT_LEN; j += 2)
+            q += im->hilbert[j] * w[j];
+        /* the real part is delayed to the centre of the filter */
+        out[i] = (float)(w[HILBERT_HALF] * im->rot_c - q * im->rot_s);
+
+        double c = im->rot_c * im->step_c - im->rot_s * im->step_s;
+        im->rot_s = im->rot_c * im->step_s + im->rot_s * im->step_c;
+        im->rot_c = c;
+        if (++im->renorm == 4096) {
+            double r = 1.0 / sqrt(im->rot_c * im->rot_c + im->rot_s * im->rot_s);
+            im->rot_c *= r;
+            im->rot_s *= r;
+            im->renorm = 0;
+        }
+    }
+}
+
+/* Catmull-Rom between x[1] and x[2] */
+static float cubic(const float *x, float t)
+{
+    float a = -0.5f * x[0] + 1.5f * x[1] - 1.5f * x[2] + 0.5f * x[3];
+    float b = x[0] - 2.5f * x[1] + 2.0f * x[2] - 0.5f * x[3];
+    float c = -0.5f * x[0] + 0.5f * x[2];
+
+    return ((a * t + b) * t + c) * t + x[1];
+}
+
+static unsigned int resample_clock(struct impair *im, const float *in, unsigned int n, float *out)
+{
+    unsigned int k = 0;
+
+    for (unsigned int i = 0; i < n; i++) {
+        im->x[0] = im->x[1];
+        im->x[1] = im->x[2];
+        im->x[2] = im->x[3];
+        im->x[3] = in[i];
+        for (; im->frac < 1.0; im->frac += im->clock_step)
+            out[k++] = cubic(im->x, (float)im->frac);
+        im->frac -= 1.0;
+    }
+    return k;
+}
+
+static void fade(struct impair *im, float *buf, unsigned int n)
+{
+    for (unsigned int i = 0; i < n; i++) {
+        if (!im->fade_left) {
+            float next = fade_gain(im);
+
+            im->gain_step = (next - im->gain) / FADE_STEP;
+            im->fade_left = FADE_STEP;
+        }
+        buf[i] *= im->gain;
+        im->gain += im->gain_step;
+        im->fade_left--;
+    }
+}
+
+unsigned int impair_run(struct impair *im, const float *in, unsigned int n, float *out)
+{
+    const float *src = in;
+
+    if (im->p.freq_shift != 0) {
+        if (im->p.drift_ppm != 0 && im->tmpcap < n) {
+            free(im->tmp);
+            if (!(im->tmp = malloc(n * sizeof(im->tmp[0])))) {
+                im->tmpcap = 0;
+                return 0;
+            }
+            im->tmpcap = n;
+        }
+        shift_frequency(im, in, n, im->p.drift_ppm != 0 ? im->tmp : out);
+        src = im->p.drift_ppm != 0 ? im->tmp : out;
+    }
+    if (im->p.drift_ppm != 0)
+        n = resample_clock(im, src, n, out);
+    else if (src != out)
+        memcpy(out, src, n * sizeof(out[0]));
+
+    if (im->p.fading_hz > 0)
+        fade(im, out, n);
+    if (im->p.dc_offset != 0)
+        for (unsigned int i = 0; i < n; i++)
+            out[i] += (float)im->p.dc_offset;
+    if (im->sigma > 0)
+        for (unsigned int i = 0; i < n; i++)
+            out[i] += (float)(im->sigma * gauss(im));
+    if (im->p.clip > 0) {
+        float c = (float)im->p.clip;
+
+        for (unsigned int i = 0; i < n; i++)
+            out[i] = out[i] > c ? c : out[i] < -c ? -c : out[i];
+    }
+    return n;
+}
+
+/* ---------------------------------------------------------------------- */
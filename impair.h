@@ -0,0 +1,64 @@
+/*
+ *      impair.h -- channel impairments for generated test signals
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _IMPAIR_H
+#define _IMPAIR_H
+
+#include <stdint.h>
+
+/* ---------------------------------------------------------------------- */
+
+/* Samples are floats, full scale 1. What is not set does nothing. */
+struct impair_params {
+    double snr_db;              /* white noise this far below signal_rms, INFINITY for none */
+    double signal_rms;          /* level the SNR refers to */
+    double freq_shift;          /* Hz every frequency of the signal is moved by */
+    double dc_offset;
+    double drift_ppm;           /* the sender's sample clock runs fast by this, up to 1000 */
+    double fading_hz;           /* Doppler spread of Rayleigh fading, up to 100 */
+    double clip;                /* level the receiver clips at, 0 for none */
+    uint64_t seed;              /* of the noise and the fading */
+};
+
+struct impair;
+
+void impair_params_init(struct impair_params *p);
+
+/* Returns NULL if a parameter is out of range or memory runs out */
+struct impair *impair_new(const struct impair_params *p, unsigned int rate);
+void impair_free(struct impair *im);
+
+/* The most samples impair_run() makes out of n */
+unsigned int impair_max_out(unsigned int n);
+
+/* Where sample pos of the input comes out, in samples of the output */
+double impair_position(const struct impair *im, double pos);
+
+/*
+ * Impair n samples into out, returns how many it holds: with a clock
+ * error that is not n, and shifting frequencies delays the signal.
+ */
+unsigned int impair_run(struct impair *im, const float *in, unsigned int n, float *out);
+
+/* ---------------------------------------------------------------------- */
+#endif /* _IMPAIR_H */
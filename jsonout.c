@@ -0,0 +1,184 @@
+/*
+ *      jsonout.c -- streaming JSON records for --json output
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * A record is one flat JSON object on one line. Fields are escaped
+ * straight into a buffer owned by the calling thread, which is kept from
+ * record to record, so once it has grown to the longest record no more
+ * memory is allocated. Strings are escaped the way cJSON used to print them:
+ * the two-character escapes, \u00xx for other control characters and
+ * everything else, including 8-bit characters, as is.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "multimon.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------------------------------------------------------- */
+
+struct json_buf {
+    char *buf;
+    size_t len;
+    size_t cap;
+    bool first;                 /* no field in the record yet */
+};
+
+static _Thread_local struct json_buf jb;
+
+static char *json_reserve(size_t n)
+{
+    if (jb.len + n > jb.cap) {
+        size_t cap = jb.cap ? jb.cap : 1024;
+        while (cap < jb.len + n)
+            cap *= 2;
+        char *buf = realloc(jb.buf, cap);
+        if (!buf) {
+            perror("realloc");
+            exit(10);
+        }
+        jb.buf = buf;
+        jb.cap = cap;
+    }
+    return jb.buf + jb.len;
+}
+
+static void json_putc(char c)
+{
+    *json_reserve(1) = c;
+    jb.len++;
+}
+
+static void json_escape(const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t len = strlen(str);
+    char *p = json_reserve(len * 6 + 2);
+
+    *p++ = '"';
+    while (*str) {
+        /* copy runs that need no escaping in one go */
+        const char *run = str;
+        while ((unsigned char)*str > 31 && *str != '"' && *str != '\\')
+            str++;
+        memcpy(p, run, str - run);
+        p += str - run;
+        if (!*str)
+            break;
+
+        unsigned char c = *str++;
+        *p++ = '\\';
+        switch (c) {
+        case '"':
+        case '\\':
+            *p++ = c;
+            break;
+        case '\b':
+            *p++ = 'b';
+            break;
+        case '\f':
+            *p++ = 'f';
+            break;
+        case '\n':
+            *p++ = 'n';
+            break;
+        case '\r':
+            *p++ = 'r';
+            break;
+        case '\t':
+            *p++ = 't';
+            break;
+        default:
+            *p++ = 'u';
+            *p++ = '0';
+            *p++ = '0';
+            *p++ = hex[c >> 4];
+            *p++ = hex[c & 15];
+            break;
+        }
+    }
+    *p++ = '"';
+    jb.len = p - jb.buf;
+}
+
+static void json_key(const char *key)
+{
+    if (!jb.first)
+        json_putc(',');
+    jb.first = false;
+    json_escape(key);
+    json_putc(':');
+}
+
+/* ---------------------------------------------------------------------- */
+
+void json_begin(void)
+{
+    jb.len = 0;
+    jb.first = true;
+    json_putc('{');
+}
+
+void json_add_string(const char *key, const char *value)
+{
+    json_key(key);
+    json_escape(value);
+}
+
+void json_add_int(const char *key, int64_t value)
+{
+    char digits[20];
+    uint64_t u = value < 0 ? -(uint64_t)value : (uint64_t)value;
+    int n = 0;
+
+    json_key(key);
+    do {
+        digits[n++] = '0' + u % 10;
+        u /= 10;
+    } while (u);
+
+    char *p = json_reserve(n + 1);
+    if (value < 0)
+        *p++ = '-';
+    while (n)
+        *p++ = digits[--n];
+    jb.len = p - jb.buf;
+}
+
+void json_add_null(const char *key)
+{
+    json_key(key);
+    memcpy(json_reserve(4), "null", 4);
+    jb.len += 4;
+}
+
+void json_end(void)
+{
+    json_add_channel();
+    memcpy(json_reserve(2), "}\n", 2);
+    jb.len += 2;
+    output_write(jb.buf, jb.len);
+}
+
+/* ---------------------------------------------------------------------- */
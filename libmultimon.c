@@ -0,0 +1,1325 @@
+/*
+ *      libmultimon.c -- decoder contexts: rate groups, workers and output
+ *
+ *      Copyright (C) 1996
+ *          Thomas Sailer (sailer@ife.ee.ethz.ch, hb9jnx@hb9w.che.eu)
+ *
+ *      Copyright (C) 2012-2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Everything a set of demodulators needs to run lives in a struct
+ * multimon: their states, the options they read through s->cfg, the rate
+ * groups feeding them and their output. Every enabled demodulator runs
+ * once on every channel of the input, each instance with a state of its
+ * own. Demodulators print with
+ * verbprintf() and json_end() and know nothing about the context; the
+ * thread running one is told which context and demodulator it works for
+ * in thread-local variables, set around every demod() call.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "multimon.h"
+#include "resample.h"
+#include "channelizer.h"
+#include "deinterleave.h"
+#include "filter.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+/* MinGW compatibility for timespec_get */
+#if defined(__MINGW32__) || defined(__MINGW64__)
+#include <windows.h>
+
+#ifndef TIME_UTC
+#define TIME_UTC 1
+#endif
+
+/* Provide timespec_get for MinGW if not available */
+#ifndef timespec_get
+static inline int timespec_get(struct timespec *ts, int base)
+{
+    if (base != TIME_UTC) return 0;
+
+    /* Get current time using Windows-specific functions */
+    FILETIME ft;
+    ULARGE_INTEGER ui;
+
+    GetSystemTimeAsFileTime(&ft);
+    ui.LowPart = ft.dwLowDateTime;
+    ui.HighPart = ft.dwHighDateTime;
+
+    /* Convert from 100-nanosecond intervals since 1601-01-01 to Unix epoch */
+    const uint64_t EPOCH_DIFF = 116444736000000000ULL;
+    uint64_t tmp = ui.QuadPart - EPOCH_DIFF;
+
+    ts->tv_sec = (time_t)(tmp / 10000000ULL);
+    ts->tv_nsec = (long)((tmp % 10000000ULL) * 100);
+
+    return TIME_UTC;
+}
+#endif
+
+/* MinGW doesn't support %F and %T format specifiers for strftime */
+#define ISO8601_FORMAT "%Y-%m-%dT%H:%M:%S"
+#else
+#define ISO8601_FORMAT "%FT%T"
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+static const struct demod_param *dem[] = { ALL_DEMOD };
+
+#define NUMDEMOD (sizeof(dem)/sizeof(dem[0]))
+
+/*
+ * Output is collected in line buffers and handed out a complete line at
+ * a time, so lines printed by different demodulators never interleave.
+ * The main thread, every parallel worker and every pool thread have one
+ * of their own.
+ */
+#define LINE_BUF_SIZE 16384
+
+struct line_buf {
+    char buf[LINE_BUF_SIZE];
+    size_t len;
+    bool startline;
+};
+
+/*
+ * The instances on a channel are grouped by the sampling rate they
+ * expect. Each group is fed one stream at its own rate: the channel
+ * itself when the rates match, otherwise a single resampled copy shared
+ * by all its members.
+ */
+#define GROUP_BUF_SIZE 8192
+
+struct rate_group {
+    unsigned int rate;
+    unsigned int channel;
+    unsigned int overlap;       /* largest overlap among the members */
+    unsigned int ndemods;
+    int demod[NUMDEMOD];        /* members, indices into the instances */
+    struct resampler *rs;       /* NULL while the input runs at this rate */
+    float *fbuf;
+    short *sbuf;
+    unsigned int fbuf_cnt;
+    uint64_t pos;               /* samples of the stream handed to the members so far */
+    unsigned int nfsk;
+    struct fskcorr_stream *fsk[NUMDEMOD];  /* FSK front ends shared by several members */
+    struct goertzel_bank *selcall;          /* tones of all its selcall standards, if several */
+    float *side;                /* output of the shared front ends for the current block */
+    unsigned int sidecap;
+#ifdef HAVE_PTHREAD
+    struct parallel *par;
+#endif
+};
+
+struct multimon {
+    struct multimon_config cfg;
+    char *label;
+    unsigned int channels;      /* interleaved in the pushed samples */
+    bool *enabled;              /* [NUMDEMOD * channels], demodulator i on channel c at i * channels + c */
+    struct demod_state *st;     /* [ninst], the instances channel by channel */
+    unsigned int ninst;
+    struct rate_group *groups;  /* [NUMDEMOD * channels] */
+    unsigned int ngroups;
+    unsigned int input_rate;
+    unsigned int demod_rate;    /* highest rate among the demodulators */
+    unsigned int overlap;       /* largest overlap among the demodulators */
+    bool float_input;           /* some demodulator wants float samples */
+    struct timespec clock_start; /* time of the first sample, for the sample clock */
+    bool clock_started;
+    struct line_buf main_lines;
+    /* samples pushed but not processed yet: the overlap, converted both ways, per channel */
+    float *pf;
+    short *ps;
+    unsigned int pstride;       /* distance between the channels in pf and ps */
+    unsigned int pcnt;
+    float **fout;               /* [channels], where the next frames go */
+    short **sout;
+    /* complex input split into channels, each filling its part of pf and ps on its own */
+    struct channelizer *cz;
+    unsigned int *ccnt;         /* [channels], samples in pf and ps */
+    /* DTMF on the channels of pushed input, filtered in one call per block */
+    unsigned int ndtmf;
+    struct demod_state **dtmf;  /* [channels] */
+    const float **dtmf_in;
+#ifdef HAVE_PTHREAD
+    int *worker_demod;          /* [ninst], the instance each worker runs */
+    unsigned int nworkers;
+    struct line_buf *worker_lines;
+    struct pool *pool;          /* runs the channels of a block side by side */
+    unsigned int npool;
+    struct line_buf *pool_lines; /* [npool] */
+#endif
+};
+
+/* what the calling thread works on */
+static _Thread_local struct multimon *cur;
+static _Thread_local struct line_buf *cur_lines;
+static _Thread_local struct demod_state *cur_demod;
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Time stamps come from the wall clock, or with the sample clock from the
+ * position in the sample stream: the time of the first input sample plus
+ * the stream index where the message began over the sampling rate.
+ */
+static void clock_position(const struct multimon *m, uint64_t *pos, unsigned int *rate)
+{
+    const struct demod_state *s = cur_demod;
+
+    if (s) {
+        *pos = s->marked ? s->mark_pos : s->block_pos;
+        *rate = s->dem_par->samplerate;
+    } else if (m->ngroups) {
+        /* not printed by a demodulator, say at the end of the input */
+        *pos = m->groups[0].pos;
+        *rate = m->groups[0].rate;
+    } else {
+        *pos = 0;
+        *rate = 1;
+    }
+}
+
+static void output_timespec(const struct multimon *m, struct timespec *ts)
+{
+    uint64_t pos;
+    unsigned int rate;
+
+    if (!m || !m->cfg.sample_clock) {
+        timespec_get(ts, TIME_UTC);
+        return;
+    }
+    clock_position(m, &pos, &rate);
+    ts->tv_sec = m->clock_start.tv_sec + pos / rate;
+    ts->tv_nsec = m->clock_start.tv_nsec + (long)(pos % rate * 1000000000ull / rate);
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+time_t output_time(void)
+{
+    struct timespec ts;
+
+    output_timespec(cur, &ts);
+    return ts.tv_sec;
+}
+
+/*
+ * The date and time only change once a second, so they are formatted once
+ * a second. Each thread keeps its own copy: localtime() and gmtime() are
+ * not reentrant.
+ */
+struct stamp_cache {
+    time_t sec;
+    bool iso8601;
+    char text[20];
+};
+
+static _Thread_local struct stamp_cache stamp = { (time_t)-1, false, "" };
+
+static int format_timestamp(const struct multimon *m, char *buf, size_t size)
+{
+    struct timespec ts;
+
+    output_timespec(m, &ts);
+    if (ts.tv_sec != stamp.sec || m->cfg.iso8601 != stamp.iso8601) {
+        if (m->cfg.iso8601)
+            strftime(stamp.text, sizeof stamp.text, ISO8601_FORMAT, gmtime(&ts.tv_sec)); //2024-09-13T20:35:30
+        else
+            strftime(stamp.text, sizeof stamp.text, "%Y-%m-%d %H:%M:%S", localtime(&ts.tv_sec));
+        stamp.sec = ts.tv_sec;
+        stamp.iso8601 = m->cfg.iso8601;
+    }
+    if (m->cfg.iso8601)
+        return snprintf(buf, size, "%s.%06ld", stamp.text, ts.tv_nsec/1000); //2024-09-13T20:35:30.156337
+    return snprintf(buf, size, "%s", stamp.text);
+}
+
+static int format_line_prefix(const struct multimon *m, char *buf, size_t size)
+{
+    int len = 0;
+
+    if (m->label != NULL)
+        len = snprintf(buf, size, "%s: ", m->label);
+    if ((size_t)len >= size)
+        return size - 1;
+
+    if (m->cfg.timestamp) {
+        len += format_timestamp(m, buf + len, size - len);
+        if ((size_t)len < size)
+            len += snprintf(buf + len, size - len, ": ");
+    }
+    if (m->channels > 1 && cur_demod && (size_t)len < size)
+        len += snprintf(buf + len, size - len, "CH%u: ", cur_demod->channel);
+    return (size_t)len >= size ? (int)size - 1 : len;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void deliver(struct multimon *m, const char *text, size_t len, bool json)
+{
+    struct multimon_message msg;
+
+    if (cur_demod && cur_demod->marked)
+        cur_demod->mark_printed = true;
+    if (!m->cfg.output) {
+        fwrite(text, 1, len, stdout);
+        return;
+    }
+    msg.demod = cur_demod ? cur_demod->dem_par->name : NULL;
+    msg.channel = cur_demod ? cur_demod->channel : 0;
+    msg.text = text;
+    msg.len = len;
+    msg.json = json;
+    clock_position(m, &msg.sample, &msg.samplerate);
+    output_timespec(m, &msg.time);
+    m->cfg.output(m->cfg.output_arg, &msg);
+}
+
+/* hand out the first len bytes, a line at a time */
+static void line_buf_flush(struct multimon *m, struct line_buf *lb, size_t len)
+{
+    const char *p = lb->buf, *end = lb->buf + len;
+
+    while (p < end) {
+        const char *nl = memchr(p, '\n', end - p);
+        const char *next = nl ? nl + 1 : end;
+        deliver(m, p, next - p, false);
+        p = next;
+    }
+    lb->len -= len;
+    memmove(lb->buf, lb->buf + len, lb->len);
+}
+
+/* hand out the complete lines */
+static void line_buf_complete(struct multimon *m, struct line_buf *lb)
+{
+    size_t end = lb->len;
+    while (end > 0 && lb->buf[end-1] != '\n')
+        end--;
+    if (end > 0)
+        line_buf_flush(m, lb, end);
+}
+
+static void line_buf_vprintf(struct multimon *m, struct line_buf *lb,
+                             const char *fmt, va_list args)
+{
+    va_list copy;
+    int n;
+
+    if (lb->startline)
+    {
+        lb->len += format_line_prefix(m, lb->buf + lb->len, LINE_BUF_SIZE - lb->len);
+        lb->startline = false;
+    }
+    if (NULL != strchr(fmt,'\n')) /* detect end of line in stream */
+        lb->startline = true;
+
+    va_copy(copy, args);
+    n = vsnprintf(lb->buf + lb->len, LINE_BUF_SIZE - lb->len, fmt, copy);
+    va_end(copy);
+    if (n < 0)
+        return;
+    if ((size_t)n >= LINE_BUF_SIZE - lb->len) {
+        /* does not fit, hand out what we have and the overlong text in one piece */
+        char *text = malloc(lb->len + n + 1);
+        if (!text) {
+            perror("malloc");
+            exit(10);
+        }
+        memcpy(text, lb->buf, lb->len);
+        vsnprintf(text + lb->len, n + 1, fmt, args);
+        deliver(m, text, lb->len + n, false);
+        free(text);
+        lb->len = 0;
+        return;
+    }
+    lb->len += n;
+    line_buf_complete(m, lb);
+}
+
+void _verbprintf(int verb_level, const char *fmt, ...)
+{
+    struct multimon *m = cur;
+    va_list args;
+
+    va_start(args, fmt);
+    if (!m)
+    {
+        /* not called on behalf of a context */
+        if (verb_level <= 0)
+            vfprintf(stdout, fmt, args);
+    }
+    else if (verb_level <= m->cfg.verbose)
+        line_buf_vprintf(m, cur_lines, fmt, args);
+    va_end(args);
+}
+
+void output_write(const char *buf, size_t len)
+{
+    if (!cur) {
+        fwrite(buf, 1, len, stdout);
+        return;
+    }
+    deliver(cur, buf, len, true);
+}
+
+void json_add_channel(void)
+{
+    if (cur && cur->channels > 1 && cur_demod)
+        json_add_int("channel", cur_demod->channel);
+}
+
+void json_add_timestamp(void)
+{
+    if (!cur || !cur->cfg.timestamp) return;
+
+    char json_temp[100];
+    format_timestamp(cur, json_temp, sizeof json_temp);
+    json_add_string("timestamp", json_temp);
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void add_to_rate_group(struct multimon *m, int inst)
+{
+    const struct demod_state *s = m->st + inst;
+    struct rate_group *g = m->groups;
+
+    while (g < m->groups + m->ngroups &&
+           (g->rate != s->dem_par->samplerate || g->channel != s->channel))
+        g++;
+    if (g == m->groups + m->ngroups) {
+        g->rate = s->dem_par->samplerate;
+        g->channel = s->channel;
+        m->ngroups++;
+    }
+    g->demod[g->ndemods++] = inst;
+    if (s->dem_par->overlap > g->overlap)
+        g->overlap = s->dem_par->overlap;
+}
+
+/*
+ * DTMF on several channels of pushed input is filtered by one call of
+ * dtmf_demod_channels() per block, eight channels at a time, before the
+ * channels run. Each DTMF instance then only decodes what was filtered
+ * for it, in its place among its channel's demodulators. That takes every
+ * channel at the input rate, in step, and run by the channels' threads:
+ * not behind a channelizer, a resampler or --parallel workers.
+ */
+static void group_dtmf(struct multimon *m)
+{
+    m->ndtmf = 0;
+    for (struct rate_group *g = m->groups; g < m->groups + m->ngroups; g++) {
+        if (!m->dtmf || m->cz || g->rs)
+            continue;
+#ifdef HAVE_PTHREAD
+        if (g->par)
+            continue;
+#endif
+        for (unsigned int d = 0; d < g->ndemods; d++)
+            if (m->st[g->demod[d]].dem_par == &demod_dtmf)
+                m->dtmf[m->ndtmf++] = m->st + g->demod[d];
+    }
+    if (m->ndtmf < 2)
+        m->ndtmf = 0;
+}
+
+void multimon_set_input_rate(struct multimon *m, unsigned int rate)
+{
+    if (rate == m->input_rate)
+        return;
+    m->input_rate = rate;
+    for (struct rate_group *g = m->groups; g < m->groups + m->ngroups; g++) {
+        resampler_free(g->rs);
+        g->rs = NULL;
+        g->fbuf_cnt = 0;
+        if (g->rate == rate)
+            continue;
+        if (!g->fbuf) {
+            g->fbuf = malloc((GROUP_BUF_SIZE + g->overlap) * sizeof(g->fbuf[0]));
+            g->sbuf = malloc((GROUP_BUF_SIZE + g->overlap) * sizeof(g->sbuf[0]));
+        }
+        if (!g->fbuf || !g->sbuf || !(g->rs = resampler_new(rate, g->rate))) {
+            perror("resampler");
+            exit(10);
+        }
+        /* the resampler works on floats, whatever the demodulators want */
+        m->float_input = true;
+        if (m->cfg.verbose >= 1 && g->channel == 0)
+            fprintf(stderr, "Resampling %u Hz input to %u Hz for %u demodulator%s\n",
+                    rate, g->rate, g->ndemods, g->ndemods == 1 ? "" : "s");
+    }
+    group_dtmf(m);
+}
+
+static unsigned int fsk_front_users(struct multimon *m, const struct rate_group *g,
+                                    unsigned int first, const struct fskcorr_front *f,
+                                    int assign)
+{
+    unsigned int users = 0;
+
+    for (unsigned int d = first; d < g->ndemods; d++) {
+        const struct fskcorr_front *o = m->st[g->demod[d]].dem_par->fsk_front;
+        if (!o || !fskcorr_front_equal(f, o))
+            continue;
+        if (assign >= 0)
+            m->st[g->demod[d]].fsk_stream = assign;
+        users++;
+    }
+    return users;
+}
+
+/*
+ * FSK demodulators of a group that correlate against the same tones over
+ * the same window (AFSK1200, CLIPFSK and UFSK1200 do) get their mark and
+ * space power from one correlator, run once per block in run_rate_group().
+ */
+static void share_fsk_fronts(struct multimon *m, struct rate_group *g)
+{
+    for (unsigned int d = 0; d < g->ndemods; d++) {
+        const struct fskcorr_front *f = m->st[g->demod[d]].dem_par->fsk_front;
+        unsigned int users;
+
+        if (!f || m->st[g->demod[d]].fsk_stream >= 0 ||
+            (users = fsk_front_users(m, g, d, f, -1)) < 2)
+            continue;
+        if (!(g->fsk[g->nfsk] = malloc(sizeof(*g->fsk[0])))) {
+            perror("malloc");
+            exit(10);
+        }
+        fskcorr_stream_init(g->fsk[g->nfsk], f);
+        fsk_front_users(m, g, d, f, g->nfsk);
+        g->nfsk++;
+        if (m->cfg.verbose >= 1 && g->channel == 0)
+            fprintf(stderr, "Sharing the %g/%g Hz FSK correlator among %u demodulators\n",
+                    f->freqs[0], f->freqs[1], users);
+    }
+}
+
+/*
+ * Selcall standards of a group share one Goertzel bank over the union of
+ * their tones, so enabling all of them costs 48 filters instead of 128
+ * oscillators.
+ */
+static void share_selcall_bank(struct multimon *m, struct rate_group *g)
+{
+    unsigned int users = 0;
+
+    for (unsigned int d = 0; d < g->ndemods; d++)
+        if (m->st[g->demod[d]].dem_par->selcall_freq)
+            users++;
+    if (users < 2)
+        return;
+    if (!(g->selcall = malloc(sizeof(*g->selcall)))) {
+        perror("malloc");
+        exit(10);
+    }
+    selcall_bank_init(g->selcall);
+    for (unsigned int d = 0; d < g->ndemods; d++)
+        if (m->st[g->demod[d]].dem_par->selcall_freq)
+            selcall_bank_add(g->selcall, m->st[g->demod[d]].dem_par->selcall_freq);
+    for (unsigned int d = 0; d < g->ndemods; d++)
+        if (m->st[g->demod[d]].dem_par->selcall_freq)
+            selcall_share(m->st + g->demod[d], g->selcall);
+    if (m->cfg.verbose >= 1 && g->channel == 0)
+        fprintf(stderr, "Sharing a %u tone selcall bank among %u standards\n",
+                g->selcall->ntones, users);
+}
+
+/* ---------------------------------------------------------------------- */
+
+/* nanoseconds by a clock that never jumps, for profiling */
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* the instance returns, a mark it printed at is used up */
+static void end_demod(struct demod_state *s)
+{
+    if (s->mark_printed)
+        s->marked = s->mark_printed = false;
+    cur_demod = NULL;
+}
+
+/*
+ * Run an instance on a block, what it prints is timed by its position.
+ * Only the thread running an instance touches its counters.
+ */
+static void run_demod(struct multimon *m, int inst, buffer_t buffer, int length)
+{
+    struct demod_state *s = m->st + inst;
+    uint64_t t0 = 0;
+
+    s->block_pos = buffer.pos;
+    cur_demod = s;
+    if (m->cfg.profile)
+        t0 = monotonic_ns();
+    s->dem_par->demod(s, buffer, length);
+    if (m->cfg.profile) {
+        s->prof_ns += monotonic_ns() - t0;
+        s->prof_samples += length;
+        s->prof_calls++;
+    }
+    end_demod(s);
+}
+
+#ifdef HAVE_PTHREAD
+static void run_worker(void *arg, unsigned int worker, buffer_t buffer, int length)
+{
+    struct multimon *m = arg;
+
+    cur = m;
+    cur_lines = &m->worker_lines[worker];
+    run_demod(m, m->worker_demod[worker], buffer, length);
+}
+
+static void stop_workers(struct multimon *m)
+{
+    if (!m->nworkers)
+        return;
+    for (struct rate_group *g = m->groups; g < m->groups + m->ngroups; g++) {
+        if (g->par)
+            parallel_stop(g->par);
+        g->par = NULL;
+    }
+    /* hand out whatever unterminated output the workers left behind */
+    for (unsigned int w = 0; w < m->nworkers; w++)
+        if (m->worker_lines[w].len)
+            line_buf_flush(m, &m->worker_lines[w], m->worker_lines[w].len);
+    free(m->worker_lines);
+    free(m->worker_demod);
+    m->worker_lines = NULL;
+    m->worker_demod = NULL;
+    m->nworkers = 0;
+}
+
+/* One ring per rate group, each worker owns one instance of its group */
+static void start_workers(struct multimon *m)
+{
+    unsigned int total = 0;
+
+    for (struct rate_group *g = m->groups; g < m->groups + m->ngroups; g++)
+        total += g->ndemods;
+    if (!total)
+        return;
+    m->worker_lines = calloc(total, sizeof(m->worker_lines[0]));
+    m->worker_demod = calloc(total, sizeof(m->worker_demod[0]));
+    if (!m->worker_lines || !m->worker_demod) {
+        perror("calloc");
+        exit(10);
+    }
+    for (unsigned int w = 0; w < total; w++)
+        m->worker_lines[w].startline = true;
+    for (struct rate_group *g = m->groups; g < m->groups + m->ngroups; g++) {
+        unsigned int first = m->nworkers;
+
+        for (unsigned int d = 0; d < g->ndemods; d++)
+            m->worker_demod[m->nworkers++] = g->demod[d];
+        if (!(g->par = parallel_start(g->ndemods, first, g->overlap, run_worker, m))) {
+            stop_workers(m);
+            return;
+        }
+    }
+}
+
+#endif
+
+static void run_rate_group(struct multimon *m, struct rate_group *g,
+                           float *float_buf, short *short_buf, unsigned int len)
+{
+    buffer_t buffer = {short_buf, float_buf, NULL, NULL, g->pos};
+    unsigned int fsklen = g->nfsk * len;
+    unsigned int sidelen = fsklen + (g->selcall ? goertzel_outlen(g->selcall, len) : 0);
+
+    if (g->sidecap < sidelen) {
+        free(g->side);
+        g->sidecap = sidelen;
+        if (!(g->side = malloc(g->sidecap * sizeof(g->side[0])))) {
+            perror("malloc");
+            exit(10);
+        }
+    }
+    if (g->nfsk) {
+        for (unsigned int k = 0; k < g->nfsk; k++)
+            fskcorr_stream_run(g->fsk[k], float_buf, len, g->side + k * len);
+        buffer.fskbuffer = g->side;
+    }
+    if (g->selcall) {
+        goertzel_run(g->selcall, float_buf, len, g->side + fsklen);
+        buffer.selcallbuffer = g->side + fsklen;
+    }
+    g->pos += len;
+#ifdef HAVE_PTHREAD
+    if (g->par) {
+        parallel_push(g->par, buffer, len, g->side, sidelen);
+        return;
+    }
+#endif
+    for (unsigned int d = 0; d < g->ndemods; d++)
+        run_demod(m, g->demod[d], buffer, len);
+}
+
+static void resample_rate_group(struct multimon *m, struct rate_group *g,
+                                const float *float_buf, unsigned int len)
+{
+    unsigned int n;
+
+    resampler_write(g->rs, float_buf, len);
+    while ((n = resampler_read(g->rs, g->fbuf + g->fbuf_cnt,
+                               GROUP_BUF_SIZE + g->overlap - g->fbuf_cnt))) {
+        for (unsigned int j = g->fbuf_cnt; j < g->fbuf_cnt + n; j++) {
+            float f = g->fbuf[j] * 32768.0f;
+            g->sbuf[j] = f >= 32767.0f ? 32767 : f <= -32768.0f ? -32768 : (short)lrintf(f);
+        }
+        g->fbuf_cnt += n;
+        if (g->fbuf_cnt > g->overlap) {
+            run_rate_group(m, g, g->fbuf, g->sbuf, g->fbuf_cnt - g->overlap);
+            memmove(g->fbuf, g->fbuf + g->fbuf_cnt - g->overlap, g->overlap * sizeof(g->fbuf[0]));
+            memmove(g->sbuf, g->sbuf + g->fbuf_cnt - g->overlap, g->overlap * sizeof(g->sbuf[0]));
+            g->fbuf_cnt = g->overlap;
+        }
+    }
+}
+
+static void start_clock(struct multimon *m)
+{
+    if (!m->clock_started) {
+        m->clock_started = true;
+        timespec_get(&m->clock_start, TIME_UTC);
+    }
+}
+
+/* only touches the groups of the channel, so channels may run side by side */
+static void process_channel(struct multimon *m, unsigned int channel,
+                            float *float_buf, short *short_buf, unsigned int len)
+{
+    for (struct rate_group *g = m->groups; g < m->groups + m->ngroups; g++) {
+        if (g->channel != channel)
+            continue;
+        if (g->rs)
+            resample_rate_group(m, g, float_buf, len);
+        else
+            run_rate_group(m, g, float_buf, short_buf, len);
+    }
+}
+
+/*
+ * Entry point for every input source: len new samples of a channel at the
+ * input rate, with the float buffer extending into the overlap.
+ */
+void multimon_process(struct multimon *m, unsigned int channel,
+                      float *float_buf, short *short_buf, unsigned int len)
+{
+    cur = m;
+    cur_lines = &m->main_lines;
+    start_clock(m);
+    process_channel(m, channel, float_buf, short_buf, len);
+    cur = NULL;
+}
+
+void multimon_call(struct multimon *m, unsigned int inst,
+                   void (*fn)(struct demod_state *s, void *arg), void *arg)
+{
+    cur = m;
+    cur_lines = &m->main_lines;
+    start_clock(m);
+    cur_demod = m->st + inst;
+    fn(m->st + inst, arg);
+    end_demod(m->st + inst);
+    cur = NULL;
+}
+
+unsigned int multimon_overlap(const struct multimon *m)
+{
+    return m->overlap;
+}
+
+bool multimon_float_input(const struct multimon *m)
+{
+    return m->float_input;
+}
+
+/* ---------------------------------------------------------------------- */
+
+#define PUSH_BLOCK 8192
+#define IQ_BLOCK   65536        /* complex samples channelized at once */
+
+static void convert_to_short(short *restrict ps, const float *restrict pf, unsigned int n)
+{
+    for (unsigned int i = 0; i < n; i++) {
+        float f = pf[i] * 32768.0f;
+        ps[i] = f >= 32767.0f ? 32767 : f <= -32768.0f ? -32768 : (short)lrintf(f);
+    }
+}
+
+/* a block and its overlap of channel c are in pf and ps */
+static void push_channel(struct multimon *m, unsigned int c)
+{
+    float *pf = m->pf + c * m->pstride;
+    short *ps = m->ps + c * m->pstride;
+
+    process_channel(m, c, pf, ps, PUSH_BLOCK);
+    memmove(pf, pf + PUSH_BLOCK, m->overlap * sizeof(pf[0]));
+    memmove(ps, ps + PUSH_BLOCK, m->overlap * sizeof(ps[0]));
+}
+
+/* demodulate what the channelizer has for channel c, running blocks as they fill */
+static void iq_channel(struct multimon *m, unsigned int c)
+{
+    float *pf = m->pf + c * m->pstride;
+    short *ps = m->ps + c * m->pstride;
+    unsigned int n;
+
+    while ((n = channelizer_read(m->cz, c, pf + m->ccnt[c],
+                                 PUSH_BLOCK + m->overlap - m->ccnt[c]))) {
+        convert_to_short(ps + m->ccnt[c], pf + m->ccnt[c], n);
+        m->ccnt[c] += n;
+        if (m->ccnt[c] == PUSH_BLOCK + m->overlap) {
+            push_channel(m, c);
+            m->ccnt[c] = m->overlap;
+        }
+    }
+}
+
+static void run_channel(struct multimon *m, unsigned int c)
+{
+    if (m->cz)
+        iq_channel(m, c);
+    else
+        push_channel(m, c);
+}
+
+#ifdef HAVE_PTHREAD
+static void run_pool_task(void *arg, unsigned int worker, unsigned int task)
+{
+    struct multimon *m = arg;
+
+    cur = m;
+    cur_lines = &m->pool_lines[worker];
+    run_channel(m, task);
+    cur = NULL;
+}
+
+static void stop_pool(struct multimon *m)
+{
+    if (!m->pool)
+        return;
+    pool_stop(m->pool);
+    m->pool = NULL;
+    for (unsigned int w = 0; w < m->npool; w++)
+        if (m->pool_lines[w].len)
+            line_buf_flush(m, &m->pool_lines[w], m->pool_lines[w].len);
+    free(m->pool_lines);
+    m->pool_lines = NULL;
+    m->npool = 0;
+}
+
+/* Threads for the channels, numbered after the parallel workers */
+static void start_pool(struct multimon *m, unsigned int nthreads)
+{
+    if (!(m->pool_lines = calloc(nthreads, sizeof(m->pool_lines[0])))) {
+        perror("calloc");
+        exit(10);
+    }
+    for (unsigned int w = 0; w < nthreads; w++)
+        m->pool_lines[w].startline = true;
+    m->npool = nthreads;
+    if (!(m->pool = pool_start(nthreads, m->nworkers, run_pool_task, m))) {
+        free(m->pool_lines);
+        m->pool_lines = NULL;
+        m->npool = 0;
+    }
+}
+#endif
+
+/*
+ * Filter the first len samples in pf for the DTMF instances of
+ * group_dtmf(), in one call. The time is split evenly among them for the
+ * profile; their calls and samples are counted when they decode.
+ */
+static void run_dtmf(struct multimon *m, unsigned int len)
+{
+    uint64_t t0 = 0;
+
+    for (unsigned int k = 0; k < m->ndtmf; k++)
+        m->dtmf_in[k] = m->pf + m->dtmf[k]->channel * m->pstride;
+    if (m->cfg.profile)
+        t0 = monotonic_ns();
+    dtmf_demod_channels(m->dtmf, m->dtmf_in, m->ndtmf, len);
+    if (m->cfg.profile) {
+        uint64_t ns = monotonic_ns() - t0;
+
+        for (unsigned int k = 0; k < m->ndtmf; k++)
+            m->dtmf[k]->prof_ns += ns / m->ndtmf;
+    }
+}
+
+/* every channel once, on the pool if there is one */
+static void run_channels(struct multimon *m)
+{
+    if (m->ndtmf)
+        run_dtmf(m, PUSH_BLOCK);
+#ifdef HAVE_PTHREAD
+    if (m->pool) {
+        pool_run(m->pool, m->channels);
+        return;
+    }
+#endif
+    cur = m;
+    cur_lines = &m->main_lines;
+    for (unsigned int c = 0; c < m->channels; c++)
+        run_channel(m, c);
+    cur = NULL;
+}
+
+/*
+ * Frames are collected, each channel on its own, until a block plus the
+ * overlap is there.
+ */
+static void push(struct multimon *m, const float *fbuf, const short *sbuf, unsigned int n)
+{
+    unsigned int nch = m->channels;
+
+    if (m->cz)
+        return;
+    start_clock(m);
+
+    while (n) {
+        unsigned int k = PUSH_BLOCK + m->overlap - m->pcnt;
+
+        if (k > n)
+            k = n;
+        for (unsigned int c = 0; c < nch; c++) {
+            m->fout[c] = m->pf + c * m->pstride + m->pcnt;
+            m->sout[c] = m->ps + c * m->pstride + m->pcnt;
+        }
+        /* split the frames first, the conversion then runs over contiguous samples */
+        if (fbuf)
+            deinterleave_f32(m->fout, fbuf, nch, k);
+        else
+            deinterleave_s16(m->sout, sbuf, nch, k);
+        for (unsigned int c = 0; c < nch; c++) {
+            float *restrict pf = m->fout[c];
+            short *restrict ps = m->sout[c];
+
+            if (fbuf) {
+                convert_to_short(ps, pf, k);
+            } else {
+                for (unsigned int i = 0; i < k; i++)
+                    pf[i] = ps[i] * (1.0f/32768.0f);
+            }
+        }
+        m->pcnt += k;
+        n -= k;
+        if (fbuf)
+            fbuf += k * nch;
+        else
+            sbuf += k * nch;
+        if (m->pcnt == PUSH_BLOCK + m->overlap) {
+            run_channels(m);
+            m->pcnt = m->overlap;
+        }
+    }
+}
+
+void multimon_push_float(struct multimon *m, const float *buf, unsigned int n)
+{
+    push(m, buf, NULL, n);
+}
+
+void multimon_push_samples(struct multimon *m, const short *buf, unsigned int n)
+{
+    push(m, NULL, buf, n);
+}
+
+void multimon_push_iq(struct multimon *m, const float *i, const float *q, unsigned int n)
+{
+    if (!m->cz)
+        return;
+    start_clock(m);
+    /* the filter bank runs here, the channels after it on the pool */
+    while (n) {
+        unsigned int k = n < IQ_BLOCK ? n : IQ_BLOCK;
+
+        channelizer_write(m->cz, i, q, k);
+        run_channels(m);
+        i += k;
+        q += k;
+        n -= k;
+    }
+}
+
+unsigned int multimon_samplerate(const struct multimon *m)
+{
+    return m->demod_rate;
+}
+
+unsigned int multimon_channels(const struct multimon *m)
+{
+    return m->channels;
+}
+
+unsigned int multimon_threads(const struct multimon *m)
+{
+#ifdef HAVE_PTHREAD
+    return m->nworkers + (m->npool ? m->npool - 1 : 0);
+#else
+    (void)m;
+    return 0;
+#endif
+}
+
+void multimon_set_start_time(struct multimon *m, const struct timespec *ts)
+{
+    m->clock_start = *ts;
+    m->clock_started = true;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void multimon_config_init(struct multimon_config *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->pocsag_mode = POCSAG_MODE_STANDARD;
+    cfg->pocsag_error_correction = 2;
+    cfg->cw_dit_length = 50;
+    cfg->cw_gap_length = 50;
+    cfg->cw_threshold = 500;
+    cfg->fm_deviation = 5000;
+}
+
+unsigned int multimon_demod_count(void)
+{
+    return NUMDEMOD;
+}
+
+const char *multimon_demod_name(unsigned int i)
+{
+    return i < NUMDEMOD ? dem[i]->name : NULL;
+}
+
+/* "3", "0-7" or "0,2,5-6": the channels a demodulator runs on */
+static bool parse_channels(const char *spec, bool *on, unsigned int channels)
+{
+    char *end;
+
+    for (;;) {
+        unsigned long a = strtoul(spec, &end, 10), b = a;
+
+        if (end == spec)
+            return false;
+        if (*end == '-') {
+            spec = end + 1;
+            b = strtoul(spec, &end, 10);
+            if (end == spec)
+                return false;
+        }
+        if (a > b || b >= channels)
+            return false;
+        while (a <= b)
+            on[a++] = true;
+        if (!*end)
+            return true;
+        if (*end != ',')
+            return false;
+        spec = end + 1;
+    }
+}
+
+#ifdef HAVE_PTHREAD
+/* the demodulators build tables shared by all contexts when they are set up */
+static pthread_mutex_t init_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+struct multimon *multimon_create(const struct multimon_config *cfg)
+{
+    struct multimon *m = calloc(1, sizeof(*m));
+    unsigned int nenabled = 0;
+
+    if (!m) {
+        perror("calloc");
+        return NULL;
+    }
+    m->cfg = *cfg;
+    m->channels = cfg->channels ? cfg->channels : 1;
+    m->cfg.demods = NULL;
+    if (cfg->label && !(m->label = strdup(cfg->label))) {
+        perror("strdup");
+        multimon_destroy(m);
+        return NULL;
+    }
+    m->cfg.label = m->label;
+    if (cfg->pocsag_charset && !pocsag_init_charset(cfg->pocsag_charset, NULL)) {
+        multimon_destroy(m);
+        return NULL;
+    }
+    if (!(m->enabled = calloc(NUMDEMOD * m->channels, sizeof(m->enabled[0])))) {
+        perror("calloc");
+        multimon_destroy(m);
+        return NULL;
+    }
+    for (const char *const *name = cfg->demods; name && *name; name++) {
+        size_t len = strcspn(*name, "@");
+        unsigned int i = 0;
+
+        while (i < NUMDEMOD && (strncasecmp(*name, dem[i]->name, len) || dem[i]->name[len]))
+            i++;
+        if (i >= NUMDEMOD) {
+            fprintf(stderr, "invalid mode \"%.*s\"\n", (int)len, *name);
+            multimon_destroy(m);
+            return NULL;
+        }
+        if (!(*name)[len]) {
+            for (unsigned int c = 0; c < m->channels; c++)
+                m->enabled[i * m->channels + c] = true;
+        } else if (!parse_channels(*name + len + 1, m->enabled + i * m->channels, m->channels)) {
+            fprintf(stderr, "invalid channels \"%s\" for %s, the input has %u\n",
+                    *name + len + 1, dem[i]->name, m->channels);
+            multimon_destroy(m);
+            return NULL;
+        }
+    }
+    for (unsigned int i = 0; i < NUMDEMOD * m->channels; i++)
+        nenabled += m->enabled[i];
+    /* as many instances as the channels need, one group per channel and rate at most */
+    if (!(m->st = calloc(nenabled + 1, sizeof(m->st[0]))) ||
+        !(m->groups = calloc(NUMDEMOD * m->channels, sizeof(m->groups[0])))) {
+        perror("calloc");
+        multimon_destroy(m);
+        return NULL;
+    }
+    m->main_lines.startline = true;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&init_lock);
+#endif
+    /* pick the correlator kernel before any demodulator runs */
+    mac_selected();
+    cur = m;
+    cur_lines = &m->main_lines;
+    for (unsigned int c = 0; c < m->channels; c++) {
+        for (unsigned int i = 0; i < NUMDEMOD; i++) {
+            struct demod_state *s = m->st + m->ninst;
+
+            if (!m->enabled[i * m->channels + c])
+                continue;
+            if (dem[i]->float_samples)
+                m->float_input = true;
+            s->dem_par = dem[i];
+            s->cfg = &m->cfg;
+            s->channel = c;
+            s->fsk_stream = -1;
+            if (dem[i]->init)
+                dem[i]->init(s);
+            if (dem[i]->demod)
+                add_to_rate_group(m, m->ninst);
+            if (dem[i]->samplerate > m->demod_rate)
+                m->demod_rate = dem[i]->samplerate;
+            if (dem[i]->overlap > m->overlap)
+                m->overlap = dem[i]->overlap;
+            m->ninst++;
+        }
+    }
+    cur = NULL;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&init_lock);
+#endif
+    /* only looked at by init, the caller's string need not outlive us */
+    m->cfg.pocsag_charset = NULL;
+
+    for (struct rate_group *g = m->groups; g < m->groups + m->ngroups; g++) {
+        share_fsk_fronts(m, g);
+        share_selcall_bank(m, g);
+    }
+    /*
+     * Room for a block, its overlap and the silence padding it at the end.
+     * The channels start a cache line past a multiple of 4 KiB apart, so
+     * the de-interleaving stores do not all land in the same cache sets.
+     */
+    m->pstride = ((PUSH_BLOCK + 2 * m->overlap + 2047) & ~2047u) + 32;
+    if (!(m->pf = malloc(m->channels * m->pstride * sizeof(m->pf[0]))) ||
+        !(m->ps = malloc(m->channels * m->pstride * sizeof(m->ps[0]))) ||
+        !(m->fout = malloc(m->channels * sizeof(m->fout[0]))) ||
+        !(m->sout = malloc(m->channels * sizeof(m->sout[0]))) ||
+        !(m->dtmf = malloc(m->channels * sizeof(m->dtmf[0]))) ||
+        !(m->dtmf_in = malloc(m->channels * sizeof(m->dtmf_in[0])))) {
+        perror("malloc");
+        multimon_destroy(m);
+        return NULL;
+    }
+    if (cfg->channel_freqs) {
+        if (!(m->ccnt = calloc(m->channels, sizeof(m->ccnt[0])))) {
+            perror("calloc");
+            multimon_destroy(m);
+            return NULL;
+        }
+        if (!(m->cz = channelizer_new(cfg->iq_rate, m->demod_rate, cfg->channel_freqs,
+                                      m->channels, cfg->fm_deviation))) {
+            fprintf(stderr, "invalid channels for %u Hz complex input, they must lie within +-%u Hz\n",
+                    cfg->iq_rate, cfg->iq_rate / 2);
+            multimon_destroy(m);
+            return NULL;
+        }
+        if (cfg->verbose >= 1) {
+            unsigned int bins = channelizer_bins(m->cz);
+            fprintf(stderr, "Channelizing %u Hz into %u bins %g Hz apart, %u taps\n",
+                    cfg->iq_rate, bins, (double)cfg->iq_rate / bins, channelizer_taps(m->cz));
+            for (unsigned int c = 0; c < m->channels; c++)
+                fprintf(stderr, "CH%u: %+.0f Hz\n", c, cfg->channel_freqs[c]);
+        }
+    }
+    m->cfg.channel_freqs = NULL;
+    /* the channelizer hands its channels over at the demodulators' rate */
+    multimon_set_input_rate(m, m->cz || !cfg->input_rate ? m->demod_rate : cfg->input_rate);
+
+    if (cfg->parallel) {
+#ifdef HAVE_PTHREAD
+        start_workers(m);
+#else
+        fprintf(stderr, "Warning: --parallel is not supported by this build, running single-threaded.\n");
+#endif
+    }
+    if (cfg->threads > 1 && m->channels > 1) {
+#ifdef HAVE_PTHREAD
+        start_pool(m, cfg->threads < m->channels ? cfg->threads : m->channels);
+#else
+        fprintf(stderr, "Warning: --threads is not supported by this build, running single-threaded.\n");
+#endif
+    }
+    /* the workers keep their DTMF instances */
+    group_dtmf(m);
+    if (m->ndtmf && cfg->verbose >= 1)
+        fprintf(stderr, "Decoding DTMF on %u channels together\n", m->ndtmf);
+    return m;
+}
+
+unsigned int multimon_profile(const struct multimon *m, struct multimon_profile *out,
+                              unsigned int max)
+{
+    for (unsigned int k = 0; k < m->ninst && k < max; k++) {
+        const struct demod_state *s = m->st + k;
+
+        out[k].demod = s->dem_par->name;
+        out[k].channel = s->channel;
+        out[k].samplerate = s->dem_par->samplerate;
+        out[k].calls = s->prof_calls;
+        out[k].samples = s->prof_samples;
+        out[k].ns = s->prof_ns;
+    }
+    return m->ninst;
+}
+
+void multimon_finish(struct multimon *m)
+{
+    /* what is left of the pushed samples, the overlap being padded with silence */
+    if (m->pf && m->ps && m->pcnt > 0) {
+        for (unsigned int c = 0; c < m->channels; c++) {
+            float *pf = m->pf + c * m->pstride;
+            short *ps = m->ps + c * m->pstride;
+
+            memset(pf + m->pcnt, 0, m->overlap * sizeof(pf[0]));
+            memset(ps + m->pcnt, 0, m->overlap * sizeof(ps[0]));
+        }
+        if (m->ndtmf)
+            run_dtmf(m, m->pcnt);
+        for (unsigned int c = 0; c < m->channels; c++)
+            multimon_process(m, c, m->pf + c * m->pstride, m->ps + c * m->pstride, m->pcnt);
+        m->pcnt = 0;
+    }
+    for (unsigned int c = 0; m->ccnt && c < m->channels; c++) {
+        float *pf = m->pf + c * m->pstride;
+        short *ps = m->ps + c * m->pstride;
+
+        if (!m->ccnt[c])
+            continue;
+        memset(pf + m->ccnt[c], 0, m->overlap * sizeof(pf[0]));
+        memset(ps + m->ccnt[c], 0, m->overlap * sizeof(ps[0]));
+        multimon_process(m, c, pf, ps, m->ccnt[c]);
+        m->ccnt[c] = 0;
+    }
+#ifdef HAVE_PTHREAD
+    stop_pool(m);
+    stop_workers(m);
+#endif
+}
+
+void multimon_destroy(struct multimon *m)
+{
+    if (!m)
+        return;
+    multimon_finish(m);
+    cur = m;
+    cur_lines = &m->main_lines;
+    for (unsigned int k = 0; k < m->ninst; k++) {
+        cur_demod = m->st + k;
+        if (m->st[k].dem_par->deinit)
+            m->st[k].dem_par->deinit(m->st + k);
+    }
+    cur_demod = NULL;
+    if (m->main_lines.len)
+        line_buf_flush(m, &m->main_lines, m->main_lines.len);
+    cur = NULL;
+
+    for (struct rate_group *g = m->groups; g < m->groups + m->ngroups; g++) {
+        resampler_free(g->rs);
+        free(g->fbuf);
+        free(g->sbuf);
+        for (unsigned int k = 0; k < g->nfsk; k++)
+            free(g->fsk[k]);
+        free(g->selcall);
+        free(g->side);
+    }
+    channelizer_free(m->cz);
+    free(m->ccnt);
+    free(m->dtmf);
+    free(m->dtmf_in);
+    free(m->pf);
+    free(m->ps);
+    free(m->fout);
+    free(m->sout);
+    free(m->groups);
+    free(m->enabled);
+    free(m->st);
+    free(m->label);
+    free(m);
+}
+
+/* ---------------------------------------------------------------------- */
@@ -0,0 +1,196 @@
+/*
+ *      libmultimon.h -- the multimon-ng decoders as a library
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _LIBMULTIMON_H
+#define _LIBMULTIMON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * A context runs a set of demodulators on one stream of samples. All its
+ * state, options included, lives in the context, so several contexts with
+ * different configurations can run in one process, each from one thread
+ * at a time. What the demodulators decode is handed to a callback, one
+ * line or JSON record at a time.
+ *
+ * The stream may interleave several channels, one sample of each per
+ * frame. Every demodulator then runs once per channel, and what the
+ * instances print is tagged with their channel. Or the context takes
+ * complex samples of a wide band and cuts the channels out of it itself,
+ * each FM demodulated.
+ */
+struct multimon;
+
+enum
+{
+    POCSAG_MODE_STANDARD = 0,
+    POCSAG_MODE_NUMERIC = 1,
+    POCSAG_MODE_ALPHA = 2,
+    POCSAG_MODE_SKYPER = 3,
+    POCSAG_MODE_AUTO = 4,
+};
+
+struct multimon_message {
+    const char *demod;          /* name of the demodulator, NULL if none printed it */
+    unsigned int channel;       /* of the input, 0 if no demodulator printed it */
+    const char *text;           /* one complete line, including its newline */
+    size_t len;
+    bool json;                  /* text is a --json record */
+    uint64_t sample;            /* stream index where the message began */
+    unsigned int samplerate;    /* rate sample counts in */
+    struct timespec time;       /* by the clock time stamps use */
+};
+
+typedef void (*multimon_output_fn)(void *arg, const struct multimon_message *msg);
+
+struct multimon_config {
+    /*
+     * Names of the demodulators to run, NULL terminated. A name runs on
+     * every channel, a name followed by channels, like "POCSAG1200@0-3,6",
+     * only on those.
+     */
+    const char *const *demods;
+    unsigned int input_rate;    /* rate of the pushed samples, 0 for the demodulators' rate */
+    unsigned int channels;      /* interleaved in the pushed samples, 0 for one */
+    multimon_output_fn output;
+    void *output_arg;
+
+    int verbose;                /* level of verbosity */
+    bool json;                  /* format messages as JSON records */
+    bool timestamp;             /* time stamp in front of every line */
+    bool iso8601;               /* UTC time stamps in ISO 8601 with microseconds */
+    const char *label;          /* put in front of every line, NULL for none */
+    bool sample_clock;          /* time stamps from the position in the stream */
+    bool parallel;              /* a worker thread per demodulator, if built with threads */
+    unsigned int threads;       /* run the channels on this many threads, if built with threads */
+    bool profile;               /* time every demodulator, see multimon_profile() */
+
+    /*
+     * With channel_freqs, samples are pushed with multimon_push_iq() at
+     * iq_rate, and channel c is the FM signal channel_freqs[c] Hz off the
+     * centre of the band. input_rate is not used then.
+     */
+    unsigned int iq_rate;
+    const double *channel_freqs; /* [channels], only looked at by multimon_create() */
+    float fm_deviation;         /* Hz of deviation giving full scale audio */
+
+    int pocsag_mode;            /* POCSAG_MODE_* */
+    int pocsag_error_correction; /* bit errors corrected, 0 to 2 */
+    int pocsag_polarity;        /* 0 auto, 1 normal only, 2 inverted only */
+    bool pocsag_invert_input;
+    bool pocsag_show_partial;
+    bool pocsag_heuristic_pruning;
+    bool pocsag_prune_empty;
+    const char *pocsag_charset; /* US, FR, DE, DK, SE or SI, NULL for US */
+
+    int cw_dit_length;          /* ms */
+    int cw_gap_length;          /* ms */
+    int cw_threshold;
+    bool cw_disable_auto_threshold;
+    bool cw_disable_auto_timing;
+
+    bool flex_disable_timestamp;
+    bool aprs_mode;             /* AFSK1200 and friends print TNC2 text */
+    bool fms_justhex;
+};
+
+/* The defaults of the multimon-ng command line, with no demodulators */
+void multimon_config_init(struct multimon_config *cfg);
+
+/* Demodulators compiled in, for listing their names */
+unsigned int multimon_demod_count(void);
+const char *multimon_demod_name(unsigned int i);
+
+/* Returns NULL, with a message on stderr, if the configuration is invalid */
+struct multimon *multimon_create(const struct multimon_config *cfg);
+
+/*
+ * Decode n frames of interleaved samples, one per channel, in the range
+ * -1..1 as floats or as 16 bit integers
+ */
+void multimon_push_float(struct multimon *m, const float *buf, unsigned int n);
+void multimon_push_samples(struct multimon *m, const short *buf, unsigned int n);
+
+/* Decode n complex samples of the band the channels are cut from */
+void multimon_push_iq(struct multimon *m, const float *i, const float *q, unsigned int n);
+
+/* The rate of the samples pushed from now on */
+void multimon_set_input_rate(struct multimon *m, unsigned int rate);
+
+/* Rate the demodulators run at, the highest if they differ */
+unsigned int multimon_samplerate(const struct multimon *m);
+
+/* Channels interleaved in the pushed samples */
+unsigned int multimon_channels(const struct multimon *m);
+
+/* Threads besides the caller's that may call the output callback */
+unsigned int multimon_threads(const struct multimon *m);
+
+/*
+ * With sample_clock, the time of the first sample. If it is not set
+ * before samples are pushed, the time of the first push is used.
+ */
+void multimon_set_start_time(struct multimon *m, const struct timespec *ts);
+
+/*
+ * With profile, what every demodulator instance cost so far: the time
+ * spent in it by the monotonic clock and the samples it was given.
+ * Returns the number of instances, up to max of them are filled in.
+ */
+struct multimon_profile {
+    const char *demod;
+    unsigned int channel;
+    unsigned int samplerate;
+    uint64_t calls;
+    uint64_t samples;
+    uint64_t ns;
+};
+
+unsigned int multimon_profile(const struct multimon *m, struct multimon_profile *out,
+                              unsigned int max);
+
+/*
+ * Decodes what is still buffered and stops the threads. Nothing may be
+ * pushed afterwards; multimon_destroy() does this itself.
+ */
+void multimon_finish(struct multimon *m);
+
+/* Decodes what is still buffered and frees the context */
+void multimon_destroy(struct multimon *m);
+
+/* ---------------------------------------------------------------------- */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIBMULTIMON_H */
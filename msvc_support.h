@@ -4,4 +4,5 @@
 
 #include "win32_getopt.h"
  
-#define strcasecmp(s1, s2) _stricmp(s1, s2)
\ No newline at end of file
+#define strcasecmp(s1, s2) _stricmp(s1, s2)
+#define strncasecmp(s1, s2, n) _strnicmp(s1, s2, n)
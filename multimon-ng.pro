@@ -14,14 +14,30 @@ target.path = $$PREFIX/bin
 INSTALLS += target
 
 HEADERS += \
+    libmultimon.h \
     multimon.h \
     gen.h \
     filter.h \
     filter-i386.h \
-    cJSON.h
+    audiofile.h \
+    resample.h \
+    deinterleave.h \
+    fmdemod.h \
+    channelizer.h \
+    fskcorr.h \
+    goertzel.h
 
 SOURCES += \
     unixinput.c \
+    libmultimon.c \
+    audiofile.c \
+    resample.c \
+    deinterleave.c \
+    fmdemod.c \
+    channelizer.c \
+    filter-simd.c \
+    fskcorr.c \
+    goertzel.c \
     uart.c \
     pocsag.c \
     selcall.c \
@@ -58,7 +74,13 @@ SOURCES += \
     demod_morse.c \
     demod_dumpcsv.c \
     demod_x10.c \
-    cJSON.c
+    jsonout.c
+
+unix{
+DEFINES += HAVE_PTHREAD
+SOURCES += parallel.c outqueue.c
+LIBS += -lpthread
+}
 
 macx{
 DEFINES += DUMMY_AUDIO
@@ -34,7 +34,11 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "cJSON.h"
+#include <stddef.h>
+#include <time.h>
+#include "fskcorr.h"
+#include "goertzel.h"
+#include "libmultimon.h"
 
 #ifdef _MSC_VER
 #include "msvc_support.h"
@@ -48,14 +52,10 @@ extern const float costabf[0x400];
 
 /* ---------------------------------------------------------------------- */
 
-enum
-{
-    POCSAG_MODE_STANDARD = 0,
-    POCSAG_MODE_NUMERIC = 1,
-    POCSAG_MODE_ALPHA = 2,
-    POCSAG_MODE_SKYPER = 3,
-    POCSAG_MODE_AUTO = 4,
-};
+#define DTMF_BATCH_MAX 8192     /* samples per dtmf_demod_channels() call */
+#define DTMF_BATCH_BLOCKS (DTMF_BATCH_MAX/220 + 1)  /* must match BLOCKLEN in demod_dtmf.c */
+
+/* ---------------------------------------------------------------------- */
 
 enum EAS_L2_State
 {
@@ -89,6 +89,17 @@ struct l2_state_fmsfsk {
 
 struct demod_state {
     const struct demod_param *dem_par;
+    const struct multimon_config *cfg; // options of the context running it
+    unsigned int channel; // of the input this instance decodes
+    int fsk_stream; // index of the shared FSK front end feeding it, -1 if none
+    uint64_t block_pos; // stream index of the first sample of the current block
+    uint64_t mark_pos; // stream index where the message printed next began
+    bool marked; // mark_pos is set, see demod_mark()
+    bool mark_printed; // and a line was printed at it
+    long rx_offset; // block offset of the symbol layer 1 handed to layer 2 last
+    uint64_t prof_ns; // with cfg->profile: time spent in demod()
+    uint64_t prof_samples; // and the samples and calls it took
+    uint64_t prof_calls;
     union {
         struct l2_state_fmsfsk fmsfsk;
         struct l2_state_clipfsk clipfsk;
@@ -98,6 +109,8 @@ struct demod_state {
             uint32_t rxstate;
             uint32_t rxbitstream;
             uint32_t rxbitbuf;
+            uint64_t start; // stream index of the start bit of the packet
+            uint64_t char_start; // and of the character being received
         } uart;
         
         struct l2_state_hdlc {
@@ -106,6 +119,7 @@ struct demod_state {
             uint32_t rxstate;
             uint32_t rxbitstream;
             uint32_t rxbitbuf;
+            uint64_t start; // stream index of the opening flag
         } hdlc;
         
         struct l2_state_eas {
@@ -116,6 +130,8 @@ struct demod_state {
             uint32_t msglen;
             uint32_t msgno;
             uint32_t state;
+            uint64_t head_pos; // stream index where the header began
+            uint64_t msg_pos[4]; // and where that of each stored message did
         } eas;
 
         struct l2_state_pocsag {
@@ -136,25 +152,18 @@ struct demod_state {
             uint32_t pocsag_total_bits_received;
             uint32_t pocsag_bits_processed_while_synced;
             uint32_t pocsag_bits_processed_while_not_synced;
+            uint32_t pocsag_words_skipped;
+            const char *trtab[128];     // character set of alphanumeric messages
         } pocsag;
     } l2;
     union {
-        struct l1_state_poc5 {
-            uint32_t dcd_shreg;
-            uint32_t sphase;
-            uint32_t subsamp;
-        } poc5;
-        
-        struct l1_state_poc12 {
+        struct l1_state_pocsag {
             uint32_t dcd_shreg;
             uint32_t sphase;
             uint32_t subsamp;
-        } poc12;
-        
-        struct l1_state_poc24 {
-            uint32_t dcd_shreg;
-            uint32_t sphase;
-        } poc24;
+            int bit_pos;                // block offset of the bit being decoded
+            unsigned int word_span;     // samples from the first to the last bit of a word
+        } pocsag;
         
         struct l1_state_eas {
             unsigned int dcd_shreg;
@@ -164,24 +173,28 @@ struct demod_state {
             unsigned char byte_counter;
             int dcd_integrator;
             uint32_t state;
+            struct fskcorr corr;
         } eas;
         
         struct l1_state_ufsk12 {
             unsigned int dcd_shreg;
             unsigned int sphase;
             unsigned int subsamp;
+            struct fskcorr corr;
         } ufsk12;
         
         struct l1_state_clipfsk {
             unsigned int dcd_shreg;
             unsigned int sphase;
             uint32_t subsamp;
+            struct fskcorr corr;
         } clipfsk;
         
         struct l1_state_fmsfsk {
             unsigned int dcd_shreg;
             unsigned int sphase;
             uint32_t subsamp;
+            struct fskcorr corr;
         } fmsfsk;
         
         struct l1_state_afsk12 {
@@ -189,12 +202,14 @@ struct demod_state {
             uint32_t sphase;
             uint32_t lasts;
             uint32_t subsamp;
+            struct fskcorr corr;
         } afsk12;
         
         struct l1_state_afsk24 {
             unsigned int dcd_shreg;
             unsigned int sphase;
             unsigned int lasts;
+            struct fskcorr corr;
         } afsk24;
         
         struct l1_state_hapn48 {
@@ -210,15 +225,23 @@ struct demod_state {
         } fsk96;
         
         struct l1_state_dtmf {
-            unsigned int ph[8];
+            struct goertzel_bank bank;
             float energy[4];
             float tenergy[4][16];
             int blkcount;
             int lastch;
+            /* the blocks dtmf_demod_channels() filtered, decoded by the next call */
+            int filtered;
+            int nrec;
+            float rec[DTMF_BATCH_BLOCKS][1 + 16];
+            long rec_end[DTMF_BATCH_BLOCKS];
         } dtmf;
         
         struct l1_state_selcall {
-            unsigned int ph[16];
+            struct goertzel_bank bank;  /* this standard's tones, unless shared */
+            unsigned char tone[16];     /* position of each tone in the bank */
+            unsigned int reclen;        /* floats per bank record */
+            int shared;
             float energy[4];
             float tenergy[4][32];
             int blkcount;
@@ -241,6 +264,7 @@ struct demod_state {
             int_fast16_t lowpass_strength;
             int_fast16_t holdoff_samples;
             int_fast8_t current_state;  // High = 1, Low = 0
+            uint64_t char_start; // stream index of the first element of the character
         } morse;
         
         struct l1_state_dumpcsv {
@@ -258,6 +282,7 @@ struct demod_state {
             char b[4];
             char bi;
             char bstring[42];
+            uint64_t start; // stream index of the preamble
         } x10;
 
 #ifndef NO_X11
@@ -274,6 +299,9 @@ typedef struct buffer
 {
     const short* sbuffer;
     const float* fbuffer;
+    const float* fskbuffer; // shared FSK front end output, length values per stream
+    const float* selcallbuffer; // shared selcall tone bank records
+    uint64_t pos; // stream index of the first sample, at the demodulators' rate
 } buffer_t;
 
 struct demod_param {
@@ -284,8 +312,52 @@ struct demod_param {
     void (*init)(struct demod_state *s);
     void (*demod)(struct demod_state *s, buffer_t buffer, int length);
     void (*deinit)(struct demod_state *s);
+    const struct fskcorr_front *fsk_front; // FSK front end it can share with others
+    const unsigned int *selcall_freq; // tones of a selcall standard, sharable as well
 };
 
+/*
+ * Mark minus space power for every window this demodulator evaluates in
+ * the block, if its front end is computed once for several demodulators.
+ * NULL means the demodulator correlates by itself.
+ */
+static inline const float *fsk_shared(const struct demod_state *s, buffer_t buffer, int length)
+{
+    return s->fsk_stream < 0 ? NULL : buffer.fskbuffer + (size_t)s->fsk_stream * length;
+}
+
+/*
+ * With --sample-clock, time stamps are taken from the position in the
+ * sample stream. Every demodulator marks where a message began before
+ * printing it, offset samples into the current block (negative if it
+ * began in an earlier block), or at a stream index it noted earlier with
+ * demod_pos(); without a mark the start of the block is used. A mark
+ * holds for every line the demodulator prints until it returns, and is
+ * dropped then unless it was set again after the last of them.
+ */
+static inline uint64_t demod_pos(const struct demod_state *s, long offset)
+{
+    return offset < 0 && (uint64_t)-offset > s->block_pos ? 0 : s->block_pos + offset;
+}
+
+static inline void demod_mark_at(struct demod_state *s, uint64_t pos)
+{
+    s->mark_pos = pos;
+    s->marked = true;
+    s->mark_printed = false;
+}
+
+static inline void demod_mark(struct demod_state *s, long offset)
+{
+    demod_mark_at(s, demod_pos(s, offset));
+}
+
+/* Stream index of the symbol layer 2 is working on, see rx_offset */
+static inline uint64_t demod_rx_pos(const struct demod_state *s)
+{
+    return demod_pos(s, s->rx_offset);
+}
+
 /* ---------------------------------------------------------------------- */
 
 extern const struct demod_param demod_poc5;
@@ -369,21 +441,111 @@ void clip_rxbit(struct demod_state *s, int bit);
 void fms_init(struct demod_state *s);
 void fms_rxbit(struct demod_state *s, int bit);
 
+/* Bit clock of a POCSAG demodulator (see pocsag_demod()) */
+struct pocsag_clock {
+    unsigned int subsamp;       /* slice every subsamp'th sample */
+    unsigned int sphaseinc;     /* bit clock phase per slice, 0x10000 is one bit */
+};
+
 void pocsag_init(struct demod_state *s);
 void pocsag_rxbit(struct demod_state *s, int32_t bit);
+void pocsag_demod(struct demod_state *s, const struct pocsag_clock *clk,
+                  const float *buf, int length);
 void pocsag_deinit(struct demod_state *s);
+/* Fills trtab for the named character set, only checks the name if trtab is NULL */
+bool pocsag_init_charset(const char *charset, const char **trtab);
 
 void selcall_init(struct demod_state *s);
-void selcall_demod(struct demod_state *s, const float *buffer, int length,
-                   const unsigned int *selcall_freq, const char *const name);
+void selcall_demod(struct demod_state *s, buffer_t buffer, int length);
 void selcall_deinit(struct demod_state *s);
+void selcall_bank_init(struct goertzel_bank *b);
+void selcall_bank_add(struct goertzel_bank *b, const unsigned int *freq);
+void selcall_share(struct demod_state *s, const struct goertzel_bank *b);
+
+/*
+ * Filter nch DTMF channels of length samples each in one call, s[c] being
+ * the state of channel c. Each channel's tones are decoded, and printed,
+ * by the next call of its demodulator, which must be given the same
+ * samples. Blocks longer than DTMF_BATCH_MAX are left to the demodulator.
+ */
+void dtmf_demod_channels(struct demod_state *const *s, const float *const *buf,
+                         unsigned int nch, int length);
+
+#ifdef HAVE_PTHREAD
+typedef void (*parallel_fn)(void *arg, unsigned int worker, buffer_t buffer, int length);
+struct parallel;
+struct parallel *parallel_start(unsigned int nworkers, unsigned int first_worker,
+                                unsigned int overlap, parallel_fn run, void *run_arg);
+void parallel_push(struct parallel *par, buffer_t buffer, unsigned int len,
+                   const float *side, unsigned int sidelen);
+void parallel_stop(struct parallel *par);
+int parallel_worker(void);
+
+/*
+ * Fork-join pool of nthreads, the caller counting as worker 0: pool_run()
+ * runs tasks 0 .. ntasks-1 on them and returns when all are done. The
+ * threads have parallel_worker() ids from first_worker on.
+ */
+typedef void (*pool_fn)(void *arg, unsigned int worker, unsigned int task);
+struct pool;
+struct pool *pool_start(unsigned int nthreads, unsigned int first_worker,
+                        pool_fn run, void *run_arg);
+void pool_run(struct pool *p, unsigned int ntasks);
+void pool_stop(struct pool *p);
+
+/*
+ * Output queue: the main thread and up to nworkers parallel workers hand
+ * complete lines to outq_write(), a writer thread writes them to stdout
+ * at most latency_ms later. outq_stop() writes what is left and returns
+ * the number of lines dropped because the queue was full.
+ */
+int outq_start(unsigned int nworkers, unsigned int latency_ms);
+bool outq_running(void);
+void outq_write(const char *buf, size_t len);
+unsigned long outq_stop(void);
+#endif
+
+/*
+ * For the command line: process len new samples of a channel at the input
+ * rate, the float buffer extending overlap samples beyond them. Floats are
+ * only filled in if multimon_float_input() says so, which may change with
+ * the input rate.
+ */
+void multimon_process(struct multimon *m, unsigned int channel,
+                      float *float_buf, short *short_buf, unsigned int len);
+unsigned int multimon_overlap(const struct multimon *m);
+bool multimon_float_input(const struct multimon *m);
+
+/*
+ * For the benchmarks: run fn on the state of instance inst (numbered
+ * channel by channel, in the order of the demodulator table) as the
+ * context would run it, what it prints going to the context's output.
+ */
+void multimon_call(struct multimon *m, unsigned int inst,
+                   void (*fn)(struct demod_state *s, void *arg), void *arg);
 
 void xdisp_terminate(int cnum);
 int xdisp_start(void);
 int xdisp_update(int cnum, float *f);
 
-void print_json(int argc, char **argv);
-void addJsonTimestamp(cJSON *json_output);
+/* When the message being printed was received, by the clock time stamps use */
+time_t output_time(void);
+
+/* Hand a complete output record to the context's output in one piece */
+void output_write(const char *buf, size_t len);
+
+/*
+ * --json output: json_begin() starts a record, the json_add functions
+ * append fields in order and json_end() writes the record as one line.
+ */
+void json_begin(void);
+void json_add_string(const char *key, const char *value);
+void json_add_int(const char *key, int64_t value);
+void json_add_null(const char *key);
+void json_add_timestamp(void);
+/* "channel", added by json_end() when the input has several */
+void json_add_channel(void);
+void json_end(void);
 
 /* ---------------------------------------------------------------------- */
 #endif /* _MULTIMON_H */
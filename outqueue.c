@@ -0,0 +1,283 @@
+/*
+ *      outqueue.c -- write decoder output from a separate thread
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Every producer (the main thread and each --parallel worker) has a byte
+ * ring of its own that it fills with complete lines, so the queue needs
+ * no lock: the producer only moves the head, the writer thread only the
+ * tail. The writer sleeps for at most the latency bound, then hands all
+ * pending text of all rings to writev(), one call unless there are more
+ * busy rings than a call takes. A producer never waits for stdout: text
+ * that does not fit into its ring is dropped and counted. A ring filling
+ * up, or a latency bound of 0, wakes the writer early.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "multimon.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define OUTQ_RING   (1u << 16)      /* bytes per producer, a power of two */
+#define OUTQ_IOV    64
+
+struct ring {
+    _Atomic size_t head;            /* written by the producer */
+    _Atomic size_t tail;            /* written by the writer thread */
+    char buf[OUTQ_RING];
+};
+
+struct outq {
+    struct ring **ring;             /* [0] is the main thread's, [1 + w] worker w's */
+    unsigned int nrings;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    unsigned int latency_ms;
+    _Atomic bool kick;              /* a producer wants the writer now */
+    _Atomic bool sleeping;          /* the writer waits on wake */
+    _Atomic bool stop;
+    _Atomic unsigned long dropped;
+    bool started;
+    bool broken;                    /* stdout is gone, discard everything */
+};
+
+static struct outq *q;
+
+/* ---------------------------------------------------------------------- */
+
+static void wake_writer(void)
+{
+    atomic_store(&q->kick, true);
+    if (atomic_load(&q->sleeping)) {
+        /* the writer holds the lock until it waits, so this cannot be lost */
+        pthread_mutex_lock(&q->lock);
+        pthread_cond_signal(&q->wake);
+        pthread_mutex_unlock(&q->lock);
+    }
+}
+
+static void sleep_writer(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += q->latency_ms / 1000;
+    ts.tv_nsec += (q->latency_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    atomic_store(&q->sleeping, true);
+    /* with a bound of 0 every line kicks the writer, so it need not time out */
+    while (!atomic_load(&q->kick) && !atomic_load(&q->stop)) {
+        if (!q->latency_ms)
+            pthread_cond_wait(&q->wake, &q->lock);
+        else if (pthread_cond_timedwait(&q->wake, &q->lock, &ts) == ETIMEDOUT)
+            break;
+    }
+    atomic_store(&q->sleeping, false);
+    atomic_store(&q->kick, false);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/*
+ * Write what is pending in the rings from *r on, as many as fit into one
+ * writev(); *r is left at the first ring not taken. Returns the number
+ * of bytes taken.
+ */
+static size_t drain_some(unsigned int *r)
+{
+    struct iovec iov[OUTQ_IOV];
+    struct ring *owner[OUTQ_IOV];
+    unsigned int n = 0;
+    size_t total = 0;
+
+    for (; *r < q->nrings && n + 2 <= OUTQ_IOV; (*r)++) {
+        struct ring *rg = q->ring[*r];
+        size_t head = atomic_load_explicit(&rg->head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&rg->tail, memory_order_relaxed);
+        size_t off = tail & (OUTQ_RING - 1);
+        size_t len = head - tail;
+
+        if (!len)
+            continue;
+        /* the pending text wraps around the end of the ring at most once */
+        size_t first = len < OUTQ_RING - off ? len : OUTQ_RING - off;
+        iov[n].iov_base = rg->buf + off;
+        iov[n].iov_len = first;
+        owner[n++] = rg;
+        if (first < len) {
+            iov[n].iov_base = rg->buf;
+            iov[n].iov_len = len - first;
+            owner[n++] = rg;
+        }
+        total += len;
+    }
+    if (!n)
+        return 0;
+
+    ssize_t done = total;
+    if (!q->broken) {
+        do
+            done = writev(STDOUT_FILENO, iov, n);
+        while (done < 0 && errno == EINTR);
+        if (done < 0) {
+            perror("writev");
+            q->broken = true;
+            done = total;
+        }
+    }
+
+    /* a short write leaves the rest for the next round */
+    for (unsigned int i = 0; i < n && done > 0; i++) {
+        size_t part = (size_t)done < iov[i].iov_len ? (size_t)done : iov[i].iov_len;
+        atomic_fetch_add_explicit(&owner[i]->tail, part, memory_order_release);
+        done -= part;
+    }
+    return total;
+}
+
+/*
+ * Write what is pending in all rings, returns the number of bytes taken.
+ * With more busy rings than one writev() takes, it writes several times,
+ * so that every ring gets its turn in every round.
+ */
+static size_t drain(void)
+{
+    unsigned int r = 0;
+    size_t total = 0;
+
+    while (r < q->nrings)
+        total += drain_some(&r);
+    return total;
+}
+
+static void *writer_main(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        /* once stopped, write until the rings are empty */
+        bool stop = atomic_load(&q->stop);
+        size_t written = drain();
+        if (stop && !written)
+            break;
+        if (!stop)
+            sleep_writer();
+    }
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int outq_start(unsigned int nworkers, unsigned int latency_ms)
+{
+    fflush(stdout);
+    if (!(q = calloc(1, sizeof(*q))) ||
+        !(q->ring = calloc(nworkers + 1, sizeof(q->ring[0])))) {
+        perror("calloc");
+        free(q);
+        q = NULL;
+        return -1;
+    }
+    q->latency_ms = latency_ms;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->wake, NULL);
+    for (q->nrings = 0; q->nrings < nworkers + 1; q->nrings++) {
+        if (!(q->ring[q->nrings] = calloc(1, sizeof(*q->ring[0])))) {
+            perror("calloc");
+            outq_stop();
+            return -1;
+        }
+    }
+    if (pthread_create(&q->thread, NULL, writer_main, NULL)) {
+        fprintf(stderr, "outqueue: could not start the writer thread\n");
+        outq_stop();
+        return -1;
+    }
+    q->started = true;
+    return 0;
+}
+
+bool outq_running(void)
+{
+    return q != NULL;
+}
+
+void outq_write(const char *buf, size_t len)
+{
+    struct ring *rg = q->ring[parallel_worker() + 1];
+    size_t head = atomic_load_explicit(&rg->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&rg->tail, memory_order_acquire);
+
+    if (len > OUTQ_RING - (head - tail)) {
+        unsigned long lines = 0;
+        for (const char *p = buf; (p = memchr(p, '\n', buf + len - p)); p++)
+            lines++;
+        atomic_fetch_add_explicit(&q->dropped, lines ? lines : 1, memory_order_relaxed);
+        wake_writer();
+        return;
+    }
+
+    size_t off = head & (OUTQ_RING - 1);
+    size_t first = len < OUTQ_RING - off ? len : OUTQ_RING - off;
+    memcpy(rg->buf + off, buf, first);
+    memcpy(rg->buf, buf + first, len - first);
+    atomic_store_explicit(&rg->head, head + len, memory_order_release);
+
+    if (!q->latency_ms || head + len - tail > OUTQ_RING / 2)
+        wake_writer();
+}
+
+unsigned long outq_stop(void)
+{
+    unsigned long dropped;
+
+    if (!q)
+        return 0;
+    if (q->started) {
+        atomic_store(&q->stop, true);
+        wake_writer();
+        pthread_join(q->thread, NULL);
+    }
+    dropped = atomic_load(&q->dropped);
+    for (unsigned int r = 0; r < q->nrings; r++)
+        free(q->ring[r]);
+    free(q->ring);
+    pthread_cond_destroy(&q->wake);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+    q = NULL;
+    return dropped;
+}
+
+/* ---------------------------------------------------------------------- */
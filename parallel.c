@@ -0,0 +1,375 @@
+/*
+ *      parallel.c -- run demodulators on worker threads
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * The reader thread publishes every sample block into a broadcast ring.
+ * Each worker owns one demodulator and walks the ring with its own read
+ * index, so blocks are seen by every worker in input order and nothing
+ * is ever copied per worker. A slot is only reused once the slowest
+ * worker has released it; until then the reader blocks, which is what
+ * keeps a slow decoder from losing samples. Every stream (one per
+ * demodulator sampling rate) gets a ring of its own.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "multimon.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define PARALLEL_SLOTS 8
+
+struct slot {
+    float *fbuf;
+    short *sbuf;
+    float *side;                /* shared front end output */
+    unsigned int fcap;
+    unsigned int scap;
+    unsigned int sidecap;
+    unsigned int len;
+    buffer_t buffer;
+};
+
+struct parallel {
+    pthread_mutex_t lock;
+    pthread_cond_t filled;      /* reader published a slot */
+    pthread_cond_t released;    /* a worker is done with a slot */
+    struct slot slot[PARALLEL_SLOTS];
+    unsigned long head;         /* sequence number of the next slot to fill */
+    unsigned long *tail;        /* per worker: next sequence number to consume */
+    pthread_t *thread;
+    unsigned int nworkers;
+    unsigned int first_worker;  /* id of worker 0 as seen by the callback */
+    unsigned int overlap;
+    int done;
+    parallel_fn run;
+    void *arg;                  /* first argument of run */
+};
+
+struct worker_arg {
+    struct parallel *par;
+    unsigned int w;
+};
+
+static _Thread_local int worker_id = -1;
+
+/* ---------------------------------------------------------------------- */
+
+static unsigned long slowest_tail(struct parallel *par)
+{
+    unsigned long min = par->head;
+
+    for (unsigned int w = 0; w < par->nworkers; w++)
+        if (par->tail[w] < min)
+            min = par->tail[w];
+    return min;
+}
+
+static void *worker_main(void *arg)
+{
+    struct parallel *par = ((struct worker_arg *)arg)->par;
+    unsigned int w = ((struct worker_arg *)arg)->w;
+
+    free(arg);
+    worker_id = par->first_worker + w;
+    pthread_mutex_lock(&par->lock);
+    for (;;) {
+        while (par->tail[w] == par->head && !par->done)
+            pthread_cond_wait(&par->filled, &par->lock);
+        if (par->tail[w] == par->head)
+            break;
+        struct slot *sl = &par->slot[par->tail[w] % PARALLEL_SLOTS];
+        pthread_mutex_unlock(&par->lock);
+
+        /* the slot is read-only until every worker has moved past it */
+        par->run(par->arg, worker_id, sl->buffer, sl->len);
+
+        pthread_mutex_lock(&par->lock);
+        par->tail[w]++;
+        pthread_cond_signal(&par->released);
+    }
+    pthread_mutex_unlock(&par->lock);
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int parallel_worker(void)
+{
+    return worker_id;
+}
+
+struct parallel *parallel_start(unsigned int nworkers, unsigned int first_worker,
+                                unsigned int overlap, parallel_fn run, void *run_arg)
+{
+    struct parallel *par = calloc(1, sizeof(*par));
+
+    if (!par) {
+        perror("calloc");
+        return NULL;
+    }
+    par->first_worker = first_worker;
+    par->overlap = overlap;
+    par->run = run;
+    par->arg = run_arg;
+    par->tail = calloc(nworkers, sizeof(par->tail[0]));
+    par->thread = calloc(nworkers, sizeof(par->thread[0]));
+    if (!par->tail || !par->thread) {
+        perror("calloc");
+        free(par->tail);
+        free(par->thread);
+        free(par);
+        return NULL;
+    }
+    pthread_mutex_init(&par->lock, NULL);
+    pthread_cond_init(&par->filled, NULL);
+    pthread_cond_init(&par->released, NULL);
+
+    for (unsigned int w = 0; w < nworkers; w++) {
+        struct worker_arg *arg = malloc(sizeof(*arg));
+        if (arg) {
+            arg->par = par;
+            arg->w = w;
+        }
+        if (!arg || pthread_create(&par->thread[w], NULL, worker_main, arg)) {
+            fprintf(stderr, "parallel: could not start worker thread %u\n", first_worker + w);
+            free(arg);
+            parallel_stop(par);
+            return NULL;
+        }
+        par->nworkers = w + 1;
+    }
+    return par;
+}
+
+/* side holds the output of shared front ends, buffer points into it */
+static const float *rebase(const float *p, const float *from, const float *to)
+{
+    return p ? to + (p - from) : NULL;
+}
+
+void parallel_push(struct parallel *par, buffer_t buffer, unsigned int len,
+                   const float *side, unsigned int sidelen)
+{
+    unsigned int flen = len + par->overlap;
+
+    pthread_mutex_lock(&par->lock);
+    while (par->head - slowest_tail(par) >= PARALLEL_SLOTS)
+        pthread_cond_wait(&par->released, &par->lock);
+    pthread_mutex_unlock(&par->lock);
+
+    /* nobody references this slot any more, so it can be refilled unlocked */
+    struct slot *sl = &par->slot[par->head % PARALLEL_SLOTS];
+    if (sl->fcap < flen) {
+        free(sl->fbuf);
+        sl->fbuf = malloc(flen * sizeof(sl->fbuf[0]));
+        sl->fcap = flen;
+    }
+    if (sl->scap < len) {
+        free(sl->sbuf);
+        sl->sbuf = malloc(len * sizeof(sl->sbuf[0]));
+        sl->scap = len;
+    }
+    if (sl->sidecap < sidelen) {
+        free(sl->side);
+        sl->side = malloc(sidelen * sizeof(sl->side[0]));
+        sl->sidecap = sidelen;
+    }
+    if (!sl->fbuf || !sl->sbuf || (sidelen && !sl->side)) {
+        perror("malloc");
+        exit(10);
+    }
+    if (buffer.fbuffer)
+        memcpy(sl->fbuf, buffer.fbuffer, flen * sizeof(sl->fbuf[0]));
+    memcpy(sl->sbuf, buffer.sbuffer, len * sizeof(sl->sbuf[0]));
+    if (sidelen)
+        memcpy(sl->side, side, sidelen * sizeof(sl->side[0]));
+    sl->buffer.sbuffer = sl->sbuf;
+    sl->buffer.fbuffer = sl->fbuf;
+    sl->buffer.fskbuffer = rebase(buffer.fskbuffer, side, sl->side);
+    sl->buffer.selcallbuffer = rebase(buffer.selcallbuffer, side, sl->side);
+    sl->buffer.pos = buffer.pos;
+    sl->len = len;
+
+    pthread_mutex_lock(&par->lock);
+    par->head++;
+    pthread_cond_broadcast(&par->filled);
+    pthread_mutex_unlock(&par->lock);
+}
+
+void parallel_stop(struct parallel *par)
+{
+    pthread_mutex_lock(&par->lock);
+    par->done = 1;
+    pthread_cond_broadcast(&par->filled);
+    pthread_mutex_unlock(&par->lock);
+
+    for (unsigned int w = 0; w < par->nworkers; w++)
+        pthread_join(par->thread[w], NULL);
+
+    for (unsigned int i = 0; i < PARALLEL_SLOTS; i++) {
+        free(par->slot[i].fbuf);
+        free(par->slot[i].sbuf);
+        free(par->slot[i].side);
+    }
+    free(par->tail);
+    free(par->thread);
+    pthread_cond_destroy(&par->released);
+    pthread_cond_destroy(&par->filled);
+    pthread_mutex_destroy(&par->lock);
+    free(par);
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * The channel pool works the other way round: every call of pool_run()
+ * is one batch of independent tasks, one per channel, that the pool
+ * threads and the caller take from a shared counter. The caller returns
+ * once all of them are done, so between batches the data is its own.
+ */
+struct pool {
+    pthread_mutex_t lock;
+    pthread_cond_t start;       /* a batch was posted */
+    pthread_cond_t finished;    /* the last task of a batch is done */
+    pthread_t *thread;
+    unsigned int nthreads;
+    unsigned int first_worker;
+    unsigned long batch;        /* sequence number of the current batch */
+    unsigned int ntasks;
+    unsigned int next;          /* next task to hand out */
+    unsigned int pending;       /* tasks of the batch not finished yet */
+    int done;
+    pool_fn run;
+    void *arg;
+};
+
+struct pool_arg {
+    struct pool *pool;
+    unsigned int w;
+};
+
+/* take tasks until the batch is used up, with the lock held */
+static void pool_work(struct pool *p, unsigned int w)
+{
+    while (p->next < p->ntasks) {
+        unsigned int task = p->next++;
+
+        pthread_mutex_unlock(&p->lock);
+        p->run(p->arg, w, task);
+        pthread_mutex_lock(&p->lock);
+        if (!--p->pending)
+            pthread_cond_signal(&p->finished);
+    }
+}
+
+static void *pool_main(void *arg)
+{
+    struct pool *p = ((struct pool_arg *)arg)->pool;
+    unsigned int w = ((struct pool_arg *)arg)->w;
+    unsigned long seen = 0;
+
+    free(arg);
+    worker_id = p->first_worker + w - 1;
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (p->batch == seen && !p->done)
+            pthread_cond_wait(&p->start, &p->lock);
+        if (p->done)
+            break;
+        seen = p->batch;
+        pool_work(p, w);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+struct pool *pool_start(unsigned int nthreads, unsigned int first_worker,
+                        pool_fn run, void *run_arg)
+{
+    struct pool *p = calloc(1, sizeof(*p));
+
+    if (!p || !(p->thread = calloc(nthreads, sizeof(p->thread[0])))) {
+        perror("calloc");
+        free(p);
+        return NULL;
+    }
+    p->first_worker = first_worker;
+    p->run = run;
+    p->arg = run_arg;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->start, NULL);
+    pthread_cond_init(&p->finished, NULL);
+
+    /* worker 0 is the caller */
+    for (unsigned int w = 1; w < nthreads; w++) {
+        struct pool_arg *arg = malloc(sizeof(*arg));
+        if (arg) {
+            arg->pool = p;
+            arg->w = w;
+        }
+        if (!arg || pthread_create(&p->thread[w], NULL, pool_main, arg)) {
+            fprintf(stderr, "parallel: could not start pool thread %u\n", first_worker + w - 1);
+            free(arg);
+            pool_stop(p);
+            return NULL;
+        }
+        p->nthreads = w + 1;
+    }
+    return p;
+}
+
+void pool_run(struct pool *p, unsigned int ntasks)
+{
+    pthread_mutex_lock(&p->lock);
+    p->ntasks = ntasks;
+    p->next = 0;
+    p->pending = ntasks;
+    p->batch++;
+    pthread_cond_broadcast(&p->start);
+    pool_work(p, 0);
+    while (p->pending)
+        pthread_cond_wait(&p->finished, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+}
+
+void pool_stop(struct pool *p)
+{
+    pthread_mutex_lock(&p->lock);
+    p->done = 1;
+    pthread_cond_broadcast(&p->start);
+    pthread_mutex_unlock(&p->lock);
+
+    for (unsigned int w = 1; w < p->nthreads; w++)
+        pthread_join(p->thread[w], NULL);
+    free(p->thread);
+    pthread_cond_destroy(&p->finished);
+    pthread_cond_destroy(&p->start);
+    pthread_mutex_destroy(&p->lock);
+    free(p);
+}
+
+/* ---------------------------------------------------------------------- */
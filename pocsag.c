@@ -40,7 +40,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include "cJSON.h"
 
 /* ---------------------------------------------------------------------- */
 
@@ -68,16 +67,6 @@
 #define POSCAG
 /* ---------------------------------------------------------------------- */
 
-int pocsag_mode = POCSAG_MODE_STANDARD;
-int pocsag_invert_input = 0;
-int pocsag_error_correction = 2;
-int pocsag_show_partial_decodes = 0;
-int pocsag_heuristic_pruning = 0;
-int pocsag_prune_empty = 0;
-int pocsag_polarity = 0;  /* 0=auto, 1=normal only, 2=inverted only */
-
-extern int json_mode;
-
 /* ---------------------------------------------------------------------- */
 
 
@@ -105,7 +94,7 @@ static inline unsigned char even_parity(uint32_t data)
 
 /* ---------------------------------------------------------------------- */
 	// ISO 646 national variant: US / IRV (1991)
-    char *trtab[128] = {
+static const char *const us_trtab[128] = {
 			"<NUL>", 	//  0x0
 			"<SOH>", 	//  0x1
 			"<STX>", 	//  0x2
@@ -267,8 +256,13 @@ static inline unsigned char even_parity(uint32_t data)
 			"~", 		// 0x7e
 */
 
-bool pocsag_init_charset(char *charset)
+bool pocsag_init_charset(const char *charset, const char **trtab)
 {
+	const char *scratch[128];
+
+	if (!trtab)
+		trtab = scratch;
+	memcpy(trtab, us_trtab, sizeof(us_trtab));
 	if(strcmp(charset,"DE")==0) // German charset
 	{
 		#ifdef CHARSET_UTF8
@@ -416,9 +410,9 @@ bool pocsag_init_charset(char *charset)
 	return true;
 }
 
-static char *translate_alpha(unsigned char chr)
+static const char *translate_alpha(const struct l2_state_pocsag *rx, unsigned char chr)
 {
-	return trtab[chr & 0x7f];
+	return rx->trtab[chr & 0x7f];
 }
 
 /* ---------------------------------------------------------------------- */
@@ -449,26 +443,34 @@ static int guesstimate_numeric(const unsigned char cp, int pos)
         return 0;
 }
 
-static int print_msg_numeric(struct l2_state_pocsag *rx, char* buff, unsigned int size)
+static const char numeric_table[16] = "084 2.6]195-3U7[";
+
+static unsigned int numeric_len(const struct l2_state_pocsag *rx, unsigned int size)
 {
-    static const char *conv_table = "084 2.6]195-3U7[";
-    unsigned char *bp = rx->buffer;
-    int len = rx->numnibbles;
-    char* cp = buff;
-    int guesstimate = 0;
+    return rx->numnibbles < size ? rx->numnibbles : size - 1;
+}
 
-    if ( (unsigned int) len >= size)
-        len = size-1;
-    for (; len > 0; bp++, len -= 2) {
-        *cp++ = conv_table[(*bp >> 4) & 0xf];
-        if (len > 1)
-            *cp++ = conv_table[*bp & 0xf];
-    }
-    *cp = '\0';
+static unsigned char get_nibble(const struct l2_state_pocsag *rx, unsigned int n)
+{
+    return (rx->buffer[n / 2] >> ((n & 1) ? 0 : 4)) & 0xf;
+}
+
+static void print_msg_numeric(const struct l2_state_pocsag *rx, char* buff, unsigned int size)
+{
+    unsigned int len = numeric_len(rx, size);
 
-    cp = buff;
-    for(int i = 0; *(cp+i); i++)
-        guesstimate += guesstimate_numeric(*(cp+i), i);
+    for (unsigned int i = 0; i < len; i++)
+        buff[i] = numeric_table[get_nibble(rx, i)];
+    buff[len] = '\0';
+}
+
+static int score_numeric(const struct l2_state_pocsag *rx, unsigned int size)
+{
+    unsigned int len = numeric_len(rx, size);
+    int guesstimate = 0;
+
+    for (unsigned int i = 0; i < len; i++)
+        guesstimate += guesstimate_numeric(numeric_table[get_nibble(rx, i)], i);
     return guesstimate;
 }
 
@@ -487,22 +489,19 @@ static unsigned char rev7(unsigned char b)
            ((b << 0) & 8);
 }
 
-static int print_msg_alpha(struct l2_state_pocsag *rx, char* buff, unsigned int size, int caesar)
+static void print_msg_alpha(const struct l2_state_pocsag *rx, char* buff, unsigned int size, int caesar)
 {
     int len = rx->numnibbles * 4 / 7;
     char* cp = buff;
     int buffree = size-1;
     unsigned char curchr;
-    char *tstr;
-    int guesstimate = 0;
+    const char *tstr;
 
-    for (int i = 0; i < len; i++)
+    for (int i = 0; i < len && buffree > 0; i++)
     {
         curchr = rev7(get7(rx->buffer, i)) - caesar;
 
-        guesstimate += guesstimate_alpha(curchr);
-
-        tstr = translate_alpha(curchr);
+        tstr = translate_alpha(rx, curchr);
         if (tstr)
         {
             int tlen = strlen(tstr);
@@ -512,181 +511,132 @@ static int print_msg_alpha(struct l2_state_pocsag *rx, char* buff, unsigned int
                 cp += tlen;
                 buffree -= tlen;
             }
-        } else if (buffree > 0) {
+        } else {
             *cp++ = curchr;
             buffree--;
         }
     }
     *cp = '\0';
+}
 
-    return guesstimate;
+/* both alphanumeric readings in one pass, they only differ in the caesar shift */
+static void score_alpha(const struct l2_state_pocsag *rx, int *alpha, int *skyper)
+{
+    int len = rx->numnibbles * 4 / 7;
+
+    *alpha = *skyper = 0;
+    for (int i = 0; i < len; i++)
+    {
+        unsigned char curchr = rev7(get7(rx->buffer, i));
+
+        *alpha += guesstimate_alpha(curchr - CAESAR_ALPHA);
+        *skyper += guesstimate_alpha(curchr - CAESAR_SKYPER);
+    }
 }
 
 /* ---------------------------------------------------------------------- */
 
+static void pocsag_printline(struct demod_state *s, bool sync, const char *label,
+                             const char *key, const char *text, int guess)
+{
+    if (s->cfg->json) {
+        json_begin();
+        json_add_string("demod_name", s->dem_par->name);
+        if((s->l2.pocsag.address != -2) || (s->l2.pocsag.function != -2)) {
+            json_add_int("address", s->l2.pocsag.address);
+            json_add_int("function", s->l2.pocsag.function);
+        } else {
+            json_add_null("address");
+            json_add_null("function");
+        }
+        if(s->cfg->pocsag_mode == POCSAG_MODE_AUTO)
+            verbprintf(3, "Certainty: %5i  ", guess);
+        json_add_string(key, text);
+        json_add_timestamp();
+        json_end();
+        return;
+    }
+
+    if((s->l2.pocsag.address != -2) || (s->l2.pocsag.function != -2))
+        verbprintf(0, "%s: Address: %7lu  Function: %1hhi  ",s->dem_par->name,
+                   s->l2.pocsag.address, s->l2.pocsag.function);
+    else
+        verbprintf(0, "%s: Address:       -  Function: -  ",s->dem_par->name);
+    if(s->cfg->pocsag_mode == POCSAG_MODE_AUTO)
+        verbprintf(3, "Certainty: %5i  ", guess);
+    verbprintf(0, "%s%s", label, text);
+    if(!sync) verbprintf(2,"<LOST SYNC>");
+    verbprintf(0,"\n");
+}
+
 static void pocsag_printmessage(struct demod_state *s, bool sync)
 {
-    if(!pocsag_show_partial_decodes && ((s->l2.pocsag.address == -2) || (s->l2.pocsag.function == -2) || !sync))
+    if(!s->cfg->pocsag_show_partial && ((s->l2.pocsag.address == -2) || (s->l2.pocsag.function == -2) || !sync))
         return; // Hide partial decodes
-    if(pocsag_prune_empty && (s->l2.pocsag.numnibbles == 0))
+    if(s->cfg->pocsag_prune_empty && (s->l2.pocsag.numnibbles == 0))
         return;
 
-    cJSON *json_output = cJSON_CreateObject();
-
     if((s->l2.pocsag.address != -1) || (s->l2.pocsag.function != -1))
     {
         if(s->l2.pocsag.numnibbles == 0)
         {
-            if (!json_mode) {
+            if (!s->cfg->json) {
                 verbprintf(0, "%s: Address: %7lu  Function: %1hhi ",s->dem_par->name,
                            s->l2.pocsag.address, s->l2.pocsag.function);
                 if(!sync) verbprintf(2,"<LOST SYNC>");
                 verbprintf(0,"\n");
             }
             else {
-                cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-                cJSON_AddNumberToObject(json_output, "address", s->l2.pocsag.address);
-                cJSON_AddNumberToObject(json_output, "function", s->l2.pocsag.function);
-                addJsonTimestamp(json_output);
-                fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
-                cJSON_Delete(json_output);
+                json_begin();
+                json_add_string("demod_name", s->dem_par->name);
+                json_add_int("address", s->l2.pocsag.address);
+                json_add_int("function", s->l2.pocsag.function);
+                json_add_timestamp();
+                json_end();
             }
         }
         else
         {
-            char num_string[1024];
-            char alpha_string[1024];
-            char skyper_string[1024];
+            /* only one string is rendered per reading that is printed */
+            char string[1024];
             int guess_num = 0;
             int guess_alpha = 0;
             int guess_skyper = 0;
             int unsure = 0;
             int func = 0;
 
-            guess_num = print_msg_numeric(&s->l2.pocsag, num_string, sizeof(num_string));
-            guess_alpha = print_msg_alpha(&s->l2.pocsag, alpha_string, sizeof(alpha_string), CAESAR_ALPHA);
-            guess_skyper = print_msg_alpha(&s->l2.pocsag, skyper_string, sizeof(skyper_string), CAESAR_SKYPER);
-
             func = s->l2.pocsag.function;
 
-            if(guess_num < 20 && guess_alpha < 20 && guess_skyper < 20)
+            /* the scores are only needed to choose a reading or to prune */
+            if(s->cfg->pocsag_mode == POCSAG_MODE_AUTO || s->cfg->pocsag_heuristic_pruning)
             {
-                if(pocsag_heuristic_pruning)
-                    return;
-                unsure = 1;
-            }
+                guess_num = score_numeric(&s->l2.pocsag, sizeof(string));
+                score_alpha(&s->l2.pocsag, &guess_alpha, &guess_skyper);
 
-            if((pocsag_mode == POCSAG_MODE_NUMERIC) || ((pocsag_mode == POCSAG_MODE_STANDARD) && (func == 0)) || ((pocsag_mode == POCSAG_MODE_AUTO) && (guess_num >= 20 || unsure)))
-            {
-                if((s->l2.pocsag.address != -2) || (s->l2.pocsag.function != -2))
+                if(guess_num < 20 && guess_alpha < 20 && guess_skyper < 20)
                 {
-                    if (!json_mode)
-                        verbprintf(0, "%s: Address: %7lu  Function: %1hhi  ",s->dem_par->name,
-                               s->l2.pocsag.address, s->l2.pocsag.function);
-                    else {
-                        cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-                        cJSON_AddNumberToObject(json_output, "address", s->l2.pocsag.address);
-                        cJSON_AddNumberToObject(json_output, "function", s->l2.pocsag.function);
-                    }
-                }
-                else
-                {
-                    if (!json_mode)
-                        verbprintf(0, "%s: Address:       -  Function: -  ",s->dem_par->name);
-                    else {
-                        cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-                        cJSON_AddNullToObject(json_output, "address");
-                        cJSON_AddNullToObject(json_output, "function");
-                    }
-                }
-                if(pocsag_mode == POCSAG_MODE_AUTO)
-                    verbprintf(3, "Certainty: %5i  ", guess_num);
-                if (!json_mode) {
-                    verbprintf(0, "Numeric: %s", num_string);
-                    if(!sync) verbprintf(2,"<LOST SYNC>");
-                    verbprintf(0,"\n");
-                }
-                else {
-                    cJSON_AddStringToObject(json_output, "numeric", num_string);
-                    addJsonTimestamp(json_output);
-                    fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
-                    fflush(stdout);
-                    cJSON_Delete(json_output);
+                    if(s->cfg->pocsag_heuristic_pruning)
+                        return;
+                    unsure = 1;
                 }
             }
 
-            if((pocsag_mode == POCSAG_MODE_ALPHA) || ((pocsag_mode == POCSAG_MODE_STANDARD) && (func != 0)) || ((pocsag_mode == POCSAG_MODE_AUTO) && (guess_alpha >= guess_skyper || unsure)))
+            if((s->cfg->pocsag_mode == POCSAG_MODE_NUMERIC) || ((s->cfg->pocsag_mode == POCSAG_MODE_STANDARD) && (func == 0)) || ((s->cfg->pocsag_mode == POCSAG_MODE_AUTO) && (guess_num >= 20 || unsure)))
             {
-                if((s->l2.pocsag.address != -2) || (s->l2.pocsag.function != -2))
-                {
-                    if (!json_mode)
-                        verbprintf(0, "%s: Address: %7lu  Function: %1hhi  ",s->dem_par->name,
-                               s->l2.pocsag.address, s->l2.pocsag.function);
-                    else {
-                        cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-                        cJSON_AddNumberToObject(json_output, "address", s->l2.pocsag.address);
-                        cJSON_AddNumberToObject(json_output, "function", s->l2.pocsag.function);
-                    }
-                }
-                else
-                {
-                    if (!json_mode)
-                        verbprintf(0, "%s: Address:       -  Function: -  ",s->dem_par->name);
-                    else {
-                        cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-                        cJSON_AddNullToObject(json_output, "address");
-                        cJSON_AddNullToObject(json_output, "function");
-                    }
-                }
-                if(pocsag_mode == POCSAG_MODE_AUTO)
-                    verbprintf(3, "Certainty: %5i  ", guess_alpha);
-                if (!json_mode) {
-                    verbprintf(0, "Alpha:   %s", alpha_string);
-                    if(!sync) verbprintf(2,"<LOST SYNC>");
-                    verbprintf(0,"\n");
-                }
-                else {
-                    cJSON_AddStringToObject(json_output, "alpha", alpha_string);
-                    addJsonTimestamp(json_output);
-                    fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
-                    fflush(stdout);
-                    cJSON_Delete(json_output);
-                }
+                print_msg_numeric(&s->l2.pocsag, string, sizeof(string));
+                pocsag_printline(s, sync, "Numeric: ", "numeric", string, guess_num);
             }
 
-            if((pocsag_mode == POCSAG_MODE_SKYPER) || ((pocsag_mode == POCSAG_MODE_AUTO) && (guess_skyper >= guess_alpha || unsure))) // Only output SKYPER if we're explicitly asking for it or we're auto guessing! (because it's not part of one of the standards, right?!)
+            if((s->cfg->pocsag_mode == POCSAG_MODE_ALPHA) || ((s->cfg->pocsag_mode == POCSAG_MODE_STANDARD) && (func != 0)) || ((s->cfg->pocsag_mode == POCSAG_MODE_AUTO) && (guess_alpha >= guess_skyper || unsure)))
             {
-                if((s->l2.pocsag.address != -2) || (s->l2.pocsag.function != -2))
-                    if (!json_mode)
-                        verbprintf(0, "%s: Address: %7lu  Function: %1hhi  ",s->dem_par->name,
-                               s->l2.pocsag.address, s->l2.pocsag.function);
-                    else {
-                        cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-                        cJSON_AddNumberToObject(json_output, "address", s->l2.pocsag.address);
-                        cJSON_AddNumberToObject(json_output, "function", s->l2.pocsag.function);
-                    }
-                else
-                    if (!json_mode)
-                        verbprintf(0, "%s: Address:       -  Function: -  ",s->dem_par->name);
-                    else {
-                        cJSON_AddStringToObject(json_output, "demod_name", s->dem_par->name);
-                        cJSON_AddNullToObject(json_output, "address");
-                        cJSON_AddNullToObject(json_output, "function");
-                    }
-                if(pocsag_mode == POCSAG_MODE_AUTO)
-                    verbprintf(3, "Certainty: %5i  ", guess_skyper);
-                if (!json_mode) {
-                    verbprintf(0, "Skyper:  %s", skyper_string);
-                    if(!sync) verbprintf(2,"<LOST SYNC>");
-                    verbprintf(0,"\n");
-                }
-                else {
-                    cJSON_AddStringToObject(json_output, "skyper", skyper_string);
-                    addJsonTimestamp(json_output);
-                    fprintf(stdout, "%s\n", cJSON_PrintUnformatted(json_output));
-                    fflush(stdout);
-                    cJSON_Delete(json_output);
-                }
+                print_msg_alpha(&s->l2.pocsag, string, sizeof(string), CAESAR_ALPHA);
+                pocsag_printline(s, sync, "Alpha:   ", "alpha", string, guess_alpha);
+            }
+
+            if((s->cfg->pocsag_mode == POCSAG_MODE_SKYPER) || ((s->cfg->pocsag_mode == POCSAG_MODE_AUTO) && (guess_skyper >= guess_alpha || unsure))) // Only output SKYPER if we're explicitly asking for it or we're auto guessing! (because it's not part of one of the standards, right?!)
+            {
+                print_msg_alpha(&s->l2.pocsag, string, sizeof(string), CAESAR_SKYPER);
+                pocsag_printline(s, sync, "Skyper:  ", "skyper", string, guess_skyper);
             }
         }
     }
@@ -696,15 +646,18 @@ static void pocsag_printmessage(struct demod_state *s, bool sync)
 
 void pocsag_init(struct demod_state *s)
 {
+    bch_init();  /* build the tables now, not lazily from a worker thread */
     memset(&s->l2.pocsag, 0, sizeof(s->l2.pocsag));
     s->l2.pocsag.address = -1;
     s->l2.pocsag.function = -1;
+    pocsag_init_charset(s->cfg->pocsag_charset ? s->cfg->pocsag_charset : "US", s->l2.pocsag.trtab);
 }
 
 void pocsag_deinit(struct demod_state *s)
 {
-    if(s->l2.pocsag.pocsag_total_error_count)
+    if(s->l2.pocsag.pocsag_total_error_count || s->l2.pocsag.pocsag_words_skipped)
         verbprintf(1, "\n===%s stats===\n"
+                   "Words skipped by sync search: %u\n"
                    "Words BCH checked: %u\n"
                    "Corrected errors: %u\n"
                    "Corrected 1bit errors: %u\n"
@@ -715,6 +668,7 @@ void pocsag_deinit(struct demod_state *s)
                    "Bits processed while out of sync: %u\n"
                    "Successfully decoded: %f%%\n",
                    s->dem_par->name,
+                   s->l2.pocsag.pocsag_words_skipped,
                    s->l2.pocsag.pocsag_total_error_count,
                    s->l2.pocsag.pocsag_corrected_error_count,
                    s->l2.pocsag.pocsag_corrected_1bit_error_count,
@@ -724,14 +678,14 @@ void pocsag_deinit(struct demod_state *s)
                    s->l2.pocsag.pocsag_bits_processed_while_synced,
                    s->l2.pocsag.pocsag_bits_processed_while_not_synced,
                    (100./s->l2.pocsag.pocsag_total_bits_received)*s->l2.pocsag.pocsag_bits_processed_while_synced);
-    fflush(stdout);
 }
 
 /* ---------------------------------------------------------------------- */
 
 // BCH error correction using unified bch library
-int pocsag_brute_repair(struct l2_state_pocsag *rx, uint32_t* data)
+int pocsag_brute_repair(struct demod_state *s, uint32_t* data)
 {
+    struct l2_state_pocsag *rx = &s->l2.pocsag;
     int result = bch_pocsag_correct(data);
     
     if (result == 0) {
@@ -741,7 +695,7 @@ int pocsag_brute_repair(struct l2_state_pocsag *rx, uint32_t* data)
     rx->pocsag_total_error_count++;
     verbprintf(6, "Error in syndrome detected!\n");
     
-    if (pocsag_error_correction == 0) {
+    if (s->cfg->pocsag_error_correction == 0) {
         rx->pocsag_uncorrected_error_count++;
         verbprintf(6, "Couldn't correct error!\n");
         return 1;
@@ -755,7 +709,7 @@ int pocsag_brute_repair(struct l2_state_pocsag *rx, uint32_t* data)
     }
     
     /* Check if we're allowed to correct this many errors */
-    if (result > pocsag_error_correction) {
+    if (result > s->cfg->pocsag_error_correction) {
         rx->pocsag_uncorrected_error_count++;
         verbprintf(6, "Couldn't correct error!\n");
         return 1;
@@ -795,6 +749,32 @@ static inline bool is_idle(const uint32_t * const rx_data)
     return false;
 }
 
+/*
+ * bch_pocsag_correct() repairs at most BCH_MAX_ERRORS bit errors, whatever
+ * -b is set to (pocsag_brute_repair() only decides how the repair is
+ * counted). A word further than that from the sync word can never be
+ * repaired into it, and the inverted word is 32 minus that distance away.
+ * While hunting for sync, which is most of the time, one popcount thus
+ * rules out both polarities for nearly every bit.
+ *
+ * The cutoff is BCH_MAX_ERRORS and not -b on purpose: sync has always been
+ * acquired with up to two bit errors, even at -b 0, and a lower cutoff
+ * would lose those syncs. Words ruled out here never reach BCH, so they
+ * count as pocsag_words_skipped and not in the BCH statistics.
+ */
+static inline int sync_distance(uint32_t rx_data)
+{
+    uint32_t x = rx_data ^ POCSAG_SYNC;
+#if defined(__POPCNT__) || defined(__aarch64__)
+    return __builtin_popcount(x);
+#else
+    /* inline; without a popcount instruction the builtin is a library call */
+    x = x - ((x >> 1) & 0x55555555);
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    return (((x + (x >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+#endif
+}
+
 static void do_one_bit(struct demod_state *s, uint32_t rx_data)
 {
     s->l2.pocsag.pocsag_total_bits_received++;
@@ -804,16 +784,18 @@ static void do_one_bit(struct demod_state *s, uint32_t rx_data)
     case NO_SYNC:
     {
         uint32_t rx_data_try;
+        int distance = sync_distance(rx_data);
         
         s->l2.pocsag.pocsag_bits_processed_while_not_synced++;
 
         /* Try normal polarity with error correction (unless inverted-only mode) */
-        if(pocsag_polarity != 2)
+        if(s->cfg->pocsag_polarity != 2 && distance <= BCH_MAX_ERRORS)
         {
             rx_data_try = rx_data;
-            pocsag_brute_repair(&s->l2.pocsag, &rx_data_try);
+            pocsag_brute_repair(s, &rx_data_try);
             if(rx_data_try == POCSAG_SYNC)
             {
+                demod_mark(s, s->l1.pocsag.bit_pos - (long)s->l1.pocsag.word_span);
                 verbprintf(4, "Acquired sync!\n");
                 s->l2.pocsag.state = SYNC;
                 s->l2.pocsag.inverted = 0;
@@ -822,18 +804,22 @@ static void do_one_bit(struct demod_state *s, uint32_t rx_data)
         }
         
         /* Try inverted polarity with error correction (unless normal-only mode) */
-        if(pocsag_polarity != 1)
+        if(s->cfg->pocsag_polarity != 1 && 32 - distance <= BCH_MAX_ERRORS)
         {
             rx_data_try = ~rx_data;
-            pocsag_brute_repair(&s->l2.pocsag, &rx_data_try);
+            pocsag_brute_repair(s, &rx_data_try);
             if(rx_data_try == POCSAG_SYNC)
             {
+                demod_mark(s, s->l1.pocsag.bit_pos - (long)s->l1.pocsag.word_span);
                 verbprintf(3, "Acquired sync (inverted polarity detected)!\n");
                 s->l2.pocsag.state = SYNC;
                 s->l2.pocsag.inverted = 1;
                 return;
             }
         }
+        if((s->cfg->pocsag_polarity == 2 || distance > BCH_MAX_ERRORS) &&
+           (s->cfg->pocsag_polarity == 1 || 32 - distance > BCH_MAX_ERRORS))
+            s->l2.pocsag.pocsag_words_skipped++;
         return;
     }
 
@@ -855,7 +841,7 @@ static void do_one_bit(struct demod_state *s, uint32_t rx_data)
         if(s->l2.pocsag.state == SYNC)
             s->l2.pocsag.state = ADDRESS; // We're in sync, move on.
 
-        if(pocsag_brute_repair(&s->l2.pocsag, &rx_data))
+        if(pocsag_brute_repair(s, &rx_data))
         {
             // Arbitration lost
             if(s->l2.pocsag.state != LOST_SYNC)
@@ -907,6 +893,7 @@ static void do_one_bit(struct demod_state *s, uint32_t rx_data)
                     s->l2.pocsag.function = -2;
                     s->l2.pocsag.address  = -2;
                     s->l2.pocsag.state = MESSAGE;
+                    demod_mark(s, s->l1.pocsag.bit_pos - (long)s->l1.pocsag.word_span);
                     break; // Performing partial decode
                 }
 
@@ -914,6 +901,7 @@ static void do_one_bit(struct demod_state *s, uint32_t rx_data)
                 s->l2.pocsag.function = (rx_data >> 11) & 3;
                 s->l2.pocsag.address  = ((rx_data >> 10) & 0x1ffff8) | ((rxword >> 1) & 7);
                 s->l2.pocsag.state = MESSAGE;
+                demod_mark(s, s->l1.pocsag.bit_pos - (long)s->l1.pocsag.word_span);
                 return;
             }
 
@@ -930,12 +918,15 @@ static void do_one_bit(struct demod_state *s, uint32_t rx_data)
                 }
 
                 if (s->l2.pocsag.numnibbles > sizeof(s->l2.pocsag.buffer)*2 - 5) {
-                    if (!json_mode) {
+                    if (!s->cfg->json) {
                         verbprintf(2, "%s: Warning: Message too long\n",
                                    s->dem_par->name);
                     } else {
-                        fprintf(stdout, "{\"error\": \"%s: Warning: Message too long\n\"}", s->dem_par->name);
-                        fflush(stdout);
+                        char error[64];
+                        snprintf(error, sizeof(error), "%s: Warning: Message too long", s->dem_par->name);
+                        json_begin();
+                        json_add_string("error", error);
+                        json_end();
                     }
                     /* Message too long indicates we're decoding garbage - lose sync */
                     s->l2.pocsag.state = LOSING_SYNC;
@@ -991,10 +982,104 @@ void pocsag_rxbit(struct demod_state *s, int32_t bit)
     s->l2.pocsag.rx_data <<= 1;
     s->l2.pocsag.rx_data |= !bit;
     verbprintf(9, " %c ", '1'-(s->l2.pocsag.rx_data & 1));
-    if(pocsag_invert_input)
+    if(s->cfg->pocsag_invert_input)
         do_one_bit(s, ~(s->l2.pocsag.rx_data)); // this tries the inverted signal
     else
         do_one_bit(s, s->l2.pocsag.rx_data);
 }
 
+/*
+ * Feed n bits, pos[i] being the block offset bit i was sliced at. While
+ * hunting for sync, bits that cannot complete a word near the sync word
+ * (in either polarity) would only be counted by do_one_bit(), so they are
+ * shifted in here without running it, unless -v9 asks for every bit.
+ */
+static void pocsag_rxbits(struct demod_state *s, const unsigned char *bits,
+                          const int *pos, unsigned int n)
+{
+    unsigned int i = 0;
+
+    if(!(s->l2.pocsag.state & SYNC) &&
+       (MAX_VERBOSE_LEVEL < 9 || s->cfg->verbose < 9))
+    {
+        uint32_t rx_data = s->l2.pocsag.rx_data;
+
+        for(; i < n; i++)
+        {
+            uint32_t next = rx_data << 1 | !bits[i];
+            int distance = sync_distance(next);
+            if(distance <= BCH_MAX_ERRORS || 32 - distance <= BCH_MAX_ERRORS)
+                break;
+            rx_data = next;
+        }
+        s->l2.pocsag.rx_data = rx_data;
+        s->l2.pocsag.pocsag_total_bits_received += i;
+        s->l2.pocsag.pocsag_bits_processed_while_not_synced += i;
+        s->l2.pocsag.pocsag_words_skipped += i;
+    }
+    for(; i < n; i++) {
+        s->l1.pocsag.bit_pos = pos[i];
+        pocsag_rxbit(s, bits[i]);
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+#define POCSAG_CHUNK 1024
+
+/*
+ * Slicer and bit clock recovery shared by the 512, 1200 and 2400 baud
+ * demodulators. Every subsamp'th sample is sliced at zero; a transition
+ * pulls the bit clock phase towards the middle of the bit by 1/8 of a
+ * sample step, and a bit is taken whenever the phase wraps. The loop is
+ * written without branches on the signal, which is mostly noise, and
+ * collects the bits of a chunk before handing them to the decoder.
+ */
+void pocsag_demod(struct demod_state *s, const struct pocsag_clock *clk,
+                  const float *buf, int length)
+{
+    const uint32_t inc = clk->sphaseinc, step = clk->subsamp;
+    const uint32_t centre = 0x8000u - inc / 2;
+    uint32_t shreg = s->l1.pocsag.dcd_shreg, sphase = s->l1.pocsag.sphase;
+    const float *start = buf;
+    unsigned char bits[POCSAG_CHUNK];
+    int pos[POCSAG_CHUNK];
+
+    /* where a codeword began, for the sample clock */
+    s->l1.pocsag.word_span = 31ull * step * 0x10000u / inc;
+    if (s->l1.pocsag.subsamp) {
+        if (length <= (int)s->l1.pocsag.subsamp) {
+            s->l1.pocsag.subsamp -= length;
+            return;
+        }
+        buf += s->l1.pocsag.subsamp;
+        length -= s->l1.pocsag.subsamp;
+        s->l1.pocsag.subsamp = 0;
+    }
+    while (length > 0) {
+        unsigned int looks = (length + step - 1) / step, n = 0;
+
+        if (looks > POCSAG_CHUNK)
+            looks = POCSAG_CHUNK;
+        for (unsigned int k = 0; k < looks; k++, buf += step) {
+            uint32_t transition, adjust;
+
+            shreg = shreg << 1 | (*buf > 0);
+            verbprintf(10, "%c", '0'+(shreg & 1));
+            transition = -((shreg ^ (shreg >> 1)) & 1);
+            adjust = sphase < centre ? inc / 8 : -(inc / 8);
+            sphase += (adjust & transition) + inc;
+            bits[n] = shreg & 1;
+            pos[n] = buf - start;
+            n += sphase >> 16;
+            sphase &= 0xffffu;
+        }
+        length -= looks * step;
+        pocsag_rxbits(s, bits, pos, n);
+    }
+    s->l1.pocsag.subsamp = -length;
+    s->l1.pocsag.dcd_shreg = shreg;
+    s->l1.pocsag.sphase = sphase;
+}
+
 /* ---------------------------------------------------------------------- */
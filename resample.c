@@ -0,0 +1,206 @@
+/*
+ *      resample.c -- polyphase sample rate converter
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * The rate ratio is reduced to up/down. Conceptually the input is
+ * upsampled by 'up', lowpass filtered and decimated by 'down'; only the
+ * filter taps that hit non-zero input samples are ever evaluated, so each
+ * output sample is one dot product with one of 'up' coefficient phases.
+ * The prototype is a Blackman windowed sinc whose cutoff follows the
+ * lower of the two Nyquist frequencies. Every phase is zero padded to a
+ * multiple of FIR_BLOCK taps so the dot product runs on whole vectors.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "resample.h"
+#include "filter.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define ZERO_CROSSINGS 12       /* sinc lobes on either side of the centre */
+#define PASSBAND       0.92     /* cutoff relative to the lower Nyquist frequency */
+#define MAX_PHASES     1024     /* quantise the phase beyond this */
+#define FIR_BLOCK      8        /* taps per iteration of the vector kernel */
+
+struct resampler {
+    unsigned int up, down;      /* out_rate/in_rate in lowest terms */
+    unsigned int phases;
+    unsigned int taps;
+    float *coef;                /* phases rows of taps coefficients */
+    float *buf;                 /* pending input samples */
+    unsigned int buflen;
+    unsigned int bufsize;
+    unsigned int start;         /* first input sample of the next output's window */
+    unsigned int frac;          /* sub-sample position of the next output, in 1/up */
+};
+
+/* ---------------------------------------------------------------------- */
+
+#if defined(__GNUC__) || defined(__clang__)
+/*
+ * Generic vector extensions map onto SSE, NEON, AltiVec, ... or plain
+ * scalar code, whatever the target offers. Two independent accumulators
+ * hide the latency of the floating point adds.
+ */
+typedef float v4sf __attribute__((vector_size(16)));
+
+static inline float fir_dot(const float *x, const float *h, unsigned int n)
+{
+    v4sf acc0 = {0, 0, 0, 0}, acc1 = {0, 0, 0, 0};
+
+    for (unsigned int i = 0; i < n; i += FIR_BLOCK) {
+        v4sf x0, x1, h0, h1;
+        memcpy(&x0, x + i, sizeof(x0));
+        memcpy(&x1, x + i + 4, sizeof(x1));
+        memcpy(&h0, h + i, sizeof(h0));
+        memcpy(&h1, h + i + 4, sizeof(h1));
+        acc0 += x0 * h0;
+        acc1 += x1 * h1;
+    }
+    acc0 += acc1;
+    return (acc0[0] + acc0[2]) + (acc0[1] + acc0[3]);
+}
+#else
+static inline float fir_dot(const float *x, const float *h, unsigned int n)
+{
+    return mac(x, h, n);
+}
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+static double sinc(double x)
+{
+    if (fabs(x) < 1e-9)
+        return 1.0;
+    return sin(M_PI * x) / (M_PI * x);
+}
+
+static double blackman(double x, double half)
+{
+    if (fabs(x) >= half)
+        return 0.0;
+    return 0.42 + 0.5 * cos(M_PI * x / half) + 0.08 * cos(2.0 * M_PI * x / half);
+}
+
+struct resampler *resampler_new(unsigned int in_rate, unsigned int out_rate)
+{
+    struct resampler *rs;
+    unsigned int g = gcd(in_rate, out_rate);
+    double cutoff;
+    unsigned int half;
+
+    if (!in_rate || !out_rate)
+        return NULL;
+    if (!(rs = calloc(1, sizeof(*rs))))
+        return NULL;
+    rs->up = out_rate / g;
+    rs->down = in_rate / g;
+    rs->phases = rs->up < MAX_PHASES ? rs->up : MAX_PHASES;
+
+    /* cutoff in cycles per input sample, relative to the input Nyquist */
+    cutoff = PASSBAND * (rs->up < rs->down ? (double)rs->up / rs->down : 1.0);
+    half = (unsigned int)ceil(ZERO_CROSSINGS / cutoff);
+    rs->taps = (2 * half + FIR_BLOCK - 1) / FIR_BLOCK * FIR_BLOCK;
+
+    rs->coef = malloc((size_t)rs->phases * rs->taps * sizeof(rs->coef[0]));
+    rs->bufsize = 4 * rs->taps + 4096;
+    rs->buf = malloc(rs->bufsize * sizeof(rs->buf[0]));
+    if (!rs->coef || !rs->buf) {
+        resampler_free(rs);
+        return NULL;
+    }
+
+    for (unsigned int p = 0; p < rs->phases; p++) {
+        float *c = rs->coef + (size_t)p * rs->taps;
+        double sum = 0;
+
+        for (unsigned int j = 0; j < rs->taps; j++) {
+            /* distance of tap j from the output instant, in input samples */
+            double d = (double)j - (half - 1) - (double)p / rs->phases;
+            c[j] = cutoff * sinc(cutoff * d) * blackman(d, half);
+            sum += c[j];
+        }
+        for (unsigned int j = 0; j < rs->taps; j++)
+            c[j] /= sum;
+    }
+
+    /* centre the first output on the first input sample */
+    rs->buflen = half - 1;
+    memset(rs->buf, 0, rs->buflen * sizeof(rs->buf[0]));
+    return rs;
+}
+
+void resampler_free(struct resampler *rs)
+{
+    if (!rs)
+        return;
+    free(rs->coef);
+    free(rs->buf);
+    free(rs);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void resampler_write(struct resampler *rs, const float *in, unsigned int n)
+{
+    /* drop what no output window can reach any more */
+    unsigned int drop = rs->start < rs->buflen ? rs->start : rs->buflen;
+    if (drop) {
+        rs->buflen -= drop;
+        memmove(rs->buf, rs->buf + drop, rs->buflen * sizeof(rs->buf[0]));
+        rs->start -= drop;
+    }
+    if (rs->buflen + n > rs->bufsize) {
+        unsigned int size = 2 * (rs->buflen + n);
+        float *buf = realloc(rs->buf, size * sizeof(buf[0]));
+        if (!buf) {
+            perror("realloc");
+            exit(10);
+        }
+        rs->buf = buf;
+        rs->bufsize = size;
+    }
+    memcpy(rs->buf + rs->buflen, in, n * sizeof(in[0]));
+    rs->buflen += n;
+}
+
+unsigned int resampler_read(struct resampler *rs, float *out, unsigned int n)
+{
+    unsigned int cnt = 0;
+
+    while (cnt < n && rs->start + rs->taps <= rs->buflen) {
+        unsigned int p = (unsigned int)((uint64_t)rs->frac * rs->phases / rs->up);
+        out[cnt++] = fir_dot(rs->buf + rs->start, rs->coef + (size_t)p * rs->taps, rs->taps);
+        rs->frac += rs->down;
+        rs->start += rs->frac / rs->up;
+        rs->frac %= rs->up;
+    }
+    return cnt;
+}
+
+/* ---------------------------------------------------------------------- */
@@ -0,0 +1,45 @@
+/*
+ *      resample.h -- polyphase sample rate converter
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#ifndef _RESAMPLE_H
+#define _RESAMPLE_H
+
+/* ---------------------------------------------------------------------- */
+
+struct resampler;
+
+/*
+ * Create a converter from in_rate to out_rate. Any pair of rates works,
+ * the ratio is reduced to up/down in lowest terms internally.
+ */
+struct resampler *resampler_new(unsigned int in_rate, unsigned int out_rate);
+void resampler_free(struct resampler *rs);
+
+/* Queue n input samples */
+void resampler_write(struct resampler *rs, const float *in, unsigned int n);
+
+/* Fetch up to n output samples, returns the number produced */
+unsigned int resampler_read(struct resampler *rs, float *out, unsigned int n);
+
+/* ---------------------------------------------------------------------- */
+#endif /* _RESAMPLE_H */
@@ -36,9 +36,46 @@
 #define BLOCKNUM 4    /* must match numbers in multimon.h */
 #define TIMEOUT_LIMIT 5 //50ms
 
+/*
+ * The tone energies of a block come from a Goertzel bank (goertzel.c).
+ * A bank can hold the union of the tones of several standards. When more
+ * than one standard is enabled, the bank runs once per input block ahead
+ * of the demodulators and each of them reads its tones from the records.
+ */
+
+void selcall_bank_init(struct goertzel_bank *b)
+{
+    goertzel_init(b, BLOCKLEN);
+}
+
+void selcall_bank_add(struct goertzel_bank *b, const unsigned int *freq)
+{
+    for (int i = 0; i < 16; i++)
+        goertzel_add(b, freq[i]);
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void map_tones(struct demod_state *s, const struct goertzel_bank *b)
+{
+    for (int i = 0; i < 16; i++)
+        s->l1.selcall.tone[i] = goertzel_tone(b, s->dem_par->selcall_freq[i]);
+    s->l1.selcall.reclen = goertzel_reclen(b);
+}
+
 void selcall_init(struct demod_state *s)
 {
     memset(&s->l1.selcall, 0, sizeof(s->l1.selcall));
+    selcall_bank_init(&s->l1.selcall.bank);
+    selcall_bank_add(&s->l1.selcall.bank, s->dem_par->selcall_freq);
+    map_tones(s, &s->l1.selcall.bank);
+}
+
+/* Read the tones from the records of a bank run for several standards */
+void selcall_share(struct demod_state *s, const struct goertzel_bank *b)
+{
+    map_tones(s, b);
+    s->l1.selcall.shared = 1;
 }
 
 void selcall_deinit(struct demod_state *s)
@@ -100,40 +137,57 @@ static inline int process_block(struct demod_state *s)
     return i;
 }
 
-void selcall_demod(struct demod_state *s, const float *buffer, int length,
-                   const unsigned int *selcall_freq, const char * const name)
+/* The block ended end samples into the current one */
+static void selcall_block(struct demod_state *s, const float *rec, long end)
 {
-    float s_in;
+    const char *name = s->dem_par->name;
+    unsigned int ntones = (s->l1.selcall.reclen - 1) / 2;
     int i;
 
-    for (; length > 0; length--, buffer++) {
-        s_in = *buffer;
-        s->l1.selcall.energy[0] += fsqr(s_in);
-        for (i = 0; i < 16; i++) {
-            s->l1.selcall.tenergy[0][i] += COS(s->l1.selcall.ph[i]) * s_in;
-            s->l1.selcall.tenergy[0][i+16] += SIN(s->l1.selcall.ph[i]) * s_in;
-            s->l1.selcall.ph[i] += selcall_freq[i];
+    s->l1.selcall.energy[0] = rec[0];
+    for (i = 0; i < 16; i++) {
+        s->l1.selcall.tenergy[0][i] = rec[1 + s->l1.selcall.tone[i]];
+        s->l1.selcall.tenergy[0][i+16] = rec[1 + ntones + s->l1.selcall.tone[i]];
+    }
+    i = process_block(s);
+    if (i != s->l1.selcall.lastch && i >= 0)
+    {
+        if(s->l1.selcall.timeout == 0) {
+            demod_mark(s, end - BLOCKLEN);
+            verbprintf(0, "%s: ", name);
         }
-        if ((s->l1.selcall.blkcount--) <= 0) {
-            s->l1.selcall.blkcount = BLOCKLEN;
-            i = process_block(s);
-            if (i != s->l1.selcall.lastch && i >= 0)
-            {
-                if(s->l1.selcall.timeout == 0)
-                    verbprintf(0, "%s: ", name);
-                verbprintf(0, "%1X", i);
-                s->l1.selcall.timeout = 1;
-            }
-
-            if(i == -1 && s->l1.selcall.timeout != 0)
-                s->l1.selcall.timeout++;
-            if(s->l1.selcall.timeout > TIMEOUT_LIMIT+1)
-            {
-                verbprintf(0, "\n");
-                s->l1.selcall.timeout = 0;
-            }
-
-            s->l1.selcall.lastch = i;
+        verbprintf(0, "%1X", i);
+        s->l1.selcall.timeout = 1;
+    }
+
+    if(i == -1 && s->l1.selcall.timeout != 0)
+        s->l1.selcall.timeout++;
+    if(s->l1.selcall.timeout > TIMEOUT_LIMIT+1)
+    {
+        verbprintf(0, "\n");
+        s->l1.selcall.timeout = 0;
+    }
+
+    s->l1.selcall.lastch = i;
+}
+
+void selcall_demod(struct demod_state *s, buffer_t buffer, int length)
+{
+    const float *start = buffer.fbuffer;
+    float rec[1 + 2*16];
+
+    if (s->l1.selcall.shared) {
+        const float *r = buffer.selcallbuffer;
+        /* the first block ends where the counter runs out, see goertzel_count() */
+        long end = s->l1.selcall.blkcount + 1;
+        for (unsigned int n = goertzel_count(&s->l1.selcall.blkcount, BLOCKLEN, length); n; n--) {
+            selcall_block(s, r, end);
+            r += s->l1.selcall.reclen;
+            end += BLOCKLEN + 1;
         }
+        return;
     }
+    while (length > 0)
+        if (goertzel_block(&s->l1.selcall.bank, &buffer.fbuffer, &length, rec))
+            selcall_block(s, rec, buffer.fbuffer - start);
 }
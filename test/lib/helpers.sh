@@ -56,6 +56,25 @@ check_patterns() {
     return 0
 }
 
+# Check if output contains all expected patterns, each after the previous one
+# Arguments: output pattern1 [pattern2 ...]
+# Returns: 0 if all found in order, 1 if not (sets MISSING_PATTERN)
+check_patterns_in_order() {
+    local rest="$1"
+    shift
+    
+    for pattern in "$@"; do
+        local line
+        line=$(echo "$rest" | grep -nF -m1 -- "$pattern" | cut -d: -f1)
+        if [ -z "$line" ]; then
+            MISSING_PATTERN="$pattern (in this order)"
+            return 1
+        fi
+        rest=$(echo "$rest" | tail -n +$((line + 1)))
+    done
+    return 0
+}
+
 # Report test result
 # Arguments: name passed [missing_pattern] [output]
 report_result() {
@@ -79,6 +98,92 @@ report_result() {
     fi
 }
 
+# Check if multimon-ng reads a file type without sox
+is_native_type() {
+    case "$1" in
+        raw|wav|au|flac) return 0 ;;
+        *) return 1 ;;
+    esac
+}
+
+# Write a little-endian integer of the given byte width
+write_le() {
+    local value=$1 width=$2 i
+    for ((i = 0; i < width; i++)); do
+        printf "\\x$(printf %02x $(((value >> (8 * i)) & 255)))"
+    done
+}
+
+# Wrap 16-bit mono raw samples in a WAV header
+# Arguments: raw_file wav_file [rate]
+raw_to_wav() {
+    local size rate=${3:-22050}
+    size=$(wc -c < "$1")
+    {
+        printf 'RIFF'; write_le $((size + 36)) 4; printf 'WAVEfmt '
+        write_le 16 4; write_le 1 2; write_le 1 2
+        write_le "$rate" 4; write_le $((rate * 2)) 4; write_le 2 2; write_le 16 2
+        printf 'data'; write_le "$size" 4
+        cat "$1"
+    } > "$2"
+}
+
+# A WAV the native reader does not take (IMA ADPCM) is handed to sox; without
+# sox multimon-ng must say that it is needed rather than fail to start it
+# Arguments: name
+run_unsupported_wav_test() {
+    local name="$1"
+    local tmpwav="${TEST_DIR}/tmp_$$.wav"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    # Windows builds do not look for sox before running it
+    if [ -n "$WINE_CMD" ] || command -v sox >/dev/null 2>&1; then
+        echo -e "${GREEN}SKIPPED${NC} (sox installed or Wine)"
+        TESTS_PASSED=$((TESTS_PASSED + 1))
+        return 0
+    fi
+    {
+        printf 'RIFF'; write_le 40 4; printf 'WAVEfmt '
+        write_le 16 4; write_le 17 2; write_le 1 2
+        write_le 22050 4; write_le 11025 4; write_le 256 2; write_le 4 2
+        printf 'data'; write_le 4 4; write_le 0 4
+    } > "$tmpwav"
+    
+    local output
+    output=$(run_multimon -q -a DTMF "$tmpwav")
+    rm -f "$tmpwav"
+    
+    if check_patterns "$output" "Error: sox is required for .wav files"; then
+        report_result "$name" 1
+    else
+        report_result "$name" 0 "$MISSING_PATTERN" "$output"
+        return 1
+    fi
+}
+
+# Double the rate of 16-bit raw samples by repeating every sample
+# Arguments: raw_file out_file
+upsample2_raw() {
+    od -An -v -tu1 -w2 "$1" | LC_ALL=C awk '{ printf "%c%c%c%c", $1, $2, $1, $2 }' > "$2"
+}
+
+# Interleave 16-bit raw files into one multichannel file, padding the shorter ones
+# Arguments: out_file raw_file1 [raw_file2 ...]
+interleave_raw() {
+    local out="$1" f
+    shift
+    local cols=()
+    for f in "$@"; do
+        od -An -v -tu1 -w2 "$f" > "$f.txt"
+        cols+=("$f.txt")
+    done
+    paste -d, "${cols[@]}" | LC_ALL=C awk -F, -v n=$# \
+        '{ for (i = 1; i <= n; i++) { split($i, b, " "); printf "%c%c", b[1] + 0, b[2] + 0 } }' > "$out"
+    rm -f "${cols[@]}"
+}
+
 # Generic test runner for sample files
 # Arguments: name decoder input_type input_file expected1 [expected2 ...]
 # Note: if input_type is "auto", auto-detection from file extension is used
@@ -100,15 +205,15 @@ run_test() {
         effective_type="${input_file##*.}"
     fi
     
-    # Skip if sox is needed but not available
-    if [ "$effective_type" != "raw" ] && ! command -v sox >/dev/null 2>&1; then
+    # Skip if sox is needed but not available (raw, wav, au and flac are read natively)
+    if ! is_native_type "$effective_type" && ! command -v sox >/dev/null 2>&1; then
         echo -e "${GREEN}SKIPPED${NC} (sox not installed)"
         TESTS_PASSED=$((TESTS_PASSED + 1))
         return 0
     fi
     
     local output
-    if [ -n "$WINE_CMD" ] && [ "$effective_type" != "raw" ]; then
+    if [ -n "$WINE_CMD" ] && ! is_native_type "$effective_type"; then
         # Wine can't run sox, so convert with host sox first then pipe raw to Wine
         output=$(sox -R -V1 --ignore-length -t "$effective_type" "$input_file" \
             -t raw -esigned-integer -b16 -r 22050 - remix 1 2>/dev/null | \
@@ -302,6 +407,201 @@ run_gen_decode_wav_test() {
     fi
 }
 
+# Generate signal with gen-ng, wrap it into a WAV file in the shell and
+# decode it with the built-in WAV reader (no sox involved)
+# Arguments: name gen_opts decoder expected1 [expected2 ...]
+run_gen_decode_native_wav_test() {
+    local name="$1"
+    local gen_opts="$2"
+    local decoder="$3"
+    shift 3
+    local expected_patterns=("$@")
+    
+    local tmpraw="${TEST_DIR}/tmp_$$.raw"
+    local tmpwav="${TEST_DIR}/tmp_$$.wav"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    if ! eval "run_gen_ng -t raw $gen_opts \"$tmpraw\"" >/dev/null 2>&1; then
+        echo -e "${RED}FAILED${NC} (gen-ng failed)"
+        rm -f "$tmpraw"
+        return 1
+    fi
+    raw_to_wav "$tmpraw" "$tmpwav"
+    rm -f "$tmpraw"
+    
+    local output
+    output=$(run_multimon -q -a "$decoder" "$tmpwav")
+    rm -f "$tmpwav"
+    
+    if check_patterns "$output" "${expected_patterns[@]}"; then
+        report_result "$name" 1
+    else
+        report_result "$name" 0 "$MISSING_PATTERN" "$output"
+        return 1
+    fi
+}
+
+# Generate signal with gen-ng at 22050 Hz, bring it to 44100 Hz and let
+# multimon-ng resample it back internally
+# Arguments: name container(raw|wav) gen_opts decoder expected1 [expected2 ...]
+run_gen_decode_upsampled_test() {
+    local name="$1"
+    local container="$2"
+    local gen_opts="$3"
+    local decoder="$4"
+    shift 4
+    local expected_patterns=("$@")
+    
+    local tmpraw="${TEST_DIR}/tmp_$$.raw"
+    local tmpup="${TEST_DIR}/tmp_up_$$.raw"
+    local tmpwav="${TEST_DIR}/tmp_up_$$.wav"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    if ! eval "run_gen_ng -t raw $gen_opts \"$tmpraw\"" >/dev/null 2>&1; then
+        echo -e "${RED}FAILED${NC} (gen-ng failed)"
+        rm -f "$tmpraw"
+        return 1
+    fi
+    upsample2_raw "$tmpraw" "$tmpup"
+    rm -f "$tmpraw"
+    
+    local output
+    if [ "$container" = "wav" ]; then
+        raw_to_wav "$tmpup" "$tmpwav" 44100
+        output=$(run_multimon -q -a "$decoder" "$tmpwav")
+    else
+        output=$(run_multimon -q -a "$decoder" --input-rate 44100 -t raw "$tmpup")
+    fi
+    rm -f "$tmpup" "$tmpwav"
+    
+    if check_patterns "$output" "${expected_patterns[@]}"; then
+        report_result "$name" 1
+    else
+        report_result "$name" 0 "$MISSING_PATTERN" "$output"
+        return 1
+    fi
+}
+
+# Test decoding of signals generated on each channel of an interleaved raw file
+# Arguments: name decoder multimon_opts gen_opts1 [gen_opts2 ...] -- expected1 [expected2 ...]
+run_gen_decode_multichannel_test() {
+    local name="$1"
+    local decoder="$2"
+    local mm_opts="$3"
+    shift 3
+    local files=()
+    local tmpout="${TEST_DIR}/tmp_mc_$$.raw"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+        local tmpfile="${TEST_DIR}/tmp_mc_$$_${#files[@]}.raw"
+        files+=("$tmpfile")
+        if ! eval "run_gen_ng -t raw $1 \"$tmpfile\"" >/dev/null 2>&1; then
+            echo -e "${RED}FAILED${NC} (gen-ng failed)"
+            rm -f "${files[@]}"
+            return 1
+        fi
+        shift
+    done
+    shift
+    local expected_patterns=("$@")
+    
+    interleave_raw "$tmpout" "${files[@]}"
+    rm -f "${files[@]}"
+    
+    local output
+    output=$(eval "run_multimon -q -a \"$decoder\" --channels ${#files[@]} $mm_opts -t raw \"$tmpout\"")
+    rm -f "$tmpout"
+    
+    if ${CHECK_PATTERNS:-check_patterns} "$output" "${expected_patterns[@]}"; then
+        report_result "$name" 1
+    else
+        report_result "$name" 0 "$MISSING_PATTERN" "$output"
+        return 1
+    fi
+}
+
+# Like run_gen_decode_multichannel_test, the patterns having to appear in order
+run_gen_decode_multichannel_order_test() {
+    CHECK_PATTERNS=check_patterns_in_order run_gen_decode_multichannel_test "$@"
+}
+
+# Generate an FM modulated IQ file with gen-ng and let multimon-ng demodulate it
+# Arguments: name type(cu8|cs16|cf32) rate gen_opts decoder expected1 [expected2 ...]
+run_gen_decode_iq_test() {
+    local name="$1"
+    local type="$2"
+    local rate="$3"
+    local gen_opts="$4"
+    local decoder="$5"
+    shift 5
+    local expected_patterns=("$@")
+    
+    local tmpfile="${TEST_DIR}/tmp_iq_$$.${type}"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    rm -f "$tmpfile"
+    if ! eval "run_gen_ng -t $type -R $rate $gen_opts \"$tmpfile\"" >/dev/null 2>&1; then
+        echo -e "${RED}FAILED${NC} (gen-ng failed)"
+        rm -f "$tmpfile"
+        return 1
+    fi
+    
+    local output
+    output=$(run_multimon -q -a "$decoder" --input-rate "$rate" "$tmpfile")
+    rm -f "$tmpfile"
+    
+    if check_patterns "$output" "${expected_patterns[@]}"; then
+        report_result "$name" 1
+    else
+        report_result "$name" 0 "$MISSING_PATTERN" "$output"
+        return 1
+    fi
+}
+
+# Generate several carriers of IQ with gen-ng and cut them apart with --fm-channels
+# Arguments: name type rate gen_opts multimon_opts expected_patterns...
+run_gen_decode_channels_test() {
+    local name="$1"
+    local type="$2"
+    local rate="$3"
+    local gen_opts="$4"
+    local mm_opts="$5"
+    shift 5
+    local expected_patterns=("$@")
+    
+    local tmpfile="${TEST_DIR}/tmp_channels_$$.${type}"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    rm -f "$tmpfile"
+    if ! eval "run_gen_ng -t $type -R $rate $gen_opts \"$tmpfile\"" >/dev/null 2>&1; then
+        echo -e "${RED}FAILED${NC} (gen-ng failed)"
+        rm -f "$tmpfile"
+        return 1
+    fi
+    
+    local output
+    output=$(eval "run_multimon -q --input-rate $rate $mm_opts \"$tmpfile\"")
+    rm -f "$tmpfile"
+    
+    if check_patterns "$output" "${expected_patterns[@]}"; then
+        report_result "$name" 1
+    else
+        report_result "$name" 0 "$MISSING_PATTERN" "$output"
+        return 1
+    fi
+}
+
 # Test that decoding FAILS (for error cases beyond correction capability)
 # Arguments: name gen_opts decoder
 # Verifies that decoder produces NO output (uncorrectable errors are silently dropped)
@@ -341,3 +641,102 @@ run_gen_decode_expect_fail() {
     TESTS_PASSED=$((TESTS_PASSED + 1))
     return 0
 }
+
+# Generate two signals with gen-ng and compare them byte for byte
+# Arguments: name expect(same|differ) gen_opts_a gen_opts_b
+run_gen_compare_test() {
+    local name="$1"
+    local expect="$2"
+    local gen_opts_a="$3"
+    local gen_opts_b="$4"
+    
+    local tmpa="${TEST_DIR}/tmp_a_$$.raw"
+    local tmpb="${TEST_DIR}/tmp_b_$$.raw"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    if ! eval "run_gen_ng -t raw $gen_opts_a \"$tmpa\"" >/dev/null 2>&1 ||
+       ! eval "run_gen_ng -t raw $gen_opts_b \"$tmpb\"" >/dev/null 2>&1; then
+        echo -e "${RED}FAILED${NC} (gen-ng failed)"
+        rm -f "$tmpa" "$tmpb"
+        return 1
+    fi
+    
+    local result=differ
+    cmp -s "$tmpa" "$tmpb" && result=same
+    rm -f "$tmpa" "$tmpb"
+    
+    if [ "$result" = "$expect" ]; then
+        echo -e "${GREEN}PASSED${NC}"
+        TESTS_PASSED=$((TESTS_PASSED + 1))
+        return 0
+    fi
+    echo -e "${RED}FAILED${NC} (outputs $result, expected $expect)"
+    return 1
+}
+
+# Render a gen-ng bulk script, decode it, and check the decoded lines and the manifest
+# Arguments: name script multimon_opts expected1 [expected2 ...]
+run_gen_bulk_test() {
+    local name="$1"
+    local script="$2"
+    local mm_opts="$3"
+    shift 3
+    local expected_patterns=("$@")
+    
+    local tmpscript="${TEST_DIR}/tmp_$$.csv"
+    local tmpmanifest="${TEST_DIR}/tmp_manifest_$$.csv"
+    local tmpfile="${TEST_DIR}/tmp_$$.raw"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    printf '%s\n' "$script" > "$tmpscript"
+    if ! run_gen_ng -b "$tmpscript" -M "$tmpmanifest" "$tmpfile" >/dev/null 2>&1; then
+        echo -e "${RED}FAILED${NC} (gen-ng failed)"
+        rm -f "$tmpscript" "$tmpmanifest" "$tmpfile"
+        return 1
+    fi
+    
+    local output
+    output=$(run_multimon -t raw -q $mm_opts "$tmpfile"; cat "$tmpmanifest")
+    rm -f "$tmpscript" "$tmpmanifest" "$tmpfile"
+    
+    if check_patterns "$output" "${expected_patterns[@]}"; then
+        report_result "$name" 1
+    else
+        report_result "$name" 0 "$MISSING_PATTERN" "$output"
+        return 1
+    fi
+}
+
+# Check that gen-ng refuses a bulk script, naming the problem
+# Arguments: name script expected_error
+run_gen_bulk_reject_test() {
+    local name="$1"
+    local script="$2"
+    local expected="$3"
+    
+    local tmpscript="${TEST_DIR}/tmp_$$.csv"
+    local tmpfile="${TEST_DIR}/tmp_$$.raw"
+    
+    TESTS_RUN=$((TESTS_RUN + 1))
+    echo -n "Testing $name... "
+    
+    printf '%s\n' "$script" > "$tmpscript"
+    local output
+    if output=$(run_gen_ng -b "$tmpscript" "$tmpfile"); then
+        echo -e "${RED}FAILED${NC} (gen-ng accepted the script)"
+        rm -f "$tmpscript" "$tmpfile"
+        return 1
+    fi
+    rm -f "$tmpscript" "$tmpfile"
+    
+    if check_patterns "$output" "$expected"; then
+        report_result "$name" 1
+    else
+        report_result "$name" 0 "$MISSING_PATTERN" "$output"
+        return 1
+    fi
+}
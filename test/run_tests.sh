@@ -133,6 +133,10 @@ if [ $GEN_NG_AVAILABLE -eq 1 ]; then
     run_gen_decode_test "ZVEI1 with E" \
         '-z "1E234"' "ZVEI1" "ZVEI1: 1E234" || FAILED=1
     
+    run_gen_decode_test_with_opts "ZVEI1 with all selcall standards" \
+        '-z "67890"' "ZVEI1" "-a ZVEI2 -a ZVEI3 -a DZVEI -a PZVEI -a EEA -a EIA -a CCIR" \
+        "ZVEI1: 67890" "ZVEI2: 67890" || FAILED=1
+    
     echo
     echo "FLEX end-to-end tests:"
     
@@ -159,7 +163,11 @@ if [ $GEN_NG_AVAILABLE -eq 1 ]; then
     
     run_gen_decode_test "FLEX_NEXT decoder" \
         '-f "FLEX_NEXT test" -F 777777' "FLEX_NEXT" "0000777777" "FLEX_NEXT test" || FAILED=1
-    
+
+    run_gen_decode_test_with_opts "FLEX JSON escaping" \
+        '-f "Say \"hi\" C:\\" -F 4242' "FLEX" "--json" \
+        '"capcode":4242' '"message":"Say \"hi\" C:\\"' || FAILED=1
+
     echo
     echo "POCSAG end-to-end tests:"
     
@@ -187,6 +195,18 @@ if [ $GEN_NG_AVAILABLE -eq 1 ]; then
     run_gen_decode_test "POCSAG1200 min address" \
         '-P "MinAddr" -A 8 -B 1200' "POCSAG1200" "Address:       8" "MinAddr" || FAILED=1
     
+    run_gen_decode_test_with_opts "POCSAG512 with all rates enabled" \
+        '-P "AllRates" -A 31337 -B 512' "POCSAG512" "-a POCSAG1200 -a POCSAG2400" \
+        "POCSAG512: Address:   31337" "AllRates" || FAILED=1
+
+    run_gen_decode_test_with_opts "POCSAG1200 auto mode JSON" \
+        '-P "AutoJson" -A 4242 -B 1200' "POCSAG1200" "-f auto --json" \
+        '"alpha":"AutoJson"' '"skyper":' || FAILED=1
+
+    run_gen_decode_test_with_opts "POCSAG1200 sample clock time stamp" \
+        '-P "OnAir" -A 5353 -B 1200' "POCSAG1200" "--timestamp --iso8601 --start-time 2024-09-13T20:35:30Z" \
+        "2024-09-13T20:35:30.560498: POCSAG1200: Address:    5353" "OnAir" || FAILED=1
+
     echo
     echo "POCSAG BCH error correction tests:"
     
@@ -241,6 +261,188 @@ if [ $GEN_NG_AVAILABLE -eq 1 ]; then
     run_gen_decode_no_output_test "POCSAG inverted with -P normal (expect fail)" \
         '-P "InvNorm" -A 66666 -I' "POCSAG1200" "-P normal" || FAILED=1
     
+    echo
+    echo "Parallel demodulator tests:"
+    
+    run_gen_decode_test_with_opts "POCSAG with --parallel" \
+        '-P "ParTest" -A 12121' "POCSAG1200" "--parallel -a POCSAG512 -a POCSAG2400 -a FLEX -a DTMF" \
+        "POCSAG1200: Address:   12121" "ParTest" || FAILED=1
+
+    run_gen_decode_test_with_opts "POCSAG with --async-output and --parallel" \
+        '-P "AsyncOut" -A 23232' "POCSAG1200" "--async-output 20 --parallel --json -a DTMF" \
+        '"address":23232' '"alpha":"AsyncOut"' || FAILED=1
+    
+    echo
+    echo "Shared FSK front end tests:"
+    
+    run_gen_decode_test_with_opts "AFSK1200 sharing with CLIPFSK and UFSK1200" \
+        '-p "SharedFront"' "AFSK1200" "-a CLIPFSK -a UFSK1200" \
+        "AFSK1200: fm AE4WA-0 to HB9JNX-0" "SharedFront" || FAILED=1
+    
+    run_gen_decode_test_with_opts "AFSK1200 sharing with --parallel" \
+        '-p "SharedPar"' "AFSK1200" "--parallel -a CLIPFSK -a UFSK1200" \
+        "AFSK1200: fm AE4WA-0 to HB9JNX-0" "SharedPar" || FAILED=1
+    
+    echo
+    echo "Raw input path tests:"
+    
+    run_gen_decode_test_with_opts "POCSAG with --no-mmap" \
+        '-P "ReadPath" -A 13131' "POCSAG1200" "--no-mmap" "Address:   13131" "ReadPath" || FAILED=1
+    
+    echo
+    echo "Multichannel input tests:"
+    
+    run_gen_decode_multichannel_test "POCSAG on 3 interleaved channels" "POCSAG1200" "" \
+        '-P "Chan0" -A 31000' '-P "Chan1" -A 31001' '-P "Chan2" -A 31002' -- \
+        "CH0: POCSAG1200: Address:   31000" "CH1: POCSAG1200: Address:   31001" \
+        "CH2: POCSAG1200: Address:   31002" "Chan2" || FAILED=1
+    
+    run_gen_decode_multichannel_test "POCSAG on 2 channels with --parallel --json" "POCSAG1200" \
+        "--parallel --json --no-mmap" '-P "ParChan0" -A 32000' '-P "ParChan1" -A 32001' -- \
+        '"address":32001' '"alpha":"ParChan1"' '"channel":1' || FAILED=1
+    
+    run_gen_decode_multichannel_test "POCSAG routed to 2 of 8 channels" "POCSAG512@0" \
+        "-a POCSAG1200@5,7" '-P "Route0" -A 33000 -B 512' '-P "Route1" -A 33001' \
+        '-P "Route2" -A 33002' '-P "Route3" -A 33003' '-P "Route4" -A 33004' \
+        '-P "Route5" -A 33005' '-P "Route6" -A 33006' '-P "Route7" -A 33007' -- \
+        "CH0: POCSAG512: Address:   33000" "CH5: POCSAG1200: Address:   33005" \
+        "CH7: POCSAG1200: Address:   33007" "Route7" || FAILED=1
+    
+    run_gen_decode_multichannel_test "DTMF on 3 interleaved channels" "DTMF" "" \
+        '-d "147"' '-d "258"' '-d "369"' -- \
+        "CH0: DTMF: 7" "CH1: DTMF: 5" "CH2: DTMF: 9" || FAILED=1
+    
+    run_gen_decode_multichannel_test "DTMF on 4 channels with --threads 2" "DTMF" \
+        "--threads 2 --sample-clock" '-d "1A"' '-d "2B"' '-d "3C"' '-d "4D"' -- \
+        "CH0: DTMF: A" "CH1: DTMF: B" "CH2: DTMF: C" "CH3: DTMF: D" || FAILED=1
+    
+    # the digits of a block come in their channel's turn, before the X10 trace
+    run_gen_decode_multichannel_order_test "DTMF in its channel's turn" "DTMF" \
+        "-v2 -a X10" '-d "123456"' '-d "ABCD*#"' -- \
+        "CH0: DTMF: 2" "CH0: x10_demod" "CH1: DTMF: B" "CH1: x10_demod" \
+        "CH0: DTMF: 4" "CH0: x10_demod" "CH1: DTMF: D" || FAILED=1
+    
+    echo
+    echo "IQ input tests:"
+    
+    run_gen_decode_iq_test "POCSAG cu8 at 240 kHz" cu8 240000 \
+        '-P "IqU8" -A 41000' "POCSAG1200" "Address:   41000" "IqU8" || FAILED=1
+    
+    run_gen_decode_iq_test "FLEX cs16 at 1.024 MHz" cs16 1024000 \
+        '-f "IqS16" -F 1234567' "FLEX" "1234567" "IqS16" || FAILED=1
+    
+    run_gen_decode_iq_test "DTMF cf32 at 96 kHz" cf32 96000 \
+        '-d "147#"' "DTMF" "DTMF: 1" "DTMF: 4" "DTMF: 7" "DTMF: #" || FAILED=1
+    
+    run_gen_decode_channels_test "Three FM channels in cf32 at 960 kHz" cf32 960000 \
+        '-P "ChanA" -A 41000 -O -200000 -P "ChanB" -A 42000 -O 150000 -f "ChanC" -F 1234567 -O 300000' \
+        '-a POCSAG1200 -a FLEX --fm-channels -200k,150k,300k' \
+        "CH0: POCSAG1200: Address:   41000" "ChanA" "CH1: POCSAG1200: Address:   42000" "ChanB" \
+        "CH2: FLEX|" "ALN|ChanC" || FAILED=1
+    
+    run_gen_decode_channels_test "FM channels off bin centres, 4 threads" cu8 2400000 \
+        '-P "Edge" -A 43000 -O -1181250 -P "Middle" -A 44000 -O 18750' \
+        '-a POCSAG1200 --fm-channels 99.81875M,101.01875M,100.5M --center-freq 101M --threads 4' \
+        "CH0: POCSAG1200: Address:   43000" "Edge" "CH1: POCSAG1200: Address:   44000" "Middle" || FAILED=1
+    
+    echo
+    echo "Benchmark mode tests:"
+    
+    run_gen_decode_test_with_opts "POCSAG with --bench-loops 3" \
+        '-P "BenchLoop" -A 51515' "POCSAG1200" "--bench-loops 3 -a FLEX" \
+        "Address:   51515" "BenchLoop" "ns/sample" "x realtime" "FLEX            0   22050" || FAILED=1
+    
+    run_gen_decode_channels_test "FM channels with --bench-loops 2" cf32 960000 \
+        '-P "BenchA" -A 52000 -O -200000 -P "BenchB" -A 53000 -O 150000' \
+        '-a POCSAG1200 --fm-channels -200k,150k --threads 2 --bench-loops 2' \
+        "CH0: POCSAG1200: Address:   52000" "CH1: POCSAG1200: Address:   53000" \
+        "POCSAG1200      1   22050" "wall clock" || FAILED=1
+    
+    echo
+    echo "Channel impairment tests:"
+    
+    run_gen_decode_test "POCSAG with noise, drift, fading, DC and clipping" \
+        '-P "Impaired" -A 4242 -w 12 -C 200 -g 5 -x 0.02 -l 0.6 -r 7' "POCSAG1200" \
+        "Address:    4242" "Impaired" || FAILED=1
+    
+    run_gen_decode_test "FLEX with noise and a slow clock" \
+        '-f "ImpairedFlex" -F 1234567 -w 8 -C -300' "FLEX" "1234567" "ImpairedFlex" || FAILED=1
+    
+    run_gen_decode_test "AFSK1200 with noise and a frequency offset" \
+        '-p "ImpairedAx" -w 10 -o 150' "AFSK1200" "ImpairedAx" || FAILED=1
+    
+    run_gen_decode_test "DTMF with noise, offset and fading" \
+        '-d "1234" -w 10 -o 5 -g 2' "DTMF" "DTMF: 1" "DTMF: 2" "DTMF: 3" "DTMF: 4" || FAILED=1
+    
+    run_gen_decode_expect_fail "POCSAG buried in noise" '-P "Buried" -w -10' "POCSAG1200" || FAILED=1
+    
+    run_gen_compare_test "Impairments repeat with the same seed" same \
+        '-P "Seeded" -w 6 -g 10 -r 5' '-P "Seeded" -w 6 -g 10 -r 5' || FAILED=1
+    
+    run_gen_compare_test "Impairments differ with another seed" differ \
+        '-P "Seeded" -w 6 -g 10 -r 5' '-P "Seeded" -w 6 -g 10 -r 6' || FAILED=1
+    
+    echo
+    echo "Bulk traffic tests:"
+    
+    BULK_SCRIPT='# time,protocol,address,message
+0.5,POCSAG1200,1111,Bulk page
+3,FLEX,222222,Bulk flex, with a comma
+6,afsk1200,,Bulk packet
+9.5,DTMF,,147#
+11,POCSAG512,33333,Slow bulk page'
+    
+    run_gen_bulk_test "Mixed traffic with a manifest" "$BULK_SCRIPT" \
+        "-a POCSAG512 -a POCSAG1200 -a FLEX -a AFSK1200 -a DTMF" \
+        "Address:    1111" "Bulk page" "ALN|Bulk flex, with a comma" "Bulk packet" \
+        "DTMF: 1" "DTMF: 4" "DTMF: 7" "DTMF: #" "Slow bulk page" \
+        "11025,30576,0.500000,POCSAG1200,1111,\"Bulk page\"" \
+        "209475,17640,9.500000,DTMF,,\"147#\"" || FAILED=1
+    
+    for read_opt in "" "--no-mmap"; do
+        run_gen_bulk_test "Mixed traffic timed by the sample clock ${read_opt:-(mmap)}" "$BULK_SCRIPT" \
+            "$read_opt --timestamp --iso8601 --start-time @0 -a POCSAG512 -a POCSAG1200 -a FLEX -a AFSK1200 -a DTMF" \
+            "1970-01-01T00:00:01.380453: POCSAG1200: Address:    1111" \
+            "1970-01-01T00:00:03.640000: FLEX|" \
+            "1970-01-01T00:00:07.006077: AFSK1200: fm AE4WA-0 to HB9JNX-0" \
+            "1970-01-01T00:00:09.712063: DTMF: 4" \
+            "1970-01-01T00:00:12.813605: POCSAG512: Address:   33333" || FAILED=1
+    done
+    
+    printf '%s\n' "$BULK_SCRIPT" > "${TEST_DIR}/tmp_bulk_$$.csv"
+    run_gen_compare_test "Bulk output independent of threads" same \
+        "-b \"${TEST_DIR}/tmp_bulk_$$.csv\" -T 1 -w 12 -C 200" \
+        "-b \"${TEST_DIR}/tmp_bulk_$$.csv\" -T 4 -w 12 -C 200" || FAILED=1
+    rm -f "${TEST_DIR}/tmp_bulk_$$.csv"
+    
+    run_gen_bulk_test "Bulk page to address 0" "0.5,POCSAG1200,0,Page to zero" \
+        "-a POCSAG1200" "Address:       0" "Page to zero" \
+        "POCSAG1200,0,\"Page to zero\"" || FAILED=1
+    run_gen_bulk_reject_test "Bulk page without an address" "0.5,FLEX,,No capcode" \
+        ":1: missing address" || FAILED=1
+    run_gen_bulk_reject_test "Bulk DTMF with an address" "0.5,DTMF,1234,147#" \
+        ":1: AFSK1200 and DTMF take no address" || FAILED=1
+    
+    echo
+    echo "Native WAV reader tests:"
+    
+    run_gen_decode_native_wav_test "POCSAG native wav" \
+        '-P "NativeWav" -A 14141' "POCSAG1200" "Address:   14141" "NativeWav" || FAILED=1
+    
+    run_gen_decode_native_wav_test "DTMF native wav" \
+        '-d "159#"' "DTMF" "DTMF: 1" "DTMF: 5" "DTMF: 9" "DTMF: #" || FAILED=1
+    
+    run_unsupported_wav_test "ADPCM wav without sox" || FAILED=1
+    
+    echo
+    echo "Multirate input tests:"
+    
+    run_gen_decode_upsampled_test "POCSAG raw at 44100 Hz" raw \
+        '-P "Rate44k" -A 24680' "POCSAG1200" "Address:   24680" "Rate44k" || FAILED=1
+    
+    run_gen_decode_upsampled_test "DTMF wav at 44100 Hz" wav \
+        '-d "2580"' "DTMF" "DTMF: 2" "DTMF: 5" "DTMF: 8" "DTMF: 0" || FAILED=1
+    
     echo
     echo "WAV roundtrip tests (sox integration):"
     
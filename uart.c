@@ -74,13 +74,18 @@ void uart_rxbit(struct demod_state *s, int bit)
 	if (!s->l2.uart.rxstate) {
 		switch (s->l2.uart.rxbitstream & 0x03) {
 			case 0x02:	/* start bit */
+				s->l2.uart.char_start = demod_rx_pos(s);
+				if (s->l2.uart.rxptr == s->l2.uart.rxbuf)
+					s->l2.uart.start = s->l2.uart.char_start;
 				s->l2.uart.rxstate = 1;
 				s->l2.uart.rxbitbuf = 0x100;
 				break;
 			case 0x00:	/* no start bit */
 			case 0x03:	/* consecutive stop bits*/
-				if ((s->l2.uart.rxptr - s->l2.uart.rxbuf) >= 1)
+				if ((s->l2.uart.rxptr - s->l2.uart.rxbuf) >= 1) {
+					demod_mark_at(s, s->l2.uart.start);
 					disp_packet(s, s->l2.uart.rxbuf, s->l2.uart.rxptr - s->l2.uart.rxbuf);
+				}
 				s->l2.uart.rxptr = s->l2.uart.rxbuf;
 				break;
 		}
@@ -92,12 +97,14 @@ void uart_rxbit(struct demod_state *s, int bit)
 	if (s->l2.uart.rxbitbuf & 1) {
 		if (s->l2.uart.rxptr >= s->l2.uart.rxbuf+sizeof(s->l2.uart.rxbuf)) {
 			s->l2.uart.rxstate = 0;
+			demod_mark_at(s, s->l2.uart.start);
 			disp_packet(s, s->l2.uart.rxbuf, s->l2.uart.rxptr - s->l2.uart.rxbuf);
 			verbprintf(1, "Error: packet size too large\n");
 			return;
 		}
                 if ( !(s->l2.uart.rxbitstream & 1) ) {
 			s->l2.uart.rxstate = 0;
+			demod_mark_at(s, s->l2.uart.char_start);
 			verbprintf(1, "Error: stop bit is 0. Bad framing\n");
 			return;
 		}
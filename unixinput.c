@@ -28,8 +28,11 @@
 /* ---------------------------------------------------------------------- */
 
 #include "multimon.h"
+#include "audiofile.h"
+#include "fmdemod.h"
+#include "deinterleave.h"
+#include "filter.h"
 #include <stdio.h>
-#include <stdarg.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -41,6 +44,7 @@
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include <time.h>
 #include <getopt.h>
 
@@ -76,11 +80,6 @@ static inline int timespec_get(struct timespec *ts, int base)
     return TIME_UTC;
 }
 #endif
-
-/* MinGW doesn't support %F and %T format specifiers for strftime */
-#define ISO8601_FORMAT "%Y-%m-%dT%H:%M:%S"
-#else
-#define ISO8601_FORMAT "%FT%T"
 #endif
 
 #ifdef SUN_AUDIO
@@ -115,6 +114,12 @@ extern void macos_set_quiet(int quiet);
 #include <sys/wait.h>
 #endif
 
+#if !defined(WINDOWS) && !defined(_MSC_VER)
+#include <sys/mman.h>
+#include <stdint.h>
+#define HAVE_MMAP 1
+#endif
+
 /* ---------------------------------------------------------------------- */
 
 static const char *allowed_types[] = {
@@ -122,12 +127,23 @@ static const char *allowed_types[] = {
     "smp", "wav", "maud", "vwe", "mp3", "mp4", "ogg", "flac", NULL
 };
 
+/* Complex baseband, FM demodulated internally */
+static const char *iq_types[] = { "cu8", "cs16", "cf32", NULL };
+
 /* Extension to type mapping (extensions that differ from type name) */
 static const struct { const char *ext; const char *type; } ext_map[] = {
     { "aif", "aiff" },
     { NULL, NULL }
 };
 
+static bool is_iq_type(const char *type)
+{
+    for (const char **t = iq_types; type && *t; t++)
+        if (!strcmp(type, *t))
+            return true;
+    return false;
+}
+
 /* Detect input type from filename extension, returns NULL if unknown */
 static const char *detect_type_from_extension(const char *fname)
 {
@@ -159,6 +175,10 @@ static const char *detect_type_from_extension(const char *fname)
         if (!strcmp(ext_lower, *t))
             return *t;
     }
+    for (const char **t = iq_types; *t; t++) {
+        if (!strcmp(ext_lower, *t))
+            return *t;
+    }
 
     return NULL;
 }
@@ -181,140 +201,298 @@ static int check_sox_available(void)
 #endif
 }
 
-/* ---------------------------------------------------------------------- */
-
-static const struct demod_param *dem[] = { ALL_DEMOD };
-
-#define NUMDEMOD (sizeof(dem)/sizeof(dem[0]))
+/* Exit with a hint to convert by hand if sox is needed but not there */
+static void require_sox(const char *type, const char *fname, unsigned int sample_rate)
+{
+    if (check_sox_available())
+        return;
+    fprintf(stderr, "Error: sox is required for .%s files but was not found.\n", type);
+    fprintf(stderr, "Install sox or convert manually:\n");
+    fprintf(stderr, "  sox -R -t %s '%s' -esigned-integer -b16 -r %u -t raw output.raw\n",
+            type, fname, sample_rate);
+    exit(10);
+}
 
-static struct demod_state dem_st[NUMDEMOD];
-static unsigned int dem_mask[(NUMDEMOD+31)/32];
+/* ---------------------------------------------------------------------- */
 
-#define MASK_SET(n) dem_mask[(n)>>5] |= 1<<((n)&0x1f)
-#define MASK_RESET(n) dem_mask[(n)>>5] &= ~(1<<((n)&0x1f))
-#define MASK_ISSET(n) (dem_mask[(n)>>5] & 1<<((n)&0x1f))
+#define MAX_CHANNELS 256
 
-#define MAX_VAR_ARGS 100
+static unsigned int num_demods;
+static bool *dem_enabled;       /* indexed like multimon_demod_name() */
+static const char **dem_routes; /* -a <demod>@<channels>, on some channels only */
+static unsigned int num_routes;
 
 /* ---------------------------------------------------------------------- */
 
+static struct multimon *mm;
+static struct multimon_config cfg;
+
 static int verbose_level = 0;
 static int repeatable_sox = 1;  /* Always use sox -R for deterministic output */
 static int mute_sox = 0;
 static int type_explicit = 0;   /* Track if -t was explicitly provided */
 static int integer_only = true;
 static bool dont_flush = false;
-static bool is_startline = true;
 static int timestamp = 0;
 static int iso8601 = 0;
-static char *label = NULL;
-int json_mode = 0;
+static int json_mode = 0;
+static int flex_disable_timestamp = 0;
+static int parallel_mode = 0;
+static int async_latency = -1;  /* --async-output bound in ms, -1 writes directly */
+static int no_mmap = 0;
+static unsigned int channels = 1; /* interleaved in raw input */
+static float fm_deviation = 5000; /* Hz at full scale, for IQ input */
+static double fm_freqs[MAX_CHANNELS]; /* --fm-channels, Hz off the centre of the IQ band */
+static unsigned int num_fm_freqs;
+static double center_freq;      /* --center-freq, the frequencies given are absolute */
+static int num_threads = -1;    /* --threads, -1 for one per CPU when channelizing */
+static int bench_mode = 0;      /* --bench, print what every demodulator cost */
+static unsigned int bench_loops = 1; /* --bench-loops, passes over every input file */
 
-extern bool fms_justhex;
+void quit(void);
 
-extern int pocsag_mode;
-extern int pocsag_invert_input;
-extern int pocsag_error_correction;
-extern int pocsag_show_partial_decodes;
-extern int pocsag_heuristic_pruning;
-extern int pocsag_prune_empty;
-extern int pocsag_polarity;
-extern bool pocsag_init_charset(char *charset);
+/* ---------------------------------------------------------------------- */
 
-extern int aprs_mode;
-extern int cw_dit_length;
-extern int cw_gap_length;
-extern int cw_threshold;
-extern bool cw_disable_auto_threshold;
-extern bool cw_disable_auto_timing;
+/* the name may be followed by the channels it runs on, "POCSAG1200@0-3" */
+static int find_demod(const char *name)
+{
+    size_t len = strcspn(name, "@");
 
-extern int flex_disable_timestamp;
+    for (unsigned int i = 0; i < num_demods; i++)
+        if (!strncasecmp(name, multimon_demod_name(i), len) && !multimon_demod_name(i)[len])
+            return i;
+    return -1;
+}
 
-void quit(void);
+static void clear_demods(void)
+{
+    memset(dem_enabled, 0, num_demods * sizeof(dem_enabled[0]));
+    num_routes = 0;
+}
 
-/* ---------------------------------------------------------------------- */
+/* "-200k", "152.5M" or "12500": Hz, with an optional k, M or G */
+static bool parse_hz(const char *str, char **end, double *hz)
+{
+    *hz = strtod(str, end);
+    if (*end == str)
+        return false;
+    switch (**end) {
+    case 'k': case 'K': *hz *= 1e3; (*end)++; break;
+    case 'M': *hz *= 1e6; (*end)++; break;
+    case 'G': *hz *= 1e9; (*end)++; break;
+    }
+    return true;
+}
 
-void _verbprintf(int verb_level, const char *fmt, ...)
+/* "-200k,150k,300k": the channels to cut out of IQ input */
+static bool parse_fm_channels(const char *list)
 {
-	char time_buf[20];
+    char *end;
 
-    if (verb_level > verbose_level)
-        return;
-    va_list args;
-    va_start(args, fmt);
+    num_fm_freqs = 0;
+    for (;;) {
+        if (num_fm_freqs == MAX_CHANNELS || !parse_hz(list, &end, &fm_freqs[num_fm_freqs]))
+            return false;
+        num_fm_freqs++;
+        if (!*end)
+            return true;
+        if (*end != ',')
+            return false;
+        list = end + 1;
+    }
+}
 
-    if (is_startline)
-    {
-        if (label != NULL)
-            fprintf(stdout, "%s: ", label);
-        
-        if (timestamp) {
-            if(iso8601)
-            {
-                struct timespec ts;
-                timespec_get(&ts, TIME_UTC);
-                strftime(time_buf, sizeof time_buf, ISO8601_FORMAT, gmtime(&ts.tv_sec)); //2024-09-13T20:35:30
-                fprintf(stdout, "%s.%06ld: ", time_buf, ts.tv_nsec/1000); //2024-09-13T20:35:30.156337
-            }
-            else
-            {
-                time_t t;
-                struct tm* tm_info;
-                t = time(NULL);
-                tm_info = localtime(&t);
-                strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", tm_info);
-                fprintf(stdout, "%s: ", time_buf);
-            }
-        }
+static unsigned int online_cpus(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0)
+        return n;
+#endif
+    return 1;
+}
 
-        is_startline = false;
+/* Every complete line the decoders print ends up here */
+static void write_output(void *arg, const struct multimon_message *msg)
+{
+    (void)arg;
+#ifdef HAVE_PTHREAD
+    if (outq_running()) {
+        outq_write(msg->text, msg->len);
+        return;
     }
-    if (NULL != strchr(fmt,'\n')) /* detect end of line in stream */
-        is_startline = true;
-
-    vfprintf(stdout, fmt, args);
+    /* with --parallel or --threads the workers print concurrently */
+    flockfile(stdout);
+#endif
+    fwrite(msg->text, 1, msg->len, stdout);
     if(!dont_flush)
         fflush(stdout);
-    va_end(args);
+#ifdef HAVE_PTHREAD
+    funlockfile(stdout);
+#endif
 }
 
 /* ---------------------------------------------------------------------- */
 
-void addJsonTimestamp(cJSON *json_output)
-{
-    if (json_output==NULL) return;
-    if (!timestamp) return;
+/*
+ * With --sample-clock, time stamps are taken from the position in the
+ * sample stream, counting from the time of the first input sample.
+ */
+static int sample_clock = 0;
+static bool clock_started = false;
 
-    char json_temp[100];
-    if(iso8601)
-    {
-        struct timespec ts;
-        timespec_get(&ts, TIME_UTC);
-        strftime(json_temp, sizeof json_temp, ISO8601_FORMAT, gmtime(&ts.tv_sec)); //2024-09-13T20:35:30
-        snprintf(json_temp + strlen(json_temp), sizeof json_temp - strlen(json_temp), ".%06ld", ts.tv_nsec/1000); //2024-09-13T20:35:30.156337
+/* "2024-09-13T20:35:30.5Z" or "@1726259730.5", in UTC */
+static int parse_start_time(const char *str, struct timespec *ts)
+{
+    int y, mon, d, h, min, sec, n = 0;
+    long long secs;
+    long nsec = 0;
+    const char *frac;
+
+    if (str[0] == '@') {
+        if (sscanf(str + 1, "%lld%n", &secs, &n) != 1)
+            return -1;
+    } else {
+        if (sscanf(str, "%4d-%2d-%2d%*1[T ]%2d:%2d:%2d%n", &y, &mon, &d, &h, &min, &sec, &n) != 6 ||
+            mon < 1 || mon > 12 || d < 1 || d > 31 || h > 23 || min > 59 || sec > 60)
+            return -1;
+        /* days since the epoch of the proleptic Gregorian calendar */
+        y -= mon <= 2;
+        long long era = (y >= 0 ? y : y - 399) / 400;
+        long long yoe = y - era * 400;
+        long long doy = (153 * (mon + (mon > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        secs = (era * 146097 + doe - 719468) * 86400 + h * 3600 + min * 60 + sec;
     }
-    else
-    {
-        time_t t;
-        struct tm* tm_info;
-        t = time(NULL);
-        tm_info = localtime(&t);
-        strftime(json_temp, sizeof(json_temp), "%Y-%m-%d %H:%M:%S", tm_info);
+    frac = str + n + (str[0] == '@');
+    if (*frac == '.') {
+        long scale = 100000000L;
+        while (*++frac >= '0' && *frac <= '9') {
+            nsec += (*frac - '0') * scale;
+            scale /= 10;
+        }
     }
-    cJSON_AddStringToObject(json_output, "timestamp", json_temp);
+    if (*frac == 'Z' && str[0] != '@')
+        frac++;
+    if (*frac)
+        return -1;
+    ts->tv_sec = (time_t)secs;
+    ts->tv_nsec = nsec;
+    return 0;
+}
+
+/*
+ * Without --start-time the sample clock starts when the first input was
+ * recorded: as the file says (Broadcast Wave), else its modification time
+ * minus its length. Otherwise the decoders start it when the first
+ * samples arrive.
+ */
+static void start_clock(const char *fname, const struct audio_file *af,
+                        uint64_t frames, unsigned int rate)
+{
+    struct stat statbuf;
+    struct timespec start;
 
+    if (clock_started)
+        return;
+    clock_started = true;
+    if (!sample_clock)
+        return;
+    if (af && audio_start_time(af, &start)) {
+        multimon_set_start_time(mm, &start);
+        return;
+    }
+    if (fname && frames && rate && !stat(fname, &statbuf) && S_ISREG(statbuf.st_mode)) {
+        start.tv_sec = statbuf.st_mtime - (time_t)(frames / rate);
+        start.tv_nsec = 0;
+        if (frames % rate) {
+            start.tv_sec--;
+            start.tv_nsec = 1000000000L - (long)(frames % rate * 1000000000ull / rate);
+        }
+        multimon_set_start_time(mm, &start);
+    }
 }
 
 /* ---------------------------------------------------------------------- */
 
+static unsigned int input_rate = 0;
+
+static void set_input_rate(unsigned int rate)
+{
+    input_rate = rate;
+    multimon_set_input_rate(mm, rate);
+    integer_only = !multimon_float_input(mm);
+}
+
+/*
+ * With --bench-loops, what the first pass over a file hands to the
+ * library is kept here: mono samples (floats too unless the decoders
+ * only take integers), interleaved frames, or the I and Q runs of
+ * --fm-channels input. The other passes are decoded from it, so reading
+ * and converting the file is only paid for once.
+ */
+static struct {
+    short *s;
+    float *f;
+    float *q;
+    size_t len;         /* samples, frames or complex samples */
+    size_t cap;
+    bool on;
+} tape;
+
+static void *tape_grow(void *p, size_t count, size_t size)
+{
+    if (!(p = realloc(p, count * size))) {
+        perror("realloc");
+        exit(10);
+    }
+    return p;
+}
+
+/* n samples, frames of width shorts, or complex samples */
+static void tape_record(const short *s, unsigned int width, const float *f,
+                        const float *q, size_t n)
+{
+    if (!tape.on)
+        return;
+    if (tape.len + n > tape.cap) {
+        tape.cap = (tape.len + n) * 2;
+        if (s)
+            tape.s = tape_grow(tape.s, tape.cap * width, sizeof(tape.s[0]));
+        if (f)
+            tape.f = tape_grow(tape.f, tape.cap, sizeof(tape.f[0]));
+        if (q)
+            tape.q = tape_grow(tape.q, tape.cap, sizeof(tape.q[0]));
+    }
+    if (s)
+        memcpy(tape.s + tape.len * width, s, n * width * sizeof(s[0]));
+    if (f)
+        memcpy(tape.f + tape.len, f, n * sizeof(f[0]));
+    if (q)
+        memcpy(tape.q + tape.len, q, n * sizeof(q[0]));
+    tape.len += n;
+}
+
+/*
+ * Entry point for every input source: len new samples at input_rate, with
+ * the float buffer extending into the overlap.
+ */
 void process_buffer(float *float_buf, short *short_buf, unsigned int len)
 {
-    for (int i = 0; (unsigned int) i <  NUMDEMOD; i++)
-        if (MASK_ISSET(i) && dem[i]->demod)
-        {
-            buffer_t buffer = {short_buf, float_buf};
-            dem[i]->demod(dem_st+i, buffer, len);
-        }
+    clock_started = true;
+    tape_record(short_buf, 1, integer_only ? NULL : float_buf, NULL, len);
+    multimon_process(mm, 0, float_buf, short_buf, len);
+}
+
+/*
+ * Raw input with several channels is handed over a frame at a time, the
+ * library takes the frames apart.
+ */
+static void process_frames(const short *buf, unsigned int frames)
+{
+    clock_started = true;
+    tape_record(buf, channels, NULL, NULL, frames);
+    multimon_push_samples(mm, buf, frames);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -779,18 +957,146 @@ static void input_sound(unsigned int sample_rate, unsigned int overlap,
 
 /* ---------------------------------------------------------------------- */
 
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report_throughput(const char *fname, const char *method,
+                              unsigned long long samples, double start,
+                              unsigned int sample_rate)
+{
+    double secs = now_seconds() - start;
+
+    if (verbose_level < 1)
+        return;
+    if (secs <= 0)
+        secs = 1e-9;
+    fprintf(stderr, "%s: %llu samples in %.3f s via %s, %.2f Msamples/s (%.0fx realtime)\n",
+            fname, samples, secs, method, samples / secs * 1e-6,
+            samples / secs / sample_rate);
+}
+
+/* ---------------------------------------------------------------------- */
+
+#ifdef HAVE_MMAP
+/*
+ * Zero-copy path for raw files: the short samples are taken straight
+ * from the mapping, floats are converted in large chunks and the overlap
+ * needs no copying because it is contiguous in the file already.
+ */
+#define MMAP_CHUNK 65536
+
+static void convert_samples(float *restrict dst, const short *restrict src, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        dst[i] = src[i] * (1.0f/32768.0f);
+}
+
+static int input_file_mmap(int fd, unsigned int overlap, unsigned long long *samples)
+{
+    struct stat statbuf;
+    const short *map;
+    float *fbuf = NULL;
+    size_t total, pos;
+
+    if (fstat(fd, &statbuf) || !S_ISREG(statbuf.st_mode) || statbuf.st_size <= 0 ||
+        (unsigned long long)statbuf.st_size > SIZE_MAX)
+        return 0;
+    map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+        return 0;
+#ifdef MADV_SEQUENTIAL
+    madvise((void *)map, statbuf.st_size, MADV_SEQUENTIAL);
+#endif
+    if (!integer_only && channels == 1 &&
+        !(fbuf = malloc((MMAP_CHUNK + overlap) * sizeof(fbuf[0])))) {
+        munmap((void *)map, statbuf.st_size);
+        return 0;
+    }
+    if (statbuf.st_size % (channels * sizeof(map[0])))
+        fprintf(stderr, "warning: noninteger number of samples read\n");
+
+    if (channels > 1) {
+        total = statbuf.st_size / (channels * sizeof(map[0]));
+        for (pos = 0; pos < total; ) {
+            size_t n = total - pos;
+            if (n > MMAP_CHUNK)
+                n = MMAP_CHUNK;
+            process_frames(map + pos * channels, n);
+            pos += n;
+        }
+        *samples = total;
+        munmap((void *)map, statbuf.st_size);
+        return 1;
+    }
+    total = statbuf.st_size / sizeof(map[0]);
+    for (pos = 0; pos + overlap < total; ) {
+        size_t n = total - overlap - pos;
+        if (n > MMAP_CHUNK)
+            n = MMAP_CHUNK;
+        if (fbuf)
+            convert_samples(fbuf, map + pos, n + overlap);
+        process_buffer(fbuf, (short *)(map + pos), n);
+        pos += n;
+    }
+    *samples = total;
+
+    free(fbuf);
+    munmap((void *)map, statbuf.st_size);
+    return 1;
+}
+#endif
+
+/* Reads interleaved raw frames, a partial frame is kept for the next read */
+static unsigned long long input_frames(int fd)
+{
+    short buffer[8192];
+    size_t have = 0, used;
+    unsigned long long frames = 0;
+    unsigned int n;
+    int i;
+
+    for (;;) {
+        i = read(fd, (char *)buffer + have, sizeof(buffer) - have);
+        if (i < 0 && errno != EAGAIN) {
+            perror("read");
+            exit(4);
+        }
+        if (!i)
+            break;
+        if (i > 0) {
+            have += i;
+            n = have / (channels * sizeof(buffer[0]));
+            process_frames(buffer, n);
+            frames += n;
+            used = n * channels * sizeof(buffer[0]);
+            memmove(buffer, (char *)buffer + used, have - used);
+            have -= used;
+        }
+    }
+    if (have)
+        fprintf(stderr, "warning: noninteger number of samples read\n");
+    return frames;
+}
+
 static void input_file(unsigned int sample_rate, unsigned int overlap,
                        const char *fname, const char *type)
 {
     struct stat statbuf;
     int pipedes[2];
     int pid = 0, soxstat;
-    int fd;
+    int fd = -1;
     int i;
     short buffer[8192];
     float fbuf[16384];
     unsigned int fbuf_cnt = 0;
     short *sp;
+    unsigned long long samples = 0;
+    double start = now_seconds();
+    struct audio_file *af = NULL;
     
     /*
      * if the input type is not raw, sox is started to convert the
@@ -804,6 +1110,7 @@ static void input_file(unsigned int sample_rate, unsigned int overlap,
 #ifdef WINDOWS
         setmode(fd, O_BINARY);
 #endif
+        set_input_rate(sample_rate);
     }
     else if (!type || !strcmp(type, "raw")) {
 #ifdef WINDOWS
@@ -814,6 +1121,21 @@ static void input_file(unsigned int sample_rate, unsigned int overlap,
             perror("open");
             exit(10);
         }
+        set_input_rate(sample_rate);
+        if (!fstat(fd, &statbuf))
+            start_clock(fname, NULL, statbuf.st_size / (channels * sizeof(short)), sample_rate);
+#ifdef HAVE_MMAP
+        if (!no_mmap && input_file_mmap(fd, overlap, &samples)) {
+            close(fd);
+            report_throughput(fname, "mmap", samples, start, input_rate);
+            return;
+        }
+#endif
+    }
+    else if (audio_native_type(type) && (af = audio_open(fname, type))) {
+        /* decoded in-process at the file's own rate, sox is only needed for other formats */
+        set_input_rate(audio_samplerate(af));
+        start_clock(fname, af, audio_frames(af), audio_samplerate(af));
     }
     
 #ifndef ONLY_RAW
@@ -822,6 +1144,9 @@ static void input_file(unsigned int sample_rate, unsigned int overlap,
             perror("stat");
             exit(10);
         }
+        /* also for wav, au and flac files the native reader does not take */
+        require_sox(type, fname, sample_rate);
+        set_input_rate(sample_rate);
         if (pipe(pipedes)) {
             perror("pipe");
             exit(10);
@@ -858,8 +1183,17 @@ static void input_file(unsigned int sample_rate, unsigned int overlap,
     /*
      * demodulate
      */
+    if (channels > 1) {
+        samples = input_frames(fd);
+        close(fd);
+        report_throughput(fname, "read", samples, start, input_rate);
+        return;
+    }
     for (;;) {
-        i = read(fd, sp = buffer, sizeof(buffer));
+        if (af)
+            i = audio_read(af, sp = buffer, sizeof(buffer)/sizeof(buffer[0])) * sizeof(buffer[0]);
+        else
+            i = read(fd, sp = buffer, sizeof(buffer));
         if (i < 0 && errno != EAGAIN) {
             perror("read");
             exit(4);
@@ -867,6 +1201,7 @@ static void input_file(unsigned int sample_rate, unsigned int overlap,
         if (!i)
             break;
         if (i > 0) {
+            samples += i/sizeof(buffer[0]);
             if(integer_only)
         {
                 fbuf_cnt = i/sizeof(buffer[0]);
@@ -885,22 +1220,235 @@ static void input_file(unsigned int sample_rate, unsigned int overlap,
             }
         }
     }
+    if (af) {
+        audio_close(af);
+        report_throughput(fname, "native decoder", samples, start, input_rate);
+        return;
+    }
     close(fd);
     
 #ifndef ONLY_RAW
     waitpid(pid, &soxstat, 0);
 #endif
+    report_throughput(fname, "read", samples, start, input_rate);
+}
+
+/* ---------------------------------------------------------------------- */
+
+/*
+ * Complex baseband input: cu8 as written by rtl_sdr, cs16 and cf32 in
+ * platform-native byte order, at iq_rate. The discriminator decimates
+ * straight to the demodulators' rate, so the library gets audio that
+ * needs no further resampling. With --fm-channels the library takes the
+ * complex samples itself and cuts the channels out of them.
+ */
+#define IQ_CHUNK 8192
+
+static void convert_iq(const char *type, const void *raw, unsigned int n,
+                       float *restrict i, float *restrict q)
+{
+    if (!strcmp(type, "cu8")) {
+        const unsigned char *p = raw;
+        for (unsigned int k = 0; k < n; k++) {
+            i[k] = (p[2*k] - 127.5f) * (1.0f/128.0f);
+            q[k] = (p[2*k+1] - 127.5f) * (1.0f/128.0f);
+        }
+    } else if (!strcmp(type, "cs16")) {
+        const short *p = raw;
+        for (unsigned int k = 0; k < n; k++) {
+            i[k] = p[2*k] * (1.0f/32768.0f);
+            q[k] = p[2*k+1] * (1.0f/32768.0f);
+        }
+    } else {
+        float *out[2] = { i, q };
+        deinterleave_f32(out, raw, 2, n);
+    }
+}
+
+static void input_iq(unsigned int iq_rate, unsigned int overlap,
+                     const char *fname, const char *type)
+{
+    static union { unsigned char u8[IQ_CHUNK * 8]; float f32[IQ_CHUNK * 2]; } raw;
+    static float ibuf[IQ_CHUNK], qbuf[IQ_CHUNK];
+    static float fbuf[16384];
+    static short sbuf[16384];
+    unsigned int size = !strcmp(type, "cu8") ? 2 : !strcmp(type, "cs16") ? 4 : 8;
+    unsigned int rate = multimon_samplerate(mm);
+    unsigned int fbuf_cnt = 0, n, got;
+    unsigned long long samples = 0;
+    size_t have = 0, used;
+    double start = now_seconds();
+    struct fm_demod *fm = NULL;
+    struct stat statbuf;
+    int fd, i;
+
+    if (!strcmp(fname, "-")) {
+        fd = 0;
+#ifdef WINDOWS
+        setmode(fd, O_BINARY);
+#endif
+    }
+#ifdef WINDOWS
+    else if ((fd = open(fname, O_RDONLY | O_BINARY)) < 0) {
+#else
+    else if ((fd = open(fname, O_RDONLY)) < 0) {
+#endif
+        perror("open");
+        exit(10);
+    }
+    if (!num_fm_freqs) {
+        if (!(fm = fm_demod_new(iq_rate, rate, fm_deviation))) {
+            fprintf(stderr, "%s: cannot FM demodulate %u Hz IQ to %u Hz at %.0f Hz deviation\n",
+                    fname, iq_rate, rate, fm_deviation);
+            exit(10);
+        }
+        set_input_rate(rate);
+    }
+    if (fd && !fstat(fd, &statbuf))
+        start_clock(fname, NULL, statbuf.st_size / size, iq_rate);
+    if (verbose_level >= 1 && fm)
+        fprintf(stderr, "%s: FM demodulating %s at %u Hz to %u Hz, %.0f Hz deviation\n",
+                fname, type, iq_rate, rate, fm_deviation);
+    else if (verbose_level >= 1)
+        fprintf(stderr, "%s: cutting %u FM channels out of %s at %u Hz, %.0f Hz deviation\n",
+                fname, num_fm_freqs, type, iq_rate, fm_deviation);
+
+    for (;;) {
+        i = read(fd, raw.u8 + have, IQ_CHUNK * size - have);
+        if (i < 0 && errno != EAGAIN) {
+            perror("read");
+            exit(4);
+        }
+        if (!i)
+            break;
+        if (i <= 0)
+            continue;
+        have += i;
+        n = have / size;
+        convert_iq(type, raw.u8, n, ibuf, qbuf);
+        samples += n;
+        used = (size_t)n * size;
+        memmove(raw.u8, raw.u8 + used, have - used);
+        have -= used;
+        if (!fm) {
+            tape_record(NULL, 0, ibuf, qbuf, n);
+            multimon_push_iq(mm, ibuf, qbuf, n);
+            continue;
+        }
+        fm_demod_write(fm, ibuf, qbuf, n);
+
+        while ((got = fm_demod_read(fm, fbuf + fbuf_cnt,
+                                    sizeof(fbuf)/sizeof(fbuf[0]) - fbuf_cnt))) {
+            for (unsigned int k = fbuf_cnt; k < fbuf_cnt + got; k++) {
+                float v = fbuf[k] * 32768.0f;
+                sbuf[k] = v >= 32767.0f ? 32767 : v <= -32768.0f ? -32768 : (short)lrintf(v);
+            }
+            fbuf_cnt += got;
+            if (fbuf_cnt > overlap) {
+                process_buffer(fbuf, sbuf, fbuf_cnt - overlap);
+                memmove(fbuf, fbuf + fbuf_cnt - overlap, overlap * sizeof(fbuf[0]));
+                memmove(sbuf, sbuf + fbuf_cnt - overlap, overlap * sizeof(sbuf[0]));
+                fbuf_cnt = overlap;
+            }
+        }
+    }
+    if (have)
+        fprintf(stderr, "warning: noninteger number of samples read\n");
+    fm_demod_free(fm);
+    if (fd)
+        close(fd);
+    report_throughput(fname, num_fm_freqs ? "channelizer" : "FM discriminator", samples, start, iq_rate);
+}
+
+/* ---------------------------------------------------------------------- */
+
+#define TAPE_CHUNK 65536
+
+/* The passes of --bench-loops after the first, from what it recorded */
+static void replay_tape(const char *fname, unsigned int overlap, unsigned int rate)
+{
+    size_t pos, n;
+
+    for (unsigned int pass = 1; pass < bench_loops && tape.len; pass++) {
+        double start = now_seconds();
+
+        if (tape.q) {
+            for (pos = 0; pos < tape.len; pos += n) {
+                n = tape.len - pos < TAPE_CHUNK ? tape.len - pos : TAPE_CHUNK;
+                multimon_push_iq(mm, tape.f + pos, tape.q + pos, n);
+            }
+        } else if (channels > 1) {
+            for (pos = 0; pos < tape.len; pos += n) {
+                n = tape.len - pos < TAPE_CHUNK ? tape.len - pos : TAPE_CHUNK;
+                multimon_push_samples(mm, tape.s + pos * channels, n);
+            }
+        } else {
+            /* the floats of the overlap are the samples that follow */
+            for (pos = 0; pos + overlap < tape.len; pos += n) {
+                n = tape.len - overlap - pos < TAPE_CHUNK ? tape.len - overlap - pos : TAPE_CHUNK;
+                multimon_process(mm, 0, tape.f ? tape.f + pos : NULL, tape.s + pos, n);
+            }
+        }
+        report_throughput(fname, "memory", tape.len, start, rate);
+    }
+    free(tape.s);
+    free(tape.f);
+    free(tape.q);
+    memset(&tape, 0, sizeof(tape));
+}
+
+static double bench_start;
+
+/* --bench: the cost of every demodulator instance, and of all of them */
+static void print_bench(void)
+{
+    unsigned int n = multimon_profile(mm, NULL, 0);
+    struct multimon_profile *prof = calloc(n ? n : 1, sizeof(prof[0]));
+    double input = 0, cpu = 0, wall = now_seconds() - bench_start;
+
+    if (!prof) {
+        perror("calloc");
+        exit(10);
+    }
+    multimon_profile(mm, prof, n);
+    fprintf(stderr, "%-12s %4s %7s %10s %12s %10s %11s\n",
+            "demod", "ch", "rate", "calls", "samples", "ns/sample", "x realtime");
+    for (unsigned int k = 0; k < n; k++) {
+        double secs = (double)prof[k].samples / prof[k].samplerate;
+
+        if (secs > input)
+            input = secs;
+        cpu += prof[k].ns * 1e-9;
+        fprintf(stderr, "%-12s %4u %7u %10llu %12llu ", prof[k].demod, prof[k].channel,
+                prof[k].samplerate, (unsigned long long)prof[k].calls,
+                (unsigned long long)prof[k].samples);
+        if (prof[k].samples && prof[k].ns)
+            fprintf(stderr, "%10.1f %11.0f\n", (double)prof[k].ns / prof[k].samples,
+                    secs / (prof[k].ns * 1e-9));
+        else
+            fprintf(stderr, "%10s %11s\n", "-", "-");
+    }
+    fprintf(stderr, "%.3f s of input: %.3f s in the demodulators (%.0fx realtime), "
+            "%.3f s wall clock (%.0fx realtime)\n", input, cpu,
+            cpu > 0 ? input / cpu : 0, wall, wall > 0 ? input / wall : 0);
+    free(prof);
 }
 
 void quit(void)
 {
-    int i = 0;
-    for (i = 0; (unsigned int) i < NUMDEMOD; i++)
-    {
-        if(MASK_ISSET(i))
-            if (dem[i]->deinit)
-                dem[i]->deinit(dem_st+i);
+    if (bench_mode && mm) {
+        multimon_finish(mm);
+        print_bench();
     }
+    multimon_destroy(mm);
+    mm = NULL;
+#ifdef HAVE_PTHREAD
+    if (outq_running()) {
+        unsigned long dropped = outq_stop();
+        if (dropped)
+            fprintf(stderr, "Output queue full, dropped %lu lines\n", dropped);
+    }
+#endif
 }
 
 /* ---------------------------------------------------------------------- */
@@ -910,17 +1458,22 @@ static const char usage_str[] = "\n"
         "  If no [file] is given, input will be read from your default sound\n"
         "  hardware. A filename of \"-\" denotes standard input.\n"
         "  -t <type>    : Input file type (auto-detected from extension if not specified)\n"
-        "                 Types other than raw require sox. Supported: hw (hardware input),\n"
+        "                 raw, wav, au and flac are read natively, other types require sox.\n"
+        "                 Supported: hw (hardware input),\n"
 #ifdef HAS_PROCESSTAP
         "                 system (capture system audio output, macOS 14.2+),\n"
 #endif
         "                 raw, wav, flac, mp3, ogg, aiff, au, etc.\n"
-        "  -a <demod>   : Add demodulator\n"
+        "                 cu8, cs16 and cf32 are complex baseband (IQ) samples that are\n"
+        "                 FM demodulated internally, see --input-rate and --fm-deviation.\n"
+        "  -a <demod>   : Add demodulator. With --channels, <demod>@<channels> runs\n"
+        "                 it on the channels listed only (e.g. POCSAG1200@0-3,6).\n"
         "  -s <demod>   : Subtract demodulator\n"
         "  -c           : Remove all demodulators (must be added with -a <demod>)\n"
         "  -q           : Quiet\n"
         "  -v <level>   : Level of verbosity (e.g. '-v 3')\n"
         "                 For POCSAG and MORSE_CW '-v1' prints decoding statistics.\n"
+        "                 For file input '-v1' reports the input throughput on stderr.\n"
         "  -h           : This help\n"
         "  -A           : APRS mode (TNC2 text output)\n"
         "  -m           : Mute SoX warnings\n"
@@ -944,14 +1497,47 @@ static const char usage_str[] = "\n"
         "  -y           : CW: Disable auto timing detection\n"
         "  --timestamp  : Add a time stamp in front of every printed line\n"
         "  --iso8601    : Use UTC timestamp in ISO 8601 format that includes microseconds\n"
+        "  --sample-clock : Take time stamps from the position in the input instead of\n"
+        "                 the system clock. The input starts at the time recorded in a\n"
+        "                 Broadcast Wave file, else at the file's modification time minus\n"
+        "                 its length, else when multimon-ng starts.\n"
+        "  --start-time <time> : Sample clock starting at <time> (UTC), given as\n"
+        "                 2024-09-13T20:35:30.5Z or as seconds since 1970 like @1726259730.5\n"
         "  --label      : Add a label to the front of every printed line\n"
         "  --flex-no-ts : FLEX: Do not add a timestamp to the FLEX demodulator output\n"
         "  --json       : Format output as JSON. Supported by the following demodulators:\n"
         "                 DTMF, EAS, FLEX, POCSAG. (Other demodulators will silently ignore this flag.)\n"
+        "  --parallel   : Run every enabled demodulator on its own worker thread\n"
+        "  --async-output <ms> : Write output from a separate thread, at most <ms>\n"
+        "                 milliseconds after a line is complete. Lines that do not\n"
+        "                 fit into the queue are dropped instead of stalling the decoders.\n"
+        "  --no-mmap    : Read raw files with read() instead of memory-mapping them\n"
+        "  --input-rate <hz> : Sampling rate of raw, piped and hardware input\n"
+        "                 (default: the demodulators' rate, usually 22050 Hz), and of\n"
+        "                 IQ input, where it is required\n"
+        "  --fm-deviation <hz> : IQ input: FM deviation that is demodulated to full\n"
+        "                 scale (default: 5000)\n"
+        "  --channels <n> : Raw input interleaves <n> channels. Every demodulator\n"
+        "                 runs on each of them (or on those given with -a <demod>@<channels>),\n"
+        "                 and lines are tagged with the channel.\n"
+        "  --fm-channels <f1,f2,...> : IQ input: cut FM channels at these offsets from\n"
+        "                 the centre of the band out of it (e.g. -200k,150k,1.2M) and run the\n"
+        "                 demodulators on each, as channels 0, 1, ... of --channels\n"
+        "  --center-freq <hz> : The --fm-channels frequencies are absolute, the IQ\n"
+        "                 input is centred on <hz>\n"
+        "  --threads <n> : Demodulate the channels on <n> threads (default: one per\n"
+        "                 CPU with --fm-channels, else 1)\n"
+        "  --bench      : Time every demodulator and print what each cost per sample,\n"
+        "                 and how many times faster than real time it runs, at the end\n"
+        "  --bench-loops <n> : --bench, decoding every input file <n> times: once\n"
+        "                 from the file and then from memory\n"
         "\n"
-        "   Raw input requires one channel, 16 bit, signed integer (platform-native)\n"
-        "   samples at the demodulator's input sampling rate, which is\n"
-        "   usually 22050 Hz. Raw input is assumed and required if piped input is used.\n";
+        "   Raw input requires one channel (or those given with --channels),\n"
+        "   16 bit, signed integer (platform-native) samples at the demodulator's\n"
+        "   input sampling rate, which is usually 22050 Hz, or at the rate given\n"
+        "   with --input-rate. Input at other rates is resampled internally, once\n"
+        "   for each distinct demodulator rate.\n"
+        "   Raw input is assumed and required if piped input is used.\n";
 
 int main(int argc, char *argv[])
 {
@@ -962,7 +1548,12 @@ int main(int argc, char *argv[])
     char **itype;
     int mask_first = 1;
     int sample_rate = -1;
+    int iq_rate;
     unsigned int overlap = 0;
+    const char *charset = NULL;
+    struct timespec start_time;
+    const char **names;
+    unsigned int nnames = 0;
 #ifdef HAS_PROCESSTAP
     char *input_type = "system";  /* Default to system audio capture on macOS */
 #else
@@ -978,9 +1569,31 @@ int main(int argc, char *argv[])
         {"charset", required_argument, NULL, 'C'},
         {"json", no_argument, &json_mode, 1},
         {"pocsag-polarity", required_argument, NULL, 'P'},
+        {"parallel", no_argument, &parallel_mode, 1},
+        {"no-mmap", no_argument, &no_mmap, 1},
+        {"input-rate", required_argument, NULL, 'R'},
+        {"async-output", required_argument, NULL, 'W'},
+        {"sample-clock", no_argument, &sample_clock, 1},
+        {"start-time", required_argument, NULL, 'S'},
+        {"channels", required_argument, NULL, 'N'},
+        {"fm-deviation", required_argument, NULL, 'D'},
+        {"fm-channels", required_argument, NULL, 'F'},
+        {"center-freq", required_argument, NULL, 'K'},
+        {"threads", required_argument, NULL, 'T'},
+        {"bench", no_argument, &bench_mode, 1},
+        {"bench-loops", required_argument, NULL, 'B'},
         {0, 0, 0, 0}
       };
 
+    num_demods = multimon_demod_count();
+    if (!(dem_enabled = calloc(num_demods, sizeof(dem_enabled[0]))) ||
+        !(dem_routes = calloc(argc, sizeof(dem_routes[0]))) ||
+        !(names = calloc(num_demods + argc + 1, sizeof(names[0])))) {
+        perror("calloc");
+        exit(10);
+    }
+    multimon_config_init(&cfg);
+
     while ((c = getopt_long(argc, argv, "t:a:s:v:f:b:C:o:d:g:P:cqhAmrnjeuipxy", long_options, NULL)) != EOF) {
         switch (c) {
         case 'h':
@@ -993,14 +1606,11 @@ int main(int argc, char *argv[])
             break;
             
         case 'A':
-            aprs_mode = 1;
-            memset(dem_mask, 0, sizeof(dem_mask));
+            cfg.aprs_mode = true;
+            clear_demods();
             mask_first = 0;
-            for (i = 0; (unsigned int) i < NUMDEMOD; i++)
-                if (!strcasecmp("AFSK1200", dem[i]->name)) {
-                    MASK_SET(i);
-                    break;
-                }
+            if ((i = find_demod("AFSK1200")) >= 0)
+                dem_enabled[i] = true;
             break;
             
         case 'v':
@@ -1008,33 +1618,33 @@ int main(int argc, char *argv[])
             break;
 
         case 'b':
-            pocsag_error_correction = strtoul(optarg, 0, 0);
-            if(pocsag_error_correction > 2 || pocsag_error_correction < 0)
+            cfg.pocsag_error_correction = strtoul(optarg, 0, 0);
+            if(cfg.pocsag_error_correction > 2 || cfg.pocsag_error_correction < 0)
             {
                 fprintf(stderr, "Invalid error correction value!\n");
-                pocsag_error_correction = 2;
+                cfg.pocsag_error_correction = 2;
             }
             break;
 
         case'p':
-            pocsag_show_partial_decodes = 1;
+            cfg.pocsag_show_partial = true;
             break;
 
         case'u':
-            pocsag_heuristic_pruning = 1;
+            cfg.pocsag_heuristic_pruning = true;
             break;
 
         case'e':
-            pocsag_prune_empty = 1;
+            cfg.pocsag_prune_empty = true;
             break;
 
         case 'P':
             if (!strcmp(optarg, "auto") || !strcmp(optarg, "0"))
-                pocsag_polarity = 0;
+                cfg.pocsag_polarity = 0;
             else if (!strcmp(optarg, "normal") || !strcmp(optarg, "1"))
-                pocsag_polarity = 1;
+                cfg.pocsag_polarity = 1;
             else if (!strcmp(optarg, "inverted") || !strcmp(optarg, "2"))
-                pocsag_polarity = 2;
+                cfg.pocsag_polarity = 2;
             else {
                 fprintf(stderr, "Invalid POCSAG polarity: %s (use auto/normal/inverted)\n", optarg);
                 errflg++;
@@ -1046,7 +1656,7 @@ int main(int argc, char *argv[])
             break;
 
         case 'j':
-            fms_justhex = true;
+            cfg.fms_justhex = true;
             break;
             
         case 'r':
@@ -1072,6 +1682,11 @@ int main(int argc, char *argv[])
                     input_type = *itype;
                     goto intypefound;
                 }
+            for (itype = (char **)iq_types; *itype; itype++)
+                if (!strcmp(*itype, optarg)) {
+                    input_type = *itype;
+                    goto intypefound;
+                }
             fprintf(stderr, "invalid input type \"%s\"\n"
                     "allowed types: hw ", optarg);
 #ifdef HAS_PROCESSTAP
@@ -1079,6 +1694,8 @@ int main(int argc, char *argv[])
 #endif
             for (itype = (char **)allowed_types; *itype; itype++)
                 fprintf(stderr, "%s ", *itype);
+            for (itype = (char **)iq_types; *itype; itype++)
+                fprintf(stderr, "%s ", *itype);
             fprintf(stderr, "\n");
             errflg++;
 intypefound:
@@ -1086,14 +1703,15 @@ intypefound:
             
         case 'a':
             if (mask_first)
-                memset(dem_mask, 0, sizeof(dem_mask));
+                clear_demods();
             mask_first = 0;
-            for (i = 0; (unsigned int) i < NUMDEMOD; i++)
-                if (!strcasecmp(optarg, dem[i]->name)) {
-                    MASK_SET(i);
-                    break;
-                }
-            if ((unsigned int) i >= NUMDEMOD) {
+            if ((i = find_demod(optarg)) >= 0) {
+                if (strchr(optarg, '@'))
+                    dem_routes[num_routes++] = optarg;
+                else
+                    dem_enabled[i] = true;
+            }
+            else {
                 fprintf(stderr, "invalid mode \"%s\"\n", optarg);
                 errflg++;
             }
@@ -1101,44 +1719,46 @@ intypefound:
             
         case 's':
             if (mask_first)
-                memset(dem_mask, 0xff, sizeof(dem_mask));
+                for (i = 0; (unsigned int) i < num_demods; i++)
+                    dem_enabled[i] = true;
             mask_first = 0;
-            for (i = 0; (unsigned int) i < NUMDEMOD; i++)
-                if (!strcasecmp(optarg, dem[i]->name)) {
-                    MASK_RESET(i);
-                    break;
-                }
-            if ((unsigned int) i >= NUMDEMOD) {
+            if ((i = find_demod(optarg)) >= 0) {
+                unsigned int kept = 0;
+                dem_enabled[i] = false;
+                for (unsigned int r = 0; r < num_routes; r++)
+                    if (find_demod(dem_routes[r]) != i)
+                        dem_routes[kept++] = dem_routes[r];
+                num_routes = kept;
+            }
+            else {
                 fprintf(stderr, "invalid mode \"%s\"\n", optarg);
                 errflg++;
             }
             break;
             
         case 'c':
-            if (mask_first)
-                memset(dem_mask, 0xff, sizeof(dem_mask));
             mask_first = 0;
-            for (i = 0; (unsigned int) i < NUMDEMOD; i++)
-                MASK_RESET(i);
+            clear_demods();
             break;
             
         case 'f':
-            if(!pocsag_mode)
+            if(!cfg.pocsag_mode)
             {
                 if(!strncmp("numeric",optarg, sizeof("numeric")))
-                    pocsag_mode = POCSAG_MODE_NUMERIC;
+                    cfg.pocsag_mode = POCSAG_MODE_NUMERIC;
                 else if(!strncmp("alpha",optarg, sizeof("alpha")))
-                    pocsag_mode = POCSAG_MODE_ALPHA;
+                    cfg.pocsag_mode = POCSAG_MODE_ALPHA;
                 else if(!strncmp("skyper",optarg, sizeof("skyper")))
-                    pocsag_mode = POCSAG_MODE_SKYPER;
+                    cfg.pocsag_mode = POCSAG_MODE_SKYPER;
                 else if(!strncmp("auto",optarg, sizeof("auto")))
-                    pocsag_mode = POCSAG_MODE_AUTO;
+                    cfg.pocsag_mode = POCSAG_MODE_AUTO;
             }else fprintf(stderr, "a POCSAG mode has already been selected!\n");
             break;
             
         case 'C':
-    		if (!pocsag_init_charset(optarg))
+    		if (!pocsag_init_charset(optarg, NULL))
     			errflg++;
+    		charset = optarg;
         	break;
         	
         case 'n':
@@ -1154,7 +1774,7 @@ intypefound:
         {
             int i = 0;
             sscanf(optarg, "%d", &i);
-            if(i) cw_dit_length = abs(i);
+            if(i) cfg.cw_dit_length = abs(i);
             break;
         }
             
@@ -1162,7 +1782,7 @@ intypefound:
         {
             int i = 0;
             sscanf(optarg, "%d", &i);
-            if(i) cw_gap_length = abs(i);
+            if(i) cfg.cw_gap_length = abs(i);
             break;
         }
             
@@ -1170,21 +1790,116 @@ intypefound:
         {
             int i = 0;
             sscanf(optarg, "%d", &i);
-            if(i) cw_threshold = abs(i);
+            if(i) cfg.cw_threshold = abs(i);
             break;
         }
             
         case 'x':
-            cw_disable_auto_threshold = true;
+            cfg.cw_disable_auto_threshold = true;
             break;
             
         case 'y':
-            cw_disable_auto_timing = true;
+            cfg.cw_disable_auto_timing = true;
             break;
             
 	case 'l':
-	    label = optarg;
+	    cfg.label = optarg;
 	    break;
+
+        case 'R':
+            sample_rate = strtol(optarg, 0, 0);
+            if (sample_rate <= 0) {
+                fprintf(stderr, "Invalid input rate: %s\n", optarg);
+                errflg++;
+            }
+            break;
+
+        case 'W':
+        {
+            char *end;
+            async_latency = strtol(optarg, &end, 0);
+            if (*end || async_latency < 0) {
+                fprintf(stderr, "Invalid output latency: %s\n", optarg);
+                errflg++;
+            }
+            break;
+        }
+
+        case 'N':
+        {
+            char *end;
+            long n = strtol(optarg, &end, 0);
+            if (*end || n < 1 || n > MAX_CHANNELS) {
+                fprintf(stderr, "Invalid number of channels: %s (1 to %d)\n", optarg, MAX_CHANNELS);
+                errflg++;
+            }
+            else
+                channels = n;
+            break;
+        }
+
+        case 'D':
+        {
+            char *end;
+            fm_deviation = strtof(optarg, &end);
+            if (*end || !(fm_deviation > 0)) {
+                fprintf(stderr, "Invalid FM deviation: %s\n", optarg);
+                errflg++;
+            }
+            break;
+        }
+
+        case 'F':
+            if (!parse_fm_channels(optarg)) {
+                fprintf(stderr, "Invalid FM channels: %s (up to %d frequencies in Hz)\n",
+                        optarg, MAX_CHANNELS);
+                errflg++;
+            }
+            break;
+
+        case 'K':
+        {
+            char *end;
+            if (!parse_hz(optarg, &end, &center_freq) || *end) {
+                fprintf(stderr, "Invalid center frequency: %s\n", optarg);
+                errflg++;
+            }
+            break;
+        }
+
+        case 'T':
+        {
+            char *end;
+            num_threads = strtol(optarg, &end, 0);
+            if (*end || num_threads < 1 || num_threads > MAX_CHANNELS) {
+                fprintf(stderr, "Invalid number of threads: %s (1 to %d)\n", optarg, MAX_CHANNELS);
+                errflg++;
+            }
+            break;
+        }
+
+        case 'B':
+        {
+            char *end;
+            long n = strtol(optarg, &end, 0);
+            if (*end || n < 1) {
+                fprintf(stderr, "Invalid number of benchmark passes: %s\n", optarg);
+                errflg++;
+            }
+            else
+                bench_loops = n;
+            bench_mode = 1;
+            break;
+        }
+
+        case 'S':
+            if (parse_start_time(optarg, &start_time)) {
+                fprintf(stderr, "Invalid start time: %s\n", optarg);
+                errflg++;
+            }
+            sample_clock = 1;
+            clock_started = true;
+            break;
         }
     }
 
@@ -1195,8 +1910,8 @@ intypefound:
             "  (C) 1996/1997 by Tom Sailer HB9JNX/AE4WA\n"
             "  (C) 2012-2026 by Elias Oenal\n"
             "Available demodulators:");
-        for (i = 0; (unsigned int) i < NUMDEMOD; i++) {
-            fprintf(stderr, " %s", dem[i]->name);
+        for (i = 0; (unsigned int) i < num_demods; i++) {
+            fprintf(stderr, " %s", multimon_demod_name(i));
         }
         fprintf(stderr, "\n");
     }
@@ -1205,37 +1920,87 @@ intypefound:
         (void)fprintf(stderr, usage_str, argv[0]);
         exit(2);
     }
+    if (num_fm_freqs) {
+        if (channels > 1) {
+            fprintf(stderr, "Error: --fm-channels sets the channels, it does not go with --channels.\n");
+            exit(2);
+        }
+        if (sample_rate == -1) {
+            fprintf(stderr, "Error: --fm-channels needs the sampling rate of the IQ input, give --input-rate.\n");
+            exit(2);
+        }
+        for (unsigned int f = 0; f < num_fm_freqs; f++)
+            fm_freqs[f] -= center_freq;
+    }
     if (mask_first)
-        memset(dem_mask, 0xff, sizeof(dem_mask));
+        for (i = 0; (unsigned int) i < num_demods; i++)
+            dem_enabled[i] = true;
     
+    /* pick the correlator kernel before any demodulator runs */
+    mac_select(NULL);
+    if (verbose_level >= 2)
+        fprintf(stderr, "Using %s correlator kernel\n", mac_selected());
+
     if (!quietflg && !json_mode)
         fprintf(stdout, "Enabled demodulators:");
-    for (i = 0; (unsigned int) i < NUMDEMOD; i++)
-        if (MASK_ISSET(i)) {
+    for (i = 0; (unsigned int) i < num_demods; i++)
+        if (dem_enabled[i]) {
             if (!quietflg && !json_mode)
-                fprintf(stdout, " %s", dem[i]->name);       //Print demod name
-            if(dem[i]->float_samples) integer_only = false; //Enable float samples on demand
-            memset(dem_st+i, 0, sizeof(dem_st[i]));
-            dem_st[i].dem_par = dem[i];
-            if (dem[i]->init)
-                dem[i]->init(dem_st+i);
-            if (sample_rate == -1)
-                sample_rate = dem[i]->samplerate;
-            else if ( (unsigned int) sample_rate != dem[i]->samplerate) {
-                if (!quietflg && !json_mode)
-                    fprintf(stdout, "\n");
-                fprintf(stderr, "Error: Current sampling rate %d, "
-                        " demodulator \"%s\" requires %d\n",
-                        sample_rate, dem[i]->name, dem[i]->samplerate);
-                exit(3);
-            }
-            if (dem[i]->overlap > overlap)
-                overlap = dem[i]->overlap;
+                fprintf(stdout, " %s", multimon_demod_name(i));       //Print demod name
+            names[nnames++] = multimon_demod_name(i);
         }
+    for (unsigned int r = 0; r < num_routes; r++) {
+        if (!quietflg && !json_mode)
+            fprintf(stdout, " %s", dem_routes[r]);
+        names[nnames++] = dem_routes[r];
+    }
     if (!quietflg && !json_mode)
         fprintf(stdout, "\n");
+
+    cfg.demods = names;
+    cfg.output = write_output;
+    cfg.verbose = verbose_level;
+    cfg.json = json_mode;
+    cfg.timestamp = timestamp;
+    cfg.iso8601 = iso8601;
+    cfg.sample_clock = sample_clock;
+    cfg.parallel = parallel_mode;
+    cfg.pocsag_charset = charset;
+    cfg.flex_disable_timestamp = flex_disable_timestamp;
+    cfg.channels = channels;
+    if (num_fm_freqs) {
+        cfg.channels = num_fm_freqs;
+        cfg.channel_freqs = fm_freqs;
+        cfg.iq_rate = sample_rate;
+        cfg.fm_deviation = fm_deviation;
+    }
+    cfg.profile = bench_mode;
+    cfg.threads = num_threads > 0 ? (unsigned int)num_threads : num_fm_freqs ? online_cpus() : 1;
+    if (parallel_mode || cfg.threads > 1)
+        fflush(stdout);
+    if (!(mm = multimon_create(&cfg)))
+        exit(10);
+
+    /* a ring for the main thread and every thread the context starts */
+    if (async_latency >= 0) {
+#ifdef HAVE_PTHREAD
+        if (outq_start(multimon_threads(mm), async_latency))
+            exit(10);
+#else
+        fprintf(stderr, "Warning: --async-output is not supported by this build, writing directly.\n");
+#endif
+    }
+    if (sample_clock && clock_started)
+        multimon_set_start_time(mm, &start_time);
+    integer_only = !multimon_float_input(mm);
+    overlap = multimon_overlap(mm);
+
+    /* raw and hardware input run at the (highest) demodulator rate unless told otherwise */
+    iq_rate = sample_rate;
+    if (sample_rate == -1)
+        sample_rate = multimon_samplerate(mm);
     
-    if (optind < argc && !strcmp(argv[optind], "-"))
+    if (optind < argc && !strcmp(argv[optind], "-") && !is_iq_type(input_type))
     {
         input_type = "raw";
         type_explicit = 1;  /* stdin requires explicit raw */
@@ -1254,16 +2019,40 @@ intypefound:
         }
     }
     
+    if (num_fm_freqs && input_type && (!strcmp(input_type, "hw") || !strcmp(input_type, "system"))) {
+        fprintf(stderr, "Error: --fm-channels needs IQ input (cu8, cs16 or cf32).\n");
+        exit(2);
+    }
+    if (bench_loops > 1 && input_type && (!strcmp(input_type, "hw") || !strcmp(input_type, "system"))) {
+        fprintf(stderr, "Error: --bench-loops needs file input.\n");
+        exit(2);
+    }
+    bench_start = now_seconds();
+
 #ifdef HAS_PROCESSTAP
     if (input_type && !strcmp(input_type, "system")) {
         macos_set_quiet(quietflg);
+        set_input_rate(sample_rate);
         input_system_audio(sample_rate, overlap);
         quit();
         exit(0);
     }
 #endif
     
+    if (channels > 1 && (!input_type || strcmp(input_type, "raw"))) {
+        for (i = optind; i < argc && !input_type; i++) {
+            const char *detected = detect_type_from_extension(argv[i]);
+            if (detected && strcmp(detected, "raw"))
+                break;
+        }
+        if (input_type || i < argc) {
+            fprintf(stderr, "Error: --channels needs raw input.\n");
+            exit(2);
+        }
+    }
+
     if (input_type && !strcmp(input_type, "hw")) {
+        set_input_rate(sample_rate);
         if ((argc - optind) >= 1)
             input_sound(sample_rate, overlap, argv[optind]);
         else
@@ -1296,16 +2085,29 @@ intypefound:
             }
         }
         
-        /* Check sox availability for non-raw types */
-        if (strcmp(file_type, "raw") != 0 && !check_sox_available()) {
-            fprintf(stderr, "Error: sox is required for .%s files but was not found.\n", file_type);
-            fprintf(stderr, "Install sox or convert manually:\n");
-            fprintf(stderr, "  sox -R -t %s '%s' -esigned-integer -b16 -r %d -t raw output.raw\n",
-                    file_type, argv[i], sample_rate);
-            exit(10);
+        if (num_fm_freqs && !is_iq_type(file_type)) {
+            fprintf(stderr, "Error: --fm-channels needs IQ input (cu8, cs16 or cf32), %s is %s.\n",
+                    argv[i], file_type);
+            exit(2);
+        }
+        if (is_iq_type(file_type)) {
+            if (iq_rate == -1) {
+                fprintf(stderr, "Error: %s input needs its sampling rate, give --input-rate.\n", file_type);
+                exit(2);
+            }
+            tape.on = bench_loops > 1;
+            input_iq(iq_rate, overlap, argv[i], file_type);
+            replay_tape(argv[i], overlap, num_fm_freqs ? (unsigned int)iq_rate : input_rate);
+            continue;
         }
+
+        /* Check sox availability for non-raw types */
+        if (strcmp(file_type, "raw") != 0 && !audio_native_type(file_type))
+            require_sox(file_type, argv[i], sample_rate);
         
+        tape.on = bench_loops > 1;
         input_file(sample_rate, overlap, argv[i], file_type);
+        replay_tape(argv[i], overlap, input_rate);
     }
     
     quit();
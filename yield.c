@@ -0,0 +1,490 @@
+/*
+ *      yield.c -- decode yield of the demodulators against signal to noise ratio
+ *
+ *      Copyright (C) 2026
+ *          Elias Oenal    (multimon-ng@eliasoenal.com)
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Messages of random content are sent by the gen-ng generators, one
+ * after the other with silence between them, impaired by noise, a
+ * frequency offset and a clock error, and decoded in-process. For every
+ * signal to noise ratio this counts the messages that came out right,
+ * the ones that came out wrong, and what the demodulators spent on them.
+ * The same seed sends the same messages with the same noise.
+ */
+
+/* ---------------------------------------------------------------------- */
+
+#include "gen.h"
+#include "impair.h"
+#include "libmultimon.h"
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------------------------------------------------------- */
+
+#define GAP_LEN (SAMPLE_RATE / 2)       /* silence before every message */
+#define TAIL_LEN SAMPLE_RATE
+#define MAX_MESSAGE_LEN (10 * SAMPLE_RATE)
+#define CHUNK 4096
+#define MAX_DEMODS 16
+#define DTMF_DIGITS 8
+
+/*
+ * FLEX and POCSAG are generated as the discriminator output of an FM
+ * receiver, full scale being their deviation: a carrier offset shows as
+ * DC there. The other signals are audio, all of it moves.
+ */
+static const struct signal {
+    const char *name;
+    const char *demod;
+    enum gen_type type;
+    int baud;
+    double deviation;           /* Hz at full scale, 0 for audio */
+} signals[] = {
+    { "pocsag512", "POCSAG512", gentype_pocsag, 512, 4500 },
+    { "pocsag1200", "POCSAG1200", gentype_pocsag, 1200, 4500 },
+    { "pocsag2400", "POCSAG2400", gentype_pocsag, 2400, 4500 },
+    { "flex", "FLEX", gentype_flex, 0, 4800 },
+    { "afsk1200", "AFSK1200", gentype_hdlc, 0, 0 },
+    { "dtmf", "DTMF", gentype_dtmf, 0, 0 },
+};
+
+struct message {
+    char text[64];              /* what the decoder has to print */
+    uint64_t start;             /* in the impaired stream */
+};
+
+struct outcome {
+    unsigned char decoded, seen;
+    char digits[DTMF_DIGITS + 1];
+};
+
+static const struct signal *sig;
+static struct message *msgs;
+static unsigned int nmsg = 200;
+static unsigned int nsent;              /* messages whose start is known */
+static const char *demod_names[MAX_DEMODS + 1];
+static unsigned int ndemods;
+static struct outcome *outcomes;        /* [ndemods][nmsg] */
+static int json_output = 0;
+static unsigned int reports = 0;
+
+static short gen_buf[MAX_MESSAGE_LEN];
+static float sig_buf[MAX_MESSAGE_LEN];
+
+/* ---------------------------------------------------------------------- */
+
+static uint64_t rng_state;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+/* the text of message i, and the generator sending it */
+static void make_message(unsigned int i, struct gen_params *p)
+{
+    static const char letters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    static const char dtmf[] = "0123456789ABCD*#";
+    struct message *msg = &msgs[i];
+    char *text = msg->text;
+    int len;
+
+    memset(p, 0, sizeof(*p));
+    p->type = sig->type;
+    p->ampl = 16384;
+    if (sig->type == gentype_dtmf) {
+        for (len = 0; len < DTMF_DIGITS; len++)
+            text[len] = dtmf[rng_next() % 16];
+        text[len] = 0;
+        p->p.dtmf.duration = MS(100);
+        p->p.dtmf.pause = MS(100);
+        strcpy(p->p.dtmf.str, text);
+        return;
+    }
+    len = sprintf(text, "YIELD %05u ", i);
+    while (len < 32)
+        text[len++] = letters[rng_next() % (sizeof(letters) - 1)];
+    text[len] = 0;
+
+    switch (sig->type) {
+    case gentype_pocsag:
+        p->p.pocsag.address = 8 + rng_next() % 2000000;
+        p->p.pocsag.function = 3;
+        p->p.pocsag.baud = sig->baud;
+        strcpy(p->p.pocsag.message, text);
+        break;
+    case gentype_flex:
+        p->p.flex.capcode = 100000 + rng_next() % 1800000;
+        strcpy(p->p.flex.message, text);
+        break;
+    default:
+        /* an AX.25 UI frame, addressed as gen-ng's -p sends it */
+        p->p.hdlc.txdelay = 100;
+        memcpy(p->p.hdlc.pkt, "\x90\x84\x72\x94\x9c\xb0\x00\x82\x8a\x68\xae\x82\x40\x01\x03\xf0", 16);
+        strcpy((char *)p->p.hdlc.pkt + 16, text);
+        p->p.hdlc.pktlen = 16 + len;
+        break;
+    }
+}
+
+/* sends message i into sig_buf, returns its length */
+static unsigned int gen_message(unsigned int i)
+{
+    static void (*const init[])(struct gen_params *, struct gen_state *) = {
+        [gentype_dtmf] = gen_init_dtmf, [gentype_hdlc] = gen_init_hdlc,
+        [gentype_flex] = gen_init_flex, [gentype_pocsag] = gen_init_pocsag,
+    };
+    static int (*const gen[])(signed short *, int, struct gen_params *, struct gen_state *) = {
+        [gentype_dtmf] = gen_dtmf, [gentype_hdlc] = gen_hdlc,
+        [gentype_flex] = gen_flex, [gentype_pocsag] = gen_pocsag,
+    };
+    static struct gen_state st;
+    struct gen_params p;
+    unsigned int n = 0;
+    int got;
+
+    make_message(i, &p);
+    memset(gen_buf, 0, sizeof(gen_buf));
+    init[sig->type](&p, &st);
+    while (n < MAX_MESSAGE_LEN && (got = gen[sig->type](gen_buf + n, MAX_MESSAGE_LEN - n, &p, &st)) > 0)
+        n += got;
+    for (unsigned int k = 0; k < n; k++)
+        sig_buf[k] = gen_buf[k] * (1.0f/32768.0f);
+    return n;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static int demod_index(const char *name)
+{
+    for (unsigned int d = 0; d < ndemods; d++)
+        if (!strcmp(name, demod_names[d]))
+            return d;
+    return -1;
+}
+
+/* the message whose silence before the next one the line came in, or -1 */
+static int message_at(uint64_t pos)
+{
+    unsigned int lo = 0, hi = nsent;
+
+    if (!nsent || pos + GAP_LEN / 2 < msgs[0].start)
+        return -1;
+    while (hi - lo > 1) {
+        unsigned int mid = (lo + hi) / 2;
+        if (msgs[mid].start <= pos + GAP_LEN / 2)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void yield_output(void *arg, const struct multimon_message *msg)
+{
+    char line[512];
+    const char *p;
+    struct outcome *o;
+    int d, i;
+
+    (void)arg;
+    if (!msg->demod || (d = demod_index(msg->demod)) < 0)
+        return;
+    snprintf(line, sizeof(line), "%.*s", (int)msg->len, msg->text);
+    /* every text message names itself, any other line goes by its position */
+    if ((p = strstr(line, "YIELD ")) && sscanf(p + 6, "%5d", &i) == 1 && i >= 0 && (unsigned)i < nmsg)
+        ;
+    else if ((i = message_at(msg->sample * SAMPLE_RATE / msg->samplerate)) < 0)
+        return;
+    o = &outcomes[d * nmsg + i];
+    o->seen = 1;
+    if (sig->type == gentype_dtmf) {
+        size_t n = strlen(o->digits);
+        if (!strncmp(line, "DTMF: ", 6) && n < DTMF_DIGITS) {
+            o->digits[n] = line[6];
+            o->digits[n + 1] = 0;
+        }
+        else
+            o->digits[0] = '?';         /* more than sent, or not a digit */
+        o->decoded = !strcmp(o->digits, msgs[i].text);
+    }
+    else if (strstr(line, msgs[i].text))
+        o->decoded = 1;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void print_json_string(const char *str)
+{
+    putchar('"');
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            putchar('\\');
+        putchar(*str);
+    }
+    putchar('"');
+}
+
+static void report(const char *demod, double snr, unsigned int decoded, unsigned int corrupt,
+                   double cpu)
+{
+    double us = decoded ? cpu / decoded * 1e6 : 0;
+
+    if (json_output) {
+        printf("%s\n    {\"demod\": ", reports++ ? "," : "");
+        print_json_string(demod);
+        printf(", \"snr_db\": %g, \"sent\": %u, \"decoded\": %u, \"corrupt\": %u, "
+               "\"yield\": %.4f, \"cpu_s\": %.6f, \"us_per_message\": ",
+               snr, nmsg, decoded, corrupt, (double)decoded / nmsg, cpu);
+        if (decoded)
+            printf("%.2f}", us);
+        else
+            printf("null}");
+        return;
+    }
+    if (!reports++)
+        printf("%-12s %7s %6s %7s %7s %7s %9s %11s\n",
+               "demod", "SNR dB", "sent", "decoded", "yield", "corrupt", "CPU s", "us/message");
+    printf("%-12s %7.1f %6u %7u %6.1f%% %7u %9.3f ", demod, snr, nmsg, decoded,
+           100.0 * decoded / nmsg, corrupt, cpu);
+    if (decoded)
+        printf("%11.1f\n", us);
+    else
+        printf("%11s\n", "-");
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void push(struct multimon *m, struct impair *im, const float *in, unsigned int n,
+                 uint64_t *pos)
+{
+    static float out[CHUNK + CHUNK / 999 + 2];
+
+    while (n > 0) {
+        unsigned int len = n < CHUNK ? n : CHUNK;
+        unsigned int got = impair_run(im, in, len, out);
+
+        if (!got && len) {
+            perror("impair_run");
+            exit(10);
+        }
+        multimon_push_float(m, out, got);
+        *pos += got;
+        in += len;
+        n -= len;
+    }
+}
+
+/* sends all messages at one SNR, and reports what came of them */
+static void run_level(const struct impair_params *base, double snr, int pocsag_ecc, double rms)
+{
+    static const float silence[GAP_LEN > TAIL_LEN ? GAP_LEN : TAIL_LEN];
+    struct multimon_config cfg;
+    struct multimon_profile prof[MAX_DEMODS];
+    struct impair_params ip = *base;
+    struct multimon *m;
+    struct impair *im;
+    unsigned int nprof;
+    uint64_t pos = 0;
+
+    ip.snr_db = snr;
+    ip.signal_rms = rms;
+    if (!(im = impair_new(&ip, SAMPLE_RATE))) {
+        fprintf(stderr, "multimon-yield: impairment out of range\n");
+        exit(10);
+    }
+    multimon_config_init(&cfg);
+    cfg.demods = demod_names;
+    cfg.input_rate = SAMPLE_RATE;
+    cfg.output = yield_output;
+    cfg.profile = true;
+    cfg.pocsag_error_correction = pocsag_ecc;
+    if (!(m = multimon_create(&cfg)))
+        exit(10);
+    memset(outcomes, 0, ndemods * nmsg * sizeof(outcomes[0]));
+    nsent = 0;
+
+    rng_state = base->seed * 0x9e3779b97f4a7c15ull + 1;
+    for (unsigned int i = 0; i < nmsg; i++) {
+        unsigned int n = gen_message(i);
+
+        push(m, im, silence, GAP_LEN, &pos);
+        msgs[i].start = pos;
+        nsent = i + 1;
+        push(m, im, sig_buf, n, &pos);
+    }
+    push(m, im, silence, TAIL_LEN, &pos);
+    multimon_finish(m);
+
+    nprof = multimon_profile(m, prof, MAX_DEMODS);
+    for (unsigned int d = 0; d < ndemods; d++) {
+        unsigned int decoded = 0, corrupt = 0;
+        uint64_t ns = 0;
+
+        for (unsigned int i = 0; i < nmsg; i++) {
+            const struct outcome *o = &outcomes[d * nmsg + i];
+            decoded += o->decoded;
+            corrupt += o->seen && !o->decoded;
+        }
+        for (unsigned int k = 0; k < nprof && k < MAX_DEMODS; k++)
+            if (!strcmp(prof[k].demod, demod_names[d]))
+                ns += prof[k].ns;
+        report(demod_names[d], snr, decoded, corrupt, ns * 1e-9);
+    }
+    multimon_destroy(m);
+    impair_free(im);
+}
+
+/* RMS of the first message while it sends, what the SNR refers to */
+static double signal_rms(uint64_t seed)
+{
+    double sum = 0;
+    unsigned int n, active = 0;
+
+    rng_state = seed * 0x9e3779b97f4a7c15ull + 1;
+    n = gen_message(0);
+    for (unsigned int k = 0; k < n; k++) {
+        sum += (double)sig_buf[k] * sig_buf[k];
+        active += sig_buf[k] != 0;
+    }
+    return active ? sqrt(sum / active) : 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static const char usage_str[] =
+    "multimon-yield\n"
+    "Decode yield of the multimon-ng demodulators against signal to noise ratio\n"
+    "usage: %s [options] <signal> [demod ...]\n"
+    "  -n <messages>       : Messages sent per SNR (default: 200)\n"
+    "  -S <from:to:step>   : SNRs in dB, or a single one (default: 0:20:2)\n"
+    "  -f <Hz>             : Carrier frequency offset\n"
+    "  -d <ppm>            : Sample clock error, up to 1000\n"
+    "  -b <errors>         : POCSAG bit errors corrected, 0 to 2 (default: 2)\n"
+    "  -s <seed>           : Seed of the messages and the noise (default: 1)\n"
+    "  -j                  : Write the results as JSON\n"
+    "  -h                  : This help\n"
+    "The demodulators default to the one for the signal. Signals:";
+
+int main(int argc, char *argv[])
+{
+    struct impair_params ip;
+    double snr_from = 0, snr_to = 20, snr_step = 2, rms;
+    int c, errflg = 0, pocsag_ecc = 2;
+
+    impair_params_init(&ip);
+    while ((c = getopt(argc, argv, "n:S:f:d:b:s:jh")) != EOF) {
+        switch (c) {
+        case 'n':
+            nmsg = strtoul(optarg, NULL, 0);
+            if (!nmsg || nmsg > 99999)
+                errflg++;
+            break;
+        case 'S':
+            c = sscanf(optarg, "%lf:%lf:%lf", &snr_from, &snr_to, &snr_step);
+            if (c == 1)
+                snr_to = snr_from;
+            else if (c != 3 || snr_step <= 0 || snr_to < snr_from)
+                errflg++;
+            break;
+        case 'f':
+            ip.freq_shift = strtod(optarg, NULL);
+            break;
+        case 'd':
+            ip.drift_ppm = strtod(optarg, NULL);
+            if (fabs(ip.drift_ppm) > 1000)
+                errflg++;
+            break;
+        case 'b':
+            pocsag_ecc = atoi(optarg);
+            if (pocsag_ecc < 0 || pocsag_ecc > 2)
+                errflg++;
+            break;
+        case 's':
+            ip.seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'j':
+            json_output = 1;
+            break;
+        default:
+            errflg++;
+            break;
+        }
+    }
+    if (!errflg && optind < argc) {
+        for (unsigned int k = 0; k < sizeof(signals) / sizeof(signals[0]); k++)
+            if (!strcmp(argv[optind], signals[k].name))
+                sig = &signals[k];
+        for (int i = optind + 1; i < argc; i++) {
+            if (ndemods == MAX_DEMODS || demod_index(argv[i]) >= 0 || strchr(argv[i], '@'))
+                errflg++;
+            else
+                demod_names[ndemods++] = argv[i];
+        }
+    }
+    if (errflg || !sig) {
+        fprintf(stderr, usage_str, argv[0]);
+        for (unsigned int k = 0; k < sizeof(signals) / sizeof(signals[0]); k++)
+            fprintf(stderr, " %s", signals[k].name);
+        fprintf(stderr, "\n");
+        exit(2);
+    }
+    if (!ndemods)
+        demod_names[ndemods++] = sig->demod;
+
+    msgs = calloc(nmsg, sizeof(msgs[0]));
+    outcomes = calloc((size_t)ndemods * nmsg, sizeof(outcomes[0]));
+    if (!msgs || !outcomes) {
+        perror("calloc");
+        exit(10);
+    }
+    /* a carrier offset in the discriminator output, full scale being the deviation */
+    if (sig->deviation) {
+        ip.dc_offset = 0.5 * ip.freq_shift / sig->deviation;
+        ip.freq_shift = 0;
+    }
+    rms = signal_rms(ip.seed);
+
+    if (json_output) {
+        printf("{\n  \"signal\": ");
+        print_json_string(sig->name);
+        printf(", \"messages\": %u, \"seed\": %llu, \"offset_hz\": %g, \"drift_ppm\": %g,"
+               "\n  \"results\": [", nmsg, (unsigned long long)ip.seed,
+               sig->deviation ? ip.dc_offset * sig->deviation / 0.5 : ip.freq_shift, ip.drift_ppm);
+    }
+    else
+        printf("%s, %u messages per SNR, signal RMS %.3f full scale\n", sig->name, nmsg, rms);
+    for (double snr = snr_from; snr <= snr_to + snr_step * 1e-6; snr += snr_step)
+        run_level(&ip, snr, pocsag_ecc, rms);
+    if (json_output)
+        printf("\n  ]\n}\n");
+    free(outcomes);
+    free(msgs);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------- */